@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// access_tracer.cpp
+//
+// Identification: src/buffer/access_tracer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/access_tracer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** @return the number of the calling thread in traces, assigned on its first record */
+auto TraceThread() -> uint16_t {
+  static std::atomic<uint16_t> next_thread{0};
+  thread_local uint16_t thread = next_thread.fetch_add(1, std::memory_order_relaxed);
+  return thread;
+}
+
+/** @return a new tracer id */
+auto NextTracerId() -> uint64_t {
+  static std::atomic<uint64_t> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+AccessTracer::AccessTracer(const std::string &path) : id_(NextTracerId()), start_(std::chrono::steady_clock::now()) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return;
+  auto start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch());
+  Header header{MAGIC, VERSION, static_cast<uint64_t>(start_ns.count())};
+  if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+    close(fd);
+    return;
+  }
+  fd_ = fd;
+  writer_thread_ = std::thread(&AccessTracer::RunWriter, this);
+}
+
+AccessTracer::~AccessTracer() {
+  if (fd_ < 0) return;
+  Flush();
+  {
+    std::scoped_lock<std::mutex> writer_lock(writer_latch_);
+    writer_stop_ = true;
+  }
+  writer_wakeup_.notify_all();
+  writer_thread_.join();
+  close(fd_);
+}
+
+void AccessTracer::Record(TraceOp op, page_id_t page_id, uint8_t arg) {
+  ThreadBuffer *buffer = GetThreadBuffer();
+  std::vector<TraceRecord> full;
+  {
+    std::scoped_lock<std::mutex> lock(buffer->latch_);
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_);
+    buffer->records_.push_back({static_cast<uint64_t>(timestamp.count()), page_id, TraceThread(), op, arg});
+    buffer->record_count_.fetch_add(1, std::memory_order_relaxed);
+    if (buffer->records_.size() < BUFFER_RECORDS) return;
+    full.swap(buffer->records_);
+    buffer->records_.reserve(BUFFER_RECORDS);
+  }
+  Submit(std::move(full));
+}
+
+void AccessTracer::Flush() {
+  uint64_t batches;
+  {
+    std::scoped_lock<std::mutex> lock(buffers_latch_);
+    for (auto &buffer : buffers_) {
+      std::vector<TraceRecord> records;
+      {
+        std::scoped_lock<std::mutex> buffer_lock(buffer->latch_);
+        records.swap(buffer->records_);
+      }
+      if (!records.empty()) Submit(std::move(records));
+    }
+    std::scoped_lock<std::mutex> writer_lock(writer_latch_);
+    batches = submitted_batches_;
+  }
+  std::unique_lock<std::mutex> writer_lock(writer_latch_);
+  written_.wait(writer_lock, [this, batches] { return written_batches_ >= batches; });
+}
+
+auto AccessTracer::GetRecordCount() -> uint64_t {
+  std::scoped_lock<std::mutex> lock(buffers_latch_);
+  uint64_t record_count = 0;
+  for (auto &buffer : buffers_) record_count += buffer->record_count_.load(std::memory_order_relaxed);
+  return record_count;
+}
+
+auto AccessTracer::GetThreadBuffer() -> ThreadBuffer * {
+  // by tracer id, a thread may record into the traces of several pools
+  thread_local std::unordered_map<uint64_t, ThreadBuffer *> thread_buffers;
+  auto it = thread_buffers.find(id_);
+  if (it != thread_buffers.end()) return it->second;
+  auto buffer = std::make_unique<ThreadBuffer>();
+  buffer->records_.reserve(BUFFER_RECORDS);
+  ThreadBuffer *thread_buffer = buffer.get();
+  {
+    std::scoped_lock<std::mutex> lock(buffers_latch_);
+    buffers_.push_back(std::move(buffer));
+  }
+  thread_buffers.emplace(id_, thread_buffer);
+  return thread_buffer;
+}
+
+void AccessTracer::Submit(std::vector<TraceRecord> records) {
+  {
+    std::scoped_lock<std::mutex> writer_lock(writer_latch_);
+    pending_.push_back(std::move(records));
+    submitted_batches_++;
+  }
+  writer_wakeup_.notify_one();
+}
+
+void AccessTracer::RunWriter() {
+  std::unique_lock<std::mutex> writer_lock(writer_latch_);
+  while (true) {
+    writer_wakeup_.wait(writer_lock, [this] { return writer_stop_ || !pending_.empty(); });
+    if (pending_.empty()) return;
+    std::deque<std::vector<TraceRecord>> batches;
+    batches.swap(pending_);
+    writer_lock.unlock();
+    for (const std::vector<TraceRecord> &records : batches) {
+      auto length = static_cast<ssize_t>(records.size() * sizeof(TraceRecord));
+      if (write(fd_, records.data(), length) != length) LOG_DEBUG("cannot write %zu trace records", records.size());
+    }
+    writer_lock.lock();
+    written_batches_ += batches.size();
+    written_.notify_all();
+  }
+}
+
+auto AccessTracer::ReadTrace(const std::string &path, std::vector<TraceRecord> *records) -> bool {
+  records->clear();
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat file_stat {};
+  Header header{};
+  // the records of version 1 are laid out the same, with no argument
+  bool valid = fstat(fd, &file_stat) == 0 && read(fd, &header, sizeof(header)) == sizeof(header) &&
+               header.magic_ == MAGIC && (header.version_ == 1 || header.version_ == VERSION);
+  if (valid) {
+    // a trace cut short by a crash ends in a partial record, which is dropped
+    auto num_records = (static_cast<size_t>(file_stat.st_size) - sizeof(header)) / sizeof(TraceRecord);
+    records->resize(num_records);
+    auto length = static_cast<ssize_t>(num_records * sizeof(TraceRecord));
+    valid = pread(fd, records->data(), length, sizeof(header)) == length;
+  }
+  close(fd);
+  if (!valid) {
+    records->clear();
+    return false;
+  }
+  // each thread's records are in order, the threads' buffers were written as they filled up
+  std::stable_sort(records->begin(), records->end(),
+                   [](const TraceRecord &a, const TraceRecord &b) { return a.timestamp_ns_ < b.timestamp_ns_; });
+  return true;
+}
+
+}  // namespace bustub
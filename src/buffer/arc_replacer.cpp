@@ -0,0 +1,205 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+ArcReplacer::ArcReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      list_of_(num_frames, NO_LIST),
+      stamps_(num_frames, 0),
+      victims_{FrameHeap(num_frames), FrameHeap(num_frames)},
+      frame_page_(num_frames, INVALID_PAGE_ID),
+      prefetched_(num_frames, false) {}
+
+auto ArcReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  *frame_id = -1;
+  if (curr_size_ == 0) return false;
+
+  size_t list = FirstVictimList();
+  if (victims_[list].Size() == 0) list = list == T1 ? T2 : T1;
+  *frame_id = victims_[list].Top();
+
+  if (list == T1) cold_evictions_++;
+  if (frame_page_[*frame_id] != INVALID_PAGE_ID) (list == T1 ? b1_ : b2_).Push(frame_page_[*frame_id]);
+  Untrack(*frame_id);
+  TrimGhosts();
+  return true;
+}
+
+void ArcReplacer::RecordAccess(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  bool tracked = list_of_[frame_id] != NO_LIST;
+  if (tracked && !prefetched_[frame_id]) {
+    // a hit in T1 or T2 makes the page frequent
+    Move(frame_id, T2, clock_++);
+    return;
+  }
+
+  // a miss, or the first access of a prefetched page
+  size_t list = T1;
+  page_id_t page_id = frame_page_[frame_id];
+  if (page_id != INVALID_PAGE_ID && b1_.Contains(page_id)) {
+    // T1 was too small to keep this page, give recency more room
+    p_ = std::min(p_ + std::max<size_t>(b2_.Size() / b1_.Size(), 1), replacer_size_);
+    b1_.Erase(page_id);
+    list = T2;
+  } else if (page_id != INVALID_PAGE_ID && b2_.Contains(page_id)) {
+    // T2 was too small to keep this page, give frequency more room
+    size_t delta = std::max<size_t>(b1_.Size() / b2_.Size(), 1);
+    p_ = p_ > delta ? p_ - delta : 0;
+    b2_.Erase(page_id);
+    list = T2;
+  }
+  if (tracked) {
+    prefetched_[frame_id] = false;
+    Move(frame_id, list, clock_++);
+  } else {
+    Track(frame_id, list, clock_++);
+  }
+  TrimGhosts();
+}
+
+void ArcReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (list_of_[frame_id] != NO_LIST) return;
+  // waits in T1 like a new page; the ghosts only learn from the page once it is accessed
+  Track(frame_id, T1, clock_++);
+  prefetched_[frame_id] = true;
+  TrimGhosts();
+}
+
+void ArcReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t list = list_of_[frame_id];
+  if (list == NO_LIST || victims_[list].Contains(frame_id) == set_evictable) return;
+
+  if (set_evictable) {
+    victims_[list].Push(frame_id, stamps_[frame_id]);
+    curr_size_++;
+  } else {
+    victims_[list].Erase(frame_id);
+    curr_size_--;
+  }
+}
+
+void ArcReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (list_of_[frame_id] == NO_LIST) return;
+  Untrack(frame_id);
+}
+
+void ArcReplacer::Reinstate(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  // the eviction left its ghost in B1 for a frame of T1 and in B2 for one of T2; p stays as it was
+  bool from_t1 = page_id == INVALID_PAGE_ID || !b2_.Erase(page_id);
+  if (from_t1 && page_id != INVALID_PAGE_ID && b1_.Erase(page_id)) cold_evictions_--;
+  frame_page_[frame_id] = page_id;
+
+  if (list_of_[frame_id] == NO_LIST) {
+    // back where it was, as if it had never left
+    Track(frame_id, from_t1 ? T1 : T2, stamps_[frame_id]);
+    return;
+  }
+  // an access in the meantime tracked the frame as a new page in T1, it is a hit of a resident page
+  Move(frame_id, T2, clock_++);
+}
+
+auto ArcReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ArcReplacer::SetFramePage(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  frame_page_[frame_id] = page_id;
+}
+
+void ArcReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame_id = num_frames; frame_id < replacer_size_; frame_id++) {
+    if (list_of_[frame_id] != NO_LIST) Untrack(static_cast<frame_id_t>(frame_id));
+  }
+  replacer_size_ = num_frames;
+  p_ = std::min(p_, num_frames);
+  list_of_.resize(num_frames, NO_LIST);
+  stamps_.resize(num_frames, 0);
+  for (auto &victims : victims_) victims.Resize(num_frames);
+  frame_page_.resize(num_frames, INVALID_PAGE_ID);
+  prefetched_.resize(num_frames, false);
+  TrimGhosts();
+}
+
+auto ArcReplacer::GetColdEvictionCount() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return cold_evictions_;
+}
+
+auto ArcReplacer::PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t first = FirstVictimList();
+  size_t count = victims_[first].Peek(frame_ids, max_frames);
+  return count + victims_[first == T1 ? T2 : T1].Peek(frame_ids + count, max_frames - count);
+}
+
+auto ArcReplacer::FirstVictimList() const -> size_t {
+  return list_sizes_[T1] > 0 && list_sizes_[T1] > p_ ? T1 : T2;
+}
+
+void ArcReplacer::TrimGhosts() {
+  while (b1_.Size() > 0 && list_sizes_[T1] + b1_.Size() > replacer_size_) b1_.PopBack();
+  while (b2_.Size() > 0 && list_sizes_[T1] + list_sizes_[T2] + b1_.Size() + b2_.Size() > 2 * replacer_size_) {
+    b2_.PopBack();
+  }
+}
+
+void ArcReplacer::Track(frame_id_t frame_id, size_t list, uint64_t stamp) {
+  list_of_[frame_id] = list;
+  list_sizes_[list]++;
+  stamps_[frame_id] = stamp;
+}
+
+void ArcReplacer::Move(frame_id_t frame_id, size_t list, uint64_t stamp) {
+  size_t old_list = list_of_[frame_id];
+  bool evictable = victims_[old_list].Contains(frame_id);
+  victims_[old_list].Erase(frame_id);
+  list_sizes_[old_list]--;
+  list_sizes_[list]++;
+  list_of_[frame_id] = list;
+  stamps_[frame_id] = stamp;
+  if (evictable) victims_[list].Push(frame_id, stamp);
+}
+
+void ArcReplacer::Untrack(frame_id_t frame_id) {
+  size_t list = list_of_[frame_id];
+  if (victims_[list].Contains(frame_id)) {
+    victims_[list].Erase(frame_id);
+    curr_size_--;
+  }
+  list_sizes_[list]--;
+  list_of_[frame_id] = NO_LIST;
+  frame_page_[frame_id] = INVALID_PAGE_ID;
+  prefetched_[frame_id] = false;
+}
+
+}  // namespace bustub
@@ -12,17 +12,66 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+
 #include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     const FrameArenaOptions &arena_options)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_policy,
+                                arena_options) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     const FrameArenaOptions &arena_options)
+    : pool_size_(pool_size),
+      chunk_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(instance_index),
+      arena_options_(arena_options),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager),
+      unpinned_frames_(pool_size),
+      max_sticky_frames_(pool_size / 4),
+      target_pool_size_(pool_size) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
   // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  chunks_[0].arena_ = new FrameArena(chunk_size_, arena_options_);
+  chunks_[0].latches_ = new FrameLatch[chunk_size_];
+  page_table_.store(new PageTable(pool_size_));
+  disk_scheduler_ = new DiskScheduler(disk_manager_);
+  switch (replacer_policy) {
+    case ReplacerPolicy::CLOCK:
+      replacer_ = new ClockReplacer(pool_size);
+      break;
+    case ReplacerPolicy::TWO_QUEUE:
+      replacer_ = new TwoQueueReplacer(pool_size);
+      break;
+    case ReplacerPolicy::ARC:
+      replacer_ = new ArcReplacer(pool_size);
+      break;
+    default:
+      replacer_ = new LRUKReplacer(pool_size, replacer_k, true);
+      break;
+  }
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -31,153 +80,1739 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopPageCleaner();
+  if (shrink_thread_.joinable()) {
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      shrink_stop_ = true;
+    }
+    shrink_wakeup_.notify_all();
+    shrink_thread_.join();
+  }
+  WriteFreePageMap();
+  delete disk_scheduler_;  // completes the prefetches still in flight first
+  for (FrameChunk &chunk : chunks_) {
+    delete chunk.arena_.load();
+    delete[] chunk.latches_.load();
+  }
+  delete free_page_map_;
+  delete compressed_cache_;
+  delete mapped_file_;
+  delete checksums_;
+  delete tracer_;
+  delete page_table_.load();
+  for (PageTable *page_table : retired_page_tables_) delete page_table;
   delete replacer_;
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+  frame_id_t frame_id = -1;
+  return NewFrame(page_id, &frame_id);
+}
 
-  int num_free_pages = 0;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) num_free_pages++;
+auto BufferPoolManagerInstance::NewPageInSegment(PageSegment *segment, page_id_t *page_id) -> Page * {
+  frame_id_t frame_id = -1;
+  return NewFrame(page_id, &frame_id, segment);
+}
+
+auto BufferPoolManagerInstance::NewReservedPage(page_id_t page_id) -> Page * {
+  if (IsFreePageMapPage(page_id)) return nullptr;
+  // a segment whose extent is the reserved page alone
+  PageSegment reserved(1);
+  reserved.next_page_id_ = page_id;
+  reserved.remaining_pages_ = 1;
+  frame_id_t frame_id = -1;
+  return NewFrame(&page_id, &frame_id, &reserved);
+}
+
+auto BufferPoolManagerInstance::NewFrame(page_id_t *page_id, frame_id_t *frame_id, PageSegment *segment) -> Page * {
+  if (unpinned_frames_.load() == 0) {
+    metrics_.new_page_failures_.Add();  // every frame is pinned, no need to wait for the latch
+    return nullptr;
   }
+  std::unique_lock<std::mutex> lock = LockLatch();
+
+  page_id_t writeback_page_id = INVALID_PAGE_ID;
+  while (!AcquireFrame(frame_id, &writeback_page_id)) {
+    if (!WaitForCleaning(&lock)) {
+      metrics_.new_page_failures_.Add();
+      return nullptr;
+    }
+  }
+  metrics_.new_pages_.Add();
+
+  *page_id = segment == nullptr ? AllocatePage() : AllocateSegmentPage(segment);
+  Page *page = InstallPage(*frame_id, *page_id, nullptr);
+  lock.unlock();
 
-  if (!num_free_pages) return nullptr;
+  FinishIo(*frame_id, writeback_page_id, false);
+  Trace(TraceOp::NEW, *page_id);
+  return page;
+}
 
-  *page_id = AllocatePage();
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
+  return FetchPageWithStrategy(page_id, nullptr);
+}
+
+auto BufferPoolManagerInstance::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   frame_id_t frame_id = -1;
+  return FetchFrame(page_id, strategy, &frame_id);
+}
 
-  if (!free_list_.empty()) {
-    frame_id = free_list_.front();
-    free_list_.pop_front();
-  } else {
-    replacer_->Evict(&frame_id);
-    Page *evicted_page = &pages_[frame_id];
-    page_id_t evicted_page_id = evicted_page->GetPageId();
+auto BufferPoolManagerInstance::FetchFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id,
+                                           const char **mapped_data) -> Page * {
+  if (IsFreePageMapPage(page_id)) return nullptr;
+  std::unique_lock<std::mutex> frame_lock;
+  if (TryLatchFrame(page_id, frame_id, &frame_lock)) {
+    return PinLatchedFrame(*frame_id, &frame_lock, strategy, mapped_data);
+  }
 
-    if (evicted_page->IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, evicted_page->GetData());
-      evicted_page->is_dirty_ = false;
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock = LockLatch();
+  page_id_t writeback_page_id = INVALID_PAGE_ID;
+  while (true) {
+    if (FindLoadablePage(page_id, frame_id, &lock)) {
+      frame_lock = std::unique_lock<std::mutex>(GetFrameLatch(*frame_id).latch_);
+      lock.unlock();
+      return PinLatchedFrame(*frame_id, &frame_lock, strategy, mapped_data);
     }
+    if (strategy == nullptr ? AcquireFrame(frame_id, &writeback_page_id)
+                            : AcquireRingFrame(strategy, frame_id, &writeback_page_id)) {
+      break;
+    }
+    if (!WaitForCleaning(&lock)) {
+      metrics_.fetch_failures_.Add();
+      return nullptr;
+    }
+  }
+  metrics_.misses_.Add();
+  uint8_t ring = strategy == nullptr ? 0 : TraceRing(strategy);
 
-    evicted_page->ResetMemory();
-    page_table_.erase(evicted_page_id);
+  Page *page = InstallPage(*frame_id, page_id, strategy);
+  if (mapped_data != nullptr) {
+    std::scoped_lock<std::mutex> installed_frame_lock(GetFrameLatch(*frame_id).latch_);
+    GetFrameLatch(*frame_id).mapped_data_ = *mapped_data;
   }
+  lock.unlock();
 
-  page_table_.emplace(*page_id, frame_id);
-  Page *page = &pages_[frame_id];
-  page->page_id_ = *page_id;
-  page->pin_count_ = 1;
+  FinishIo(*frame_id, writeback_page_id, true);
+  metrics_.miss_latency_.Record(std::chrono::steady_clock::now() - start);
+  Trace(strategy == nullptr ? TraceOp::FETCH : TraceOp::FETCH_STRATEGY, page_id, ring);
+  return page;
+}
 
-  replacer_->RecordAccess(frame_id);
-  replacer_->SetEvictable(frame_id, false);
+auto BufferPoolManagerInstance::FindLoadablePage(page_id_t page_id, frame_id_t *frame_id,
+                                                 std::unique_lock<std::mutex> *lock) -> bool {
+  bool resident = GetPageTable()->Find(page_id, frame_id);
+  while (!resident) {
+    std::unique_lock<std::mutex> writeback_lock(writeback_latch_);
+    if (writeback_pages_.count(page_id) == 0) break;
+    // the previous image of page_id is still being written back, reading it now would return stale data
+    lock->unlock();
+    writeback_done_.wait(writeback_lock, [this, page_id] { return writeback_pages_.count(page_id) == 0; });
+    writeback_lock.unlock();
+    lock->lock();
+    resident = GetPageTable()->Find(page_id, frame_id);
+  }
+  return resident;
+}
 
+auto BufferPoolManagerInstance::FetchPageAsync(page_id_t page_id, std::function<void(Page *)> on_loaded, bool *pending)
+    -> Page * {
+  *pending = false;
+  if (IsFreePageMapPage(page_id)) return nullptr;
+  frame_id_t frame_id = -1;
+  std::unique_lock<std::mutex> frame_lock;
+  if (!TryLatchFrame(page_id, &frame_id, &frame_lock)) {
+    auto start = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock = LockLatch();
+    page_id_t writeback_page_id = INVALID_PAGE_ID;
+    bool resident = FindLoadablePage(page_id, &frame_id, &lock);
+    while (!resident && !AcquireFrame(&frame_id, &writeback_page_id)) {
+      // like FetchFrame(), a frame the page cleaner is writing back is free once the write completes
+      if (!WaitForCleaning(&lock)) {
+        metrics_.fetch_failures_.Add();
+        return nullptr;
+      }
+      resident = FindLoadablePage(page_id, &frame_id, &lock);
+    }
+    if (!resident) {
+      metrics_.misses_.Add();
+      InstallPage(frame_id, page_id, nullptr);
+      lock.unlock();
+      *pending = true;
+      Trace(TraceOp::FETCH, page_id);
+      ScheduleRead(frame_id, writeback_page_id, [this, frame_id, start, on_loaded = std::move(on_loaded)] {
+        FinishAsyncFetch(frame_id, start, on_loaded);
+      });
+      // here rather than in FinishAsyncFetch(), which would keep the I/O thread from completing other requests
+      if (compressed_cache_ != nullptr) compressed_cache_->CompressPending();
+      return nullptr;
+    }
+    frame_lock = std::unique_lock<std::mutex>(GetFrameLatch(frame_id).latch_);
+    lock.unlock();
+  }
+
+  Page *page = PinHitFrame(frame_id, nullptr);
+  Trace(TraceOp::FETCH, page_id);
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (frame_latch.io_in_progress_) {
+    // another fetch is still loading the page, this one completes along with it
+    *pending = true;
+    frame_latch.io_waiters_.emplace_back([this, frame_id, page, on_loaded = std::move(on_loaded)] {
+      {
+        std::scoped_lock<std::mutex> loaded_frame_lock(GetFrameLatch(frame_id).latch_);
+        CopyMappedPage(frame_id);
+      }
+      on_loaded(page);
+    });
+    return nullptr;
+  }
+  CopyMappedPage(frame_id);
   return page;
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+void BufferPoolManagerInstance::FinishAsyncFetch(frame_id_t frame_id, std::chrono::steady_clock::time_point start,
+                                                 const std::function<void(Page *)> &on_loaded) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  std::vector<std::function<void()>> waiters;
+  {
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    frame_latch.io_in_progress_ = false;
+    waiters.swap(frame_latch.io_waiters_);
+  }
+  NotifyIoDone(&frame_latch, std::move(waiters));
+  metrics_.miss_latency_.Record(std::chrono::steady_clock::now() - start);
+  on_loaded(GetFrame(frame_id));
+}
 
-  auto it = page_table_.find(page_id);
-  if (it != page_table_.end()) {
-    frame_id_t frame_id = it->second;
-    pages_[frame_id].pin_count_++;
-    replacer_->RecordAccess(frame_id);
-    replacer_->SetEvictable(frame_id, false);
-    return &pages_[frame_id];
+void BufferPoolManagerInstance::NotifyIoDone(FrameLatch *frame_latch, std::vector<std::function<void()>> waiters) {
+  frame_latch->io_done_.notify_all();
+  for (auto &waiter : waiters) waiter();
+}
+
+auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  frame_id_t frame_id = -1;
+  std::unique_lock<std::mutex> frame_lock;
+  if (!TryLatchFrame(page_id, &frame_id, &frame_lock)) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (!GetPageTable()->Find(page_id, &frame_id)) return false;
+    frame_lock = std::unique_lock<std::mutex>(GetFrameLatch(frame_id).latch_);
   }
+  if (!UnpinLatchedFrame(frame_id, is_dirty)) return false;
+  Trace(is_dirty ? TraceOp::UNPIN_DIRTY : TraceOp::UNPIN, page_id);
+  return true;
+}
 
-  int num_free_pages = 0;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) num_free_pages++;
+void BufferPoolManagerInstance::UnpinFrame(frame_id_t frame_id, bool is_dirty) {
+  std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+  if (!UnpinLatchedFrame(frame_id, is_dirty)) return;
+  Trace(is_dirty ? TraceOp::UNPIN_DIRTY : TraceOp::UNPIN, GetFrame(frame_id)->page_id_);
+}
+
+auto BufferPoolManagerInstance::UnpinLatchedFrame(frame_id_t frame_id, bool is_dirty) -> bool {
+  Page *page = GetFrame(frame_id);
+  if (page->GetPinCount() <= 0) return false;
+  if (is_dirty) page->is_dirty_ = is_dirty;
+  page->pin_count_--;
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (page->pin_count_ == 0 && frame_latch.ring_owner_ == nullptr && !frame_latch.retiring_) {
+    // a frame being cleaned becomes evictable when the cleaner is done with it
+    if (!frame_latch.cleaning_) replacer_->SetEvictable(frame_id, true);
+    unpinned_frames_++;
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
+  frame_id_t frame_id = -1;
+  Page *page = FetchFrame(page_id, nullptr, &frame_id);
+  return page == nullptr ? BasicPageGuard() : BasicPageGuard(this, page, frame_id);
+}
+
+auto BufferPoolManagerInstance::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
+  return FetchPageBasic(page_id).UpgradeRead();
+}
+
+auto BufferPoolManagerInstance::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
+  return FetchPageBasic(page_id).UpgradeWrite();
+}
+
+auto BufferPoolManagerInstance::FetchPageMapped(page_id_t page_id) -> ReadPageGuard {
+  const char *mapped_data = mapped_file_ == nullptr ? nullptr : mapped_file_->GetPage(page_id);
+  if (mapped_data == nullptr) return FetchPageRead(page_id);
+  frame_id_t frame_id = -1;
+  Page *page = FetchFrame(page_id, nullptr, &frame_id, &mapped_data);
+  if (page == nullptr) return {};
+  return BasicPageGuard(this, page, frame_id, mapped_data).UpgradeRead();
+}
+
+auto BufferPoolManagerInstance::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
+  frame_id_t frame_id = -1;
+  Page *page = NewFrame(page_id, &frame_id);
+  return page == nullptr ? BasicPageGuard() : BasicPageGuard(this, page, frame_id);
+}
+
+auto BufferPoolManagerInstance::FetchPageWithPriority(page_id_t page_id, PagePriority priority) -> Page * {
+  frame_id_t frame_id = -1;
+  Page *page = FetchFrame(page_id, nullptr, &frame_id);
+  if (page != nullptr) SetFramePriority(frame_id, priority);
+  return page;
+}
+
+auto BufferPoolManagerInstance::NewPageWithPriority(page_id_t *page_id, PagePriority priority) -> Page * {
+  frame_id_t frame_id = -1;
+  Page *page = NewFrame(page_id, &frame_id);
+  if (page != nullptr) SetFramePriority(frame_id, priority);
+  return page;
+}
+
+auto BufferPoolManagerInstance::FetchPageBasic(page_id_t page_id, PagePriority priority) -> BasicPageGuard {
+  frame_id_t frame_id = -1;
+  Page *page = FetchFrame(page_id, nullptr, &frame_id);
+  if (page == nullptr) return {};
+  SetFramePriority(frame_id, priority);
+  return {this, page, frame_id};
+}
+
+auto BufferPoolManagerInstance::NewPageGuarded(page_id_t *page_id, PagePriority priority) -> BasicPageGuard {
+  frame_id_t frame_id = -1;
+  Page *page = NewFrame(page_id, &frame_id);
+  if (page == nullptr) return {};
+  SetFramePriority(frame_id, priority);
+  return {this, page, frame_id};
+}
+
+void BufferPoolManagerInstance::SetFramePriority(frame_id_t frame_id, PagePriority priority) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+  // ring frames are recycled by their scan and never reach the replacer
+  if (frame_latch.ring_owner_ != nullptr || frame_latch.priority_ == priority) return;
+  if (priority == PagePriority::STICKY && sticky_frames_++ >= max_sticky_frames_) {
+    sticky_frames_--;
+    priority = PagePriority::NORMAL;
+    if (frame_latch.priority_ == priority) return;
+  }
+  if (frame_latch.priority_ == PagePriority::STICKY) sticky_frames_--;
+  frame_latch.priority_ = priority;
+  replacer_->SetPriority(frame_id, priority);
+  Trace(TraceOp::PRIORITY, GetFrame(frame_id)->page_id_, static_cast<uint8_t>(priority));
+}
+
+auto BufferPoolManagerInstance::FetchPages(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> {
+  if (page_ids.empty()) return {};
+  for (page_id_t page_id : page_ids) {
+    if (IsFreePageMapPage(page_id)) return {};
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock = LockLatch();
+  while (true) {
+    page_id_t pending_page_id = INVALID_PAGE_ID;
+    {
+      std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+      for (page_id_t page_id : page_ids) {
+        if (writeback_pages_.count(page_id) > 0) {
+          pending_page_id = page_id;
+          break;
+        }
+      }
+    }
+    if (pending_page_id == INVALID_PAGE_ID) break;
+    // the previous image of the page is still being written back, reading it now would return stale data
+    lock.unlock();
+    {
+      std::unique_lock<std::mutex> writeback_lock(writeback_latch_);
+      writeback_done_.wait(writeback_lock,
+                           [this, pending_page_id] { return writeback_pages_.count(pending_page_id) == 0; });
+    }
+    lock.lock();
+  }
+
+  std::vector<frame_id_t> frame_ids(page_ids.size(), -1);
+  std::vector<page_id_t> misses;
+  std::unordered_set<page_id_t> missing;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (GetPageTable()->Find(page_ids[i], &frame_ids[i])) continue;
+    frame_ids[i] = -1;
+    if (missing.insert(page_ids[i]).second) misses.push_back(page_ids[i]);
+  }
+
+  // the resident pages are pinned first, so that making room for the missing ones cannot evict them; their accesses
+  // are only recorded once the batch is sure to go ahead
+  std::vector<frame_id_t> hit_frames;
+  std::vector<frame_id_t> ring_frames;
+  size_t hits = 0;
+  for (frame_id_t frame_id : frame_ids) {
+    if (frame_id == -1) continue;
+    hits++;
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    Page *page = GetFrame(frame_id);
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    if (frame_latch.ring_owner_ != nullptr) {
+      page->pin_count_++;
+      ring_frames.push_back(frame_id);
+      continue;
+    }
+    if (page->pin_count_++ == 0 && !frame_latch.retiring_) unpinned_frames_--;
+    hit_frames.push_back(frame_id);
+  }
+
+  std::vector<std::pair<frame_id_t, page_id_t>> frames;
+  if (!AcquireFrames(misses.size(), &frames)) {
+    // unpinned directly, the pins are not the caller's and stay out of the trace
+    for (frame_id_t frame_id : frame_ids) {
+      if (frame_id == -1) continue;
+      std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+      UnpinLatchedFrame(frame_id, false);
+    }
+    ReleaseFrames(&frames, &lock);
+    metrics_.fetch_failures_.Add();
+    return {};
   }
+  replacer_->PinFrames(hit_frames.data(), hit_frames.size());
+  for (frame_id_t frame_id : ring_frames) {
+    // a ring that reused its slot meanwhile took care of the frame already
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+    if (GetFrameLatch(frame_id).ring_owner_ != nullptr) AdoptRingFrame(frame_id);
+  }
+  metrics_.hits_.Add(hits);
+  metrics_.misses_.Add(misses.size());
+
+  std::vector<frame_id_t> miss_frames;
+  miss_frames.reserve(misses.size());
+  for (size_t i = 0; i < misses.size(); i++) {
+    MapPage(frames[i].first, misses[i], nullptr);
+    replacer_->SetFramePage(frames[i].first, misses[i]);
+    miss_frames.push_back(frames[i].first);
+  }
+  replacer_->PinFrames(miss_frames.data(), miss_frames.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (frame_ids[i] != -1) continue;
+    GetPageTable()->Find(page_ids[i], &frame_ids[i]);
+    if (missing.erase(page_ids[i]) > 0) continue;  // the first occurrence of the page took the pin of MapPage()
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_ids[i]).latch_);
+    GetFrame(frame_ids[i])->pin_count_++;
+  }
+  lock.unlock();
+
+  FinishBatchIo(frames, true);
+  if (!misses.empty()) {
+    auto latency = std::chrono::steady_clock::now() - start;
+    for (size_t i = 0; i < misses.size(); i++) metrics_.miss_latency_.Record(latency);
+  }
+
+  std::vector<Page *> pages;
+  pages.reserve(page_ids.size());
+  for (frame_id_t frame_id : frame_ids) {
+    // other threads may still be loading some of the resident pages
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    std::unique_lock<std::mutex> frame_lock(frame_latch.latch_);
+    frame_latch.io_done_.wait(frame_lock, [&frame_latch] { return !frame_latch.io_in_progress_; });
+    CopyMappedPage(frame_id);
+    pages.push_back(GetFrame(frame_id));
+  }
+  for (page_id_t page_id : page_ids) Trace(TraceOp::FETCH, page_id);
+  return pages;
+}
+
+auto BufferPoolManagerInstance::NewPages(size_t num_pages, std::vector<page_id_t> *page_ids) -> std::vector<Page *> {
+  page_ids->clear();
+  if (num_pages == 0) return {};
+  std::unique_lock<std::mutex> lock = LockLatch();
+
+  std::vector<std::pair<frame_id_t, page_id_t>> frames;
+  while (!AcquireFrames(num_pages, &frames)) {
+    ReleaseFrames(&frames, &lock);
+    if (!WaitForCleaning(&lock)) {
+      metrics_.new_page_failures_.Add();
+      return {};
+    }
+  }
+  metrics_.new_pages_.Add(num_pages);
+
+  std::vector<Page *> pages;
+  std::vector<frame_id_t> frame_ids;
+  pages.reserve(num_pages);
+  frame_ids.reserve(num_pages);
+  for (const auto &[frame_id, writeback_page_id] : frames) {
+    page_id_t page_id = AllocatePage();
+    pages.push_back(MapPage(frame_id, page_id, nullptr));
+    replacer_->SetFramePage(frame_id, page_id);
+    page_ids->push_back(page_id);
+    frame_ids.push_back(frame_id);
+  }
+  replacer_->PinFrames(frame_ids.data(), frame_ids.size());
+  lock.unlock();
+
+  FinishBatchIo(frames, false);
+  for (page_id_t page_id : *page_ids) Trace(TraceOp::NEW, page_id);
+  return pages;
+}
+
+auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == -1) return false;
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t pages_written = 0;
+  if (FlushResidentPages({page_id}, &lock, &pages_written).empty()) return false;
+  Trace(TraceOp::FLUSH, page_id);
+  return true;
+}
 
-  if (!num_free_pages) return nullptr;
+void BufferPoolManagerInstance::FlushAllPgsImp() { FlushAllDirtyPages(); }
+
+auto BufferPoolManagerInstance::FlushAllDirtyPages() -> size_t {
+  std::unique_lock<std::mutex> lock(latch_);
+  std::vector<page_id_t> dirty_pages;
+  for (size_t frame_id = 0; frame_id < pool_size_; ++frame_id) {
+    Page *page = GetFrame(static_cast<frame_id_t>(frame_id));
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(static_cast<frame_id_t>(frame_id)).latch_);
+    if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) dirty_pages.push_back(page->page_id_);
+  }
+  size_t pages_written = 0;
+  FlushResidentPages(std::move(dirty_pages), &lock, &pages_written);
+  return (pages_written + WriteFreePageMap()) * BUSTUB_PAGE_SIZE;
+}
+
+auto BufferPoolManagerInstance::FlushResidentPages(std::vector<page_id_t> page_ids, std::unique_lock<std::mutex> *lock,
+                                                   size_t *pages_written) -> std::vector<page_id_t> {
+  // in page id order consecutive pages become a single vectored write, and the disk sees one sequential pass
+  std::sort(page_ids.begin(), page_ids.end());
+  page_ids.erase(std::unique(page_ids.begin(), page_ids.end()), page_ids.end());
+  std::vector<std::pair<page_id_t, frame_id_t>> resident;
+  while (true) {
+    resident.clear();
+    FrameLatch *cleaned_latch = nullptr;
+    for (page_id_t page_id : page_ids) {
+      frame_id_t frame_id = -1;
+      if (page_id == INVALID_PAGE_ID || !GetPageTable()->Find(page_id, &frame_id)) continue;
+      resident.emplace_back(page_id, frame_id);
+      std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+      if (GetFrameLatch(frame_id).cleaning_) cleaned_latch = &GetFrameLatch(frame_id);
+    }
+    if (cleaned_latch == nullptr) break;
+    // the page cleaner or another flush is writing the page; it is written again once that write is done, with no
+    // frame marked by this flush meanwhile, so that two flushes never wait for each other
+    std::unique_lock<std::mutex> frame_lock(cleaned_latch->latch_);
+    metrics_.cleaning_waits_.Add();
+    lock->unlock();
+    cleaned_latch->io_done_.wait(frame_lock, [cleaned_latch] { return !cleaned_latch->cleaning_; });
+    frame_lock.unlock();
+    lock->lock();
+  }
+
+  std::vector<DiskRequest> requests;
+  std::vector<std::vector<frame_id_t>> request_frames;
+  for (auto [page_id, frame_id] : resident) PrepareFlush(frame_id, &requests, &request_frames);
+  if (!requests.empty()) {
+    std::scoped_lock<std::mutex> cleaner_lock(cleaner_latch_);
+    for (const auto &frames : request_frames) cleaning_frames_ += frames.size();
+  }
+  lock->unlock();
+
+  std::vector<page_id_t> resident_page_ids;
+  resident_page_ids.reserve(resident.size());
+  for (auto [page_id, frame_id] : resident) resident_page_ids.push_back(page_id);
+  *pages_written = 0;
+  if (requests.empty()) return resident_page_ids;
+
+  *pages_written = PersistFreePageMap(resident_page_ids.data(), resident_page_ids.size());
+  std::unique_ptr<bool[]> failed(new bool[requests.size()]());
+  for (size_t i = 0; i < requests.size(); i++) requests[i].failed_ = &failed[i];
+  disk_scheduler_->ScheduleAndWait(std::move(requests));
+  for (size_t i = 0; i < request_frames.size(); i++) {
+    if (!failed[i]) *pages_written += request_frames[i].size();
+    for (frame_id_t frame_id : request_frames[i]) FinishCleaning(frame_id, failed[i]);
+  }
+  return resident_page_ids;
+}
+
+auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
+  if (IsFreePageMapPage(page_id)) return false;
+  std::unique_lock<std::mutex> lock(latch_);
 
   frame_id_t frame_id = -1;
+  while (GetPageTable()->Find(page_id, &frame_id)) {
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    std::unique_lock<std::mutex> frame_lock(frame_latch.latch_);
+    if (frame_latch.cleaning_) {
+      // the page cleaner is writing the page out; by the time it is done the page may be pinned or gone
+      metrics_.cleaning_waits_.Add();
+      lock.unlock();
+      frame_latch.io_done_.wait(frame_lock, [&frame_latch] { return !frame_latch.cleaning_; });
+      frame_lock.unlock();
+      lock.lock();
+      continue;
+    }
+    if (GetFrame(frame_id)->GetPinCount() > 0) return false;
+    RemovePage(frame_id, page_id);
+    break;
+  }
+  DeallocatePage(page_id);
+  Trace(TraceOp::DELETE, page_id);
+  return true;
+}
+
+auto BufferPoolManagerInstance::DeletePages(const std::vector<page_id_t> &page_ids) -> bool {
+  for (page_id_t page_id : page_ids) {
+    if (IsFreePageMapPage(page_id)) return false;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+
+  std::vector<std::pair<frame_id_t, page_id_t>> frames;
+  std::vector<std::unique_lock<std::mutex>> frame_locks;
+  while (true) {
+    frames.clear();
+    for (page_id_t page_id : page_ids) {
+      frame_id_t frame_id = -1;
+      if (GetPageTable()->Find(page_id, &frame_id)) frames.emplace_back(frame_id, page_id);
+    }
+    // in frame order like LatchAllFrames(), the other holder of several frame latches, both under the latch
+    std::sort(frames.begin(), frames.end());
+    frame_locks.clear();
+    FrameLatch *cleaned_latch = nullptr;
+    for (auto [frame_id, page_id] : frames) {
+      frame_locks.emplace_back(GetFrameLatch(frame_id).latch_);
+      if (GetFrameLatch(frame_id).cleaning_) {
+        cleaned_latch = &GetFrameLatch(frame_id);
+        break;
+      }
+      if (GetFrame(frame_id)->GetPinCount() > 0) return false;
+    }
+    if (cleaned_latch == nullptr) break;
+    // wait for the page cleaner with no other latch held, then check all the pages again
+    std::unique_lock<std::mutex> frame_lock = std::move(frame_locks.back());
+    frame_locks.clear();
+    metrics_.cleaning_waits_.Add();
+    lock.unlock();
+    cleaned_latch->io_done_.wait(frame_lock, [cleaned_latch] { return !cleaned_latch->cleaning_; });
+    frame_lock.unlock();
+    lock.lock();
+  }
+
+  for (auto [frame_id, page_id] : frames) RemovePage(frame_id, page_id);
+  frame_locks.clear();
+  for (page_id_t page_id : page_ids) {
+    DeallocatePage(page_id);
+    Trace(TraceOp::DELETE, page_id);
+  }
+  return true;
+}
+
+auto BufferPoolManagerInstance::FlushPages(const std::vector<page_id_t> &page_ids) -> size_t {
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t pages_written = 0;
+  std::vector<page_id_t> resident = FlushResidentPages(page_ids, &lock, &pages_written);
+  for (page_id_t page_id : resident) Trace(TraceOp::FLUSH, page_id);
+  return resident.size();
+}
+
+void BufferPoolManagerInstance::RemovePage(frame_id_t frame_id, page_id_t page_id) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (frame_latch.ring_owner_ != nullptr) {
+    frame_latch.ring_owner_ = nullptr;
+    if (!frame_latch.retiring_) unpinned_frames_++;  // ring frames are not counted, free frames are
+  }
+  replacer_->Remove(frame_id);
+  ClearFramePriority(&frame_latch);
+  frame_latch.mapped_data_ = nullptr;
+
+  Page *page = GetFrame(frame_id);
+  page->ResetMemory();
+  page->page_id_ = INVALID_PAGE_ID;
+  page->pin_count_ = 0;
+  page->is_dirty_ = false;
+
+  GetPageTable()->Erase(page_id);
+  if (!frame_latch.retiring_) free_list_.push_back(frame_id);  // a retiring frame is left empty for the shrink
+}
+
+auto BufferPoolManagerInstance::GetMetrics() -> BufferPoolMetricsSnapshot {
+  BufferPoolMetricsSnapshot snapshot = metrics_.Snapshot();
+  snapshot.cold_evictions_ = replacer_->GetColdEvictionCount();
+  snapshot.replacer_k_ = replacer_->GetK();
+  snapshot.pool_size_ = pool_size_;
+  snapshot.unpinned_frames_ = unpinned_frames_;
+  snapshot.evictable_frames_ = replacer_->Size();
+  if (compressed_cache_ != nullptr) {
+    snapshot.compressed_pages_ = compressed_cache_->GetPageCount();
+    snapshot.compressed_bytes_ = compressed_cache_->GetSize();
+  }
+  if (checksums_ != nullptr) snapshot.checksum_failures_ = checksums_->GetFailureCount();
+  return snapshot;
+}
+
+auto BufferPoolManagerInstance::LockLatch() -> std::unique_lock<std::mutex> {
+  std::unique_lock<std::mutex> lock(latch_, std::try_to_lock);
+  if (lock.owns_lock()) return lock;
+  // only a contended latch pays for reading the clock
+  auto start = std::chrono::steady_clock::now();
+  lock.lock();
+  metrics_.latch_wait_.Record(std::chrono::steady_clock::now() - start);
+  return lock;
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *writeback_page_id) -> bool {
+  *writeback_page_id = INVALID_PAGE_ID;
   if (!free_list_.empty()) {
-    frame_id = free_list_.front();
+    *frame_id = free_list_.front();
     free_list_.pop_front();
-  } else {
-    replacer_->Evict(&frame_id);
-    Page *evicted_page = &pages_[frame_id];
+    unpinned_frames_--;
+    return true;
+  }
+
+  while (true) {
+    if (!replacer_->Evict(frame_id)) return false;
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(*frame_id).latch_);
+    Page *evicted_page = GetFrame(*frame_id);
+    if (evicted_page->GetPinCount() > 0) {
+      // a lock-free hit pinned the victim while it was being evicted, take the eviction back and pick another one
+      replacer_->Reinstate(*frame_id, evicted_page->GetPageId());
+      replacer_->SetPriority(*frame_id, GetFrameLatch(*frame_id).priority_);
+      continue;
+    }
+    unpinned_frames_--;
     page_id_t evicted_page_id = evicted_page->GetPageId();
+    bool evicted_mapped = GetFrameLatch(*frame_id).mapped_data_ != nullptr;
+    *writeback_page_id = DetachPage(*frame_id);
+    metrics_.evictions_.Add();
+    if (*writeback_page_id != INVALID_PAGE_ID) {
+      metrics_.dirty_evictions_.Add();
+    } else if (compressed_cache_ != nullptr && !evicted_mapped) {
+      // only a copy under the latch, FinishIo() and FinishBatchIo() compress it
+      compressed_cache_->Insert(evicted_page_id, evicted_page->GetData());
+    }
+    return true;
+  }
+}
+
+auto BufferPoolManagerInstance::WaitForCleaning(std::unique_lock<std::mutex> *lock) -> bool {
+  std::unique_lock<std::mutex> cleaner_lock(cleaner_latch_);
+  if (cleaning_frames_ == 0) return false;
+  metrics_.cleaning_waits_.Add();
+  size_t cleaned_frames = cleaned_frames_;
+  lock->unlock();
+  cleaning_done_.wait(cleaner_lock, [this, cleaned_frames] { return cleaned_frames_ != cleaned_frames; });
+  cleaner_lock.unlock();
+  lock->lock();
+  return true;
+}
 
-    if (evicted_page->IsDirty()) {
-      disk_manager_->WritePage(evicted_page_id, evicted_page->GetData());
-      evicted_page->is_dirty_ = false;
+auto BufferPoolManagerInstance::AcquireRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id,
+                                                 page_id_t *writeback_page_id) -> bool {
+  BufferAccessStrategy::Ring &ring = strategy->GetRing(instance_index_);
+  if (ring.frames_.size() < strategy->GetRingSize()) {
+    if (!AcquireFrame(frame_id, writeback_page_id)) return false;
+    ring.frames_.push_back(*frame_id);
+    return true;
+  }
+
+  size_t slot = ring.next_;
+  ring.next_ = (ring.next_ + 1) % ring.frames_.size();
+  frame_id_t ring_frame_id = ring.frames_[slot];
+  {
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(ring_frame_id).latch_);
+    if (GetFrameLatch(ring_frame_id).ring_owner_ == strategy) {
+      if (GetFrame(ring_frame_id)->pin_count_ == 0 && !GetFrameLatch(ring_frame_id).retiring_ &&
+          !GetFrameLatch(ring_frame_id).cleaning_) {
+        *frame_id = ring_frame_id;
+        *writeback_page_id = DetachPage(ring_frame_id);
+        metrics_.evictions_.Add();
+        if (*writeback_page_id != INVALID_PAGE_ID) metrics_.dirty_evictions_.Add();
+        return true;
+      }
+      AdoptRingFrame(ring_frame_id);  // the scan still holds or a flush writes this page, let the replacer take it
     }
+  }
 
-    evicted_page->ResetMemory();
+  if (!AcquireFrame(frame_id, writeback_page_id)) {
+    // the slot's frame is gone, the ring shrinks and grows back on the next miss
+    ring.frames_.erase(ring.frames_.begin() + slot);
+    ring.next_ = slot < ring.frames_.size() ? slot : 0;
+    return false;
+  }
+  ring.frames_[slot] = *frame_id;
+  return true;
+}
+
+auto BufferPoolManagerInstance::AcquireFrames(size_t num_frames, std::vector<std::pair<frame_id_t, page_id_t>> *frames)
+    -> bool {
+  frames->clear();
+  // checked before the first eviction, a batch that cannot fit leaves the replacer as it was; the replacer's size
+  // counts the pinned frames it still holds evictable too
+  if (unpinned_frames_.load() < num_frames || free_list_.size() + replacer_->Size() < num_frames) return false;
+  frames->reserve(num_frames);
+  while (frames->size() < num_frames) {
+    frame_id_t frame_id = -1;
+    page_id_t writeback_page_id = INVALID_PAGE_ID;
+    if (!AcquireFrame(&frame_id, &writeback_page_id)) return false;  // lock-free hits pinned frames since the check
+    frames->emplace_back(frame_id, writeback_page_id);
+  }
+  return true;
+}
 
-    page_table_.erase(evicted_page_id);
+void BufferPoolManagerInstance::ReleaseFrames(std::vector<std::pair<frame_id_t, page_id_t>> *frames,
+                                              std::unique_lock<std::mutex> *lock) {
+  std::vector<DiskRequest> writebacks;
+  std::vector<page_id_t> writeback_page_ids;
+  for (const auto &[frame_id, writeback_page_id] : *frames) {
+    if (writeback_page_id == INVALID_PAGE_ID) continue;
+    writebacks.push_back({true, GetFrame(frame_id)->GetData(), writeback_page_id,
+                          [this, page_id = writeback_page_id] { FinishWriteback(page_id); }});
+    writeback_page_ids.push_back(writeback_page_id);
   }
+  if (!writebacks.empty()) {
+    // the frames are on no list meanwhile, nobody else can hand them out before their pages are on disk
+    lock->unlock();
+    PersistFreePageMap(writeback_page_ids.data(), writeback_page_ids.size());
+    disk_scheduler_->ScheduleAndWait(std::move(writebacks));
+    lock->lock();
+  }
+  for (const auto &acquired : *frames) {
+    free_list_.push_back(acquired.first);
+    unpinned_frames_++;
+  }
+  frames->clear();
+}
 
-  page_table_.emplace(page_id, frame_id);
-  Page *page = &pages_[frame_id];
-  page->page_id_ = page_id;
-  page->pin_count_ = 1;
-  disk_manager_->ReadPage(page_id, page->GetData());
+auto BufferPoolManagerInstance::DetachPage(frame_id_t frame_id) -> page_id_t {
+  Page *page = GetFrame(frame_id);
+  page_id_t page_id = page->GetPageId();
+  page_id_t writeback_page_id = INVALID_PAGE_ID;
+  if (page->IsDirty()) {
+    // the data stays in the frame until FinishIo() has written it out
+    writeback_page_id = page_id;
+    std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+    writeback_pages_.insert(page_id);
+    page->is_dirty_ = false;
+  }
+  page->page_id_ = INVALID_PAGE_ID;  // makes optimistic lookups of the old page fail validation
+  GetPageTable()->Erase(page_id);
+  ClearFramePriority(&GetFrameLatch(frame_id));
+  GetFrameLatch(frame_id).mapped_data_ = nullptr;
+  return writeback_page_id;
+}
 
+void BufferPoolManagerInstance::AdoptRingFrame(frame_id_t frame_id) {
+  Page *page = GetFrame(frame_id);
+  GetFrameLatch(frame_id).ring_owner_ = nullptr;
+  replacer_->SetFramePage(frame_id, page->page_id_);
   replacer_->RecordAccess(frame_id);
+  if (page->pin_count_ == 0 && !GetFrameLatch(frame_id).retiring_) {
+    // a frame being flushed is handed to the replacer once the write is done
+    if (!GetFrameLatch(frame_id).cleaning_) replacer_->SetEvictable(frame_id, true);
+    unpinned_frames_++;
+  }
+}
+
+auto BufferPoolManagerInstance::InstallPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy,
+                                            bool prefetch) -> Page * {
+  Page *page = MapPage(frame_id, page_id, strategy);
+  if (strategy != nullptr) return page;
+  replacer_->SetFramePage(frame_id, page_id);
+  if (prefetch) {
+    replacer_->RecordPrefetch(frame_id);
+  } else {
+    replacer_->RecordAccess(frame_id);
+  }
   replacer_->SetEvictable(frame_id, false);
+  return page;
+}
 
+auto BufferPoolManagerInstance::MapPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy)
+    -> Page * {
+  GetPageTable()->Insert(page_id, frame_id);
+  Page *page = GetFrame(frame_id);
+  {
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+    page->page_id_ = page_id;
+    page->pin_count_ = 1;
+    GetFrameLatch(frame_id).io_in_progress_ = true;
+    GetFrameLatch(frame_id).ring_owner_ = strategy;
+  }
   return page;
 }
 
-auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+auto BufferPoolManagerInstance::TryLatchFrame(page_id_t page_id, frame_id_t *frame_id,
+                                              std::unique_lock<std::mutex> *frame_lock) -> bool {
+  if (!GetPageTable()->Find(page_id, frame_id)) return false;
+  *frame_lock = std::unique_lock<std::mutex>(GetFrameLatch(*frame_id).latch_);
+  // a frame id beyond the pool size belongs to a chunk a shrink released, its page must not be touched
+  if (static_cast<size_t>(*frame_id) < pool_size_ && GetFrame(*frame_id)->page_id_ == page_id) return true;
+  frame_lock->unlock();  // the frame was recycled after the lookup
+  return false;
+}
+
+auto BufferPoolManagerInstance::PinLatchedFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *frame_lock,
+                                                BufferAccessStrategy *strategy, const char **mapped_data) -> Page * {
+  Page *page = PinHitFrame(frame_id, strategy);
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  // another thread may still be loading the page into this frame
+  frame_latch.io_done_.wait(*frame_lock, [&frame_latch] { return !frame_latch.io_in_progress_; });
+  if (mapped_data == nullptr) {
+    CopyMappedPage(frame_id);
+  } else {
+    *mapped_data = frame_latch.mapped_data_ != nullptr ? frame_latch.mapped_data_ : page->GetData();
+  }
+  Trace(strategy == nullptr ? TraceOp::FETCH : TraceOp::FETCH_STRATEGY, page->page_id_);
+  return page;
+}
+
+auto BufferPoolManagerInstance::PinHitFrame(frame_id_t frame_id, BufferAccessStrategy *strategy) -> Page * {
+  metrics_.hits_.Add();
+  Page *page = GetFrame(frame_id);
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (strategy == nullptr && frame_latch.ring_owner_ != nullptr) {
+    // a page a scan brought in turns out to be wanted by others, the pool keeps it from now on
+    page->pin_count_++;
+    AdoptRingFrame(frame_id);
+  } else {
+    if (strategy == nullptr) replacer_->RecordAccess(frame_id);
+    // the frame stays evictable in the replacer, AcquireFrame() takes back the eviction of a pinned frame
+    if (page->pin_count_++ == 0 && frame_latch.ring_owner_ == nullptr && !frame_latch.retiring_) unpinned_frames_--;
+  }
+  return page;
+}
+
+void BufferPoolManagerInstance::CopyMappedPage(frame_id_t frame_id) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (frame_latch.mapped_data_ == nullptr) return;
+  // readers of the mapping keep reading it, they hold the page's read latch until they are done
+  std::memcpy(GetFrame(frame_id)->GetData(), frame_latch.mapped_data_, BUSTUB_PAGE_SIZE);
+  frame_latch.mapped_data_ = nullptr;
+}
+
+void BufferPoolManagerInstance::FinishIo(frame_id_t frame_id, page_id_t writeback_page_id, bool read_page) {
+  Page *page = GetFrame(frame_id);
+  DiskRequest writeback{true, page->GetData(), writeback_page_id,
+                        [this, writeback_page_id] { FinishWriteback(writeback_page_id); }};
+  if (writeback_page_id != INVALID_PAGE_ID) PersistFreePageMap(&writeback_page_id, 1);
+  bool mapped = GetFrameLatch(frame_id).mapped_data_ != nullptr;
+  if (read_page && !mapped && writeback_page_id != INVALID_PAGE_ID) {
+    // the cached image is taken aside, the frame still holds the evicted page
+    std::vector<char> cached;
+    if (compressed_cache_ != nullptr) {
+      cached.resize(BUSTUB_PAGE_SIZE);
+      if (!compressed_cache_->Take(page->GetPageId(), cached.data())) cached.clear();
+    }
+    if (cached.empty()) {
+      // the read starts from the disk scheduler as soon as the write-back is done, no round trip in between
+      writeback.link_next_ = true;
+      disk_scheduler_->ScheduleAndWait({std::move(writeback), {false, page->GetData(), page->GetPageId(), nullptr}});
+    } else {
+      disk_scheduler_->ScheduleAndWait({std::move(writeback)});
+      std::memcpy(page->GetData(), cached.data(), BUSTUB_PAGE_SIZE);
+      metrics_.compressed_hits_.Add();
+    }
+  } else {
+    if (writeback_page_id != INVALID_PAGE_ID) disk_scheduler_->ScheduleAndWait({std::move(writeback)});
+    if (!read_page) {
+      page->ResetMemory();
+    } else if (mapped) {
+      // read through the mapping instead; a cached image would go stale once the page is written back
+      if (compressed_cache_ != nullptr) compressed_cache_->Erase(page->GetPageId());
+      if (checksums_ != nullptr) checksums_->Verify(page->GetPageId(), GetFrameLatch(frame_id).mapped_data_);
+    } else if (!TakeCompressedPage(page)) {
+      disk_scheduler_->ScheduleAndWait({{false, page->GetData(), page->GetPageId(), nullptr}});
+    }
+  }
+
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  std::vector<std::function<void()>> waiters;
+  {
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    frame_latch.io_in_progress_ = false;
+    waiters.swap(frame_latch.io_waiters_);
+  }
+  NotifyIoDone(&frame_latch, std::move(waiters));
+  if (compressed_cache_ != nullptr) compressed_cache_->CompressPending();
+}
+
+auto BufferPoolManagerInstance::TakeCompressedPage(Page *page) -> bool {
+  if (compressed_cache_ == nullptr || !compressed_cache_->Take(page->GetPageId(), page->GetData())) return false;
+  metrics_.compressed_hits_.Add();
+  return true;
+}
+
+void BufferPoolManagerInstance::FinishBatchIo(const std::vector<std::pair<frame_id_t, page_id_t>> &frames,
+                                              bool read_pages) {
+  std::vector<DiskRequest> writebacks;
+  std::vector<page_id_t> writeback_page_ids;
+  for (const auto &[frame_id, writeback_page_id] : frames) {
+    if (writeback_page_id == INVALID_PAGE_ID) continue;
+    writebacks.push_back({true, GetFrame(frame_id)->GetData(), writeback_page_id,
+                          [this, page_id = writeback_page_id] { FinishWriteback(page_id); }});
+    writeback_page_ids.push_back(writeback_page_id);
+  }
+  // the reads must not overwrite a frame before its evicted page is on disk
+  if (!writebacks.empty()) {
+    PersistFreePageMap(writeback_page_ids.data(), writeback_page_ids.size());
+    disk_scheduler_->ScheduleAndWait(std::move(writebacks));
+  }
+
+  if (read_pages) {
+    std::vector<std::pair<page_id_t, frame_id_t>> loads;
+    loads.reserve(frames.size());
+    for (const auto &frame : frames) {
+      Page *page = GetFrame(frame.first);
+      if (!TakeCompressedPage(page)) loads.emplace_back(page->GetPageId(), frame.first);
+    }
+    std::vector<std::vector<frame_id_t>> request_frames;
+    disk_scheduler_->ScheduleAndWait(CoalesceReads(std::move(loads), &request_frames));
+  } else {
+    for (const auto &frame : frames) GetFrame(frame.first)->ResetMemory();
+  }
+
+  for (const auto &frame : frames) {
+    FrameLatch &frame_latch = GetFrameLatch(frame.first);
+    std::vector<std::function<void()>> waiters;
+    {
+      std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+      frame_latch.io_in_progress_ = false;
+      waiters.swap(frame_latch.io_waiters_);
+    }
+    NotifyIoDone(&frame_latch, std::move(waiters));
+  }
+  if (compressed_cache_ != nullptr) compressed_cache_->CompressPending();
+}
+
+auto BufferPoolManagerInstance::CoalesceReads(std::vector<std::pair<page_id_t, frame_id_t>> loads,
+                                              std::vector<std::vector<frame_id_t>> *request_frames)
+    -> std::vector<DiskRequest> {
+  std::sort(loads.begin(), loads.end());
+  std::vector<DiskRequest> requests;
+  request_frames->clear();
+  for (const auto &[page_id, frame_id] : loads) {
+    char *data = GetFrame(frame_id)->GetData();
+    if (!requests.empty()) {
+      DiskRequest &last = requests.back();
+      if (last.NumPages() < DiskScheduler::MAX_PAGES_PER_REQUEST &&
+          last.page_id_ + static_cast<page_id_t>(last.NumPages()) == page_id) {
+        last.next_data_.push_back(data);
+        request_frames->back().push_back(frame_id);
+        continue;
+      }
+    }
+    requests.push_back({false, data, page_id, nullptr});
+    request_frames->push_back({frame_id});
+  }
+  return requests;
+}
+
+void BufferPoolManagerInstance::FinishWriteback(page_id_t page_id) {
+  {
+    std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+    writeback_pages_.erase(page_id);
+    // the page was deleted meanwhile, its id can be handed out again now that no older image is on its way to disk
+    if (pending_free_pages_.erase(page_id) > 0) released_free_pages_.push_back(page_id);
+  }
+  writeback_done_.notify_all();
+}
+
+void BufferPoolManagerInstance::PrepareFlush(frame_id_t frame_id, std::vector<DiskRequest> *requests,
+                                             std::vector<std::vector<frame_id_t>> *request_frames) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  // held until the frame is marked, an unpin marking the page dirty meanwhile is not lost
+  std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+  // a frame that is being loaded holds either the on-disk image or a zeroed new page, neither needs a flush
+  if (frame_latch.io_in_progress_) return;
+  // a mapped page is the disk image itself
+  if (frame_latch.mapped_data_ != nullptr) return;
+  Page *page = GetFrame(frame_id);
+  StartCleaning(frame_id);
+  if (!requests->empty()) {
+    DiskRequest &last = requests->back();
+    if (last.NumPages() < DiskScheduler::MAX_PAGES_PER_REQUEST &&
+        last.page_id_ + static_cast<page_id_t>(last.NumPages()) == page->page_id_) {
+      last.next_data_.push_back(page->data_);
+      request_frames->back().push_back(frame_id);
+      return;
+    }
+  }
+  requests->push_back({true, page->data_, page->page_id_, nullptr});
+  request_frames->push_back({frame_id});
+}
+
+void BufferPoolManagerInstance::StartCleaning(frame_id_t frame_id) {
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  Page *page = GetFrame(frame_id);
+  frame_latch.cleaning_ = true;
+  page->is_dirty_ = false;
+  // nobody latches an unpinned page, so this never blocks; it keeps writers out until the page is written. A pinned
+  // page may be latched by the caller itself, it is written as it is
+  frame_latch.cleaning_latched_ = page->pin_count_ == 0;
+  if (frame_latch.cleaning_latched_) page->RLatch();
+  // even a pinned frame, a hit leaves it evictable in the replacer and its unpin would not tell it otherwise
+  if (frame_latch.ring_owner_ == nullptr && !frame_latch.retiring_) replacer_->SetEvictable(frame_id, false);
+}
+
+void BufferPoolManagerInstance::FinishCleaning(frame_id_t frame_id, bool failed) {
+  Page *page = GetFrame(frame_id);
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  if (frame_latch.cleaning_latched_) page->RUnlatch();
+  {
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    // the page stays dirty until a write goes through, or an eviction would drop its changes
+    if (failed) page->is_dirty_ = true;
+    frame_latch.cleaning_ = false;
+    frame_latch.cleaning_latched_ = false;
+    if (page->pin_count_ == 0 && frame_latch.ring_owner_ == nullptr && !frame_latch.retiring_) {
+      replacer_->SetEvictable(frame_id, true);
+    }
+  }
+  frame_latch.io_done_.notify_all();
+  {
+    std::scoped_lock<std::mutex> cleaner_lock(cleaner_latch_);
+    cleaning_frames_--;
+    cleaned_frames_++;
+  }
+  cleaning_done_.notify_all();
+}
+
+void BufferPoolManagerInstance::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  for (page_id_t page_id : page_ids) {
+    if (page_id == INVALID_PAGE_ID || IsFreePageMapPage(page_id)) continue;
+    std::unique_lock<std::mutex> lock(latch_);
+    frame_id_t frame_id = -1;
+    // a page still being written back cannot be read yet, the fetch will wait for it instead
+    if (GetPageTable()->Find(page_id, &frame_id)) continue;
+    {
+      std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+      if (writeback_pages_.count(page_id) > 0) continue;
+    }
+
+    page_id_t writeback_page_id = INVALID_PAGE_ID;
+    if (!AcquireFrame(&frame_id, &writeback_page_id)) break;
+    InstallPage(frame_id, page_id, nullptr, true);
+    lock.unlock();
+    Trace(TraceOp::PREFETCH, page_id);
+    ScheduleRead(frame_id, writeback_page_id, [this, frame_id] { FinishPrefetch(frame_id); });
+  }
+  if (compressed_cache_ != nullptr) compressed_cache_->CompressPending();
+}
+
+auto BufferPoolManagerInstance::EnableIoUring(const std::string &db_file, bool direct_io) -> bool {
+  delete disk_scheduler_;
+  disk_scheduler_ = new DiskScheduler(disk_manager_, db_file, direct_io);
+  disk_scheduler_->SetChecksums(checksums_);
+  return disk_scheduler_->UsesIoUring();
+}
+
+void BufferPoolManagerInstance::ScheduleRead(frame_id_t frame_id, page_id_t writeback_page_id,
+                                             std::function<void()> on_read) {
+  Page *page = GetFrame(frame_id);
+  // a cached page is restored right away, which is cheaper than handing it to the disk scheduler
+  if (writeback_page_id == INVALID_PAGE_ID && TakeCompressedPage(page)) {
+    on_read();
+    return;
+  }
+  DiskRequest read{false, page->GetData(), page->page_id_, std::move(on_read)};
+  if (writeback_page_id == INVALID_PAGE_ID) {
+    disk_scheduler_->Schedule(std::move(read));
+    return;
+  }
+
+  // the read must not overwrite the frame before the evicted page is on disk
+  PersistFreePageMap(&writeback_page_id, 1);
+  disk_scheduler_->Schedule({true, page->GetData(), writeback_page_id, [this, writeback_page_id, read]() mutable {
+                               FinishWriteback(writeback_page_id);
+                               disk_scheduler_->Schedule(std::move(read));
+                             }});
+}
+
+void BufferPoolManagerInstance::FinishPrefetch(frame_id_t frame_id) {
+  Page *page = GetFrame(frame_id);
+  FrameLatch &frame_latch = GetFrameLatch(frame_id);
+  std::vector<std::function<void()>> waiters;
+  {
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    frame_latch.io_in_progress_ = false;
+    waiters.swap(frame_latch.io_waiters_);
+    if (--page->pin_count_ == 0 && !frame_latch.retiring_) {
+      replacer_->SetEvictable(frame_id, true);
+      unpinned_frames_++;
+    }
+  }
+  NotifyIoDone(&frame_latch, std::move(waiters));
+}
+
+auto BufferPoolManagerInstance::GetHotPages() -> std::vector<page_id_t> {
   std::scoped_lock<std::mutex> lock(latch_);
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) return false;
-  frame_id_t frame_id = it->second;
-  Page *page = &pages_[frame_id];
-  if (page->GetPinCount() <= 0) return false;
-  if (is_dirty) page->is_dirty_ = is_dirty;
-  page->pin_count_--;
-  if (page->pin_count_ == 0) replacer_->SetEvictable(frame_id, true);
+  std::vector<frame_id_t> victims(pool_size_);
+  victims.resize(replacer_->PeekVictims(victims.data(), victims.size()));
+  std::vector<bool> evictable(pool_size_, false);
+  for (frame_id_t frame_id : victims) {
+    // a hit leaves a pinned frame evictable in the replacer
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+    evictable[frame_id] = GetFrame(frame_id)->pin_count_ == 0;
+  }
+  auto pinned = [&evictable](frame_id_t frame_id) { return !evictable[frame_id]; };
+  victims.erase(std::remove_if(victims.begin(), victims.end(), pinned), victims.end());
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    if (evictable[i]) continue;
+    std::scoped_lock<std::mutex> frame_lock(GetFrameLatch(frame_id).latch_);
+    Page *page = GetFrame(frame_id);
+    if (page->page_id_ != INVALID_PAGE_ID && GetFrameLatch(frame_id).ring_owner_ == nullptr) {
+      page_ids.push_back(page->page_id_);
+    }
+  }
+  // the last victim is the hottest unpinned page
+  for (auto it = victims.rbegin(); it != victims.rend(); ++it) page_ids.push_back(GetFrame(*it)->page_id_);
+  return page_ids;
+}
+
+auto BufferPoolManagerInstance::DumpHotPages(const std::string &path) -> bool {
+  return HotPageFile::Write(path, GetHotPages());
+}
+
+auto BufferPoolManagerInstance::LoadHotPages(const std::string &path) -> size_t {
+  std::vector<page_id_t> page_ids;
+  if (!HotPageFile::Read(path, &page_ids)) return 0;
+  return WarmUp(page_ids);
+}
+
+auto BufferPoolManagerInstance::WarmUp(const std::vector<page_id_t> &page_ids) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<page_id_t> selected;
+  std::unordered_set<page_id_t> selected_set;
+  for (page_id_t page_id : page_ids) {
+    if (selected.size() == free_list_.size()) break;
+    if (page_id < 0 || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_) continue;
+    frame_id_t frame_id = -1;
+    if (GetPageTable()->Find(page_id, &frame_id) || !selected_set.insert(page_id).second) continue;
+    {
+      std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+      if (writeback_pages_.count(page_id) > 0) continue;
+    }
+    selected.push_back(page_id);
+  }
+
+  // installed coldest first, so that the replacer ranks the pages by the order they were dumped in
+  std::vector<std::pair<page_id_t, frame_id_t>> loads;
+  loads.reserve(selected.size());
+  for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+    frame_id_t frame_id = free_list_.front();
+    free_list_.pop_front();
+    unpinned_frames_--;
+    InstallPage(frame_id, *it, nullptr, true);
+    // the pages are read from disk, a cached image would be stale once they are written back
+    if (compressed_cache_ != nullptr) compressed_cache_->Erase(*it);
+    loads.emplace_back(*it, frame_id);
+  }
+
+  size_t num_loads = loads.size();
+  std::vector<std::vector<frame_id_t>> request_frames;
+  std::vector<DiskRequest> requests = CoalesceReads(std::move(loads), &request_frames);
+  for (size_t i = 0; i < requests.size(); i++) {
+    requests[i].callback_ = [this, frames = std::move(request_frames[i])] {
+      for (frame_id_t frame_id : frames) FinishPrefetch(frame_id);
+    };
+  }
+  disk_scheduler_->Schedule(std::move(requests));
+  return num_loads;
+}
+
+void BufferPoolManagerInstance::ReleaseAccessStrategy(BufferAccessStrategy *strategy) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  BufferAccessStrategy::Ring &ring = strategy->GetRing(instance_index_);
+  if (ring.trace_ring_ != 0) Trace(TraceOp::RELEASE_RING, INVALID_PAGE_ID, ring.trace_ring_);
+  ring.trace_ring_ = 0;
+  for (frame_id_t frame_id : ring.frames_) {
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    // checked first, the frame may belong to a chunk a shrink released
+    if (frame_latch.ring_owner_ != strategy) continue;
+    Page *page = GetFrame(frame_id);
+    if (page->pin_count_ > 0 || page->is_dirty_ || frame_latch.retiring_ || frame_latch.cleaning_) {
+      AdoptRingFrame(frame_id);
+      continue;
+    }
+    frame_latch.ring_owner_ = nullptr;
+    DetachPage(frame_id);
+    free_list_.push_back(frame_id);
+    unpinned_frames_++;
+  }
+  ring.frames_.clear();
+  ring.next_ = 0;
+}
+
+void BufferPoolManagerInstance::StartPageCleaner(size_t clean_low_watermark, size_t max_writes_per_second) {
+  StopPageCleaner();
+  clean_low_watermark_ = clean_low_watermark;
+  max_writes_per_second_ = max_writes_per_second;
+  cleaner_stop_ = false;
+  cleaner_thread_ = std::thread(&BufferPoolManagerInstance::RunPageCleaner, this);
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  if (!cleaner_thread_.joinable()) return;
+  {
+    std::scoped_lock<std::mutex> cleaner_lock(cleaner_latch_);
+    cleaner_stop_ = true;
+  }
+  cleaner_wakeup_.notify_all();
+  cleaner_thread_.join();
+}
+
+void BufferPoolManagerInstance::RunPageCleaner() {
+  // token bucket: the budget grows with the elapsed time and holds at most one second worth of writes
+  const auto max_budget = static_cast<double>(std::max<size_t>(max_writes_per_second_, 1));
+  double budget = 0;
+  auto last_refill = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> cleaner_lock(cleaner_latch_);
+  while (!cleaner_stop_) {
+    cleaner_lock.unlock();
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - last_refill;
+    last_refill = now;
+    budget = std::min(budget + elapsed.count() * static_cast<double>(max_writes_per_second_), max_budget);
+    if (budget >= 1) budget -= static_cast<double>(CleanFrames(static_cast<size_t>(budget)));
+    cleaner_lock.lock();
+    cleaner_wakeup_.wait_for(cleaner_lock, PAGE_CLEANER_INTERVAL, [this] { return cleaner_stop_; });
+  }
+}
+
+auto BufferPoolManagerInstance::CleanFrames(size_t max_writes) -> size_t {
+  std::vector<frame_id_t> frames;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (free_list_.size() >= clean_low_watermark_) return 0;
+    std::vector<frame_id_t> candidates(clean_low_watermark_ - free_list_.size());
+    candidates.resize(replacer_->PeekVictims(candidates.data(), candidates.size()));
+
+    for (frame_id_t frame_id : candidates) {
+      if (frames.size() == max_writes) break;
+      FrameLatch &frame_latch = GetFrameLatch(frame_id);
+      Page *page = GetFrame(frame_id);
+      std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+      if (page->pin_count_ > 0 || !page->is_dirty_ || frame_latch.io_in_progress_ || frame_latch.cleaning_) continue;
+      StartCleaning(frame_id);
+      frames.push_back(frame_id);
+      Trace(TraceOp::CLEAN, page->page_id_);
+    }
+    if (frames.empty()) return 0;
+    std::scoped_lock<std::mutex> cleaner_lock(cleaner_latch_);
+    cleaning_frames_ += frames.size();
+  }
+
+  std::unique_ptr<bool[]> failed(new bool[frames.size()]());
+  std::vector<DiskRequest> requests;
+  std::vector<page_id_t> page_ids;
+  requests.reserve(frames.size());
+  page_ids.reserve(frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    Page *page = GetFrame(frames[i]);
+    requests.push_back({true, page->GetData(), page->page_id_, nullptr});
+    requests.back().failed_ = &failed[i];
+    page_ids.push_back(page->page_id_);
+  }
+  PersistFreePageMap(page_ids.data(), page_ids.size());
+  disk_scheduler_->ScheduleAndWait(std::move(requests));
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    FinishCleaning(frames[i], failed[i]);
+    if (failed[i]) {
+      metrics_.cleaner_write_failures_.Add();
+    } else {
+      metrics_.cleaner_writes_.Add();
+    }
+  }
+  return frames.size();
+}
+
+auto BufferPoolManagerInstance::Resize(size_t new_pool_size) -> bool {
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  if (!IsValidPoolSize(new_pool_size)) return false;
+  size_t num_frames = (new_pool_size + chunk_size_ - 1) / chunk_size_ * chunk_size_;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (shrinking_) return false;
+  }
+  if (shrink_thread_.joinable()) shrink_thread_.join();  // the previous shrink is done, only its exit is left
+
+  if (num_frames > pool_size_) {
+    GrowPool(num_frames);
+  } else if (num_frames < pool_size_) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    StartShrink(num_frames);
+  }
+  if (!sticky_limit_set_) max_sticky_frames_ = num_frames / 4;
   return true;
 }
 
-auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  if (page_id == -1) return false;
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) return false;
-  frame_id_t frame_id = it->second;
-  Page *page = &pages_[frame_id];
-  disk_manager_->WritePage(page_id, page->GetData());
+auto BufferPoolManagerInstance::CanResize(size_t new_pool_size) -> bool {
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  if (!IsValidPoolSize(new_pool_size)) return false;
+  std::scoped_lock<std::mutex> lock(latch_);
+  return !shrinking_;
+}
+
+auto BufferPoolManagerInstance::IsValidPoolSize(size_t new_pool_size) const -> bool {
+  if (chunk_size_ == 0) return false;
+  size_t num_chunks = (new_pool_size + chunk_size_ - 1) / chunk_size_;
+  return num_chunks > 0 && num_chunks <= MAX_FRAME_CHUNKS;
+}
+
+void BufferPoolManagerInstance::GrowPool(size_t num_frames) {
+  const size_t old_pool_size = pool_size_;
+  // the memory is mapped before the pool is stopped, only linking the chunks in happens under the latches
+  std::vector<std::unique_ptr<FrameArena>> arenas;
+  for (size_t chunk = old_pool_size / chunk_size_; chunk < num_frames / chunk_size_; chunk++) {
+    arenas.push_back(std::make_unique<FrameArena>(chunk_size_, arena_options_));
+    if (chunks_[chunk].latches_.load() == nullptr) chunks_[chunk].latches_.store(new FrameLatch[chunk_size_]);
+  }
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto frame_locks = LatchAllFrames();
+  replacer_->Resize(num_frames);
+  PageTable *old_page_table = GetPageTable();
+  if (old_page_table->GetCapacity() < num_frames) {
+    // lookups still probing the old table get a hint that the frame validates, so it is only retired, not freed
+    auto *page_table = new PageTable(std::max(num_frames, 2 * old_page_table->GetCapacity()));
+    for (size_t frame_id = 0; frame_id < old_pool_size; frame_id++) {
+      Page *page = GetFrame(static_cast<frame_id_t>(frame_id));
+      if (page->page_id_ != INVALID_PAGE_ID) page_table->Insert(page->page_id_, static_cast<frame_id_t>(frame_id));
+    }
+    retired_page_tables_.push_back(old_page_table);
+    page_table_.store(page_table, std::memory_order_release);
+  }
+
+  for (size_t chunk = old_pool_size / chunk_size_; chunk < num_frames / chunk_size_; chunk++) {
+    chunks_[chunk].arena_.store(arenas[chunk - old_pool_size / chunk_size_].release(), std::memory_order_release);
+  }
+  for (size_t frame_id = old_pool_size; frame_id < num_frames; frame_id++) {
+    free_list_.push_back(static_cast<frame_id_t>(frame_id));
+  }
+  unpinned_frames_ += num_frames - old_pool_size;
+  target_pool_size_ = num_frames;
+  pool_size_ = num_frames;
+}
+
+void BufferPoolManagerInstance::StartShrink(size_t num_frames) {
+  target_pool_size_ = num_frames;
+  free_list_.remove_if([num_frames](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= num_frames; });
+  for (size_t i = num_frames; i < pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    frame_latch.retiring_ = true;
+    if (frame_latch.ring_owner_ != nullptr) continue;
+    if (GetFrame(frame_id)->pin_count_ == 0) unpinned_frames_--;
+    // a pinned frame too, a hit leaves it evictable in the replacer
+    replacer_->SetEvictable(frame_id, false);
+  }
+  shrinking_ = true;
+  shrink_thread_ = std::thread(&BufferPoolManagerInstance::RunShrink, this);
+}
+
+void BufferPoolManagerInstance::RunShrink() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (!shrink_stop_) {
+    std::vector<FrameArena *> arenas = DrainRetiringFrames(&lock);
+    if (!arenas.empty()) {
+      // nothing can reach the released frames any more, unmapping them can happen without the latch
+      lock.unlock();
+      for (FrameArena *arena : arenas) delete arena;
+      lock.lock();
+      shrinking_ = false;
+      return;
+    }
+    shrink_wakeup_.wait_for(lock, SHRINK_RETRY_INTERVAL, [this] { return shrink_stop_; });
+  }
+}
+
+auto BufferPoolManagerInstance::DrainRetiringFrames(std::unique_lock<std::mutex> *lock) -> std::vector<FrameArena *> {
+  std::vector<DiskRequest> requests;
+  std::vector<page_id_t> writeback_page_ids;
+  bool drained = true;
+  bool cached = false;
+  for (size_t i = target_pool_size_; i < pool_size_; i++) {
+    auto frame_id = static_cast<frame_id_t>(i);
+    FrameLatch &frame_latch = GetFrameLatch(frame_id);
+    Page *page = GetFrame(frame_id);
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    if (page->page_id_ == INVALID_PAGE_ID) continue;
+    if (page->pin_count_ > 0 || frame_latch.io_in_progress_ || frame_latch.cleaning_) {
+      drained = false;
+      continue;
+    }
+    frame_latch.ring_owner_ = nullptr;
+    replacer_->Remove(frame_id);
+    page_id_t page_id = page->page_id_;
+    bool mapped = frame_latch.mapped_data_ != nullptr;
+    page_id_t writeback_page_id = DetachPage(frame_id);
+    if (writeback_page_id != INVALID_PAGE_ID) {
+      requests.push_back(
+          {true, page->GetData(), writeback_page_id, [this, writeback_page_id] { FinishWriteback(writeback_page_id); }});
+      writeback_page_ids.push_back(writeback_page_id);
+    } else if (compressed_cache_ != nullptr && !mapped) {
+      // evicted like any clean page
+      compressed_cache_->Insert(page_id, page->GetData());
+      cached = true;
+    }
+  }
+  if (!requests.empty() || cached) {
+    // the detached frames are out of everyone's reach, a fetch of one of their pages waits for its write-back
+    lock->unlock();
+    if (!requests.empty()) {
+      PersistFreePageMap(writeback_page_ids.data(), writeback_page_ids.size());
+      disk_scheduler_->ScheduleAndWait(std::move(requests));
+    }
+    if (cached) compressed_cache_->CompressPending();
+    lock->lock();
+  }
+  if (!drained) return {};
+
+  auto frame_locks = LatchAllFrames();
+  replacer_->Resize(target_pool_size_);
+  std::vector<FrameArena *> arenas;
+  for (size_t chunk = target_pool_size_ / chunk_size_; chunk < pool_size_ / chunk_size_; chunk++) {
+    arenas.push_back(chunks_[chunk].arena_.exchange(nullptr));
+  }
+  // the latches stay, ready for the chunk to be mapped again
+  for (size_t i = target_pool_size_; i < pool_size_; i++) GetFrameLatch(static_cast<frame_id_t>(i)).retiring_ = false;
+  pool_size_ = target_pool_size_;
+  return arenas;
+}
+
+auto BufferPoolManagerInstance::LatchAllFrames() -> std::vector<std::unique_lock<std::mutex>> {
+  std::vector<std::unique_lock<std::mutex>> frame_locks;
+  frame_locks.reserve(pool_size_);
+  // in frame order; only DeletePages() also holds several frame latches, and both hold the latch
+  for (size_t i = 0; i < pool_size_; i++) frame_locks.emplace_back(GetFrameLatch(static_cast<frame_id_t>(i)).latch_);
+  return frame_locks;
+}
+
+auto BufferPoolManagerInstance::EnableFreePageMap(size_t *free_pages) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  FreePageMap *free_page_map = LoadFreePageMap();
+  if (free_page_map == nullptr) return false;
+  delete free_page_map_;
+  free_page_map_ = free_page_map;
+  if (free_pages != nullptr) *free_pages = free_page_map_->GetFreePageCount();
   return true;
 }
 
-void BufferPoolManagerInstance::FlushAllPgsImp() {
+auto BufferPoolManagerInstance::CanEnableFreePageMap() -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
-  for (size_t frame_id = 0; frame_id < pool_size_; ++frame_id) {
-    FlushPgImp(pages_[frame_id].GetPageId());
+  FreePageMap *free_page_map = LoadFreePageMap();
+  delete free_page_map;
+  return free_page_map != nullptr;
+}
+
+auto BufferPoolManagerInstance::LoadFreePageMap() -> FreePageMap * {
+  auto *free_page_map = new FreePageMap(num_instances_, instance_index_);
+  std::vector<char> data(BUSTUB_PAGE_SIZE);
+  while (true) {
+    // a page past the end of the file is left untouched by the read, zeroes tell it is not a map page
+    std::fill(data.begin(), data.end(), 0);
+    page_id_t map_page_id = free_page_map->GetMapPageId(free_page_map->GetGroupCount());
+    disk_scheduler_->ScheduleAndWait({{false, data.data(), map_page_id, nullptr}});
+    if (!free_page_map->LoadGroup(data.data())) break;
   }
+  if (free_page_map->GetGroupCount() > 0) return free_page_map;
+
+  // without a map, the database must not have any page yet: neither allocated by this pool, nor in the file where
+  // the first page or the first map page go
+  bool empty = next_page_id_.load() == static_cast<page_id_t>(instance_index_) &&
+               std::all_of(data.begin(), data.end(), [](char byte) { return byte == 0; });
+  if (empty) {
+    disk_scheduler_->ScheduleAndWait({{false, data.data(), static_cast<page_id_t>(instance_index_), nullptr}});
+    empty = std::all_of(data.begin(), data.end(), [](char byte) { return byte == 0; });
+  }
+  if (empty) return free_page_map;
+  delete free_page_map;
+  return nullptr;
 }
 
-auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
+auto BufferPoolManagerInstance::WriteFreePageMap() -> size_t {
+  std::scoped_lock<std::mutex> map_write_lock(map_write_latch_);
+  std::vector<page_id_t> map_page_ids;
+  std::vector<char> map_pages;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (free_page_map_ == nullptr) return 0;
+    FreeReleasedPages();
+    free_page_map_->TakeDirtyGroups(&map_page_ids, &map_pages);
+  }
+  if (map_page_ids.empty()) return 0;
+
+  std::unique_ptr<bool[]> failed(new bool[map_page_ids.size()]());
+  std::vector<DiskRequest> requests;
+  for (size_t i = 0; i < map_page_ids.size(); i++) {
+    requests.push_back({true, map_pages.data() + i * BUSTUB_PAGE_SIZE, map_page_ids[i], nullptr});
+    requests.back().failed_ = &failed[i];
+  }
+  disk_scheduler_->ScheduleAndWait(std::move(requests));
+
+  size_t pages_written = 0;
   std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t i = 0; i < map_page_ids.size(); i++) {
+    if (failed[i]) {
+      free_page_map_->MarkDirty(map_page_ids[i]);
+      continue;
+    }
+    free_page_map_->MarkPersisted(map_page_ids[i], map_pages.data() + i * BUSTUB_PAGE_SIZE);
+    pages_written++;
+  }
+  return pages_written;
+}
 
-  auto it = page_table_.find(page_id);
-  if (it == page_table_.end()) return true;
-  frame_id_t frame_id = it->second;
-  if (pages_[frame_id].GetPinCount() > 0) return false;
-  replacer_->Remove(frame_id);
+auto BufferPoolManagerInstance::PersistFreePageMap(const page_id_t *page_ids, size_t num_pages) -> size_t {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (free_page_map_ == nullptr) return 0;
+    if (std::all_of(page_ids, page_ids + num_pages,
+                    [this](page_id_t page_id) { return free_page_map_->IsPersisted(page_id); })) {
+      return 0;
+    }
+  }
+  // a write of the map that took the pages' groups already is waited for on map_write_latch_
+  return WriteFreePageMap();
+}
 
-  Page *page = &pages_[frame_id];
-  page->ResetMemory();
-  page->page_id_ = INVALID_PAGE_ID;
-  page->pin_count_ = 0;
-  page->is_dirty_ = false;
+auto BufferPoolManagerInstance::EnableMappedReads(const std::string &db_file) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  // the frames and guards reading through a mapping point into it, it can never be replaced
+  if (mapped_file_ != nullptr) return false;
+  for (size_t i = 0; i < pool_size_; i++) {
+    FrameLatch &frame_latch = GetFrameLatch(static_cast<frame_id_t>(i));
+    std::scoped_lock<std::mutex> frame_lock(frame_latch.latch_);
+    if (frame_latch.mapped_data_ != nullptr) return false;
+  }
+  auto *mapped_file = new MappedFile(db_file);
+  if (!mapped_file->IsValid()) {
+    delete mapped_file;
+    return false;
+  }
+  mapped_file_ = mapped_file;
+  return true;
+}
 
-  page_table_.erase(page_id);
-  free_list_.push_back(frame_id);
-  DeallocatePage(page_id);
+auto BufferPoolManagerInstance::EnableChecksums(const std::string &checksum_file) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  disk_scheduler_->SetChecksums(nullptr);
+  delete checksums_;
+  checksums_ = new PageChecksums(checksum_file, num_instances_);
+  if (!checksums_->IsValid()) {
+    delete checksums_;
+    checksums_ = nullptr;
+    return false;
+  }
+  disk_scheduler_->SetChecksums(checksums_);
+  return true;
+}
+
+auto BufferPoolManagerInstance::EnableTracing(const std::string &trace_file) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  delete tracer_;
+  tracer_ = new AccessTracer(trace_file);
+  if (tracer_->IsValid()) return true;
+  delete tracer_;
+  tracer_ = nullptr;
+  return false;
+}
+
+auto BufferPoolManagerInstance::TraceRing(BufferAccessStrategy *strategy) -> uint8_t {
+  if (tracer_ == nullptr) return 0;
+  BufferAccessStrategy::Ring &ring = strategy->GetRing(instance_index_);
+  if (ring.trace_ring_ == 0) {
+    last_trace_ring_ = last_trace_ring_ % 255 + 1;
+    ring.trace_ring_ = last_trace_ring_;
+    Trace(TraceOp::RING, static_cast<page_id_t>(strategy->GetRingSize()), ring.trace_ring_);
+  }
+  return ring.trace_ring_;
+}
+
+auto BufferPoolManagerInstance::EnableAdaptiveK(size_t min_k, size_t max_k) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return replacer_->SetAdaptiveK(min_k, max_k);
+}
+
+auto BufferPoolManagerInstance::GetCorruptPages() -> std::vector<page_id_t> {
+  if (checksums_ == nullptr) return {};
+  return checksums_->GetCorruptPages();
+}
+
+void BufferPoolManagerInstance::EnableCompressedCache(size_t capacity) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  delete compressed_cache_;
+  compressed_cache_ = new CompressedPageCache(capacity);
+}
 
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  if (free_page_map_ != nullptr) {
+    FreeReleasedPages();
+    const page_id_t page_id = free_page_map_->Allocate();
+    ValidatePageId(page_id);
+    return page_id;
+  }
+  const page_id_t next_page_id = next_page_id_.fetch_add(num_instances_);
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+auto BufferPoolManagerInstance::AllocateSegmentPage(PageSegment *segment) -> page_id_t {
+  if (segment->remaining_pages_ == 0) {
+    size_t num_pages = std::min(segment->GetExtentPages(), FreePageMap::MAX_RUN_PAGES);
+    if (free_page_map_ != nullptr) FreeReleasedPages();
+    segment->next_page_id_ = free_page_map_ != nullptr
+                                 ? free_page_map_->AllocateRun(num_pages)
+                                 : next_page_id_.fetch_add(static_cast<page_id_t>(num_pages * num_instances_));
+    segment->remaining_pages_ = num_pages;
+    segment->stride_ = static_cast<page_id_t>(num_instances_);
+  }
+  const page_id_t page_id = segment->next_page_id_;
+  segment->next_page_id_ += segment->stride_;
+  segment->remaining_pages_--;
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+auto BufferPoolManagerInstance::GetEndPageNo() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (free_page_map_ != nullptr) return free_page_map_->GetEndPageNo();
+  return static_cast<size_t>(next_page_id_.load()) / num_instances_;
+}
+
+auto BufferPoolManagerInstance::ReservePageRun(size_t page_no, size_t num_pages) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (free_page_map_ != nullptr) return free_page_map_->ReserveRunAt(page_no, num_pages);
+  // page ids are only allocated under the latch, next_page_id_ cannot move meanwhile
+  auto first_page_id = static_cast<page_id_t>(page_no * num_instances_ + instance_index_);
+  if (next_page_id_.load() > first_page_id) return false;
+  next_page_id_ = first_page_id + static_cast<page_id_t>(num_pages * num_instances_);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  if (compressed_cache_ != nullptr) compressed_cache_->Erase(page_id);
+  if (free_page_map_ == nullptr) return;
+  {
+    // the id must not be handed out while an older image of the page may still land on disk
+    std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+    if (writeback_pages_.count(page_id) > 0) {
+      pending_free_pages_.insert(page_id);
+      return;
+    }
+  }
+  free_page_map_->Free(page_id);
+}
+
+void BufferPoolManagerInstance::FreeReleasedPages() {
+  std::vector<page_id_t> released;
+  {
+    std::scoped_lock<std::mutex> writeback_lock(writeback_latch_);
+    released.swap(released_free_pages_);
+  }
+  for (page_id_t page_id : released) free_page_map_->Free(page_id);
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
+}
 
 }  // namespace bustub
\ No newline at end of file
@@ -0,0 +1,94 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.cpp
+//
+// Identification: src/buffer/buffer_pool_metrics.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bustub {
+
+auto LatencySnapshot::PercentileNs(double quantile) const -> uint64_t {
+  if (count_ == 0) return 0;
+  auto rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count_)));
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+    seen += buckets_[bucket];
+    if (seen >= rank && seen > 0) return bucket == 0 ? 0 : static_cast<uint64_t>(1) << bucket;
+  }
+  return static_cast<uint64_t>(1) << (NUM_BUCKETS - 1);
+}
+
+auto LatencySnapshot::operator+=(const LatencySnapshot &other) -> LatencySnapshot & {
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) buckets_[bucket] += other.buckets_[bucket];
+  count_ += other.count_;
+  sum_ns_ += other.sum_ns_;
+  return *this;
+}
+
+auto LatencyHistogram::Snapshot() const -> LatencySnapshot {
+  LatencySnapshot snapshot;
+  for (const Shard &shard : shards_) {
+    for (size_t bucket = 0; bucket < LatencySnapshot::NUM_BUCKETS; bucket++) {
+      uint64_t count = shard.buckets_[bucket].load(std::memory_order_relaxed);
+      snapshot.buckets_[bucket] += count;
+      snapshot.count_ += count;
+    }
+    snapshot.sum_ns_ += shard.sum_ns_.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+auto BufferPoolMetricsSnapshot::operator+=(const BufferPoolMetricsSnapshot &other) -> BufferPoolMetricsSnapshot & {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  new_pages_ += other.new_pages_;
+  fetch_failures_ += other.fetch_failures_;
+  new_page_failures_ += other.new_page_failures_;
+  evictions_ += other.evictions_;
+  dirty_evictions_ += other.dirty_evictions_;
+  cold_evictions_ += other.cold_evictions_;
+  cleaner_writes_ += other.cleaner_writes_;
+  cleaner_write_failures_ += other.cleaner_write_failures_;
+  cleaning_waits_ += other.cleaning_waits_;
+  compressed_hits_ += other.compressed_hits_;
+  pool_size_ += other.pool_size_;
+  unpinned_frames_ += other.unpinned_frames_;
+  evictable_frames_ += other.evictable_frames_;
+  compressed_pages_ += other.compressed_pages_;
+  compressed_bytes_ += other.compressed_bytes_;
+  checksum_failures_ += other.checksum_failures_;
+  replacer_k_ = std::max(replacer_k_, other.replacer_k_);
+  miss_latency_ += other.miss_latency_;
+  latch_wait_ += other.latch_wait_;
+  return *this;
+}
+
+auto BufferPoolMetrics::Snapshot() const -> BufferPoolMetricsSnapshot {
+  BufferPoolMetricsSnapshot snapshot;
+  snapshot.hits_ = hits_.Load();
+  snapshot.misses_ = misses_.Load();
+  snapshot.new_pages_ = new_pages_.Load();
+  snapshot.fetch_failures_ = fetch_failures_.Load();
+  snapshot.new_page_failures_ = new_page_failures_.Load();
+  snapshot.evictions_ = evictions_.Load();
+  snapshot.dirty_evictions_ = dirty_evictions_.Load();
+  snapshot.cleaner_writes_ = cleaner_writes_.Load();
+  snapshot.cleaner_write_failures_ = cleaner_write_failures_.Load();
+  snapshot.cleaning_waits_ = cleaning_waits_.Load();
+  snapshot.compressed_hits_ = compressed_hits_.Load();
+  snapshot.miss_latency_ = miss_latency_.Snapshot();
+  snapshot.latch_wait_ = latch_wait_.Snapshot();
+  return snapshot;
+}
+
+}  // namespace bustub
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer.cpp
+//
+// Identification: src/buffer/clock_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_replacer.h"
+
+namespace bustub {
+
+ClockReplacer::ClockReplacer(size_t num_frames)
+    : replacer_size_(num_frames), state_(num_frames), prev_(num_frames, -1), next_(num_frames, -1) {
+  for (auto &state : state_) state.store(0, std::memory_order_relaxed);
+}
+
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  *frame_id = -1;
+  if (curr_size_ == 0) return false;
+
+  // one turn clears every reference bit it passes; a frame that lock-free hits keep referencing goes after two
+  for (size_t steps = 0;; steps++) {
+    frame_id_t current = hand_;
+    if ((state_[current].load(std::memory_order_relaxed) & REFERENCED) != 0 && steps < 2 * curr_size_) {
+      state_[current].fetch_and(static_cast<uint8_t>(~REFERENCED), std::memory_order_relaxed);
+      hand_ = next_[current];
+      continue;
+    }
+    LeaveCircle(current);
+    state_[current].store(0, std::memory_order_relaxed);
+    curr_size_--;
+    *frame_id = current;
+    return true;
+  }
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::atomic<uint8_t> &state = state_[frame_id];
+  if ((state.load(std::memory_order_relaxed) & TRACKED) != 0) {
+    state.fetch_or(REFERENCED, std::memory_order_relaxed);
+    return;
+  }
+
+  std::scoped_lock<std::mutex> lock(latch_);
+  state.fetch_or(TRACKED | REFERENCED, std::memory_order_relaxed);
+}
+
+void ClockReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  // tracked with the reference bit clear, only a real access sets it
+  state_[frame_id].fetch_or(TRACKED, std::memory_order_relaxed);
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  uint8_t state = state_[frame_id].load(std::memory_order_relaxed);
+  if ((state & TRACKED) == 0 || ((state & EVICTABLE) != 0) == set_evictable) return;
+
+  if (set_evictable) {
+    state_[frame_id].fetch_or(EVICTABLE, std::memory_order_relaxed);
+    JoinCircle(frame_id);
+    curr_size_++;
+  } else {
+    state_[frame_id].fetch_and(static_cast<uint8_t>(~EVICTABLE), std::memory_order_relaxed);
+    LeaveCircle(frame_id);
+    curr_size_--;
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  uint8_t state = state_[frame_id].exchange(0, std::memory_order_relaxed);
+  if ((state & EVICTABLE) != 0) {
+    LeaveCircle(frame_id);
+    curr_size_--;
+  }
+}
+
+void ClockReplacer::Reinstate(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  // CLOCK keeps no ghosts; the hit that pinned the frame referenced it
+  state_[frame_id].fetch_or(TRACKED | REFERENCED, std::memory_order_relaxed);
+}
+
+auto ClockReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void ClockReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame_id = num_frames; frame_id < replacer_size_; frame_id++) {
+    if ((state_[frame_id].load(std::memory_order_relaxed) & EVICTABLE) == 0) continue;
+    LeaveCircle(static_cast<frame_id_t>(frame_id));
+    curr_size_--;
+  }
+  // atomics cannot be moved, so the states are copied over to a new vector
+  std::vector<std::atomic<uint8_t>> state(num_frames);
+  for (size_t frame_id = 0; frame_id < num_frames; frame_id++) {
+    state[frame_id].store(frame_id < replacer_size_ ? state_[frame_id].load(std::memory_order_relaxed) : 0,
+                          std::memory_order_relaxed);
+  }
+  state_.swap(state);
+  prev_.resize(num_frames, -1);
+  next_.resize(num_frames, -1);
+  replacer_size_ = num_frames;
+}
+
+auto ClockReplacer::PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t count = 0;
+  // the hand takes the unreferenced frames on its first turn and the referenced ones on the second
+  for (uint8_t referenced : {static_cast<uint8_t>(0), REFERENCED}) {
+    frame_id_t current = hand_;
+    for (size_t steps = 0; steps < curr_size_ && count < max_frames; steps++, current = next_[current]) {
+      if ((state_[current].load(std::memory_order_relaxed) & REFERENCED) == referenced) frame_ids[count++] = current;
+    }
+  }
+  return count;
+}
+
+void ClockReplacer::JoinCircle(frame_id_t frame_id) {
+  if (hand_ == -1) {
+    prev_[frame_id] = frame_id;
+    next_[frame_id] = frame_id;
+    hand_ = frame_id;
+    return;
+  }
+  frame_id_t last = prev_[hand_];
+  prev_[frame_id] = last;
+  next_[frame_id] = hand_;
+  next_[last] = frame_id;
+  prev_[hand_] = frame_id;
+}
+
+void ClockReplacer::LeaveCircle(frame_id_t frame_id) {
+  if (next_[frame_id] == frame_id) {
+    hand_ = -1;
+    return;
+  }
+  next_[prev_[frame_id]] = next_[frame_id];
+  prev_[next_[frame_id]] = prev_[frame_id];
+  if (hand_ == frame_id) hand_ = next_[frame_id];
+}
+
+}  // namespace bustub
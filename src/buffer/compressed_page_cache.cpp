@@ -0,0 +1,247 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t HASH_BITS = 12;
+constexpr size_t MAX_OFFSET = 65535;
+constexpr size_t LENGTH_NIBBLE = 15;
+
+auto Read32(const char *p) -> uint32_t {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> size_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Appends the bytes of a compressed buffer, failing once the capacity is exceeded. */
+class Writer {
+ public:
+  Writer(char *dst, size_t capacity) : dst_(dst), capacity_(capacity) {}
+
+  auto Byte(uint8_t value) -> bool {
+    if (size_ == capacity_) return false;
+    dst_[size_++] = static_cast<char>(value);
+    return true;
+  }
+
+  auto Bytes(const char *src, size_t size) -> bool {
+    if (capacity_ - size_ < size) return false;
+    std::memcpy(dst_ + size_, src, size);
+    size_ += size;
+    return true;
+  }
+
+  /** The part of a length beyond its nibble: 255 per byte until a byte below 255 ends it. */
+  auto Length(size_t length) -> bool {
+    for (; length >= 255; length -= 255) {
+      if (!Byte(255)) return false;
+    }
+    return Byte(static_cast<uint8_t>(length));
+  }
+
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  char *dst_;
+  size_t capacity_;
+  size_t size_{0};
+};
+
+/** Writes a sequence; match_length 0 marks the last one, which has no match. */
+auto WriteSequence(Writer *writer, const char *literals, size_t num_literals, size_t offset, size_t match_length)
+    -> bool {
+  size_t literal_nibble = std::min(num_literals, LENGTH_NIBBLE);
+  size_t match_nibble = match_length == 0 ? 0 : std::min(match_length - CompressedPageCache::MIN_MATCH, LENGTH_NIBBLE);
+  if (!writer->Byte(static_cast<uint8_t>(literal_nibble << 4 | match_nibble))) return false;
+  if (literal_nibble == LENGTH_NIBBLE && !writer->Length(num_literals - LENGTH_NIBBLE)) return false;
+  if (!writer->Bytes(literals, num_literals)) return false;
+  if (match_length == 0) return true;
+  if (!writer->Byte(static_cast<uint8_t>(offset)) || !writer->Byte(static_cast<uint8_t>(offset >> 8))) return false;
+  return match_nibble < LENGTH_NIBBLE || writer->Length(match_length - CompressedPageCache::MIN_MATCH - LENGTH_NIBBLE);
+}
+
+/** Reads the part of a length beyond its nibble, see Writer::Length(). */
+auto ReadLength(const uint8_t **in, const uint8_t *end, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*in == end) return false;
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+auto CompressedPageCache::Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  // positions plus one of the last 4-byte sequence with each hash, 0 for none
+  std::array<uint32_t, 1 << HASH_BITS> table{};
+  Writer writer(dst, capacity);
+  size_t pos = 0;
+  size_t anchor = 0;
+  while (pos + MIN_MATCH <= size) {
+    uint32_t sequence = Read32(src + pos);
+    uint32_t &slot = table[Hash(sequence)];
+    size_t candidate = slot;
+    slot = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Read32(src + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match = candidate - 1;
+    size_t length = MIN_MATCH;
+    while (pos + length < size && src[match + length] == src[pos + length]) length++;
+    if (!WriteSequence(&writer, src + anchor, pos - anchor, pos - match, length)) return 0;
+    pos += length;
+    anchor = pos;
+  }
+  if (!WriteSequence(&writer, src + anchor, size - anchor, 0, 0)) return 0;
+  return writer.Size();
+}
+
+auto CompressedPageCache::Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *end = in + size;
+  size_t out = 0;
+  while (in < end) {
+    uint8_t token = *in++;
+    size_t num_literals = token >> 4;
+    if (num_literals == LENGTH_NIBBLE && !ReadLength(&in, end, &num_literals)) return false;
+    if (static_cast<size_t>(end - in) < num_literals || dst_size - out < num_literals) return false;
+    std::memcpy(dst + out, in, num_literals);
+    in += num_literals;
+    out += num_literals;
+    if (in == end) break;
+
+    if (end - in < 2) return false;
+    size_t offset = in[0] | static_cast<size_t>(in[1]) << 8;
+    in += 2;
+    size_t match_length = (token & LENGTH_NIBBLE) + MIN_MATCH;
+    if ((token & LENGTH_NIBBLE) == LENGTH_NIBBLE && !ReadLength(&in, end, &match_length)) return false;
+    if (offset == 0 || offset > out || dst_size - out < match_length) return false;
+    // byte by byte, a match may overlap the bytes it produces
+    for (size_t i = 0; i < match_length; i++, out++) dst[out] = dst[out - offset];
+  }
+  return out == dst_size;
+}
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) EraseEntry(it);
+  lru_.push_front(page_id);
+  Entry &entry = entries_[page_id];
+  entry.data_.assign(data, BUSTUB_PAGE_SIZE);
+  entry.generation_ = next_generation_++;
+  entry.lru_ = lru_.begin();
+  pending_size_ += BUSTUB_PAGE_SIZE;
+  pending_.emplace_back(page_id, entry.generation_);
+  while (pending_.size() > MAX_PENDING_PAGES) {
+    // nobody compressed them in time, the oldest raw images go
+    auto [pending_page_id, generation] = pending_.front();
+    pending_.pop_front();
+    auto pending = entries_.find(pending_page_id);
+    if (pending != entries_.end() && pending->second.generation_ == generation) EraseEntry(pending);
+  }
+}
+
+auto CompressedPageCache::Take(page_id_t page_id, char *data) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it == entries_.end()) return false;
+  const Entry &entry = it->second;
+  bool restored = true;
+  if (entry.compressed_) {
+    restored = Decompress(entry.data_.data(), entry.data_.size(), data, BUSTUB_PAGE_SIZE);
+  } else {
+    std::memcpy(data, entry.data_.data(), BUSTUB_PAGE_SIZE);
+  }
+  EraseEntry(it);
+  return restored;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) EraseEntry(it);
+}
+
+void CompressedPageCache::CompressPending() {
+  std::string raw;
+  std::string compressed(MAX_COMPRESSED_SIZE, '\0');
+  while (true) {
+    std::pair<page_id_t, uint64_t> pending;
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      if (pending_.empty()) return;
+      pending = pending_.front();
+      pending_.pop_front();
+      auto it = entries_.find(pending.first);
+      if (it == entries_.end() || it->second.generation_ != pending.second) continue;
+      raw = it->second.data_;
+    }
+
+    size_t compressed_size = Compress(raw.data(), raw.size(), compressed.data(), MAX_COMPRESSED_SIZE);
+    std::scoped_lock<std::mutex> lock(latch_);
+    // the page may have been taken or inserted again meanwhile
+    auto it = entries_.find(pending.first);
+    if (it == entries_.end() || it->second.generation_ != pending.second) continue;
+    if (compressed_size == 0) {
+      EraseEntry(it);
+      continue;
+    }
+    pending_size_ -= it->second.data_.size();
+    it->second.data_.assign(compressed.data(), compressed_size);
+    it->second.compressed_ = true;
+    size_ += compressed_size;
+    EvictOverCapacity();
+  }
+}
+
+auto CompressedPageCache::GetPageCount() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return entries_.size();
+}
+
+auto CompressedPageCache::GetSize() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return size_ + pending_size_;
+}
+
+void CompressedPageCache::EraseEntry(std::unordered_map<page_id_t, Entry>::iterator it) {
+  (it->second.compressed_ ? size_ : pending_size_) -= it->second.data_.size();
+  lru_.erase(it->second.lru_);
+  entries_.erase(it);
+}
+
+void CompressedPageCache::EvictOverCapacity() {
+  auto it = lru_.end();
+  while (size_ > capacity_ && it != lru_.begin()) {
+    auto entry = entries_.find(*--it);
+    if (!entry->second.compressed_) continue;  // the raw images are not charged to the capacity
+    it = std::next(it);
+    EraseEntry(entry);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,124 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+auto AlignUp(size_t value, size_t alignment) -> size_t { return (value + alignment - 1) / alignment * alignment; }
+}  // namespace
+
+FrameArena::FrameArena(size_t num_frames, const FrameArenaOptions &options)
+    : num_frames_(num_frames), frame_stride_(sizeof(Page)) {
+  size_t alignment = options.frame_alignment_;
+  size_t padding = 0;
+  if (alignment > 0) {
+    BUSTUB_ASSERT((alignment & (alignment - 1)) == 0, "frame alignment must be a power of two");
+    // the data need not start the Page, so the first frame is shifted until its data lands on the alignment
+    Page probe;
+    auto data_offset = static_cast<size_t>(probe.GetData() - reinterpret_cast<char *>(&probe));
+    frame_stride_ = AlignUp(sizeof(Page), alignment);
+    padding = (alignment - data_offset % alignment) % alignment;
+    BUSTUB_ASSERT(padding % alignof(Page) == 0, "frame data cannot be aligned");
+  }
+
+  size_t length = std::max<size_t>(padding + num_frames_ * frame_stride_, 1);
+  if (options.huge_page_size_ > 0) {
+    memory_size_ = AlignUp(length, options.huge_page_size_);
+    memory_ = MapHugeTlb(memory_size_, options.huge_page_size_);
+    huge_tlb_ = memory_ != nullptr;
+    if (memory_ == nullptr) {
+      LOG_DEBUG("no %zu byte huge pages available, using transparent huge pages", options.huge_page_size_);
+    }
+  }
+  if (memory_ == nullptr) {
+    memory_size_ = AlignUp(length, TRANSPARENT_HUGE_PAGE_SIZE);
+    memory_ = MapAligned(memory_size_, TRANSPARENT_HUGE_PAGE_SIZE);
+  }
+  if (memory_ == nullptr) throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map the frame arena");
+
+  ApplyNumaPolicy(options);
+  frames_ = memory_ + padding;
+  for (size_t i = 0; i < num_frames_; i++) new (GetFrame(static_cast<frame_id_t>(i))) Page();
+}
+
+FrameArena::~FrameArena() {
+  for (size_t i = 0; i < num_frames_; i++) GetFrame(static_cast<frame_id_t>(i))->~Page();
+  munmap(memory_, memory_size_);
+}
+
+auto FrameArena::NumaNodeCount() -> int {
+  // the online nodes are listed as ranges, e.g. "0-3" or "0,2-3"
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string nodes;
+  if (!(online >> nodes)) return 1;
+  size_t last = nodes.find_last_of(",-");
+  int max_node = std::atoi(nodes.c_str() + (last == std::string::npos ? 0 : last + 1));
+  return std::max(max_node + 1, 1);
+}
+
+auto FrameArena::MapHugeTlb(size_t length, size_t huge_page_size) -> char * {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (__builtin_ctzll(huge_page_size) << MAP_HUGE_SHIFT);
+  void *memory = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return memory == MAP_FAILED ? nullptr : static_cast<char *>(memory);
+}
+
+auto FrameArena::MapAligned(size_t length, size_t alignment) -> char * {
+  // over-allocate, then trim both ends so that the mapping starts on the alignment
+  void *memory = mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) return nullptr;
+  auto *start = static_cast<char *>(memory);
+  auto *aligned = reinterpret_cast<char *>(AlignUp(reinterpret_cast<uintptr_t>(start), alignment));
+  if (aligned > start) munmap(start, aligned - start);
+  size_t tail = alignment - static_cast<size_t>(aligned - start);
+  if (tail > 0) munmap(aligned + length, tail);
+  // transparent huge pages are only a hint, the kernel may be configured to ignore it
+  madvise(aligned, length, MADV_HUGEPAGE);
+  return aligned;
+}
+
+void FrameArena::ApplyNumaPolicy(const FrameArenaOptions &options) {
+  int mode;
+  int num_nodes = NumaNodeCount();
+  std::vector<uint64_t> node_mask(static_cast<size_t>(num_nodes + 63) / 64, 0);
+  if (options.numa_policy_ == NumaPolicy::INTERLEAVE && num_nodes > 1) {
+    mode = MPOL_INTERLEAVE;
+    for (int node = 0; node < num_nodes; node++) node_mask[node / 64] |= uint64_t{1} << (node % 64);
+  } else if (options.numa_policy_ == NumaPolicy::BIND && options.numa_node_ >= 0 && options.numa_node_ < num_nodes) {
+    mode = MPOL_BIND;
+    node_mask[options.numa_node_ / 64] |= uint64_t{1} << (options.numa_node_ % 64);
+  } else {
+    return;
+  }
+  // called through syscall() so that no libnuma is needed; the kernel expects one more than the number of bits
+  if (syscall(__NR_mbind, memory_, memory_size_, mode, node_mask.data(), node_mask.size() * 64 + 1, 0) != 0) {
+    LOG_DEBUG("mbind failed, the frame arena keeps the default NUMA placement");
+  }
+}
+
+}  // namespace bustub
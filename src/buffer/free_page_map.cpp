@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/buffer/free_page_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_page_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bustub {
+
+FreePageMap::FreePageMap(uint32_t num_instances, uint32_t instance_index)
+    : num_instances_(num_instances), instance_index_(instance_index) {}
+
+auto FreePageMap::Allocate() -> page_id_t {
+  if (free_pages_ > 0) {
+    // the first free page after the last one handed out, wrapping around to the start of the file
+    for (size_t i = 0; i <= groups_.size(); i++) {
+      size_t group = (hint_group_ + i) % groups_.size();
+      size_t bit = FindFree(group, i == 0 ? hint_bit_ + 1 : 0);
+      if (bit != PAGES_PER_GROUP) return Take(group, bit);
+    }
+  }
+
+  // no page is free, the file grows by one page, and by the map page of a new group when the last group is full
+  if (groups_.empty() || groups_.back().num_pages_ == PAGES_PER_GROUP) groups_.emplace_back();
+  size_t bit = groups_.back().num_pages_++;
+  free_pages_++;
+  return Take(groups_.size() - 1, bit);
+}
+
+auto FreePageMap::AllocateRun(size_t num_pages) -> page_id_t {
+  if (num_pages <= 1) return Allocate();
+  if (free_pages_ >= num_pages) {
+    for (size_t i = 0; i <= groups_.size(); i++) {
+      size_t group = (hint_group_ + i) % groups_.size();
+      size_t bit = FindFreeRun(group, i == 0 ? hint_bit_ + 1 : 0, num_pages);
+      if (bit != PAGES_PER_GROUP) return TakeRun(group, bit, num_pages);
+    }
+  }
+
+  size_t page_no = FitRun(GetEndPageNo(), num_pages);
+  ReserveRunAt(page_no, num_pages);
+  return ToPageId(page_no);
+}
+
+auto FreePageMap::ReserveRunAt(size_t page_no, size_t num_pages) -> bool {
+  if (page_no < GetEndPageNo() || FitRun(page_no, num_pages) != page_no) return false;
+  GrowTo(page_no);
+  size_t group = groups_.size() - 1;
+  size_t first_bit = groups_[group].num_pages_;
+  groups_[group].num_pages_ += num_pages;
+  free_pages_ += num_pages;
+  TakeRun(group, first_bit, num_pages);
+  return true;
+}
+
+auto FreePageMap::FitRun(size_t page_no, size_t num_pages) -> size_t {
+  // the first page of a group is followed by the map page, runs start after the map page
+  size_t offset = page_no % GROUP_SPAN;
+  if (offset < 2) return page_no - offset + 2;
+  if (offset + num_pages > GROUP_SPAN) return page_no - offset + GROUP_SPAN + 2;
+  return page_no;
+}
+
+auto FreePageMap::Free(page_id_t page_id) -> bool {
+  size_t group;
+  size_t bit;
+  if (!ToBit(page_id, &group, &bit)) return false;
+
+  Group &entry = groups_[group];
+  uint64_t mask = static_cast<uint64_t>(1) << (bit % 64);
+  if (bit >= entry.num_pages_ || (entry.bits_[bit / 64] & mask) == 0) return false;
+  entry.bits_[bit / 64] &= ~mask;
+  entry.dirty_ = true;
+  free_pages_++;
+  return true;
+}
+
+auto FreePageMap::IsPersisted(page_id_t page_id) const -> bool {
+  size_t group;
+  size_t bit;
+  if (!ToBit(page_id, &group, &bit)) return true;
+  const Group &entry = groups_[group];
+  uint64_t mask = static_cast<uint64_t>(1) << (bit % 64);
+  // a free page is never written
+  return (entry.persisted_bits_[bit / 64] & mask) != 0 || (entry.bits_[bit / 64] & mask) == 0;
+}
+
+auto FreePageMap::IsMapPage(page_id_t page_id) const -> bool {
+  if (page_id < 0 || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_) return false;
+  return static_cast<size_t>(page_id) / num_instances_ % GROUP_SPAN == 1;
+}
+
+auto FreePageMap::LoadGroup(const char *data) -> bool {
+  uint32_t header[2];
+  memcpy(header, data, sizeof(header));
+  if (header[0] != MAGIC || header[1] == 0 || header[1] > PAGES_PER_GROUP) return false;
+
+  Group &entry = groups_.emplace_back();
+  entry.num_pages_ = header[1];
+  entry.dirty_ = false;
+  memcpy(entry.bits_, data + sizeof(header), sizeof(entry.bits_));
+  memcpy(entry.persisted_bits_, entry.bits_, sizeof(entry.bits_));
+  size_t used = 0;
+  for (uint64_t word : entry.bits_) used += __builtin_popcountll(word);
+  free_pages_ += entry.num_pages_ - used;
+  // allocation resumes where the file ends
+  hint_group_ = groups_.size() - 1;
+  hint_bit_ = entry.num_pages_ - 1;
+  return true;
+}
+
+void FreePageMap::TakeDirtyGroups(std::vector<page_id_t> *page_ids, std::vector<char> *pages) {
+  page_ids->clear();
+  pages->clear();
+  for (size_t group = 0; group < groups_.size(); group++) {
+    Group &entry = groups_[group];
+    if (!entry.dirty_) continue;
+    entry.dirty_ = false;
+    page_ids->push_back(GetMapPageId(group));
+    size_t offset = pages->size();
+    pages->resize(offset + BUSTUB_PAGE_SIZE);
+    const uint32_t header[2] = {MAGIC, entry.num_pages_};
+    memcpy(pages->data() + offset, header, sizeof(header));
+    memcpy(pages->data() + offset + sizeof(header), entry.bits_, sizeof(entry.bits_));
+  }
+}
+
+void FreePageMap::MarkDirty(page_id_t map_page_id) {
+  if (!IsMapPage(map_page_id)) return;
+  size_t group = static_cast<size_t>(map_page_id) / num_instances_ / GROUP_SPAN;
+  if (group < groups_.size()) groups_[group].dirty_ = true;
+}
+
+void FreePageMap::MarkPersisted(page_id_t map_page_id, const char *data) {
+  if (!IsMapPage(map_page_id)) return;
+  size_t group = static_cast<size_t>(map_page_id) / num_instances_ / GROUP_SPAN;
+  if (group < groups_.size()) {
+    memcpy(groups_[group].persisted_bits_, data + 2 * sizeof(uint32_t), sizeof(groups_[group].persisted_bits_));
+  }
+}
+
+auto FreePageMap::ToBit(page_id_t page_id, size_t *group, size_t *bit) const -> bool {
+  if (page_id < 0 || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_) return false;
+  size_t page_no = static_cast<size_t>(page_id) / num_instances_;
+  *group = page_no / GROUP_SPAN;
+  size_t offset = page_no % GROUP_SPAN;
+  if (offset == 1 || *group >= groups_.size()) return false;
+  *bit = offset == 0 ? 0 : offset - 1;
+  return true;
+}
+
+auto FreePageMap::Take(size_t group, size_t bit) -> page_id_t {
+  Group &entry = groups_[group];
+  entry.bits_[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+  entry.dirty_ = true;
+  free_pages_--;
+  hint_group_ = group;
+  hint_bit_ = bit;
+  return ToPageId(ToPageNo(group, bit));
+}
+
+auto FreePageMap::TakeRun(size_t group, size_t first_bit, size_t num_bits) -> page_id_t {
+  Group &entry = groups_[group];
+  for (size_t bit = first_bit; bit < first_bit + num_bits; bit++) {
+    entry.bits_[bit / 64] |= static_cast<uint64_t>(1) << (bit % 64);
+  }
+  entry.dirty_ = true;
+  free_pages_ -= num_bits;
+  hint_group_ = group;
+  hint_bit_ = first_bit + num_bits - 1;
+  return ToPageId(ToPageNo(group, first_bit));
+}
+
+auto FreePageMap::FindFreeRun(size_t group, size_t from_bit, size_t num_bits) const -> size_t {
+  const Group &entry = groups_[group];
+  size_t run = 0;
+  for (size_t bit = std::max<size_t>(from_bit, 1); bit < entry.num_pages_; bit++) {
+    uint64_t word = entry.bits_[bit / 64];
+    if (bit % 64 == 0 && word == ~static_cast<uint64_t>(0)) {
+      run = 0;
+      bit += 63;  // a word without free bits
+      continue;
+    }
+    if (((word >> (bit % 64)) & 1) != 0) {
+      run = 0;
+      continue;
+    }
+    if (++run == num_bits) return bit + 1 - num_bits;
+  }
+  return PAGES_PER_GROUP;
+}
+
+void FreePageMap::GrowTo(size_t page_no) {
+  while (GetEndPageNo() < page_no) {
+    if (groups_.empty() || groups_.back().num_pages_ == PAGES_PER_GROUP) groups_.emplace_back();
+    size_t group = groups_.size() - 1;
+    Group &entry = groups_.back();
+    // the map page at offset 1 has no bit, the file cannot end right before it
+    size_t num_bits = page_no >= (group + 1) * GROUP_SPAN ? PAGES_PER_GROUP
+                                                          : std::max<size_t>(page_no - group * GROUP_SPAN, 2) - 1;
+    free_pages_ += num_bits - entry.num_pages_;
+    entry.num_pages_ = num_bits;
+    entry.dirty_ = true;
+  }
+}
+
+auto FreePageMap::FindFree(size_t group, size_t from_bit) const -> size_t {
+  const Group &entry = groups_[group];
+  for (size_t word = from_bit / 64; word * 64 < entry.num_pages_; word++) {
+    uint64_t free_bits = ~entry.bits_[word];
+    if (word == from_bit / 64) free_bits &= ~static_cast<uint64_t>(0) << (from_bit % 64);
+    if (free_bits == 0) continue;
+    size_t bit = word * 64 + __builtin_ctzll(free_bits);
+    return bit < entry.num_pages_ ? bit : PAGES_PER_GROUP;
+  }
+  return PAGES_PER_GROUP;
+}
+
+}  // namespace bustub
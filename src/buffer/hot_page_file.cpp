@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hot_page_file.cpp
+//
+// Identification: src/buffer/hot_page_file.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/hot_page_file.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace bustub {
+
+auto HotPageFile::Write(const std::string &path, const std::vector<page_id_t> &page_ids) -> bool {
+  // written next to the old file and renamed over it, so that a crash never leaves a truncated file behind
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    uint32_t header[2] = {MAGIC, static_cast<uint32_t>(page_ids.size())};
+    file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(page_ids.data()),
+               static_cast<std::streamsize>(page_ids.size() * sizeof(page_id_t)));
+    if (!file.flush()) return false;
+  }
+  return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+auto HotPageFile::Read(const std::string &path, std::vector<page_id_t> *page_ids) -> bool {
+  std::ifstream file(path, std::ios::binary);
+  uint32_t header[2];
+  if (!file.read(reinterpret_cast<char *>(header), sizeof(header)) || header[0] != MAGIC) return false;
+  // the count is checked against what the file holds before anything is allocated for it
+  file.seekg(0, std::ios::end);
+  auto file_size = static_cast<uint64_t>(file.tellg());
+  if (file_size != sizeof(header) + static_cast<uint64_t>(header[1]) * sizeof(page_id_t)) return false;
+  file.seekg(sizeof(header));
+  page_ids->resize(header[1]);
+  if (!file.read(reinterpret_cast<char *>(page_ids->data()),
+                 static_cast<std::streamsize>(page_ids->size() * sizeof(page_id_t)))) {
+    page_ids->clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace bustub
@@ -12,102 +12,492 @@
 
 #include "buffer/lru_k_replacer.h"
 
+#include <algorithm>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {
-  preliminary_queue_ = std::unordered_map<frame_id_t, std::list<size_t>>();
-  lru_cache_queue_ = std::unordered_map<frame_id_t, std::list<size_t>>();
+namespace {
+/** Number of access buffers: the hardware thread count rounded up to a power of two, at most 64. */
+auto NumAccessBuffers() -> size_t {
+  size_t count = 1;
+  while (count < std::thread::hardware_concurrency() && count < 64) count <<= 1;
+  return count;
+}
+}  // namespace
+
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k, bool buffered_access)
+    : replacer_size_(num_frames),
+      k_(k),
+      history_capacity_(k),
+      min_k_(k),
+      max_k_(k),
+      history_(num_frames * k),
+      history_head_(num_frames, 0),
+      history_size_(num_frames, 0),
+      evictable_((num_frames + 63) / 64),
+      priorities_(num_frames, PagePriority::NORMAL),
+      heap_pos_(num_frames, NOT_IN_HEAP),
+      prefetched_(num_frames, false),
+      access_buffers_(buffered_access ? NumAccessBuffers() : 0),
+      frame_epochs_(buffered_access ? num_frames : 0) {
+  heap_.reserve(num_frames);
 }
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
 
   *frame_id = -1;  // default initialization for pointer param out (the evicted frame)
-  clock_++;        // increment time for simulation
-  // if no frames can be evicted, as the replacer is empty
-  if (preliminary_queue_.empty() && lru_cache_queue_.empty()) return false;
-
-  size_t reference_clock = clock_;
-  if (!preliminary_queue_.empty()) {
-    for (auto e : preliminary_queue_) {
-      bool can_evict = evictable_.find(e.first) != evictable_.end();
-      size_t oldest_time = e.second.front();
-      if (can_evict && oldest_time < reference_clock) {
-        *frame_id = e.first;
-        reference_clock = oldest_time;  // computation of backward k-distance maximum of all frames
-      }
-    }
-  }
-  if (preliminary_queue_.find(*frame_id) != preliminary_queue_.end()) {
-    preliminary_queue_.erase(*frame_id);
-    evictable_.erase(*frame_id);
-    return true;
-  }
+  // frames with +inf backward k-distance always go first, the oldest first access among them wins
+  if (heap_.empty()) return false;
 
-  for (auto e : lru_cache_queue_) {
-    bool can_evict = evictable_.find(e.first) != evictable_.end();
-    size_t oldest_time = e.second.front();
-    if (can_evict && oldest_time < reference_clock) {
-      *frame_id = e.first;
-      reference_clock = oldest_time;
-    }
-  }
-  if (*frame_id != -1) {  // check that frame is valid
-    lru_cache_queue_.erase(*frame_id);
-    evictable_.erase(*frame_id);
-    return true;
+  *frame_id = heap_.front().frame_id_;
+  bool cold = history_size_[*frame_id] < k_;
+  if (cold) cold_evictions_++;
+  last_victim_ = {*frame_id, history_head_[*frame_id], history_size_[*frame_id], priorities_[*frame_id], cold};
+  HeapErase(0);
+  if (adaptive_k_) {
+    if (k_ > min_k_) lower_k_.victim_key_ = EvictionKey(*frame_id, k_ - 1);
+    if (k_ < max_k_) higher_k_.victim_key_ = EvictionKey(*frame_id, k_ + 1);
+    PushGhost(*frame_id);
   }
-  return false;
+  ResetFrame(*frame_id);
+  curr_size_--;
+  if (adaptive_k_ && ++window_evictions_ >= std::max(ADAPT_WINDOW, replacer_size_)) AdaptK();
+  return true;
 }
 
 void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+
+  if (!access_buffers_.empty()) {
+    thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    uint64_t epoch = frame_epochs_[frame_id].load(std::memory_order_acquire);
+    uint64_t access = (epoch << 32) | static_cast<uint32_t>(frame_id);
+    if (access_buffers_[thread_hash & (access_buffers_.size() - 1)].Offer(access)) return;
+  }
+
   std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();  // the ring is full
+  RecordAccessLocked(frame_id);
+}
 
-  if (frame_id >= static_cast<int>(replacer_size_) || frame_id == -1) return;
+void LRUKReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+  if (history_size_[frame_id] > 0) return;
+  RecordAccessLocked(frame_id);
+  prefetched_[frame_id] = true;
+}
 
-  // check cache_queue first
-  if (lru_cache_queue_.find(frame_id) != lru_cache_queue_.end()) {
-    access_history_t &access_history = lru_cache_queue_[frame_id];
-    access_history.pop_front();
-    access_history.push_back(clock_++);
-    return;
+void LRUKReplacer::RecordAccessLocked(frame_id_t frame_id) {
+  if (prefetched_[frame_id]) {
+    // the read ahead was no access, the first real one replaces its timestamp
+    prefetched_[frame_id] = false;
+    history_size_[frame_id] = 0;
   }
-  // if doesnt exist in prelim queue, initialize a new timestamp history
-  if (preliminary_queue_.find(frame_id) == preliminary_queue_.end()) {
-    preliminary_queue_[frame_id] = access_history_t();
+  if (adaptive_k_ && history_size_[frame_id] > 0) RecordNeighbourLosses(frame_id);
+  size_t base = frame_id * history_capacity_;
+  if (history_size_[frame_id] < history_capacity_) {
+    history_[base + (history_head_[frame_id] + history_size_[frame_id]) % history_capacity_] = clock_++;
+    history_size_[frame_id]++;
+  } else {
+    // only the last k accesses matter, overwrite the oldest one
+    history_[base + history_head_[frame_id]] = clock_++;
+    history_head_[frame_id] = (history_head_[frame_id] + 1) % history_capacity_;
   }
-  access_history_t &access_history = preliminary_queue_[frame_id];
-  access_history.push_back(clock_++);
-  // move it to cache queue if accessed more than k times
-  if (access_history.size() >= k_) {
-    lru_cache_queue_[frame_id] = access_history;  // move reference to cache queue
-    preliminary_queue_.erase(frame_id);
+
+  if (IsEvictable(frame_id)) {
+    // the key never decreases on an access
+    size_t pos = heap_pos_[frame_id];
+    heap_[pos].key_ = EvictionKey(frame_id);
+    SiftDown(pos);
   }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  // the unpin of a frame that was never taken out of the heap; a bit cleared meanwhile is an eviction in progress,
+  // which finds the frame unpinned
+  if (set_evictable && IsEvictable(frame_id)) return;
   std::scoped_lock<std::mutex> lock(latch_);
-  clock_++;
-  if (preliminary_queue_.find(frame_id) == preliminary_queue_.end() &&
-      lru_cache_queue_.find(frame_id) == lru_cache_queue_.end()) {
-    return;
-  } else if (set_evictable) {
-    evictable_[frame_id] = true;
+  if (history_size_[frame_id] == 0 && !access_buffers_.empty()) {
+    DrainAccessBuffers();  // the first access of the frame may still be buffered
+  }
+  if (history_size_[frame_id] == 0 || IsEvictable(frame_id) == set_evictable) return;
+
+  SetEvictableBit(frame_id, set_evictable);
+  if (set_evictable) {
+    HeapPush(frame_id);
+    curr_size_++;
   } else {
-    evictable_.erase(frame_id);
+    HeapErase(heap_pos_[frame_id]);
+    curr_size_--;
   }
 }
 
+void LRUKReplacer::PinFrames(const frame_id_t *frame_ids, size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+  for (size_t i = 0; i < num_frames; i++) {
+    frame_id_t frame_id = frame_ids[i];
+    if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) continue;
+    if (IsEvictable(frame_id)) {
+      // leaving the heap first saves re-sifting a key that is about to go away
+      SetEvictableBit(frame_id, false);
+      HeapErase(heap_pos_[frame_id]);
+      curr_size_--;
+    }
+    RecordAccessLocked(frame_id);
+  }
+}
+
+void LRUKReplacer::SetPriority(frame_id_t frame_id, PagePriority priority) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (priorities_[frame_id] == priority) return;
+  priorities_[frame_id] = priority;
+  if (!IsEvictable(frame_id)) return;
+  size_t pos = heap_pos_[frame_id];
+  heap_[pos].key_ = EvictionKey(frame_id);
+  SiftUp(pos);
+  SiftDown(heap_pos_[frame_id]);
+}
+
 void LRUKReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
   std::scoped_lock<std::mutex> lock(latch_);
-  clock_++;
-  preliminary_queue_.erase(frame_id);  // remove all the timestamp history
-  lru_cache_queue_.erase(frame_id);
-  evictable_.erase(frame_id);
+  if (IsEvictable(frame_id)) {
+    HeapErase(heap_pos_[frame_id]);
+    curr_size_--;
+  }
+  // even an untracked frame may have its first access still buffered
+  ResetFrame(frame_id);  // remove all the timestamp history
+  if (last_victim_.frame_id_ == frame_id) last_victim_ = {};
+}
+
+void LRUKReplacer::Reinstate(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+  if (adaptive_k_) {
+    // the eviction did not happen after all: its ghost is no ghost hit and it does not count towards the window
+    auto it = ghost_entries_.find(page_id);
+    if (it != ghost_entries_.end()) {
+      free_ghost_slots_.push_back(it->second.slot_);
+      ghost_entries_.erase(it);
+      ghosts_.Erase(page_id);
+    }
+    frame_page_[frame_id] = page_id;
+    if (window_evictions_ > 0) window_evictions_--;
+  }
+  if (history_size_[frame_id] > 0) return;  // an access since the eviction tracks it already
+  if (last_victim_.frame_id_ != frame_id) {
+    RecordAccessLocked(frame_id);
+    return;
+  }
+  history_head_[frame_id] = last_victim_.history_head_;
+  history_size_[frame_id] = last_victim_.history_size_;
+  priorities_[frame_id] = last_victim_.priority_;
+  if (last_victim_.cold_) cold_evictions_--;
+  last_victim_ = {};
 }
 
 auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
-  return evictable_.size();
+  return curr_size_;
+}
+
+auto LRUKReplacer::GetColdEvictionCount() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return cold_evictions_;
+}
+
+auto LRUKReplacer::GetK() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return k_;
+}
+
+auto LRUKReplacer::SetAdaptiveK(size_t min_k, size_t max_k) -> bool {
+  if (min_k == 0 || min_k > max_k) return false;
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+
+  // every frame keeps room for max_k accesses, its most recent ones are carried over
+  std::vector<size_t> history(replacer_size_ * max_k);
+  for (size_t frame_id = 0; frame_id < replacer_size_; frame_id++) {
+    size_t kept = std::min<size_t>(history_size_[frame_id], max_k);
+    size_t first = history_head_[frame_id] + history_size_[frame_id] - kept;
+    for (size_t i = 0; i < kept; i++) {
+      history[frame_id * max_k + i] = history_[frame_id * history_capacity_ + (first + i) % history_capacity_];
+    }
+    history_head_[frame_id] = 0;
+    history_size_[frame_id] = kept;
+  }
+  history_ = std::move(history);
+  history_capacity_ = max_k;
+  last_victim_ = {};
+  min_k_ = min_k;
+  max_k_ = max_k;
+  k_ = std::clamp(k_, min_k, max_k);
+  if (!adaptive_k_) frame_page_.assign(replacer_size_, INVALID_PAGE_ID);
+  adaptive_k_ = true;
+  ResetGhosts();
+  window_evictions_ = 0;
+  lower_k_ = {};
+  higher_k_ = {};
+  RebuildHeap();
+  return true;
+}
+
+void LRUKReplacer::SetFramePage(frame_id_t frame_id, page_id_t page_id) {
+  if (!adaptive_k_ || frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  frame_page_[frame_id] = page_id;
+  auto it = ghost_entries_.find(page_id);
+  if (it == ghost_entries_.end()) return;
+  GhostEntry ghost = it->second;
+  RecordGhostHit(ghost.size_);
+  ghosts_.Erase(page_id);
+  ghost_entries_.erase(it);
+  free_ghost_slots_.push_back(ghost.slot_);
+  if (history_size_[frame_id] > 0) return;
+  // the frame is not tracked before its first access, the page starts from its retained history
+  std::copy_n(ghost_history_.begin() + ghost.slot_ * history_capacity_, ghost.size_,
+              history_.begin() + frame_id * history_capacity_);
+  history_size_[frame_id] = ghost.size_;
+  retained_[frame_id] = ghost.size_ > 0;
+}
+
+void LRUKReplacer::RecordGhostHit(uint32_t accesses) {
+  if (k_ > min_k_ && accesses == k_ - 1) {
+    lower_k_.gains_++;
+  } else if (k_ < max_k_ && accesses > k_) {
+    higher_k_.gains_++;
+  }
+}
+
+void LRUKReplacer::RecordNeighbourLosses(frame_id_t frame_id) {
+  if (retained_[frame_id]) {
+    retained_[frame_id] = false;  // the miss that brought the page back, not a hit
+    return;
+  }
+  if (k_ > min_k_ && EvictionKey(frame_id, k_ - 1) < lower_k_.victim_key_) lower_k_.losses_++;
+  if (k_ < max_k_ && EvictionKey(frame_id, k_ + 1) < higher_k_.victim_key_) higher_k_.losses_++;
+}
+
+void LRUKReplacer::PushGhost(frame_id_t frame_id) {
+  page_id_t page_id = frame_page_[frame_id];
+  if (page_id == INVALID_PAGE_ID || ghost_entries_.count(page_id) > 0) return;
+  if (free_ghost_slots_.empty()) {
+    // the oldest ghost makes room
+    auto oldest = ghost_entries_.find(ghosts_.Back());
+    free_ghost_slots_.push_back(oldest->second.slot_);
+    ghost_entries_.erase(oldest);
+    ghosts_.PopBack();
+  }
+  GhostEntry ghost{free_ghost_slots_.back(), history_size_[frame_id]};
+  free_ghost_slots_.pop_back();
+  for (size_t i = 0; i < ghost.size_; i++) {
+    ghost_history_[ghost.slot_ * history_capacity_ + i] =
+        history_[frame_id * history_capacity_ + (history_head_[frame_id] + i) % history_capacity_];
+  }
+  ghosts_.Push(page_id);
+  ghost_entries_[page_id] = ghost;
+}
+
+void LRUKReplacer::ResetGhosts() {
+  while (ghosts_.Size() > 0) ghosts_.PopBack();
+  ghost_entries_.clear();
+  ghost_history_.assign(replacer_size_ * history_capacity_, 0);
+  retained_.assign(replacer_size_, false);
+  free_ghost_slots_.resize(replacer_size_);
+  for (size_t slot = 0; slot < replacer_size_; slot++) {
+    free_ghost_slots_[slot] = static_cast<uint32_t>(replacer_size_ - 1 - slot);
+  }
+}
+
+void LRUKReplacer::AdaptK() {
+  // a neighbour must save about 3% of the window's misses for k to move
+  auto margin = static_cast<int64_t>(window_evictions_ / 32);
+  auto lower_net = static_cast<int64_t>(lower_k_.gains_) - static_cast<int64_t>(lower_k_.losses_);
+  auto higher_net = static_cast<int64_t>(higher_k_.gains_) - static_cast<int64_t>(higher_k_.losses_);
+  size_t old_k = k_;
+  if (k_ < max_k_ && higher_net > margin && higher_net >= lower_net) {
+    k_++;
+  } else if (k_ > min_k_ && lower_net > margin) {
+    k_--;
+  }
+  window_evictions_ = 0;
+  lower_k_ = {};
+  higher_k_ = {};
+  if (k_ != old_k) RebuildHeap();
+}
+
+void LRUKReplacer::RebuildHeap() {
+  for (auto &entry : heap_) entry.key_ = EvictionKey(entry.frame_id_);
+  for (size_t pos = heap_.size() / 2; pos-- > 0;) SiftDown(pos);
+}
+
+auto LRUKReplacer::PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+
+  // best-first walk of the heap: the next smallest key is always a child of an entry that was already listed
+  auto greater = [this](size_t a, size_t b) { return heap_[a].key_ > heap_[b].key_; };
+  std::vector<size_t> frontier;
+  if (!heap_.empty()) frontier.push_back(0);
+  size_t count = 0;
+  while (count < max_frames && !frontier.empty()) {
+    std::pop_heap(frontier.begin(), frontier.end(), greater);
+    size_t pos = frontier.back();
+    frontier.pop_back();
+    frame_ids[count++] = heap_[pos].frame_id_;
+    for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); child++) {
+      frontier.push_back(child);
+      std::push_heap(frontier.begin(), frontier.end(), greater);
+    }
+  }
+  return count;
+}
+
+void LRUKReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  DrainAccessBuffers();
+  for (size_t frame_id = num_frames; frame_id < replacer_size_; frame_id++) {
+    if (IsEvictable(static_cast<frame_id_t>(frame_id))) {
+      HeapErase(heap_pos_[frame_id]);
+      curr_size_--;
+    }
+    ResetFrame(static_cast<frame_id_t>(frame_id));
+  }
+  replacer_size_ = num_frames;
+  last_victim_ = {};
+  history_.resize(num_frames * history_capacity_);
+  history_head_.resize(num_frames, 0);
+  history_size_.resize(num_frames, 0);
+  if ((num_frames + 63) / 64 != evictable_.size()) {
+    // atomics cannot be moved, the words of the frames that remain are copied over
+    std::vector<std::atomic<uint64_t>> evictable((num_frames + 63) / 64);
+    for (size_t word = 0; word < evictable.size() && word < evictable_.size(); word++) {
+      evictable[word].store(evictable_[word].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    evictable_.swap(evictable);
+  }
+  priorities_.resize(num_frames, PagePriority::NORMAL);
+  heap_pos_.resize(num_frames, NOT_IN_HEAP);
+  prefetched_.resize(num_frames, false);
+  heap_.reserve(num_frames);
+  if (num_frames > frame_epochs_.size() && !access_buffers_.empty()) {
+    // never shrunk, so that the epochs of retired frames keep moving on
+    std::vector<std::atomic<uint32_t>> frame_epochs(num_frames);
+    for (size_t frame_id = 0; frame_id < frame_epochs_.size(); frame_id++) {
+      frame_epochs[frame_id].store(frame_epochs_[frame_id].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    frame_epochs_.swap(frame_epochs);
+  }
+  if (adaptive_k_) {
+    frame_page_.resize(num_frames, INVALID_PAGE_ID);
+    ResetGhosts();
+  }
+}
+
+void LRUKReplacer::DrainAccessBuffers() {
+  for (auto &buffer : access_buffers_) {
+    uint64_t head = buffer.read_count_.load(std::memory_order_relaxed);
+    uint64_t tail = buffer.write_count_.load(std::memory_order_acquire);
+    bool gap = false;  // a claimed slot is not published yet, read_count_ stays before it
+    for (uint64_t pos = head; pos < tail; pos++) {
+      std::atomic<uint64_t> &slot = buffer.slots_[pos % AccessBuffer::CAPACITY];
+      uint64_t access = slot.load(std::memory_order_acquire);
+      if (access == AccessBuffer::EMPTY_SLOT) {
+        // its writer was preempted between claiming and publishing, waiting for it could take a whole time slice
+        gap = true;
+        continue;
+      }
+      if (gap) {
+        if (access != AccessBuffer::CONSUMED_SLOT) slot.store(AccessBuffer::CONSUMED_SLOT, std::memory_order_relaxed);
+      } else {
+        slot.store(AccessBuffer::EMPTY_SLOT, std::memory_order_relaxed);
+        head = pos + 1;
+      }
+      if (access == AccessBuffer::CONSUMED_SLOT) continue;
+      auto frame_id = static_cast<frame_id_t>(static_cast<uint32_t>(access));
+      auto epoch = static_cast<uint32_t>(access >> 32);
+      // the frame stopped being tracked since, its next page must not inherit the access
+      if (static_cast<size_t>(frame_id) >= replacer_size_ ||
+          epoch != frame_epochs_[frame_id].load(std::memory_order_relaxed)) {
+        continue;
+      }
+      RecordAccessLocked(frame_id);
+    }
+    buffer.read_count_.store(head, std::memory_order_release);
+  }
+}
+
+auto LRUKReplacer::AccessBuffer::Offer(uint64_t access) -> bool {
+  uint64_t tail = write_count_.load(std::memory_order_relaxed);
+  do {
+    if (tail - read_count_.load(std::memory_order_acquire) >= CAPACITY) return false;
+  } while (!write_count_.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel));
+  slots_[tail % CAPACITY].store(access, std::memory_order_release);
+  return true;
+}
+
+void LRUKReplacer::ResetFrame(frame_id_t frame_id) {
+  if (!frame_epochs_.empty()) frame_epochs_[frame_id].fetch_add(1, std::memory_order_release);
+  history_head_[frame_id] = 0;
+  history_size_[frame_id] = 0;
+  priorities_[frame_id] = PagePriority::NORMAL;
+  prefetched_[frame_id] = false;
+  SetEvictableBit(frame_id, false);
+  if (adaptive_k_) {
+    frame_page_[frame_id] = INVALID_PAGE_ID;
+    retained_[frame_id] = false;
+  }
+}
+
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+  heap_.push_back({EvictionKey(frame_id), frame_id});
+  heap_pos_[frame_id] = heap_.size() - 1;
+  SiftUp(heap_.size() - 1);
+}
+
+void LRUKReplacer::HeapErase(size_t pos) {
+  heap_pos_[heap_[pos].frame_id_] = NOT_IN_HEAP;
+  HeapEntry last = heap_.back();
+  heap_.pop_back();
+  if (pos == heap_.size()) return;
+  HeapPlace(pos, last);
+  SiftUp(pos);
+  SiftDown(heap_pos_[last.frame_id_]);
+}
+
+void LRUKReplacer::SiftUp(size_t pos) {
+  HeapEntry entry = heap_[pos];
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+    if (heap_[parent].key_ <= entry.key_) break;
+    HeapPlace(pos, heap_[parent]);
+    pos = parent;
+  }
+  HeapPlace(pos, entry);
+}
+
+void LRUKReplacer::SiftDown(size_t pos) {
+  HeapEntry entry = heap_[pos];
+  size_t size = heap_.size();
+  while (2 * pos + 1 < size) {
+    size_t child = 2 * pos + 1;
+    if (child + 1 < size && heap_[child + 1].key_ < heap_[child].key_) child++;
+    if (entry.key_ <= heap_[child].key_) break;
+    HeapPlace(pos, heap_[child]);
+    pos = child;
+  }
+  HeapPlace(pos, entry);
 }
 }  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <vector>
+
+namespace bustub {
+
+PageTable::PageTable(size_t capacity) {
+  // keep the load factor at or below one half
+  num_slots_ = 16;
+  shift_ = 60;
+  while (num_slots_ < 2 * capacity) {
+    num_slots_ <<= 1;
+    shift_--;
+  }
+  mask_ = num_slots_ - 1;
+  slots_ = new std::atomic<uint64_t>[num_slots_];
+  for (size_t i = 0; i < num_slots_; i++) slots_[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+}
+
+PageTable::~PageTable() { delete[] slots_; }
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) const -> bool {
+  size_t index = HomeSlot(page_id);
+  for (size_t probes = 0; probes < num_slots_; probes++, index = (index + 1) & mask_) {
+    uint64_t slot = slots_[index].load(std::memory_order_acquire);
+    if (slot == EMPTY_SLOT) return false;
+    if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+      *frame_id = SlotFrameId(slot);
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  if (num_entries_ + num_tombstones_ + 1 > num_slots_ * 3 / 4) Rebuild();
+
+  size_t index = HomeSlot(page_id);
+  while (true) {
+    uint64_t slot = slots_[index].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT || slot == TOMBSTONE_SLOT) {
+      if (slot == TOMBSTONE_SLOT) num_tombstones_--;
+      slots_[index].store(PackSlot(page_id, frame_id), std::memory_order_release);
+      num_entries_++;
+      return;
+    }
+    index = (index + 1) & mask_;
+  }
+}
+
+auto PageTable::Erase(page_id_t page_id) -> bool {
+  size_t index = HomeSlot(page_id);
+  for (size_t probes = 0; probes < num_slots_; probes++, index = (index + 1) & mask_) {
+    uint64_t slot = slots_[index].load(std::memory_order_relaxed);
+    if (slot == EMPTY_SLOT) return false;
+    if (slot != TOMBSTONE_SLOT && SlotPageId(slot) == page_id) {
+      slots_[index].store(TOMBSTONE_SLOT, std::memory_order_release);
+      num_entries_--;
+      num_tombstones_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void PageTable::Rebuild() {
+  // optimistic readers may miss entries while this runs, which they already have to tolerate
+  std::vector<uint64_t> entries;
+  entries.reserve(num_entries_);
+  for (size_t i = 0; i < num_slots_; i++) {
+    uint64_t slot = slots_[i].load(std::memory_order_relaxed);
+    if (slot != EMPTY_SLOT && slot != TOMBSTONE_SLOT) entries.push_back(slot);
+    slots_[i].store(EMPTY_SLOT, std::memory_order_release);
+  }
+  num_entries_ = 0;
+  num_tombstones_ = 0;
+  for (uint64_t slot : entries) Insert(SlotPageId(slot), SlotFrameId(slot));
+}
+
+}  // namespace bustub
@@ -0,0 +1,378 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>  // NOLINT
+#include <utility>
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy,
+                                                     const FrameArenaOptions &arena_options)
+    : num_instances_(num_instances), pool_size_(pool_size) {
+  // Allocate and create individual BufferPoolManagerInstances
+  bool bind_per_instance = arena_options.numa_policy_ == NumaPolicy::BIND && arena_options.numa_node_ < 0;
+  int num_nodes = bind_per_instance ? FrameArena::NumaNodeCount() : 1;
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    FrameArenaOptions instance_arena_options = arena_options;
+    if (bind_per_instance) instance_arena_options.numa_node_ = static_cast<int>(i % num_nodes);
+    instances_.push_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager, replacer_k,
+                                                       log_manager, replacer_policy, instance_arena_options));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto *instance : instances_) delete instance;
+}
+
+void ParallelBufferPoolManager::StartPageCleaner(size_t clean_low_watermark, size_t max_writes_per_second) {
+  for (auto *instance : instances_) instance->StartPageCleaner(clean_low_watermark, max_writes_per_second);
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto *instance : instances_) instance->StopPageCleaner();
+}
+
+void ParallelBufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  for (page_id_t page_id : page_ids) {
+    if (page_id >= 0) instance_page_ids[page_id % num_instances_].push_back(page_id);
+  }
+  for (size_t i = 0; i < num_instances_; i++) {
+    if (!instance_page_ids[i].empty()) instances_[i]->PrefetchPages(instance_page_ids[i]);
+  }
+}
+
+auto ParallelBufferPoolManager::EnableIoUring(const std::string &db_file, bool direct_io) -> bool {
+  bool uses_io_uring = true;
+  for (auto *instance : instances_) uses_io_uring = instance->EnableIoUring(db_file, direct_io) && uses_io_uring;
+  return uses_io_uring;
+}
+
+auto ParallelBufferPoolManager::EnableFreePageMap(size_t *free_pages) -> bool {
+  // all or nothing, extents span the instances and must leave the map pages of every instance out
+  for (auto *instance : instances_) {
+    if (!instance->CanEnableFreePageMap()) return false;
+  }
+  size_t total_free_pages = 0;
+  for (auto *instance : instances_) {
+    size_t instance_free_pages = 0;
+    instance->EnableFreePageMap(&instance_free_pages);
+    total_free_pages += instance_free_pages;
+  }
+  free_page_maps_ = true;
+  if (free_pages != nullptr) *free_pages = total_free_pages;
+  return true;
+}
+
+auto ParallelBufferPoolManager::EnableMappedReads(const std::string &db_file) -> bool {
+  bool mapped = true;
+  for (auto *instance : instances_) mapped = instance->EnableMappedReads(db_file) && mapped;
+  return mapped;
+}
+
+auto ParallelBufferPoolManager::EnableChecksums(const std::string &checksum_file) -> bool {
+  bool checksummed = true;
+  for (size_t i = 0; i < num_instances_; i++) {
+    std::string path = num_instances_ == 1 ? checksum_file : checksum_file + "." + std::to_string(i);
+    checksummed = instances_[i]->EnableChecksums(path) && checksummed;
+  }
+  return checksummed;
+}
+
+auto ParallelBufferPoolManager::EnableTracing(const std::string &trace_file) -> bool {
+  bool traced = true;
+  for (size_t i = 0; i < num_instances_; i++) {
+    std::string path = num_instances_ == 1 ? trace_file : trace_file + "." + std::to_string(i);
+    traced = instances_[i]->EnableTracing(path) && traced;
+  }
+  return traced;
+}
+
+auto ParallelBufferPoolManager::EnableAdaptiveK(size_t min_k, size_t max_k) -> bool {
+  bool adaptive = true;
+  for (auto *instance : instances_) adaptive = instance->EnableAdaptiveK(min_k, max_k) && adaptive;
+  return adaptive;
+}
+
+auto ParallelBufferPoolManager::GetCorruptPages() -> std::vector<page_id_t> {
+  std::vector<page_id_t> corrupt_pages;
+  for (auto *instance : instances_) {
+    std::vector<page_id_t> instance_pages = instance->GetCorruptPages();
+    corrupt_pages.insert(corrupt_pages.end(), instance_pages.begin(), instance_pages.end());
+  }
+  return corrupt_pages;
+}
+
+void ParallelBufferPoolManager::EnableCompressedCache(size_t capacity) {
+  for (auto *instance : instances_) instance->EnableCompressedCache(capacity / num_instances_);
+}
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) pool_size += instance->GetPoolSize();
+  return pool_size;
+}
+
+auto ParallelBufferPoolManager::Resize(size_t new_pool_size) -> bool {
+  std::scoped_lock<std::mutex> resize_lock(resize_latch_);
+  size_t instance_pool_size = (new_pool_size + num_instances_ - 1) / num_instances_;
+  // a shrink in progress only ever finishes meanwhile, an instance that can take the resize still can below
+  for (auto *instance : instances_) {
+    if (!instance->CanResize(instance_pool_size)) return false;
+  }
+  bool resized = true;
+  for (auto *instance : instances_) resized = instance->Resize(instance_pool_size) && resized;
+  return resized;
+}
+
+auto ParallelBufferPoolManager::GetMetrics() -> BufferPoolMetricsSnapshot {
+  BufferPoolMetricsSnapshot snapshot;
+  for (auto *instance : instances_) snapshot += instance->GetMetrics();
+  return snapshot;
+}
+
+auto ParallelBufferPoolManager::FlushAllDirtyPages() -> size_t {
+  std::vector<size_t> bytes_written(num_instances_, 0);
+  std::vector<std::thread> flushers;
+  flushers.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; i++) {
+    flushers.emplace_back([this, i, &bytes_written] { bytes_written[i] = instances_[i]->FlushAllDirtyPages(); });
+  }
+  for (auto &flusher : flushers) flusher.join();
+  return std::accumulate(bytes_written.begin(), bytes_written.end(), static_cast<size_t>(0));
+}
+
+auto ParallelBufferPoolManager::DumpHotPages(const std::string &path) -> bool {
+  std::vector<std::vector<page_id_t>> instance_pages;
+  instance_pages.reserve(num_instances_);
+  for (auto *instance : instances_) instance_pages.push_back(instance->GetHotPages());
+
+  std::vector<page_id_t> page_ids;
+  bool more = true;
+  for (size_t rank = 0; more; rank++) {
+    more = false;
+    for (const auto &pages : instance_pages) {
+      if (rank < pages.size()) page_ids.push_back(pages[rank]);
+      more = more || rank + 1 < pages.size();
+    }
+  }
+  return HotPageFile::Write(path, page_ids);
+}
+
+auto ParallelBufferPoolManager::LoadHotPages(const std::string &path) -> size_t {
+  std::vector<page_id_t> page_ids;
+  if (!HotPageFile::Read(path, &page_ids)) return 0;
+  size_t loaded = 0;
+  for (auto *instance : instances_) loaded += instance->WarmUp(page_ids);
+  return loaded;
+}
+
+auto ParallelBufferPoolManager::FetchPages(const std::vector<page_id_t> &page_ids) -> std::vector<Page *> {
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  std::vector<std::vector<size_t>> instance_slots(num_instances_);
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    if (page_ids[i] < 0) return {};
+    size_t instance = page_ids[i] % num_instances_;
+    instance_page_ids[instance].push_back(page_ids[i]);
+    instance_slots[instance].push_back(i);
+  }
+
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  for (size_t instance = 0; instance < num_instances_; instance++) {
+    if (instance_page_ids[instance].empty()) continue;
+    std::vector<Page *> instance_pages = instances_[instance]->FetchPages(instance_page_ids[instance]);
+    if (instance_pages.empty()) {
+      for (size_t done = 0; done < instance; done++) {
+        for (page_id_t page_id : instance_page_ids[done]) instances_[done]->UnpinPage(page_id, false);
+      }
+      return {};
+    }
+    for (size_t i = 0; i < instance_pages.size(); i++) pages[instance_slots[instance][i]] = instance_pages[i];
+  }
+  return pages;
+}
+
+auto ParallelBufferPoolManager::NewPages(size_t num_pages, std::vector<page_id_t> *page_ids) -> std::vector<Page *> {
+  size_t start = start_index_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    std::vector<Page *> pages = instances_[(start + i) % num_instances_]->NewPages(num_pages, page_ids);
+    if (!pages.empty()) return pages;
+  }
+  return {};
+}
+
+auto ParallelBufferPoolManager::NewPageInSegment(PageSegment *segment, page_id_t *page_id) -> Page * {
+  if (segment->remaining_pages_ == 0) ReserveExtent(segment);
+  Page *page = GetBufferPoolManager(segment->next_page_id_)->NewReservedPage(segment->next_page_id_);
+  if (page == nullptr) return nullptr;
+  *page_id = segment->next_page_id_;
+  segment->next_page_id_ += segment->stride_;
+  segment->remaining_pages_--;
+  return page;
+}
+
+void ParallelBufferPoolManager::ReserveExtent(PageSegment *segment) {
+  size_t num_pages = std::min(segment->GetExtentPages(), FreePageMap::MAX_RUN_PAGES);
+  std::scoped_lock<std::mutex> lock(extent_latch_);
+  while (true) {
+    size_t page_no = 0;
+    for (auto *instance : instances_) page_no = std::max(page_no, instance->GetEndPageNo());
+    if (free_page_maps_) page_no = FreePageMap::FitRun(page_no, num_pages);
+    size_t reserved = 0;
+    while (reserved < num_instances_ && instances_[reserved]->ReservePageRun(page_no, num_pages)) reserved++;
+    if (reserved == num_instances_) {
+      segment->next_page_id_ = static_cast<page_id_t>(page_no * num_instances_);
+      segment->remaining_pages_ = num_pages * num_instances_;
+      segment->stride_ = 1;
+      return;
+    }
+
+    // a concurrent NewPage() got past page_no first; the instances that reserved the run give it back
+    for (size_t i = 0; i < reserved; i++) {
+      for (size_t k = 0; k < num_pages; k++) {
+        instances_[i]->DeletePage(static_cast<page_id_t>((page_no + k) * num_instances_ + i));
+      }
+    }
+  }
+}
+
+auto ParallelBufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return {};
+  return instance->FetchPageBasic(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
+  return FetchPageBasic(page_id).UpgradeRead();
+}
+
+auto ParallelBufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
+  return FetchPageBasic(page_id).UpgradeWrite();
+}
+
+auto ParallelBufferPoolManager::FetchPageMapped(page_id_t page_id) -> ReadPageGuard {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return {};
+  return instance->FetchPageMapped(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPageAsync(page_id_t page_id, std::function<void(Page *)> on_loaded, bool *pending)
+    -> Page * {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) {
+    *pending = false;
+    return nullptr;
+  }
+  return instance->FetchPageAsync(page_id, std::move(on_loaded), pending);
+}
+
+auto ParallelBufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
+  size_t start = start_index_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    BasicPageGuard guard = instances_[(start + i) % num_instances_]->NewPageGuarded(page_id);
+    if (guard.IsValid()) return guard;
+  }
+  return {};
+}
+
+auto ParallelBufferPoolManager::FetchPageWithPriority(page_id_t page_id, PagePriority priority) -> Page * {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return nullptr;
+  return instance->FetchPageWithPriority(page_id, priority);
+}
+
+auto ParallelBufferPoolManager::NewPageWithPriority(page_id_t *page_id, PagePriority priority) -> Page * {
+  size_t start = start_index_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    Page *page = instances_[(start + i) % num_instances_]->NewPageWithPriority(page_id, priority);
+    if (page != nullptr) return page;
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::FetchPageBasic(page_id_t page_id, PagePriority priority) -> BasicPageGuard {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return {};
+  return instance->FetchPageBasic(page_id, priority);
+}
+
+auto ParallelBufferPoolManager::NewPageGuarded(page_id_t *page_id, PagePriority priority) -> BasicPageGuard {
+  size_t start = start_index_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    BasicPageGuard guard = instances_[(start + i) % num_instances_]->NewPageGuarded(page_id, priority);
+    if (guard.IsValid()) return guard;
+  }
+  return {};
+}
+
+void ParallelBufferPoolManager::SetStickyFrameLimit(size_t max_frames) {
+  for (auto *instance : instances_) instance->SetStickyFrameLimit(max_frames / num_instances_);
+}
+
+auto ParallelBufferPoolManager::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return nullptr;
+  return instance->FetchPageWithStrategy(page_id, strategy);
+}
+
+void ParallelBufferPoolManager::ReleaseAccessStrategy(BufferAccessStrategy *strategy) {
+  for (auto *instance : instances_) instance->ReleaseAccessStrategy(strategy);
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  if (page_id < 0) return nullptr;
+  return instances_[page_id % num_instances_];
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return nullptr;
+  return instance->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return false;
+  return instance->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return false;
+  return instance->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // every call advances the starting point, so consecutive new pages spread over all instances
+  size_t start = start_index_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; i++) {
+    Page *page = instances_[(start + i) % num_instances_]->NewPage(page_id);
+    if (page != nullptr) return page;
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  BufferPoolManagerInstance *instance = GetBufferPoolManager(page_id);
+  if (instance == nullptr) return true;
+  return instance->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() { FlushAllDirtyPages(); }
+}  // namespace bustub
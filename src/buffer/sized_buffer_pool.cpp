@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sized_buffer_pool.cpp
+//
+// Identification: src/buffer/sized_buffer_pool.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/sized_buffer_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+template <size_t PageSize>
+SizedPageGuard<PageSize>::SizedPageGuard(SizedPageGuard &&that) noexcept
+    : pool_(that.pool_), page_id_(that.page_id_), blocks_(that.blocks_), dirty_(that.dirty_) {
+  that.pool_ = nullptr;
+}
+
+template <size_t PageSize>
+auto SizedPageGuard<PageSize>::operator=(SizedPageGuard &&that) noexcept -> SizedPageGuard & {
+  if (this == &that) return *this;
+  Drop();
+  pool_ = std::exchange(that.pool_, nullptr);
+  page_id_ = that.page_id_;
+  blocks_ = that.blocks_;
+  dirty_ = that.dirty_;
+  return *this;
+}
+
+template <size_t PageSize>
+void SizedPageGuard<PageSize>::Drop() {
+  if (pool_ == nullptr) return;
+  for (size_t block = 0; block < BLOCKS_PER_PAGE; block++) {
+    pool_->blocks_.UnpinPage(SizedBufferPool<PageSize>::BlockId(page_id_, block), dirty_.test(block));
+  }
+  pool_ = nullptr;
+  dirty_.reset();
+}
+
+template <size_t PageSize>
+void SizedPageGuard<PageSize>::Read(size_t offset, char *dst, size_t size) const {
+  BUSTUB_ASSERT(offset + size <= PageSize, "read past the end of the page");
+  while (size > 0) {
+    size_t block = offset / BUSTUB_PAGE_SIZE;
+    size_t length = std::min<size_t>(size, BUSTUB_PAGE_SIZE - offset % BUSTUB_PAGE_SIZE);
+    memcpy(dst, blocks_[block]->GetData() + offset % BUSTUB_PAGE_SIZE, length);
+    dst += length;
+    offset += length;
+    size -= length;
+  }
+}
+
+template <size_t PageSize>
+void SizedPageGuard<PageSize>::Write(size_t offset, const char *src, size_t size) {
+  BUSTUB_ASSERT(offset + size <= PageSize, "write past the end of the page");
+  while (size > 0) {
+    size_t block = offset / BUSTUB_PAGE_SIZE;
+    size_t length = std::min<size_t>(size, BUSTUB_PAGE_SIZE - offset % BUSTUB_PAGE_SIZE);
+    memcpy(GetBlockMut(block) + offset % BUSTUB_PAGE_SIZE, src, length);
+    src += length;
+    offset += length;
+    size -= length;
+  }
+}
+
+template <size_t PageSize>
+auto SizedBufferPool<PageSize>::NewPage(page_id_t *page_id) -> SizedPageGuard<PageSize> {
+  std::vector<page_id_t> block_ids;
+  std::vector<Page *> pages = blocks_.NewPages(BLOCKS_PER_PAGE, &block_ids);
+  if (pages.empty()) return {};
+  // without a free page map, the blocks created under one acquisition of the latch are consecutive
+  auto first_block = static_cast<size_t>(block_ids[0]);
+  auto last_block = static_cast<size_t>(block_ids.back());
+  if (first_block % BLOCKS_PER_PAGE != 0 || last_block != first_block + BLOCKS_PER_PAGE - 1) {
+    // pages were created in the block pool behind this pool's back, these blocks cannot make a page
+    for (page_id_t block_id : block_ids) blocks_.UnpinPage(block_id, false);
+    blocks_.DeletePages(block_ids);
+    return {};
+  }
+  *page_id = static_cast<page_id_t>(first_block / BLOCKS_PER_PAGE);
+  std::array<Page *, BLOCKS_PER_PAGE> blocks;
+  std::copy(pages.begin(), pages.end(), blocks.begin());
+  return {this, *page_id, blocks};
+}
+
+template <size_t PageSize>
+auto SizedBufferPool<PageSize>::FetchPage(page_id_t page_id) -> SizedPageGuard<PageSize> {
+  std::vector<Page *> pages = blocks_.FetchPages(BlockIds(page_id));
+  if (pages.empty()) return {};
+  std::array<Page *, BLOCKS_PER_PAGE> blocks;
+  std::copy(pages.begin(), pages.end(), blocks.begin());
+  return {this, page_id, blocks};
+}
+
+template <size_t PageSize>
+auto SizedBufferPool<PageSize>::FlushPage(page_id_t page_id) -> bool {
+  return blocks_.FlushPages(BlockIds(page_id)) > 0;
+}
+
+template <size_t PageSize>
+auto SizedBufferPool<PageSize>::DeletePage(page_id_t page_id) -> bool {
+  return blocks_.DeletePages(BlockIds(page_id));
+}
+
+template <size_t PageSize>
+auto SizedBufferPool<PageSize>::BlockIds(page_id_t page_id) -> std::vector<page_id_t> {
+  std::vector<page_id_t> block_ids(BLOCKS_PER_PAGE);
+  for (size_t block = 0; block < BLOCKS_PER_PAGE; block++) block_ids[block] = BlockId(page_id, block);
+  return block_ids;
+}
+
+// the size classes of the tree, from the pages of the indexes to pages 16 times larger for the analytic tables
+template class SizedPageGuard<BUSTUB_PAGE_SIZE>;
+template class SizedPageGuard<2 * BUSTUB_PAGE_SIZE>;
+template class SizedPageGuard<4 * BUSTUB_PAGE_SIZE>;
+template class SizedPageGuard<8 * BUSTUB_PAGE_SIZE>;
+template class SizedPageGuard<16 * BUSTUB_PAGE_SIZE>;
+
+template class SizedBufferPool<BUSTUB_PAGE_SIZE>;
+template class SizedBufferPool<2 * BUSTUB_PAGE_SIZE>;
+template class SizedBufferPool<4 * BUSTUB_PAGE_SIZE>;
+template class SizedBufferPool<8 * BUSTUB_PAGE_SIZE>;
+template class SizedBufferPool<16 * BUSTUB_PAGE_SIZE>;
+
+}  // namespace bustub
@@ -0,0 +1,190 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : replacer_size_(num_frames),
+      kin_(std::max<size_t>(num_frames / 4, 1)),
+      kout_(std::max<size_t>(num_frames / 2, 1)),
+      list_of_(num_frames, NO_LIST),
+      stamps_(num_frames, 0),
+      victims_{FrameHeap(num_frames), FrameHeap(num_frames)},
+      frame_page_(num_frames, INVALID_PAGE_ID),
+      prefetched_(num_frames, false) {}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  *frame_id = -1;
+  if (curr_size_ == 0) return false;
+
+  size_t list = FirstVictimList();
+  if (victims_[list].Size() == 0) list = list == A1IN ? AM : A1IN;
+  *frame_id = victims_[list].Top();
+
+  if (list == A1IN) cold_evictions_++;
+  if (list == A1IN && frame_page_[*frame_id] != INVALID_PAGE_ID) {
+    a1out_.Push(frame_page_[*frame_id]);
+    if (a1out_.Size() > kout_) a1out_.PopBack();
+  }
+  Untrack(*frame_id);
+  return true;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+
+  switch (list_of_[frame_id]) {
+    case AM:
+      Move(frame_id, AM, clock_++);
+      break;
+    case A1IN: {
+      if (!prefetched_[frame_id]) break;  // correlated references right after the first one do not count
+      // the first access of a prefetched page, it enters the queues now
+      prefetched_[frame_id] = false;
+      page_id_t page_id = frame_page_[frame_id];
+      Move(frame_id, page_id != INVALID_PAGE_ID && a1out_.Erase(page_id) ? AM : A1IN, clock_++);
+      break;
+    }
+    default: {
+      page_id_t page_id = frame_page_[frame_id];
+      Track(frame_id, page_id != INVALID_PAGE_ID && a1out_.Erase(page_id) ? AM : A1IN, clock_++);
+      break;
+    }
+  }
+}
+
+void TwoQueueReplacer::RecordPrefetch(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (list_of_[frame_id] != NO_LIST) return;
+  // waits in A1in like a new page, but leaves a ghost in A1out alone until an access
+  Track(frame_id, A1IN, clock_++);
+  prefetched_[frame_id] = true;
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t list = list_of_[frame_id];
+  if (list == NO_LIST || victims_[list].Contains(frame_id) == set_evictable) return;
+
+  if (set_evictable) {
+    victims_[list].Push(frame_id, stamps_[frame_id]);
+    curr_size_++;
+  } else {
+    victims_[list].Erase(frame_id);
+    curr_size_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (list_of_[frame_id] == NO_LIST) return;
+  Untrack(frame_id);
+}
+
+void TwoQueueReplacer::Reinstate(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  // only an eviction from A1in leaves a ghost
+  bool from_a1in = page_id == INVALID_PAGE_ID || a1out_.Erase(page_id);
+  if (from_a1in && page_id != INVALID_PAGE_ID) cold_evictions_--;
+  frame_page_[frame_id] = page_id;
+
+  if (list_of_[frame_id] == NO_LIST) {
+    // back where it was, as if it had never left
+    Track(frame_id, from_a1in ? A1IN : AM, stamps_[frame_id]);
+    return;
+  }
+  // an access in the meantime tracked the frame as a new page in A1in
+  if (from_a1in) return;
+  Move(frame_id, AM, clock_++);
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return curr_size_;
+}
+
+void TwoQueueReplacer::SetFramePage(frame_id_t frame_id, page_id_t page_id) {
+  if (frame_id >= static_cast<int>(replacer_size_) || frame_id < 0) return;
+  std::scoped_lock<std::mutex> lock(latch_);
+  frame_page_[frame_id] = page_id;
+}
+
+void TwoQueueReplacer::Resize(size_t num_frames) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (size_t frame_id = num_frames; frame_id < replacer_size_; frame_id++) {
+    if (list_of_[frame_id] != NO_LIST) Untrack(static_cast<frame_id_t>(frame_id));
+  }
+  replacer_size_ = num_frames;
+  kin_ = std::max<size_t>(num_frames / 4, 1);
+  kout_ = std::max<size_t>(num_frames / 2, 1);
+  while (a1out_.Size() > kout_) a1out_.PopBack();
+  list_of_.resize(num_frames, NO_LIST);
+  stamps_.resize(num_frames, 0);
+  for (auto &victims : victims_) victims.Resize(num_frames);
+  frame_page_.resize(num_frames, INVALID_PAGE_ID);
+  prefetched_.resize(num_frames, false);
+}
+
+auto TwoQueueReplacer::GetColdEvictionCount() -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return cold_evictions_;
+}
+
+auto TwoQueueReplacer::PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t {
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t first = FirstVictimList();
+  size_t count = victims_[first].Peek(frame_ids, max_frames);
+  return count + victims_[first == A1IN ? AM : A1IN].Peek(frame_ids + count, max_frames - count);
+}
+
+auto TwoQueueReplacer::FirstVictimList() const -> size_t { return list_sizes_[A1IN] > kin_ ? A1IN : AM; }
+
+void TwoQueueReplacer::Track(frame_id_t frame_id, size_t list, uint64_t stamp) {
+  list_of_[frame_id] = list;
+  list_sizes_[list]++;
+  stamps_[frame_id] = stamp;
+}
+
+void TwoQueueReplacer::Move(frame_id_t frame_id, size_t list, uint64_t stamp) {
+  size_t old_list = list_of_[frame_id];
+  bool evictable = victims_[old_list].Contains(frame_id);
+  victims_[old_list].Erase(frame_id);
+  list_sizes_[old_list]--;
+  list_sizes_[list]++;
+  list_of_[frame_id] = list;
+  stamps_[frame_id] = stamp;
+  if (evictable) victims_[list].Push(frame_id, stamp);
+}
+
+void TwoQueueReplacer::Untrack(frame_id_t frame_id) {
+  size_t list = list_of_[frame_id];
+  if (victims_[list].Contains(frame_id)) {
+    victims_[list].Erase(frame_id);
+    curr_size_--;
+  }
+  list_sizes_[list]--;
+  list_of_[frame_id] = NO_LIST;
+  frame_page_[frame_id] = INVALID_PAGE_ID;
+  prefetched_[frame_id] = false;
+}
+
+}  // namespace bustub
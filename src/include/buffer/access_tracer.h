@@ -0,0 +1,169 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// access_tracer.h
+//
+// Identification: src/include/buffer/access_tracer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** Buffer pool calls and events recorded by an AccessTracer. */
+enum class TraceOp : uint8_t {
+  /** A fetch that pinned the page and counted as an access in the replacer. */
+  FETCH,
+  NEW,
+  UNPIN,
+  UNPIN_DIRTY,
+  DELETE,
+  FLUSH,
+  /** A fetch through a BufferAccessStrategy, not an access in the replacer; a miss has its ring in arg_. */
+  FETCH_STRATEGY,
+  /** A page read ahead by PrefetchPages(), which takes a frame but no pin. */
+  PREFETCH,
+  /** The priority of a resident page was set to the PagePriority in arg_, after the sticky limit applied. */
+  PRIORITY,
+  /** The page cleaner wrote the page out, it is clean from then on. */
+  CLEAN,
+  /** A strategy started its ring, arg_ numbers it and page_id_ holds its size in frames. */
+  RING,
+  /** The ring in arg_ was released with ReleaseAccessStrategy(). */
+  RELEASE_RING,
+};
+
+/** One call of a trace, as stored in the trace file. */
+struct TraceRecord {
+  /** Nanoseconds since the tracer was created. ReadTrace() returns the records in the order of their timestamps. */
+  uint64_t timestamp_ns_;
+  page_id_t page_id_;
+  /** Small number of the calling thread, in the order threads first called the traced pool. */
+  uint16_t thread_;
+  TraceOp op_;
+  /** Argument of op_, see TraceOp; 0 for the ops without one. */
+  uint8_t arg_{0};
+};
+static_assert(sizeof(TraceRecord) == 16, "trace records are stored as they are in memory");
+
+/**
+ * AccessTracer records the page calls of a buffer pool to a file, so that the workload of a deployment can be
+ * replayed offline against other pool sizes and replacement policies (see tools/bpm_replay). Only calls that
+ * succeed are recorded: the fetches and new pages that pinned a page, the unpins, flushes and deletes of pages,
+ * along with the prefetches, priorities, strategy rings and page cleaner writes that shape what the pool evicts.
+ *
+ * The file is a 16-byte header followed by 16-byte TraceRecords. Each thread buffers its records on its own and
+ * hands BUFFER_RECORDS of them at a time to a writer thread, so recording takes no shared latch and never waits for
+ * the file. The records of different threads are therefore written out of order; ReadTrace() sorts them.
+ */
+class AccessTracer {
+ public:
+  /** Records a thread buffers before they are handed to the writer. */
+  static constexpr size_t BUFFER_RECORDS = 4096;
+
+  /**
+   * @brief Create the trace file, replacing any file of that name, and start the writer. Check IsValid() afterwards.
+   * @param path path of the trace file
+   */
+  explicit AccessTracer(const std::string &path);
+
+  DISALLOW_COPY_AND_MOVE(AccessTracer);
+
+  /** @brief Write out the buffered records of every thread, stop the writer and close the file. */
+  ~AccessTracer();
+
+  /** @return true if the trace file could be created */
+  auto IsValid() const -> bool { return fd_ >= 0; }
+
+  /**
+   * @brief Record a call into the calling thread's buffer.
+   * @param op the call
+   * @param page_id the page it was on
+   * @param arg the argument of op, see TraceOp
+   */
+  void Record(TraceOp op, page_id_t page_id, uint8_t arg = 0);
+
+  /** @brief Write out the buffered records of every thread, and wait until they are written. */
+  void Flush();
+
+  /** @return the number of calls recorded */
+  auto GetRecordCount() -> uint64_t;
+
+  /**
+   * @brief Read a trace file.
+   * @param path path of the trace file
+   * @param[out] records the records of the trace, in the order of their timestamps
+   * @return false if the file cannot be read or is not a trace file
+   */
+  static auto ReadTrace(const std::string &path, std::vector<TraceRecord> *records) -> bool;
+
+ private:
+  /** "BTTR", read in the byte order the file was written in. */
+  static constexpr uint32_t MAGIC = 0x52545442;
+  /** Version 2 added the ops after FLUSH and arg_; version 1 traces are still read. */
+  static constexpr uint32_t VERSION = 2;
+
+  struct Header {
+    uint32_t magic_;
+    uint32_t version_;
+    /** Wall clock time the trace started at, in nanoseconds since the epoch. */
+    uint64_t start_ns_;
+  };
+  static_assert(sizeof(Header) == 16, "the trace header is stored as it is in memory");
+
+  /** The records of one thread. Its latch is only contended while Flush() takes the records. */
+  struct ThreadBuffer {
+    std::mutex latch_;
+    std::vector<TraceRecord> records_;
+    std::atomic<uint64_t> record_count_{0};
+  };
+
+  /** @return the buffer of the calling thread, created on its first record */
+  auto GetThreadBuffer() -> ThreadBuffer *;
+
+  /** @brief Queue records for the writer. */
+  void Submit(std::vector<TraceRecord> records);
+
+  /** @brief The writer thread: write out the queued records until the tracer stops. */
+  void RunWriter();
+
+  /** Unique across tracers, so that a thread never takes the buffer of a destroyed tracer for one of this tracer. */
+  const uint64_t id_;
+  int fd_{-1};
+  const std::chrono::steady_clock::time_point start_;
+
+  /** Protects buffers_, which only changes on the first record of a thread. */
+  std::mutex buffers_latch_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  /** Protects the fields below it. Taken after a thread buffer's latch, never while writing the file. */
+  std::mutex writer_latch_;
+  std::condition_variable writer_wakeup_;
+  std::condition_variable written_;
+  std::deque<std::vector<TraceRecord>> pending_;
+  uint64_t submitted_batches_{0};
+  uint64_t written_batches_{0};
+  bool writer_stop_{false};
+  std::thread writer_thread_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ArcReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST 2003).
+ *
+ * Resident frames are split between T1 (pages seen once recently) and T2 (pages seen at least twice), both in LRU
+ * order. Pages evicted from T1 and T2 are remembered in the ghost lists B1 and B2. A page that comes back while in
+ * B1 grows the target size p of T1, one that comes back while in B2 shrinks it, and eviction takes from T1 when it
+ * is larger than p. The policy thereby balances recency against frequency on its own.
+ *
+ * Because the buffer pool evicts before it knows which page will be loaded, the victim list is chosen from |T1|
+ * and p alone, without ARC's tie-break on the incoming page. The evictable frames of T1 and T2 are kept in heaps
+ * ordered by last access, so that eviction never steps over pinned frames.
+ */
+class ArcReplacer : public Replacer {
+ public:
+  /**
+   * @brief Creates a new ArcReplacer.
+   * @param num_frames the maximum number of frames the ArcReplacer will be required to store
+   */
+  explicit ArcReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ArcReplacer);
+
+  ~ArcReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordPrefetch(frame_id_t frame_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void Reinstate(frame_id_t frame_id, page_id_t page_id) override;
+
+  auto Size() -> size_t override;
+
+  auto PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t override;
+
+  void SetFramePage(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Resize(size_t num_frames) override;
+
+  auto GetColdEvictionCount() -> size_t override;
+
+ private:
+  static constexpr size_t T1 = 0;
+  static constexpr size_t T2 = 1;
+  static constexpr size_t NO_LIST = 2;
+
+  /** @return the list Evict() takes from first */
+  auto FirstVictimList() const -> size_t;
+  /** Keep |T1| + |B1| <= c and the directory (all four lists) <= 2c. */
+  void TrimGhosts();
+  /** Start tracking an untracked frame on the list, non-evictable, with the given stamp. Caller must hold latch_. */
+  void Track(frame_id_t frame_id, size_t list, uint64_t stamp);
+  /** Move a tracked frame to the list with a new stamp, evictable or not as it was. Caller must hold latch_. */
+  void Move(frame_id_t frame_id, size_t list, uint64_t stamp);
+  /** Stop tracking a tracked frame; its stamp is left behind for Reinstate(). Caller must hold latch_. */
+  void Untrack(frame_id_t frame_id);
+
+  size_t replacer_size_;  // c in the paper
+  size_t p_{0};           // target size of T1
+  size_t curr_size_{0};
+  size_t cold_evictions_{0};
+  uint64_t clock_{0};
+  std::mutex latch_;
+
+  std::vector<size_t> list_of_;   // T1, T2 or NO_LIST for an untracked frame
+  size_t list_sizes_[2]{0, 0};    // tracked frames of each list, evictable or not
+  std::vector<uint64_t> stamps_;  // last access of the frame
+  FrameHeap victims_[2];          // evictable frames of each list by stamp
+  GhostList b1_;
+  GhostList b2_;
+  std::vector<page_id_t> frame_page_;
+  std::vector<bool> prefetched_;  // frames tracked by RecordPrefetch() and not accessed since
+};
+
+}  // namespace bustub
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferAccessStrategy confines the pages a large sequential scan reads to a small private ring of frames, in the
+ * spirit of PostgreSQL's BULKREAD strategy. Misses fetched with a strategy recycle the ring's frames instead of
+ * evicting from the whole pool, and neither misses nor hits under a strategy are recorded in the replacer, so a scan
+ * cannot push the hot pages of other workloads out of the pool.
+ *
+ * A page of the ring that is fetched without the strategy is taken over by the pool and replaced in the ring. A
+ * strategy is meant to be used by one scan (one thread) at a time, and must be released with
+ * BufferPoolManagerInstance::ReleaseAccessStrategy() (or the ParallelBufferPoolManager equivalent) before it is
+ * destroyed.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * @brief Creates a new BufferAccessStrategy.
+   * @param ring_size the number of frames in the ring of each buffer pool instance
+   */
+  explicit BufferAccessStrategy(size_t ring_size) : ring_size_(ring_size) {
+    BUSTUB_ASSERT(ring_size > 0, "the ring needs at least one frame");
+  }
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  ~BufferAccessStrategy() {
+    for (const Ring &ring : rings_) BUSTUB_ASSERT(ring.frames_.empty(), "strategy destroyed before it was released");
+  }
+
+  /** @return the number of frames in the ring of each buffer pool instance */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  /** The frames of one buffer pool instance; frames_ grows until ring_size_, then next_ wraps around. */
+  struct Ring {
+    std::vector<frame_id_t> frames_;
+    size_t next_{0};
+    /** Number of the ring in the trace of the instance, 0 until its first traced miss. */
+    uint8_t trace_ring_{0};
+  };
+
+  /** @return the ring of the instance_index-th buffer pool instance */
+  auto GetRing(size_t instance_index) -> Ring & {
+    if (rings_.size() <= instance_index) rings_.resize(instance_index + 1);
+    return rings_[instance_index];
+  }
+
+  const size_t ring_size_;
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
@@ -12,17 +12,37 @@
 
 #pragma once
 
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <functional>
 #include <list>
-#include <mutex>  // NOLINT
-#include <unordered_map>
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "buffer/access_tracer.h"
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/free_page_map.h"
+#include "buffer/hot_page_file.h"
+#include "buffer/page_segment.h"
+#include "buffer/page_table.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
+#include "storage/disk/mapped_file.h"
+#include "storage/disk/page_checksums.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -37,9 +57,29 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_policy the replacement policy of the buffer pool
+   * @param arena_options huge page, alignment and NUMA options of the memory holding the frames
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                            const FrameArenaOptions &arena_options = FrameArenaOptions{});
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of this instance's buffer pool
+   * @param num_instances total number of instances in the parallel buffer pool
+   * @param instance_index index of this instance in the parallel buffer pool; it allocates the page ids congruent to
+   * instance_index modulo num_instances
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_policy the replacement policy of the buffer pool
+   * @param arena_options huge page, alignment and NUMA options of the memory holding the frames
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                            const FrameArenaOptions &arena_options = FrameArenaOptions{});
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -49,8 +89,363 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
-  /** @brief Return the pointer to all the pages in the buffer pool. */
-  auto GetPages() -> Page * { return pages_; }
+  /**
+   * @brief Return the pointer to the pages of the buffer pool's first chunk, see Resize(). They form a plain array
+   * unless the frames are aligned (FrameArenaOptions::frame_alignment_), in which case GetFrameStride() bytes
+   * separate two pages.
+   */
+  auto GetPages() -> Page * { return GetFrame(0); }
+
+  /** @return the distance in bytes between the pages of two consecutive frames of a chunk */
+  auto GetFrameStride() const -> size_t { return chunks_[0].arena_.load()->GetFrameStride(); }
+
+  /**
+   * @brief Grow or shrink the buffer pool while it stays in use. The pool is made of chunks of as many frames as it
+   * had initially, and is resized to the smallest number of chunks that holds new_pool_size frames, at most
+   * MAX_FRAME_CHUNKS.
+   *
+   * Growing maps the new chunks and adds their frames to the free list before returning. Shrinking takes the frames
+   * beyond the new size out of use right away and returns; a background thread then writes out and drops their
+   * pages as they become unpinned, and releases the chunks once they are empty. GetPoolSize() reports the old size
+   * until then.
+   * @param new_pool_size the number of frames wanted
+   * @return false if new_pool_size is out of range or a previous shrink is still in progress
+   */
+  auto Resize(size_t new_pool_size) -> bool;
+
+  /**
+   * @param new_pool_size the number of frames wanted
+   * @return whether Resize(new_pool_size) would be accepted now
+   */
+  auto CanResize(size_t new_pool_size) -> bool;
+
+  /**
+   * @brief Take a snapshot of the pool's metrics. The counters only grow, rates are the difference between two
+   * snapshots.
+   * @return the counters, latency histograms and current gauges of the pool
+   */
+  auto GetMetrics() -> BufferPoolMetricsSnapshot;
+
+  /** Maximum number of chunks of a buffer pool, see Resize(). */
+  static constexpr size_t MAX_FRAME_CHUNKS = 64;
+
+  /**
+   * @brief Start the background page cleaner, restarting it if it is already running. Every round it looks at the
+   * frames next in line for eviction and writes their dirty pages out, so that evictions find clean victims and
+   * skip the write-back on the foreground path.
+   * @param clean_low_watermark number of frames at the head of the eviction order, free frames included, that the
+   * cleaner keeps clean
+   * @param max_writes_per_second upper bound on the rate of page writes issued by the cleaner
+   */
+  void StartPageCleaner(size_t clean_low_watermark, size_t max_writes_per_second);
+
+  /** @brief Stop the background page cleaner if it is running. */
+  void StopPageCleaner();
+
+  /**
+   * @brief Start loading pages that will be fetched soon, without waiting for them. Each page that is not resident
+   * gets a frame and a read request on the disk scheduler; the frame stays pinned by the prefetch until the read
+   * completes and is then left unpinned, so a later FetchPage() either hits or waits only for the read in flight.
+   * A prefetch is no access of the page for the replacer, the first fetch is. Prefetching stops at the first page
+   * for which no frame is available.
+   * @param page_ids ids of the pages to load
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Route the pool's disk I/O through io_uring on the disk manager's database file instead of the disk
+   * manager's blocking calls; see DiskScheduler. Must be called before the pool is used.
+   * @param db_file path of the database file of the disk manager
+   * @param direct_io true to bypass the OS page cache with O_DIRECT
+   * @return true if io_uring is used, false if it is not available and the disk manager is still used
+   */
+  auto EnableIoUring(const std::string &db_file, bool direct_io) -> bool;
+
+  /**
+   * @brief Track the page ids in use in a FreePageMap kept in the database file, so that NewPage() hands out the ids
+   * of deleted pages again before growing the file. The map pages written by an earlier run are read back. Must be
+   * called before the pool is used. A map page is written out before the first write of a page it marks in use that
+   * its copy on disk does not, so that a page on disk is never counted free, and by FlushAllDirtyPages() and the
+   * destructor.
+   * @param[out] free_pages if not nullptr, receives the number of free pages found in the map
+   * @return false if the database has pages but no map, in which case no map is kept
+   */
+  auto EnableFreePageMap(size_t *free_pages = nullptr) -> bool;
+
+  /** @return whether EnableFreePageMap() would be accepted now */
+  auto CanEnableFreePageMap() -> bool;
+
+  /**
+   * @brief Keep clean evicted pages in a CompressedPageCache, so that a miss on one of them decompresses it instead of
+   * reading the disk. Must be called before the pool is used.
+   * @param capacity the most bytes of compressed pages to keep
+   */
+  void EnableCompressedCache(size_t capacity);
+
+  /**
+   * @brief Map the database file read-only, see MappedFile, so that FetchPageMapped() can read pages where the kernel
+   * (or, on a DAX file system, the persistent memory) keeps them. Must be called before the pool is used, and only
+   * once: the pages read through a mapping keep pointing into it, so it is never replaced.
+   * @param db_file path of the database file of the disk manager
+   * @return false if the file cannot be opened or a mapping is already in place; without a mapping FetchPageMapped()
+   * is FetchPageRead()
+   */
+  auto EnableMappedReads(const std::string &db_file) -> bool;
+
+  /**
+   * @brief Record a CRC32C of every page the pool writes in a checksum file, see PageChecksums, and verify the pages
+   * it reads against them, including the ones read through the mapping of EnableMappedReads(). A page that fails
+   * verification is still loaded; the failure is logged, counted in the metrics and reported by GetCorruptPages().
+   * Must be called before the pool is used.
+   * @param checksum_file path of the checksum file, created if it does not exist
+   * @return false if the file cannot be opened or is not a checksum file, in which case pages are not checksummed
+   */
+  auto EnableChecksums(const std::string &checksum_file) -> bool;
+
+  /** @return the pages whose checksum did not match when last read and that were not written since */
+  auto GetCorruptPages() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Record the page calls of the pool to a trace file, see AccessTracer, for tools/bpm_replay to replay
+   * against other pool sizes and policies. The replay is an estimate: it models the replacer, pins, priorities,
+   * prefetches, strategy rings and the pages the cleaner wrote, but not the timing of I/O, the compressed cache, nor
+   * the interleaving of the threads beyond the order of their records. The trace is complete once the pool is
+   * destroyed. Must be called before the pool is used.
+   * @param trace_file path of the trace file, replaced if it exists
+   * @return false if the file cannot be created, in which case nothing is traced
+   */
+  auto EnableTracing(const std::string &trace_file) -> bool;
+
+  /**
+   * @brief Let the LRU-K replacer adapt its lookback k to the workload between min_k and max_k, see
+   * LRUKReplacer::SetAdaptiveK(). The current k is reported by GetMetrics(). Must be called before the pool is used.
+   * @param min_k the smallest k, at least 1
+   * @param max_k the largest k, at least min_k
+   * @return false if the pool does not use the LRU-K policy or the bounds are invalid, in which case k stays fixed
+   */
+  auto EnableAdaptiveK(size_t min_k, size_t max_k) -> bool;
+
+  /**
+   * @brief Create a new page like NewPage(), with the next page id of the segment's current extent. When the extent
+   * is used up the segment gets a new one of PageSegment::GetExtentPages() pages, at most
+   * FreePageMap::MAX_RUN_PAGES, taken from a free run of the free page map if enabled, from the end of the file
+   * otherwise.
+   * @param segment the segment the page belongs to
+   * @param[out] page_id id of created page
+   * @return nullptr if every frame is pinned, otherwise pointer to the new page
+   */
+  auto NewPageInSegment(PageSegment *segment, page_id_t *page_id) -> Page *;
+
+  /**
+   * @brief Create a new page like NewPage() with an id this instance already reserved by ReservePageRun().
+   * @param page_id id of the page to create
+   * @return nullptr if every frame is pinned, otherwise pointer to the new page
+   */
+  auto NewReservedPage(page_id_t page_id) -> Page *;
+
+  /**
+   * @return the number of page ids of this instance allocated so far, the first page number past the end of the
+   * file; page number i is page id i * num_instances + instance_index
+   */
+  auto GetEndPageNo() -> size_t;
+
+  /**
+   * @brief Reserve the page numbers [page_no, page_no + num_pages) at the end of the file, see GetEndPageNo(). Page
+   * numbers skipped on the way become free pages with a free page map and are lost without one. Instances of a
+   * parallel pool reserving the same page numbers make up a run of consecutive page ids.
+   * @param page_no first page number of the run, at or past the end of the file
+   * @param num_pages length of the run; with a free page map the run must span no map page, see
+   * FreePageMap::FitRun()
+   * @return false if page_no is before the end of the file
+   */
+  auto ReservePageRun(size_t page_no, size_t num_pages) -> bool;
+
+  /**
+   * @brief Write every dirty page out, as a checkpoint does. The dirty pages are written in page id order, each run
+   * of consecutive pages with one vectored write, and their dirty flags are cleared. Modified pages of the free page
+   * map are written too. A page whose write fails stays dirty.
+   * @return the number of bytes written, failed writes left out
+   */
+  auto FlushAllDirtyPages() -> size_t;
+
+  /**
+   * @brief List the resident pages, hottest first: the pinned pages, then the unpinned ones in the reverse of the
+   * order the replacer would evict them in. Pages held by the ring of an access strategy are left out.
+   * @return the page ids
+   */
+  auto GetHotPages() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Write the ids of the resident pages to a file, hottest first, for LoadHotPages() to warm up the pool
+   * after a restart. Called on demand or before shutting down.
+   * @param path path of the file, see HotPageFile
+   * @return false if the file could not be written
+   */
+  auto DumpHotPages(const std::string &path) -> bool;
+
+  /**
+   * @brief Warm up the pool with the pages listed in a file written by DumpHotPages(), see WarmUp().
+   * @param path path of the file
+   * @return the number of pages being loaded, 0 if the file could not be read
+   */
+  auto LoadHotPages(const std::string &path) -> size_t;
+
+  /**
+   * @brief Start loading pages into free frames without waiting for them, while the pool keeps serving requests.
+   * The hottest pages that fit in the free list are taken, pages of other instances and resident pages skipped;
+   * no page is evicted for them. Their reads are issued in page id order, runs of consecutive pages as one
+   * vectored read, and the pages are left unpinned once loaded, the hottest being the last one the replacer evicts.
+   * A fetch of a page still being loaded waits for its read only.
+   * @param page_ids page ids, hottest first
+   * @return the number of pages being loaded
+   */
+  auto WarmUp(const std::vector<page_id_t> &page_ids) -> size_t;
+
+  /**
+   * @brief Fetch several pages at once, e.g. the nodes of a B+ tree split, all or nothing. The frames of the missing
+   * pages are reserved under a single acquisition of the latch, the replacer is updated in one batch, and the reads
+   * of the missing pages go to the disk scheduler as one submission, runs of consecutive pages as one vectored read.
+   * A page listed twice is pinned twice.
+   * @param page_ids ids of the pages to fetch
+   * @return the pinned pages in the order of page_ids, empty if they cannot all be fetched, in which case none of
+   * them is pinned
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids) -> std::vector<Page *>;
+
+  /**
+   * @brief Create several new pages at once like NewPage(), all or nothing, with their frames reserved under a
+   * single acquisition of the latch.
+   * @param num_pages number of pages to create
+   * @param[out] page_ids ids of the created pages
+   * @return the pinned new pages in the order of page_ids, empty if fewer than num_pages frames are unpinned
+   */
+  auto NewPages(size_t num_pages, std::vector<page_id_t> *page_ids) -> std::vector<Page *>;
+
+  /**
+   * @brief Delete several pages at once like DeletePage(), all or nothing: under a single acquisition of the latch,
+   * either none of them is pinned and all are deleted, or none is.
+   * @param page_ids ids of the pages to delete, each listed once
+   * @return false if one of the pages is pinned, in which case none of them is deleted
+   */
+  auto DeletePages(const std::vector<page_id_t> &page_ids) -> bool;
+
+  /**
+   * @brief Write out the resident pages among several, like FlushPage(), under a single acquisition of the latch.
+   * The writes go to the disk scheduler as one submission, runs of consecutive pages as one vectored write.
+   * @param page_ids ids of the pages to flush
+   * @return the number of the pages that were resident
+   */
+  auto FlushPages(const std::vector<page_id_t> &page_ids) -> size_t;
+
+  /**
+   * @brief Fetch a page and pin it for as long as the returned guard lives. Unlike FetchPage() and UnpinPage(), the
+   * guard unpins the frame directly, without a second page table lookup, and cannot leak its pin.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, empty (IsValid() false) if the page cannot be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
+
+  /**
+   * @brief Like FetchPageBasic(), and hold the page's read latch as long as the guard lives.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, empty if the page cannot be fetched
+   */
+  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
+
+  /**
+   * @brief Like FetchPageBasic(), and hold the page's write latch as long as the guard lives. The page is marked
+   * dirty when the guard is released.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, empty if the page cannot be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+
+  /**
+   * @brief Like FetchPageRead(), except that a miss takes no copy: the frame maps the page, and the guard reads it
+   * right out of the file mapping of EnableMappedReads(). The frame is pinned and tracked by the replacer like any
+   * other, so the pool still bounds what is in use. A regular fetch of the page copies it into the frame first, so
+   * that writes and write-backs only ever see frame data. Pages past the end of the file are fetched as usual.
+   * @param page_id id of page to be fetched
+   * @return the guard of the page, empty if the page cannot be fetched
+   */
+  auto FetchPageMapped(page_id_t page_id) -> ReadPageGuard;
+
+  /**
+   * @brief Fetch a page without waiting for it to be read, so that a few threads can keep many fetches in flight on
+   * the io_uring backend. A hit completes at once, as does a fetch that finds every frame pinned. A miss installs
+   * the page in a frame and schedules the write-back of the evicted page and the read on the disk scheduler, and a
+   * hit on a page another fetch is still loading waits for that load; both are pending. A miss on a page whose old
+   * image is still being written back waits for that write first, as in FetchPage().
+   *
+   * A pending fetch calls on_loaded with the pinned page once it is loaded, possibly before FetchPageAsync()
+   * returns, on the thread that completed the load, often a disk scheduler thread. Threads may wait for I/O while
+   * holding the pool's latch, so on_loaded must not block or call into the pool: it should hand the page over to
+   * another thread, as the coroutine awaitable of buffer/fetch_page_awaitable.h does.
+   * @param page_id id of page to be fetched
+   * @param on_loaded completion of a pending fetch, not called otherwise
+   * @param[out] pending set to whether the fetch is pending
+   * @return the pinned page if the fetch completed at once, nullptr if it is pending or every frame is pinned
+   */
+  auto FetchPageAsync(page_id_t page_id, std::function<void(Page *)> on_loaded, bool *pending) -> Page *;
+
+  /**
+   * @brief Create a new page like NewPage(), pinned for as long as the returned guard lives.
+   * @param[out] page_id id of created page
+   * @return the guard of the page, empty if every frame is pinned
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+
+  /**
+   * @brief Fetch a page like FetchPage() and put its frame in the given priority class, which the replacer evicts
+   * after every lower class (see PagePriority). The class sticks to the frame until the page leaves the pool; a
+   * plain FetchPage() leaves it unchanged. A STICKY hint is taken as NORMAL once the sticky frames reach the limit
+   * of SetStickyFrameLimit().
+   * @param page_id id of page to be fetched
+   * @param priority the class of the page
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPageWithPriority(page_id_t page_id, PagePriority priority) -> Page *;
+
+  /**
+   * @brief Create a new page like NewPage() in the given priority class, see FetchPageWithPriority().
+   * @param[out] page_id id of created page
+   * @param priority the class of the page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPageWithPriority(page_id_t *page_id, PagePriority priority) -> Page *;
+
+  /** @brief FetchPageBasic() with a priority class, see FetchPageWithPriority(). */
+  auto FetchPageBasic(page_id_t page_id, PagePriority priority) -> BasicPageGuard;
+
+  /** @brief NewPageGuarded() with a priority class, see FetchPageWithPriority(). */
+  auto NewPageGuarded(page_id_t *page_id, PagePriority priority) -> BasicPageGuard;
+
+  /**
+   * @brief Limit the number of frames holding STICKY pages, a quarter of the pool by default, so that sticky pages
+   * cannot crowd everything else out of the pool. Frames that are already sticky stay so until their pages leave.
+   * The default follows the pool through Resize(), a limit set here does not.
+   * @param max_frames the most frames that may hold sticky pages, 0 to disable the class
+   */
+  void SetStickyFrameLimit(size_t max_frames) {
+    sticky_limit_set_ = true;
+    max_sticky_frames_ = max_frames;
+  }
+
+  /**
+   * @brief Fetch a page on behalf of a scan. Like FetchPage(), except that a miss reuses a frame of the strategy's
+   * ring once the ring is full, and that neither hits nor misses are recorded in the replacer.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's access strategy, nullptr for a regular fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page *;
+
+  /**
+   * @brief Give the frames of the strategy's ring back to the pool. Clean unpinned pages are dropped and their frames
+   * return to the free list; the other frames are handed over to the replacer.
+   * @param strategy the access strategy to release
+   */
+  void ReleaseAccessStrategy(BufferAccessStrategy *strategy);
 
  protected:
   /**
@@ -60,8 +455,10 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * are currently in use and not evictable (in another word, pinned).
    *
    * You should pick the replacement frame from either the free list or the replacer (always find from the free list
-   * first), and then call the AllocatePage() method to get a new page id. If the replacement frame has a dirty page,
-   * you should write it back to the disk first. You also need to reset the memory and metadata for the new page.
+   * first), and then call the AllocatePage() method to get a new page id. An instance of a ParallelBufferPoolManager
+   * only allocates the ids congruent to instance_index_ modulo num_instances_, so the instances never hand out the
+   * same id and every id maps back to the instance that created it. If the replacement frame has a dirty page, you
+   * should write it back to the disk first. You also need to reset the memory and metadata for the new page.
    *
    * Remember to "Pin" the frame by calling replacer.SetEvictable(frame_id, false)
    * so that the replacer wouldn't evict the frame before the buffer pool manager "Unpin"s it.
@@ -121,15 +518,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the dirty pages in the buffer pool to disk, see FlushAllDirtyPages().
    */
   void FlushAllPgsImp() override;
 
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, only deallocate it and return true.
+   * If the page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
    * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
@@ -140,27 +537,508 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of frames in the buffer pool's chunks. Changed while holding latch_ and every frame latch. */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames of a chunk, the initial pool size. */
+  const size_t chunk_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
   /** The next page id to be allocated  */
   std::atomic<page_id_t> next_page_id_ = 0;
   /** Bucket size for the extendible hash table */
   const size_t bucket_size_ = 4;
 
-  /** Array of buffer pool pages. */
-  Page *pages_;
+  /**
+   * Per-frame latch guarding the pin count, dirty flag and I/O state of the frame's page; its page id is changed only
+   * while holding both latch_ and this latch. A frame is marked as having I/O in progress while its page is read
+   * from disk (and its previous page written back) without latch_ held; threads that pin the frame meanwhile wait on
+   * io_done_ rather than on latch_.
+   *
+   * A frame is marked as cleaning while the page cleaner or a flush writes its dirty page out. It stays resident and
+   * can be pinned, but it is not evictable until the write completes, which is also signalled on io_done_.
+   *
+   * A frame that belongs to the ring of a BufferAccessStrategy is recycled by that strategy alone: it is not tracked
+   * by the replacer and not counted in unpinned_frames_.
+   *
+   * A frame beyond the target size of a shrink is retiring: its page can still be pinned, but the frame is neither
+   * evictable nor counted in unpinned_frames_, and it is not reused once the page is gone.
+   */
+  struct FrameLatch {
+    std::mutex latch_;
+    std::condition_variable io_done_;
+    bool io_in_progress_{false};
+    bool cleaning_{false};
+    /** Whether the page is read latched for the write of cleaning_, which it is unless it was pinned. */
+    bool cleaning_latched_{false};
+    bool retiring_{false};
+    const BufferAccessStrategy *ring_owner_{nullptr};
+    PagePriority priority_{PagePriority::NORMAL};
+    /** The page in mapped_file_ if the frame maps it rather than holds its data, see FetchPageMapped(). */
+    const char *mapped_data_{nullptr};
+    /** Completions of the FetchPageAsync() calls that hit while io_in_progress_, run once the I/O is done. */
+    std::vector<std::function<void()>> io_waiters_;
+  };
+
+  /**
+   * The frames of a chunk and their latches. Lookups read a chunk without any latch: the latch array is allocated
+   * the first time the chunk is used and kept until the pool is destroyed, so a stale frame id can always be
+   * latched, while the arena goes away when a shrink releases the chunk.
+   */
+  struct FrameChunk {
+    std::atomic<FrameArena *> arena_{nullptr};
+    std::atomic<FrameLatch *> latches_{nullptr};
+  };
+
+  /** @return the page of the given frame */
+  auto GetFrame(frame_id_t frame_id) const -> Page * {
+    const FrameChunk &chunk = chunks_[static_cast<size_t>(frame_id) / chunk_size_];
+    return chunk.arena_.load(std::memory_order_acquire)->GetFrame(static_cast<frame_id_t>(frame_id % chunk_size_));
+  }
+
+  /** @return the latch of the given frame */
+  auto GetFrameLatch(frame_id_t frame_id) -> FrameLatch & {
+    const FrameChunk &chunk = chunks_[static_cast<size_t>(frame_id) / chunk_size_];
+    return chunk.latches_.load(std::memory_order_acquire)[frame_id % chunk_size_];
+  }
+
+  /** @return the current page table */
+  auto GetPageTable() const -> PageTable * { return page_table_.load(std::memory_order_acquire); }
+
+  /** Frames of the buffer pool, chunk i holding frames [i * chunk_size_, (i + 1) * chunk_size_). */
+  FrameChunk chunks_[MAX_FRAME_CHUNKS];
+  /** Options the chunks' arenas are created with. */
+  const FrameArenaOptions arena_options_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
+  /** Executes the pool's disk I/O, the DiskManager is only reached through it. */
+  DiskScheduler *disk_scheduler_;
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  /**
+   * Page table for keeping track of buffer pool pages. Modified under latch_, probed optimistically without it.
+   * Growing the pool past its capacity replaces it; the old tables are kept until destruction, because a lookup may
+   * still be probing them.
+   */
+  std::atomic<PageTable *> page_table_;
+  std::vector<PageTable *> retired_page_tables_;
+  /**
+   * Replacer to find unpinned pages for replacement. A hit does not take its frame out of the replacer: Evict() may
+   * return a pinned frame, whose eviction AcquireFrame() takes back. A frame that must stay put for another reason
+   * (being cleaned, retiring) is made non-evictable explicitly, whether it is pinned or not.
+   */
+  Replacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * Number of frames with a zero pin count, i.e. the free list plus the unpinned frames of the replacer. Atomic:
+   * pins and unpins update it under the frame latch alone, the free list under latch_, and it is read without any
+   * latch, so that a fully pinned pool can be rejected before taking the latch.
+   */
+  std::atomic<size_t> unpinned_frames_;
+  /**
+   * Number of frames whose priority_ is STICKY, and the most there may be. Updated under the frame latches. The
+   * limit is a quarter of the pool until SetStickyFrameLimit() sets it.
+   */
+  std::atomic<size_t> sticky_frames_{0};
+  std::atomic<size_t> max_sticky_frames_;
+  std::atomic<bool> sticky_limit_set_{false};
+  /**
+   * Evicted dirty pages whose write-back is still in flight. A miss on one of them waits on writeback_done_. Guarded
+   * by writeback_latch_ rather than latch_, so that I/O completions never need latch_ and a thread may wait for I/O
+   * while holding it.
+   */
+  std::unordered_set<page_id_t> writeback_pages_;
+  std::mutex writeback_latch_;
+  std::condition_variable writeback_done_;
+  /**
+   * This latch protects modifications of the page table, the free list and frame ownership (which page a frame
+   * holds). Hits and unpins of resident pages only take the frame latch. It is never held across disk I/O or while
+   * waiting for the page cleaner or a flush.
+   */
   std::mutex latch_;
+  /** Page ids in use once EnableFreePageMap() was called, nullptr before. Guarded by latch_. */
+  FreePageMap *free_page_map_{nullptr};
+  /**
+   * Serializes the writes of the map pages, so that an older image of a map page never lands on disk after a newer
+   * one. Taken before latch_.
+   */
+  std::mutex map_write_latch_;
+  /**
+   * Deleted pages whose id is freed once their write-back completes, and the ids FinishWriteback() released since,
+   * which FreeReleasedPages() hands to the free page map. Guarded by writeback_latch_.
+   */
+  std::unordered_set<page_id_t> pending_free_pages_;
+  std::vector<page_id_t> released_free_pages_;
+  /** Clean evicted pages once EnableCompressedCache() was called, nullptr before. Has a latch of its own. */
+  CompressedPageCache *compressed_cache_{nullptr};
+  /** The database file once EnableMappedReads() was called, nullptr before. */
+  MappedFile *mapped_file_{nullptr};
+  /** Checksums of the pages once EnableChecksums() was called, nullptr before. Has a latch of its own. */
+  PageChecksums *checksums_{nullptr};
+  /** Trace of the page calls once EnableTracing() was called, nullptr before. Has a latch of its own. */
+  AccessTracer *tracer_{nullptr};
+  /** Number of the last ring numbered in the trace, from 1 to 255 and around again. Protected by latch_. */
+  uint8_t last_trace_ring_{0};
+  /** Hit, miss and eviction counters and latency histograms, sharded so that they do not serialize threads. */
+  BufferPoolMetrics metrics_;
+
+  /** Pause between two rounds of the page cleaner. */
+  static constexpr std::chrono::milliseconds PAGE_CLEANER_INTERVAL{10};
+  /** Page cleaner settings, fixed while the cleaner thread runs. */
+  size_t clean_low_watermark_{0};
+  size_t max_writes_per_second_{0};
+  std::thread cleaner_thread_;
+  /**
+   * Protects cleaner_stop_, cleaning_frames_ and cleaned_frames_. Taken last: latch_ or a frame latch may be held
+   * when taking it, but never taken while it is held.
+   */
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_wakeup_;
+  bool cleaner_stop_{false};
+  /** Number of frames marked as cleaning. A fetch that finds no victim while it is > 0 waits in WaitForCleaning(). */
+  size_t cleaning_frames_{0};
+  /** Number of cleaned frames the cleaner has released so far, signalled on cleaning_done_. */
+  size_t cleaned_frames_{0};
+  std::condition_variable cleaning_done_;
+
+  /** Pause between two attempts of a shrink to drop the pages that were still pinned. */
+  static constexpr std::chrono::milliseconds SHRINK_RETRY_INTERVAL{10};
+  /** Serializes Resize() calls. Taken before latch_. */
+  std::mutex resize_latch_;
+  /** Frames from target_pool_size_ up to pool_size_ are retiring while shrinking_. Guarded by latch_. */
+  size_t target_pool_size_;
+  bool shrinking_{false};
+  /** Drains the retiring frames of a shrink; stopped by the destructor through shrink_stop_ (guarded by latch_). */
+  std::thread shrink_thread_;
+  bool shrink_stop_{false};
+  std::condition_variable shrink_wakeup_;
+
+  friend class BasicPageGuard;
+
+  /**
+   * @brief NewPgImp(), also returning the frame of the new page in frame_id.
+   * @param segment the segment whose extent the page id comes from, nullptr to allocate a single page
+   */
+  auto NewFrame(page_id_t *page_id, frame_id_t *frame_id, PageSegment *segment = nullptr) -> Page *;
+
+  /**
+   * @brief FetchPageWithStrategy(), also returning the frame of the page in frame_id.
+   * @param[in,out] mapped_data nullptr for a regular fetch. For a mapped fetch, the page in mapped_file_ on the way
+   * in, and on the way out the data to read: that same mapping if the frame maps the page, else the frame's data
+   */
+  auto FetchFrame(page_id_t page_id, BufferAccessStrategy *strategy, frame_id_t *frame_id,
+                  const char **mapped_data = nullptr) -> Page *;
+
+  /**
+   * @brief Look page_id up in the page table under the latch, first waiting, without the latch, until no
+   * write-back of an earlier image of the page is in flight.
+   * @param[out] frame_id frame holding page_id if it is resident
+   * @param lock the held lock of the latch, released while waiting
+   * @return true if page_id is resident
+   */
+  auto FindLoadablePage(page_id_t page_id, frame_id_t *frame_id, std::unique_lock<std::mutex> *lock) -> bool;
+
+  /** @brief Drop a pin of a frame whose page is known to be pinned, e.g. by a page guard, with no page table lookup. */
+  void UnpinFrame(frame_id_t frame_id, bool is_dirty);
+  /** @brief Record a call in the trace, if the pool is traced. */
+  void Trace(TraceOp op, page_id_t page_id, uint8_t arg = 0) {
+    if (tracer_ != nullptr) tracer_->Record(op, page_id, arg);
+  }
+
+  /**
+   * @brief Number the ring of a strategy in the trace, recording its size the first time. Caller should acquire the
+   * latch.
+   * @return the number of the ring, 0 if the pool is not traced
+   */
+  auto TraceRing(BufferAccessStrategy *strategy) -> uint8_t;
+
+  /**
+   * @brief Drop a pin of a frame whose frame latch is held.
+   * @return false if the frame's page is not pinned
+   */
+  auto UnpinLatchedFrame(frame_id_t frame_id, bool is_dirty) -> bool;
+
+  /** @brief Lock the latch, recording in metrics_ how long the caller waited for it if it was taken. */
+  auto LockLatch() -> std::unique_lock<std::mutex>;
+
+  /**
+   * @brief Take a frame for a new resident page, from the free list first and the replacer otherwise. An evicted
+   * page is dropped from the page table; if it is dirty it is added to writeback_pages_ and must be written out by
+   * FinishIo(). Never waits: if the only candidates are being cleaned it fails, and a caller that can block retries
+   * after WaitForCleaning(). Caller should acquire the latch before calling this function.
+   * @param[out] frame_id id of the acquired frame
+   * @param[out] writeback_page_id id of the evicted page to write back, INVALID_PAGE_ID if none
+   * @return false if no frame is evictable, true otherwise
+   */
+  auto AcquireFrame(frame_id_t *frame_id, page_id_t *writeback_page_id) -> bool;
+
+  /**
+   * @brief After AcquireFrame() failed, wait for the page cleaner to finish a write if it is cleaning frames,
+   * releasing the latch meanwhile. The caller must redo its lookup, the page may have been loaded in the meantime.
+   * @param lock the caller's lock on latch_, unlocked while waiting and locked again on return
+   * @return false without waiting if no frame is being cleaned, so that no frame will become evictable
+   */
+  auto WaitForCleaning(std::unique_lock<std::mutex> *lock) -> bool;
+
+  /**
+   * @brief Take a frame for a page fetched with an access strategy. Until the ring is full frames come from
+   * AcquireFrame(); then the ring's next frame is recycled, unless the scan still pins it or the pool took it over,
+   * in which case a frame from AcquireFrame() replaces it in the ring. Caller should acquire the latch.
+   * @param strategy the access strategy of the fetch
+   * @param[out] frame_id id of the acquired frame
+   * @param[out] writeback_page_id id of the evicted page to write back, INVALID_PAGE_ID if none
+   * @return false if no frame is available, true otherwise
+   */
+  auto AcquireRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id, page_id_t *writeback_page_id) -> bool;
+
+  /**
+   * @brief Drop the page of an unpinned frame from the page table. Caller should acquire the latch and the frame
+   * latch.
+   * @return the page id to write back (and added to writeback_pages_) if the page is dirty, INVALID_PAGE_ID otherwise
+   */
+  auto DetachPage(frame_id_t frame_id) -> page_id_t;
+
+  /**
+   * @brief Set the priority class of a frame pinned by the caller, in the frame latch and the replacer.
+   * @param frame_id id of the frame
+   * @param priority the class wanted, demoted to NORMAL if the sticky frames are at their limit
+   */
+  void SetFramePriority(frame_id_t frame_id, PagePriority priority);
+
+  /** @brief Put a frame whose page leaves the pool back in the NORMAL class. Caller should hold the frame latch. */
+  void ClearFramePriority(FrameLatch *frame_latch) {
+    if (frame_latch->priority_ == PagePriority::STICKY) sticky_frames_--;
+    frame_latch->priority_ = PagePriority::NORMAL;
+  }
+
+  /**
+   * @brief Hand a frame over from its strategy's ring to the replacer. Caller should acquire the frame latch.
+   * @param frame_id id of a frame that belongs to a ring
+   */
+  void AdoptRingFrame(frame_id_t frame_id);
+
+  /**
+   * @brief Map page_id to an acquired frame, pin it once and mark its I/O in progress. Caller should acquire the
+   * latch before calling this function.
+   * @param strategy the strategy whose ring the frame joins, nullptr to track the frame in the replacer
+   * @param prefetch true if the page is read ahead of any access, which the replacer then does not count as one:
+   * the first fetch of the page records its first access
+   * @return pointer to the page in the frame
+   */
+  auto InstallPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy, bool prefetch = false)
+      -> Page *;
+
+  /**
+   * @brief InstallPage() without the replacer bookkeeping, which a batch does for all its frames at once. Caller
+   * should acquire the latch.
+   * @return pointer to the page in the frame
+   */
+  auto MapPage(frame_id_t frame_id, page_id_t page_id, BufferAccessStrategy *strategy) -> Page *;
+
+  /**
+   * @brief Acquire num_frames frames for a batch, all or nothing. Nothing is evicted unless the free and evictable
+   * frames are enough; only lock-free hits pinning victims in the meantime can make it run out halfway. Caller
+   * should acquire the latch.
+   * @param num_frames number of frames wanted
+   * @param[out] frames the acquired frames, each with the evicted page to write back or INVALID_PAGE_ID
+   * @return false if the frames could not all be acquired, in which case frames holds those acquired so far and the
+   * caller must give them back with ReleaseFrames()
+   */
+  auto AcquireFrames(size_t num_frames, std::vector<std::pair<frame_id_t, page_id_t>> *frames) -> bool;
+
+  /**
+   * @brief Put the frames of a failed AcquireFrames() on the free list. Their evicted pages are written back with
+   * the latch released, so the frames only become free once the latch is taken again.
+   * @param frames the acquired frames, cleared on return
+   * @param lock the caller's lock on the latch, held again on return
+   */
+  void ReleaseFrames(std::vector<std::pair<frame_id_t, page_id_t>> *frames, std::unique_lock<std::mutex> *lock);
+
+  /**
+   * @brief Restore the page of a frame being loaded from the compressed cache.
+   * @return false if the page is not in the cache and must be read from disk
+   */
+  auto TakeCompressedPage(Page *page) -> bool;
+
+  /**
+   * @brief Perform the disk I/O of the frames installed by a batch, then wake the threads waiting for them: one
+   * submission for the write-backs of the evicted pages, then one for the reads. Called without the latch.
+   * @param frames the installed frames, each with the evicted page to write back or INVALID_PAGE_ID
+   * @param read_pages true to read the frames' pages from disk, false to zero them for new pages
+   */
+  void FinishBatchIo(const std::vector<std::pair<frame_id_t, page_id_t>> &frames, bool read_pages);
+
+  /**
+   * @brief Build the read requests of installed frames in page id order, each run of consecutive pages as one
+   * vectored request. The requests have no callbacks.
+   * @param loads the pages to read and the frames they go to
+   * @param[out] request_frames receives, for every request, the frames it reads into
+   * @return the read requests
+   */
+  auto CoalesceReads(std::vector<std::pair<page_id_t, frame_id_t>> loads,
+                     std::vector<std::vector<frame_id_t>> *request_frames) -> std::vector<DiskRequest>;
+
+  /**
+   * @brief Perform the disk I/O of an installed frame, then wake the threads waiting for it. Called without the latch.
+   * @param frame_id id of the installed frame
+   * @param writeback_page_id evicted page whose data must first be written back, INVALID_PAGE_ID if none
+   * @param read_page true to read the frame's page from disk (unless the frame maps it), false to zero it for a new
+   * page
+   */
+  void FinishIo(frame_id_t frame_id, page_id_t writeback_page_id, bool read_page);
+
+  /**
+   * @brief Wake the threads waiting for the I/O of a frame and run the FetchPageAsync() completions waiting for it,
+   * after io_in_progress_ was cleared. Called without the frame latch.
+   * @param waiters the frame's io_waiters_, taken under the frame latch along with clearing io_in_progress_
+   */
+  void NotifyIoDone(FrameLatch *frame_latch, std::vector<std::function<void()>> waiters);
+
+  /** @brief Completion of the read of a FetchPageAsync() miss: end the frame's I/O and hand the page over. */
+  void FinishAsyncFetch(frame_id_t frame_id, std::chrono::steady_clock::time_point start,
+                        const std::function<void(Page *)> &on_loaded);
+
+  /**
+   * @brief Optimistically look up page_id without the latch and lock the frame latch of the frame holding it.
+   * @param page_id id of the page to look up
+   * @param[out] frame_id frame holding page_id
+   * @param[out] frame_lock lock of the frame latch, held on success
+   * @return false if page_id was not found or its frame changed hands; the caller retries under the latch
+   */
+  auto TryLatchFrame(page_id_t page_id, frame_id_t *frame_id, std::unique_lock<std::mutex> *frame_lock) -> bool;
+
+  /**
+   * @brief Pin the page of a hit in a frame whose frame latch is held, counting the hit. A regular fetch records the
+   * access and takes a ring frame over from its strategy; a fetch with a strategy does neither. The frame is left
+   * evictable in the replacer, see replacer_.
+   * @param strategy the access strategy of the fetch, nullptr for a regular fetch
+   * @return pointer to the pinned page, which may still be being loaded
+   */
+  auto PinHitFrame(frame_id_t frame_id, BufferAccessStrategy *strategy) -> Page *;
+
+  /**
+   * @brief PinHitFrame(), then wait until no I/O is in progress on the frame.
+   * @param strategy the access strategy of the fetch, nullptr for a regular fetch
+   * @param[out] mapped_data nullptr to copy a mapped page into the frame, see FetchPageMapped(); otherwise receives
+   * the data to read, the mapping if the frame maps its page
+   * @return pointer to the pinned page
+   */
+  auto PinLatchedFrame(frame_id_t frame_id, std::unique_lock<std::mutex> *frame_lock, BufferAccessStrategy *strategy,
+                       const char **mapped_data = nullptr) -> Page *;
+
+  /**
+   * @brief Copy the page a frame maps into the frame, so that it can be written. Caller should hold the frame latch
+   * and make sure no I/O is in progress on the frame.
+   */
+  void CopyMappedPage(frame_id_t frame_id);
+
+  /**
+   * @brief Drop the page of a frame from the pool and return the frame to the free list. Caller should acquire the
+   * latch and the frame's latch, and check that the page is not pinned.
+   * @param frame_id id of the frame
+   * @param page_id id of the frame's page
+   */
+  void RemovePage(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * @brief Queue the write of the frame's page unless it is still being loaded, and mark the frame as being cleaned.
+   * The write joins the last request when it continues that request's run of pages. Caller should acquire the latch,
+   * release it before the write and call FinishCleaning() once the write completes.
+   * @param frame_id id of the frame to flush
+   * @param[out] requests the write request is appended to it
+   * @param[out] request_frames the frame is appended to the frames of its request
+   */
+  void PrepareFlush(frame_id_t frame_id, std::vector<DiskRequest> *requests,
+                    std::vector<std::vector<frame_id_t>> *request_frames);
+
+  /**
+   * @brief Write the resident pages among page_ids that are dirty. The frames are marked as being cleaned under the
+   * latch, which is released while they are written; a page another flush or the cleaner is writing is waited for
+   * first. Caller should acquire the latch, which is released on return.
+   * @param page_ids ids of the pages to flush
+   * @param lock the caller's lock on the latch
+   * @param[out] pages_written the number of pages written
+   * @return the ids of the resident pages among page_ids
+   */
+  auto FlushResidentPages(std::vector<page_id_t> page_ids, std::unique_lock<std::mutex> *lock, size_t *pages_written)
+      -> std::vector<page_id_t>;
+
+  /**
+   * @brief Mark a dirty frame as being cleaned and clear its dirty flag. An unpinned frame is read latched and taken
+   * from the replacer until the write completes. Caller should acquire the latch and the frame's latch.
+   * @param frame_id id of the frame
+   */
+  void StartCleaning(frame_id_t frame_id);
+
+  /**
+   * @brief Undo StartCleaning() once the frame's write completed and wake whoever waits for it. Caller should not
+   * hold the latch.
+   * @param frame_id id of the frame
+   * @param failed whether the write failed, the page is marked dirty again then
+   */
+  void FinishCleaning(frame_id_t frame_id, bool failed);
+
+  /** @brief Drop a page whose write-back completed from writeback_pages_ and wake the misses waiting for it. */
+  void FinishWriteback(page_id_t page_id);
+
+  /**
+   * @brief Issue the I/O of a frame installed by PrefetchPages() or FetchPageAsync() on the disk scheduler: the
+   * write-back of its evicted page if any, then the read of its new page, then on_read. A page in the compressed
+   * cache is restored and on_read is called right away instead. Called without the latch.
+   * @param frame_id id of the installed frame
+   * @param writeback_page_id evicted page whose data must first be written back, INVALID_PAGE_ID if none
+   * @param on_read called once the page is in the frame
+   */
+  void ScheduleRead(frame_id_t frame_id, page_id_t writeback_page_id, std::function<void()> on_read);
+
+  /** @brief Completion of a prefetch read: end the frame's I/O and drop the prefetch's pin. */
+  void FinishPrefetch(frame_id_t frame_id);
+
+  /**
+   * @brief Map the chunks that make the pool num_frames frames large, then hand their frames out. Caller should
+   * acquire resize_latch_.
+   */
+  void GrowPool(size_t num_frames);
+
+  /**
+   * @brief Start shrinking the pool to num_frames frames: retire the frames beyond it and start the thread that
+   * drains them. Caller should acquire resize_latch_ and the latch.
+   */
+  void StartShrink(size_t num_frames);
+
+  /** @brief Body of the shrink thread: runs DrainRetiringFrames() until it is done or the pool is destroyed. */
+  void RunShrink();
+
+  /**
+   * @brief Drop the pages of the retiring frames that are not in use, writing the dirty ones out without the latch.
+   * Once every retiring frame is empty, finish the shrink.
+   * @param lock the caller's lock on the latch, released while the pages are written
+   * @return the chunks to release if the shrink is finished, an empty vector otherwise
+   */
+  auto DrainRetiringFrames(std::unique_lock<std::mutex> *lock) -> std::vector<FrameArena *>;
+
+  /** @return whether new_pool_size is a valid size for Resize(). Caller should acquire resize_latch_. */
+  auto IsValidPoolSize(size_t new_pool_size) const -> bool;
+
+  /**
+   * @brief Lock the latches of all the frames. Together with the latch this stops every call on the replacer and
+   * every lookup that is not turned away. Caller should acquire the latch.
+   * @return the locks, released when they go out of scope
+   */
+  auto LatchAllFrames() -> std::vector<std::unique_lock<std::mutex>>;
+
+  /** @brief Body of the page cleaner thread: runs CleanFrames() every PAGE_CLEANER_INTERVAL until stopped. */
+  void RunPageCleaner();
+
+  /**
+   * @brief Write out the dirty pages among the next clean_low_watermark_ eviction candidates. A page whose write
+   * fails is marked dirty again. Called without the latch.
+   * @param max_writes maximum number of pages to write
+   * @return the number of writes issued, failed ones included
+   */
+  auto CleanFrames(size_t max_writes) -> size_t;
 
   /**
    * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
@@ -169,13 +1047,57 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   auto AllocatePage() -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Allocate the next page id of a segment, reserving it a new extent first if its extent is used up. Caller
+   * should acquire the latch.
+   * @return the id of the allocated page
+   */
+  auto AllocateSegmentPage(PageSegment *segment) -> page_id_t;
+
+  /**
+   * @brief Deallocate a page on disk: with a free page map its id is marked free, to be handed out again, once any
+   * write-back of the page has completed; FinishWriteback() releases it then. A no-op without a free page map. Caller
+   * should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
+  void DeallocatePage(page_id_t page_id);
+
+  /** @brief Mark free the deleted pages whose write-back completed since. Caller should acquire the latch. */
+  void FreeReleasedPages();
+
+  /**
+   * @brief Read the free page map of the database file. Caller should acquire the latch.
+   * @return the map, owned by the caller; nullptr if the database has pages but no map, every id would then be taken
+   * for free
+   */
+  auto LoadFreePageMap() -> FreePageMap *;
+
+  /**
+   * @brief Write out the map pages changed since their last write, those of failed writes are left changed. Called
+   * without the latch.
+   * @return the number of map pages written
+   */
+  auto WriteFreePageMap() -> size_t;
+
+  /**
+   * @brief Write out the free page map if its copy on disk does not mark all the given pages in use, before the pages
+   * are written. Called without the latch.
+   * @param page_ids ids of the pages about to be written
+   * @param num_pages number of ids
+   * @return the number of map pages written
+   */
+  auto PersistFreePageMap(const page_id_t *page_ids, size_t num_pages) -> size_t;
+
+  /** @return true if page_id holds a bitmap of the free page map, and cannot be fetched, created or deleted */
+  auto IsFreePageMapPage(page_id_t page_id) const -> bool {
+    return free_page_map_ != nullptr && free_page_map_->IsMapPage(page_id);
   }
 
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI.
+   * @param page_id the page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
   // TODO(student): You may add additional private members and helper functions
 };
 }  // namespace bustub
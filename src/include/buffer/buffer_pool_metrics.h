@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <functional>
+#include <thread>  // NOLINT
+
+namespace bustub {
+
+/** Number of shards of the metrics; each thread updates the shard it hashes to. */
+static constexpr size_t METRICS_SHARDS = 16;
+
+/** @return the metrics shard of the calling thread */
+inline auto MetricsShard() -> size_t {
+  thread_local const size_t thread_hash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  return thread_hash & (METRICS_SHARDS - 1);
+}
+
+/**
+ * ShardedCounter is a counter that threads can bump without contending on a single cache line: every shard sits on a
+ * line of its own, and reading the counter sums the shards. The sum is not a consistent snapshot while writers are
+ * running, which is fine for monitoring.
+ */
+class ShardedCounter {
+ public:
+  void Add(uint64_t n = 1) { shards_[MetricsShard()].value_.fetch_add(n, std::memory_order_relaxed); }
+
+  auto Load() const -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &shard : shards_) sum += shard.value_.load(std::memory_order_relaxed);
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> value_{0};
+  };
+  std::array<Shard, METRICS_SHARDS> shards_;
+};
+
+/** Latency distribution of a LatencyHistogram, see LatencyHistogram::Snapshot(). */
+struct LatencySnapshot {
+  /** Number of samples in bucket i: below 1 ns for bucket 0, in [2^(i-1), 2^i) ns for the others. */
+  static constexpr size_t NUM_BUCKETS = 40;
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+  uint64_t count_{0};
+  uint64_t sum_ns_{0};
+
+  /** @return the mean latency in nanoseconds, 0 without samples */
+  auto MeanNs() const -> double { return count_ == 0 ? 0 : static_cast<double>(sum_ns_) / static_cast<double>(count_); }
+
+  /**
+   * @param quantile e.g. 0.99 for the 99th percentile
+   * @return an upper bound in nanoseconds, within a factor of two, of the latency at the given quantile
+   */
+  auto PercentileNs(double quantile) const -> uint64_t;
+
+  auto operator+=(const LatencySnapshot &other) -> LatencySnapshot &;
+};
+
+/**
+ * LatencyHistogram records latencies into power-of-two buckets. Like ShardedCounter, each thread records into a
+ * shard of its own; a sample costs two relaxed atomic increments.
+ */
+class LatencyHistogram {
+ public:
+  void Record(std::chrono::nanoseconds latency) {
+    auto ns = static_cast<uint64_t>(latency.count() < 0 ? 0 : latency.count());
+    size_t bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+    if (bucket >= LatencySnapshot::NUM_BUCKETS) bucket = LatencySnapshot::NUM_BUCKETS - 1;
+    Shard &shard = shards_[MetricsShard()];
+    shard.buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+  }
+
+  auto Snapshot() const -> LatencySnapshot;
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> sum_ns_{0};
+    std::array<std::atomic<uint64_t>, LatencySnapshot::NUM_BUCKETS> buckets_{};
+  };
+  std::array<Shard, METRICS_SHARDS> shards_;
+};
+
+/** Point-in-time values of the metrics of a buffer pool, see BufferPoolManagerInstance::GetMetrics(). */
+struct BufferPoolMetricsSnapshot {
+  /** Fetches that found the page resident, including pages still being loaded by another thread. */
+  uint64_t hits_{0};
+  /** Fetches that read the page from disk. */
+  uint64_t misses_{0};
+  /** Pages created by NewPage(). */
+  uint64_t new_pages_{0};
+  /** FetchPage() and NewPage() calls that returned nullptr because every frame was pinned. */
+  uint64_t fetch_failures_{0};
+  uint64_t new_page_failures_{0};
+  /** Pages evicted to make room for another page, and how many of them had to be written back first. */
+  uint64_t evictions_{0};
+  uint64_t dirty_evictions_{0};
+  /** Evictions of frames the replacer considers cold, e.g. with fewer than k accesses for LRU-K. */
+  uint64_t cold_evictions_{0};
+  /** Pages written by the background page cleaner, and its writes that failed, after which the page stays dirty. */
+  uint64_t cleaner_writes_{0};
+  uint64_t cleaner_write_failures_{0};
+  /**
+   * Waits for a page write of the page cleaner or a flush: by fetches and new pages that found no other frame, and
+   * by deletes and flushes of the page being written.
+   */
+  uint64_t cleaning_waits_{0};
+  /** Misses served by the compressed page cache instead of the disk; they count as misses too. */
+  uint64_t compressed_hits_{0};
+  /**
+   * Frames in the pool, unpinned frames (free or evictable), and frames the replacer holds evictable, which includes
+   * the pinned frames hits left there.
+   */
+  uint64_t pool_size_{0};
+  uint64_t unpinned_frames_{0};
+  uint64_t evictable_frames_{0};
+  /** Pages held by the compressed page cache and the bytes they take. */
+  uint64_t compressed_pages_{0};
+  uint64_t compressed_bytes_{0};
+  /** Page reads that did not match their checksum, see BufferPoolManagerInstance::EnableChecksums(). */
+  uint64_t checksum_failures_{0};
+  /**
+   * Lookback k of the LRU-K replacer, which moves with the workload once BufferPoolManagerInstance::EnableAdaptiveK()
+   * was called; the largest k of the instances of a parallel pool. 0 for the other policies.
+   */
+  uint64_t replacer_k_{0};
+  /** Time from the start of a missing fetch until its page is loaded. */
+  LatencySnapshot miss_latency_;
+  /** Time spent waiting for the pool latch by fetches and new pages that found it taken. */
+  LatencySnapshot latch_wait_;
+
+  /** @return the fraction of fetches that hit, 0 without fetches */
+  auto HitRatio() const -> double {
+    uint64_t fetches = hits_ + misses_;
+    return fetches == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches);
+  }
+
+  auto operator+=(const BufferPoolMetricsSnapshot &other) -> BufferPoolMetricsSnapshot &;
+};
+
+/** The sharded counters and histograms behind a BufferPoolMetricsSnapshot. */
+struct BufferPoolMetrics {
+  ShardedCounter hits_;
+  ShardedCounter misses_;
+  ShardedCounter new_pages_;
+  ShardedCounter fetch_failures_;
+  ShardedCounter new_page_failures_;
+  ShardedCounter evictions_;
+  ShardedCounter dirty_evictions_;
+  ShardedCounter cleaner_writes_;
+  ShardedCounter cleaner_write_failures_;
+  ShardedCounter cleaning_waits_;
+  ShardedCounter compressed_hits_;
+  LatencyHistogram miss_latency_;
+  LatencyHistogram latch_wait_;
+
+  /** @return the counters and histograms; the gauges of the pool are left for the pool to fill in */
+  auto Snapshot() const -> BufferPoolMetricsSnapshot;
+};
+
+}  // namespace bustub
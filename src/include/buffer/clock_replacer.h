@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer.h
+//
+// Identification: src/include/buffer/clock_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * ClockReplacer implements the CLOCK (second chance) policy. The frames form a circle with a clock hand; an access
+ * sets the frame's reference bit, and eviction advances the hand, clearing reference bits, until it reaches an
+ * evictable frame whose bit is already clear. Only evictable frames are on the circle: a frame leaves it when it is
+ * pinned and joins again right behind the hand when it is unpinned, so the hand never steps over pinned frames.
+ *
+ * RecordAccess() on a tracked frame only sets an atomic bit and never takes the latch, which keeps hits cheap.
+ */
+class ClockReplacer : public Replacer {
+ public:
+  /**
+   * @brief Creates a new ClockReplacer.
+   * @param num_frames the maximum number of frames the ClockReplacer will be required to store
+   */
+  explicit ClockReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(ClockReplacer);
+
+  ~ClockReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordPrefetch(frame_id_t frame_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void Reinstate(frame_id_t frame_id, page_id_t page_id) override;
+
+  auto Size() -> size_t override;
+
+  auto PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t override;
+
+  void Resize(size_t num_frames) override;
+
+ private:
+  static constexpr uint8_t TRACKED = 1;
+  static constexpr uint8_t EVICTABLE = 2;
+  static constexpr uint8_t REFERENCED = 4;
+
+  /** Put an evictable frame on the circle, right behind the hand. Caller must hold latch_. */
+  void JoinCircle(frame_id_t frame_id);
+  /** Take a frame off the circle. Caller must hold latch_. */
+  void LeaveCircle(frame_id_t frame_id);
+
+  size_t replacer_size_;
+  frame_id_t hand_{-1};  // the next frame the hand looks at, -1 if the circle is empty
+  size_t curr_size_{0};
+  /** Protects the circle, hand_, curr_size_ and changes of the TRACKED and EVICTABLE bits. */
+  std::mutex latch_;
+  /** State bits of every frame; REFERENCED is also set without the latch. */
+  std::vector<std::atomic<uint8_t>> state_;
+  /** Links of the circle of evictable frames, in the order the hand visits them. */
+  std::vector<frame_id_t> prev_;
+  std::vector<frame_id_t> next_;
+};
+
+}  // namespace bustub
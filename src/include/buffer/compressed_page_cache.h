@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache keeps clean pages evicted from a buffer pool in compressed form, so that a miss on one of them
+ * costs a decompression instead of a disk read. It is a second tier behind the pool: a page is either resident in
+ * the pool or cached here, never both, and is taken out of the cache when it comes back into the pool.
+ *
+ * Insert() only copies the page, since it is called under the pool latch; the copies are compressed later by
+ * CompressPending(), which the pool calls once it dropped its latch. The copies waiting for it do not count against
+ * the capacity, there are at most MAX_PENDING_PAGES of them and the oldest are dropped beyond. Pages that do not
+ * shrink by a quarter are not worth their memory and are dropped. When the compressed pages reach the capacity, the
+ * least recently inserted go first.
+ *
+ * The codec is a byte-oriented LZ77 in the spirit of the LZ4 block format: each sequence is a token (literal length
+ * in the high nibble, match length minus MIN_MATCH in the low one, 15 meaning more length bytes follow), the
+ * literals, then a 2-byte little-endian match offset. The last sequence has literals only.
+ */
+class CompressedPageCache {
+ public:
+  /**
+   * @brief Create an empty cache.
+   * @param capacity the most bytes of compressed page images the cache holds
+   */
+  explicit CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+  /**
+   * @brief Cache the image of a clean page, replacing any earlier image of it. The image is copied, to be compressed
+   * by the next CompressPending().
+   * @param page_id id of the page
+   * @param data BUSTUB_PAGE_SIZE bytes, the page as it is on disk
+   */
+  void Insert(page_id_t page_id, const char *data);
+
+  /**
+   * @brief Take the image of a page out of the cache.
+   * @param page_id id of the page
+   * @param[out] data receives BUSTUB_PAGE_SIZE bytes, the page as it is on disk
+   * @return false if the page is not cached, in which case data is left untouched
+   */
+  auto Take(page_id_t page_id, char *data) -> bool;
+
+  /** @brief Drop the image of a page, if cached, because the page on disk is no longer what it holds. */
+  void Erase(page_id_t page_id);
+
+  /** @brief Compress the images inserted since the last call. Called without any latch of the pool. */
+  void CompressPending();
+
+  /** @return the number of cached pages */
+  auto GetPageCount() -> size_t;
+
+  /** @return the bytes taken by the cached images, compressed or waiting to be */
+  auto GetSize() -> size_t;
+
+  /**
+   * @brief Compress a buffer.
+   * @param src the bytes to compress
+   * @param size number of bytes of src, at most 65536 so that every offset fits in 2 bytes
+   * @param[out] dst receives the compressed bytes
+   * @param capacity the most bytes dst may receive
+   * @return the compressed size, 0 if it would exceed capacity
+   */
+  static auto Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * @brief Decompress the output of Compress().
+   * @param src the compressed bytes
+   * @param size number of bytes of src
+   * @param[out] dst receives the original bytes
+   * @param dst_size the size of the original bytes
+   * @return false if src is malformed or does not decompress to exactly dst_size bytes
+   */
+  static auto Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool;
+
+  /** Shortest match the codec encodes. */
+  static constexpr size_t MIN_MATCH = 4;
+  /** Most images kept waiting for CompressPending(). */
+  static constexpr size_t MAX_PENDING_PAGES = 64;
+
+ private:
+  struct Entry {
+    /** The image, raw until CompressPending() got to it. */
+    std::string data_;
+    bool compressed_{false};
+    /** Tells a re-inserted image apart from the one CompressPending() started on. */
+    uint64_t generation_{0};
+    std::list<page_id_t>::iterator lru_;
+  };
+
+  /** @brief Drop an entry. Caller must hold latch_. */
+  void EraseEntry(std::unordered_map<page_id_t, Entry>::iterator it);
+
+  /**
+   * @brief Drop the least recently inserted compressed entries until size_ fits the capacity. Caller must hold
+   * latch_.
+   */
+  void EvictOverCapacity();
+
+  /** Compressed images larger than this are not kept. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = BUSTUB_PAGE_SIZE - BUSTUB_PAGE_SIZE / 4;
+
+  const size_t capacity_;
+  std::mutex latch_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  /** Cached pages, most recently inserted first. */
+  std::list<page_id_t> lru_;
+  /** Raw images waiting for CompressPending(), with the generation they were inserted with. */
+  std::deque<std::pair<page_id_t, uint64_t>> pending_;
+  /** Bytes of the compressed images, and of the raw ones. */
+  size_t size_{0};
+  size_t pending_size_{0};
+  uint64_t next_generation_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// fetch_page_awaitable.h
+//
+// Identification: src/include/buffer/fetch_page_awaitable.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+// The rest of the tree builds as C++17; coroutine executors include this header from C++20 translation units.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define BUSTUB_HAS_COROUTINES 1
+
+#include <atomic>
+#include <coroutine>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CoroutineExecutor is the part of a coroutine executor that a buffer pool needs: a way to hand back a coroutine
+ * whose page was loaded, so that it resumes on one of the executor's threads.
+ */
+class CoroutineExecutor {
+ public:
+  virtual ~CoroutineExecutor() = default;
+
+  /**
+   * @brief Queue a coroutine to be resumed by the executor. Called on the thread that completed the page read, often
+   * a disk scheduler thread, so it must neither block nor resume the coroutine in place.
+   * @param handle the coroutine to resume
+   */
+  virtual void Post(std::coroutine_handle<> handle) = 0;
+};
+
+/**
+ * FetchPageAwaitable is what co_await FetchPageAsync(pool, page_id, executor) waits on: it starts the fetch with the
+ * pool's callback based FetchPageAsync(), completes without suspending on a hit, and otherwise suspends the coroutine
+ * until the page is loaded, when the coroutine is posted to the executor. The result of the co_await is the pinned
+ * page, nullptr if every frame of the pool was pinned; the coroutine must unpin it as usual.
+ *
+ * The awaitable lives in the coroutine frame while the coroutine is suspended, so the completion can refer to it.
+ * @tparam BufferPool BufferPoolManagerInstance or ParallelBufferPoolManager
+ */
+template <typename BufferPool>
+class FetchPageAwaitable {
+ public:
+  FetchPageAwaitable(BufferPool *pool, page_id_t page_id, CoroutineExecutor *executor)
+      : pool_(pool), page_id_(page_id), executor_(executor) {}
+
+  DISALLOW_COPY_AND_MOVE(FetchPageAwaitable);
+
+  auto await_ready() -> bool {  // NOLINT
+    bool pending = false;
+    Page *page = pool_->FetchPageAsync(page_id_, [this](Page *loaded) { Complete(loaded); }, &pending);
+    // a pending fetch may complete before FetchPageAsync() returns, page_ is then the loaded page already
+    if (!pending) page_ = page;
+    return !pending;
+  }
+
+  auto await_suspend(std::coroutine_handle<> handle) -> bool {  // NOLINT
+    handle_ = handle;
+    // the first of the completion and the suspension to get here lets the other one resume the coroutine
+    return !resumable_.exchange(true, std::memory_order_acq_rel);
+  }
+
+  auto await_resume() -> Page * { return page_; }  // NOLINT
+
+ private:
+  void Complete(Page *page) {
+    page_ = page;
+    if (resumable_.exchange(true, std::memory_order_acq_rel)) executor_->Post(handle_);
+  }
+
+  BufferPool *pool_;
+  page_id_t page_id_;
+  CoroutineExecutor *executor_;
+  Page *page_{nullptr};
+  std::coroutine_handle<> handle_;
+  std::atomic<bool> resumable_{false};
+};
+
+/**
+ * @brief Fetch a page from a coroutine: co_await FetchPageAsync(&bpm, page_id, &executor) evaluates to the pinned
+ * page, see FetchPageAwaitable. A free function rather than a member, so that the pool classes are the same in the
+ * C++17 translation units that do not see it.
+ * @param pool the buffer pool
+ * @param page_id id of page to be fetched
+ * @param executor where the coroutine is posted once a missing page is loaded
+ */
+template <typename BufferPool>
+auto FetchPageAsync(BufferPool *pool, page_id_t page_id, CoroutineExecutor *executor)
+    -> FetchPageAwaitable<BufferPool> {
+  return {pool, page_id, executor};
+}
+
+}  // namespace bustub
+
+#endif
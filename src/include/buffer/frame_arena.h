@@ -0,0 +1,112 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/** NUMA placement of the frame arena's memory. */
+enum class NumaPolicy {
+  /** Leave the placement to the kernel, which allocates on the node of the thread that first touches a page. */
+  DEFAULT,
+  /** Spread the memory evenly over all online nodes. */
+  INTERLEAVE,
+  /** Allocate all the memory on a single node. */
+  BIND,
+};
+
+/** Options of the memory a buffer pool keeps its frames in. */
+struct FrameArenaOptions {
+  /**
+   * 0 to map regular pages and ask for transparent huge pages, 2 MB or 1 GB to map explicit huge pages of that size
+   * from the hugetlb pool. The arena falls back to transparent huge pages if the pool has no pages left.
+   */
+  size_t huge_page_size_{0};
+
+  /**
+   * Alignment of the data of every frame, e.g. the device block size so that O_DIRECT transfers need no bounce
+   * buffer; 0 packs the frames as a plain Page array. Since a Page keeps its metadata next to its data, each frame
+   * then takes a whole multiple of the alignment, i.e. twice the memory for 4 KB alignment.
+   */
+  size_t frame_alignment_{0};
+
+  /** NUMA placement of the frames. */
+  NumaPolicy numa_policy_{NumaPolicy::DEFAULT};
+
+  /**
+   * Node to allocate on with NumaPolicy::BIND. -1 lets the ParallelBufferPoolManager bind each instance to a node
+   * of its own, round-robin; a BufferPoolManagerInstance on its own then leaves the placement to the kernel.
+   */
+  int numa_node_{-1};
+};
+
+/**
+ * FrameArena holds the frames of a buffer pool in a single anonymous memory mapping rather than on the heap, so that
+ * large pools can be backed by huge pages (far fewer TLB misses when the pool is scanned or probed at random) and be
+ * placed on NUMA nodes. The NUMA policy is applied before the memory is first touched.
+ */
+class FrameArena {
+ public:
+  /** Size of the huge pages the arena asks for when no explicit huge page size is given. */
+  static constexpr size_t TRANSPARENT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * @brief Map memory for num_frames frames and construct an empty Page in each of them.
+   * @param num_frames number of frames
+   * @param options huge page, alignment and NUMA options
+   */
+  FrameArena(size_t num_frames, const FrameArenaOptions &options);
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @brief Destroy the pages and unmap the memory. */
+  ~FrameArena();
+
+  /** @return the Page of the given frame */
+  auto GetFrame(frame_id_t frame_id) const -> Page * {
+    return reinterpret_cast<Page *>(frames_ + static_cast<size_t>(frame_id) * frame_stride_);
+  }
+
+  /** @return the distance in bytes between two consecutive frames, sizeof(Page) when the frames are packed */
+  auto GetFrameStride() const -> size_t { return frame_stride_; }
+
+  /** @return true if the memory is mapped from the hugetlb pool */
+  auto UsesHugeTlb() const -> bool { return huge_tlb_; }
+
+  /** @return the number of NUMA nodes of the machine, 1 when NUMA is not available */
+  static auto NumaNodeCount() -> int;
+
+ private:
+  /** @brief Map length bytes from the hugetlb pool, nullptr if it has no huge pages of that size available. */
+  static auto MapHugeTlb(size_t length, size_t huge_page_size) -> char *;
+  /** @brief Map length bytes aligned to alignment, and ask for transparent huge pages. */
+  static auto MapAligned(size_t length, size_t alignment) -> char *;
+  /** @brief Apply the NUMA policy to the mapped memory; the memory must not have been touched yet. */
+  void ApplyNumaPolicy(const FrameArenaOptions &options);
+
+  size_t num_frames_;
+  size_t frame_stride_;
+  /** The mapping, and the first frame inside it. */
+  char *memory_{nullptr};
+  size_t memory_size_{0};
+  char *frames_{nullptr};
+  bool huge_tlb_{false};
+};
+
+}  // namespace bustub
@@ -0,0 +1,172 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_list.h
+//
+// Identification: src/include/buffer/frame_list.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameHeap is an indexed binary min-heap of frame ids ordered by a key the policy assigns, such as the time of a
+ * frame's last access. The position of every frame is kept in an array indexed by frame id, so a frame's key can be
+ * changed and any frame taken out in O(log n), and no operation allocates.
+ */
+class FrameHeap {
+ public:
+  static constexpr size_t NOT_IN_HEAP = static_cast<size_t>(-1);
+
+  explicit FrameHeap(size_t num_frames) : pos_(num_frames, NOT_IN_HEAP) { heap_.reserve(num_frames); }
+
+  auto Size() const -> size_t { return heap_.size(); }
+  auto Contains(frame_id_t frame_id) const -> bool { return pos_[frame_id] != NOT_IN_HEAP; }
+  /** @return the frame with the smallest key, -1 if the heap is empty */
+  auto Top() const -> frame_id_t { return heap_.empty() ? -1 : heap_.front().frame_id_; }
+
+  /** Insert a frame that is not in the heap. */
+  void Push(frame_id_t frame_id, uint64_t key) {
+    heap_.push_back({key, frame_id});
+    pos_[frame_id] = heap_.size() - 1;
+    SiftUp(heap_.size() - 1);
+  }
+
+  /** Change the key of a frame in the heap. */
+  void Update(frame_id_t frame_id, uint64_t key) {
+    size_t pos = pos_[frame_id];
+    heap_[pos].key_ = key;
+    SiftUp(pos);
+    SiftDown(pos_[frame_id]);
+  }
+
+  /** Take a frame out of the heap, if it is in it. */
+  void Erase(frame_id_t frame_id) {
+    size_t pos = pos_[frame_id];
+    if (pos == NOT_IN_HEAP) return;
+    pos_[frame_id] = NOT_IN_HEAP;
+    Entry last = heap_.back();
+    heap_.pop_back();
+    if (pos == heap_.size()) return;
+    Place(pos, last);
+    SiftUp(pos);
+    SiftDown(pos_[last.frame_id_]);
+  }
+
+  /**
+   * List the frames with the smallest keys, smallest first, by a best-first walk: the next smallest key is always a
+   * child of an entry that was already listed.
+   * @return the number of frames listed, at most max_frames
+   */
+  auto Peek(frame_id_t *frame_ids, size_t max_frames) const -> size_t {
+    auto greater = [this](size_t a, size_t b) { return heap_[a].key_ > heap_[b].key_; };
+    std::vector<size_t> frontier;
+    if (!heap_.empty()) frontier.push_back(0);
+    size_t count = 0;
+    while (count < max_frames && !frontier.empty()) {
+      std::pop_heap(frontier.begin(), frontier.end(), greater);
+      size_t pos = frontier.back();
+      frontier.pop_back();
+      frame_ids[count++] = heap_[pos].frame_id_;
+      for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); child++) {
+        frontier.push_back(child);
+        std::push_heap(frontier.begin(), frontier.end(), greater);
+      }
+    }
+    return count;
+  }
+
+  /** Change the number of frames; frames beyond the new number must not be in the heap. */
+  void Resize(size_t num_frames) {
+    pos_.resize(num_frames, NOT_IN_HEAP);
+    heap_.reserve(num_frames);
+  }
+
+ private:
+  struct Entry {
+    uint64_t key_;
+    frame_id_t frame_id_;
+  };
+
+  void Place(size_t pos, const Entry &entry) {
+    heap_[pos] = entry;
+    pos_[entry.frame_id_] = pos;
+  }
+  void SiftUp(size_t pos) {
+    Entry entry = heap_[pos];
+    while (pos > 0 && entry.key_ < heap_[(pos - 1) / 2].key_) {
+      Place(pos, heap_[(pos - 1) / 2]);
+      pos = (pos - 1) / 2;
+    }
+    Place(pos, entry);
+  }
+  void SiftDown(size_t pos) {
+    Entry entry = heap_[pos];
+    while (2 * pos + 1 < heap_.size()) {
+      size_t child = 2 * pos + 1;
+      if (child + 1 < heap_.size() && heap_[child + 1].key_ < heap_[child].key_) child++;
+      if (heap_[child].key_ >= entry.key_) break;
+      Place(pos, heap_[child]);
+      pos = child;
+    }
+    Place(pos, entry);
+  }
+
+  std::vector<size_t> pos_;  // position of each frame in heap_, NOT_IN_HEAP if it is not in it
+  std::vector<Entry> heap_;
+};
+
+/**
+ * GhostList remembers the ids of recently evicted pages in FIFO order, for the policies whose decisions depend on
+ * whether a missing page was resident recently.
+ */
+class GhostList {
+ public:
+  auto Size() const -> size_t { return order_.size(); }
+  auto Contains(page_id_t page_id) const -> bool { return entries_.count(page_id) > 0; }
+
+  /** Remember page_id as the most recent ghost. */
+  void Push(page_id_t page_id) {
+    Erase(page_id);
+    order_.push_front(page_id);
+    entries_[page_id] = order_.begin();
+  }
+
+  /** Forget page_id. @return false if it was not a ghost */
+  auto Erase(page_id_t page_id) -> bool {
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) return false;
+    order_.erase(it->second);
+    entries_.erase(it);
+    return true;
+  }
+
+  /** @return the oldest ghost; the list must not be empty */
+  auto Back() const -> page_id_t { return order_.back(); }
+
+  /** Forget the oldest ghost. */
+  void PopBack() {
+    if (order_.empty()) return;
+    entries_.erase(order_.back());
+    order_.pop_back();
+  }
+
+ private:
+  std::list<page_id_t> order_;  // most recent first
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> entries_;
+};
+
+}  // namespace bustub
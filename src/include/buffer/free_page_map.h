@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/buffer/free_page_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreePageMap tracks which page ids of a buffer pool instance are in use, so that the pages of deleted ids are handed
+ * out again instead of growing the database file forever.
+ *
+ * The page ids of the instance (those congruent to its index modulo the number of instances) are numbered 0, 1, ...
+ * in order and split into groups of PAGES_PER_GROUP + 1. The second page of every group is a map page holding the
+ * group's bitmap, one bit per other page of the group, set while the page is in use; the first page of the file is
+ * thus left to the header page. Map pages are kept in memory and persisted in the database file like any page; the
+ * pool writes a map page before the first page it marks in use, see IsPersisted().
+ *
+ * Allocation prefers the first free page at or after the last page handed out, so that pages allocated together stay
+ * contiguous on disk, and grows the file only when no page is free.
+ */
+class FreePageMap {
+ public:
+  /**
+   * @param num_instances number of instances of the parallel buffer pool, 1 for a single instance
+   * @param instance_index index of the instance whose page ids are tracked
+   */
+  FreePageMap(uint32_t num_instances, uint32_t instance_index);
+
+  /** @return a free page id, marked in use */
+  auto Allocate() -> page_id_t;
+
+  /**
+   * @brief Allocate a run of consecutive page ids of the instance for an extent: the first free run large enough
+   * after the last page handed out, or new pages at the end of the file. A run never spans a map page.
+   * @param num_pages length of the run, at most MAX_RUN_PAGES
+   * @return the first page id of the run; the others follow at intervals of the number of instances
+   */
+  auto AllocateRun(size_t num_pages) -> page_id_t;
+
+  /**
+   * @brief Allocate a run of pages at a given page number at or past the end of the file; the pages between the end
+   * and the run become free pages. Instances of a parallel pool reserving the same run make up a run of consecutive
+   * page ids across the whole file.
+   * @param page_no the instance's number of the first page, which FitRun() returns unchanged
+   * @param num_pages length of the run, at most MAX_RUN_PAGES
+   * @return false if page_no is before the end of the file
+   */
+  auto ReserveRunAt(size_t page_no, size_t num_pages) -> bool;
+
+  /** @return the number of the first page past the end of the file */
+  auto GetEndPageNo() const -> size_t {
+    return groups_.empty() ? 0 : EndPageNo(groups_.size() - 1, groups_.back().num_pages_);
+  }
+
+  /**
+   * @return the first page number at or after page_no at which a run of num_pages pages spans no map page
+   */
+  static auto FitRun(size_t page_no, size_t num_pages) -> size_t;
+
+  /**
+   * @brief Mark a page id free. Ids of other instances, of map pages and ids never allocated are ignored.
+   * @param page_id id of the deleted page
+   * @return true if the page was in use
+   */
+  auto Free(page_id_t page_id) -> bool;
+
+  /**
+   * @return true if the map page on disk marks page_id in use, or the id is not tracked by the map. A page whose id
+   * is not marked must not be written before its map page is, or the next run would hand the id out again.
+   */
+  auto IsPersisted(page_id_t page_id) const -> bool;
+
+  /** @return true if page_id holds a bitmap of the map */
+  auto IsMapPage(page_id_t page_id) const -> bool;
+
+  /** @return the number of free page ids below the end of the file */
+  auto GetFreePageCount() const -> size_t { return free_pages_; }
+
+  /** @return the number of map pages, one per group */
+  auto GetGroupCount() const -> size_t { return groups_.size(); }
+
+  /** @return the page id of the map page of a group */
+  auto GetMapPageId(size_t group) const -> page_id_t { return ToPageId(group * GROUP_SPAN + 1); }
+
+  /**
+   * @brief Restore the next group from its map page read from disk. Groups are restored in order, from group 0.
+   * @param data contents of the map page
+   * @return false if data is not a map page, i.e. the group does not exist yet
+   */
+  auto LoadGroup(const char *data) -> bool;
+
+  /**
+   * @brief Write the map pages modified since the last call into pages that can be written to disk.
+   * @param[out] page_ids ids of the modified map pages
+   * @param[out] pages contents of the map pages, BUSTUB_PAGE_SIZE bytes each, in the order of page_ids
+   */
+  void TakeDirtyGroups(std::vector<page_id_t> *page_ids, std::vector<char> *pages);
+
+  /**
+   * @brief Have the next TakeDirtyGroups() take a map page again, e.g. because writing it failed.
+   * @param map_page_id id of the map page, as TakeDirtyGroups() gave it
+   */
+  void MarkDirty(page_id_t map_page_id);
+
+  /**
+   * @brief Record that a map page TakeDirtyGroups() took was written.
+   * @param map_page_id id of the map page
+   * @param data contents of the map page as written
+   */
+  void MarkPersisted(page_id_t map_page_id, const char *data);
+
+  /** Pages tracked by the bitmap of one map page. */
+  static constexpr size_t WORDS_PER_GROUP = (BUSTUB_PAGE_SIZE - 2 * sizeof(uint32_t)) / sizeof(uint64_t);
+  static constexpr size_t PAGES_PER_GROUP = WORDS_PER_GROUP * 64;
+  /** Longest run AllocateRun() hands out: the pages of a group that follow its map page. */
+  static constexpr size_t MAX_RUN_PAGES = PAGES_PER_GROUP - 1;
+
+ private:
+  /** Pages of a group in the instance's numbering, the map page included. */
+  static constexpr size_t GROUP_SPAN = PAGES_PER_GROUP + 1;
+  /** "BTFM", marks a map page. */
+  static constexpr uint32_t MAGIC = 0x4d465442;
+
+  struct Group {
+    /** Number of the group's pages below the end of the file; they have the first num_pages_ bits. */
+    uint32_t num_pages_{0};
+    bool dirty_{true};
+    uint64_t bits_[WORDS_PER_GROUP]{};
+    /** The bits of the group's map page on disk. */
+    uint64_t persisted_bits_[WORDS_PER_GROUP]{};
+  };
+
+  /** @return the page id of the instance's page with the given number */
+  auto ToPageId(size_t page_no) const -> page_id_t {
+    return static_cast<page_id_t>(page_no * num_instances_ + instance_index_);
+  }
+
+  /** @return the number of the page at a bit of a group; bit 0 is the group's first page, the map page follows */
+  static auto ToPageNo(size_t group, size_t bit) -> size_t { return group * GROUP_SPAN + (bit == 0 ? 0 : bit + 1); }
+
+  /** @return the number of the first page past the first num_bits pages of a group */
+  static auto EndPageNo(size_t group, size_t num_bits) -> size_t {
+    return group * GROUP_SPAN + (num_bits == 0 ? 0 : num_bits + 1);
+  }
+
+  /**
+   * @brief Find the group and bit of a page id.
+   * @return false if the id is of another instance, of a map page or past the groups
+   */
+  auto ToBit(page_id_t page_id, size_t *group, size_t *bit) const -> bool;
+
+  /** @brief Mark a bit in use and remember it as the place to continue from. */
+  auto Take(size_t group, size_t bit) -> page_id_t;
+
+  /** @brief Mark the bits [first_bit, first_bit + num_bits) in use, continuing from the last one. */
+  auto TakeRun(size_t group, size_t first_bit, size_t num_bits) -> page_id_t;
+
+  /**
+   * @brief Find the first run of num_bits free bits of a group in [max(from_bit, 1), the group's num_pages_).
+   * @return the first bit of the run, PAGES_PER_GROUP if there is none
+   */
+  auto FindFreeRun(size_t group, size_t from_bit, size_t num_bits) const -> size_t;
+
+  /** @brief Add free pages at the end of the file until it ends at or past page_no. */
+  void GrowTo(size_t page_no);
+
+  /**
+   * @brief Find the first free bit of a group in [from_bit, the group's num_pages_).
+   * @return the bit, PAGES_PER_GROUP if there is none
+   */
+  auto FindFree(size_t group, size_t from_bit) const -> size_t;
+
+  const uint32_t num_instances_;
+  const uint32_t instance_index_;
+  std::vector<Group> groups_;
+  size_t free_pages_{0};
+  /** Group and bit of the last page handed out; the search for a free page starts right after it. */
+  size_t hint_group_{0};
+  size_t hint_bit_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,52 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hot_page_file.h
+//
+// Identification: src/include/buffer/hot_page_file.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * HotPageFile stores the ids of the pages resident in a buffer pool, hottest first, so that a restarted pool can be
+ * warmed up with them instead of going to disk for every first access. The file is a small header (magic number and
+ * count) followed by the page ids; it holds ids only, never page data, so a stale file costs reads but no
+ * correctness.
+ */
+class HotPageFile {
+ public:
+  /**
+   * @brief Write the page ids to path, replacing the file if it exists.
+   * @param path path of the file
+   * @param page_ids page ids, hottest first
+   * @return false if the file could not be written
+   */
+  static auto Write(const std::string &path, const std::vector<page_id_t> &page_ids) -> bool;
+
+  /**
+   * @brief Read the page ids of a file written by Write().
+   * @param path path of the file
+   * @param[out] page_ids receives the page ids, hottest first
+   * @return false if the file is missing, is not a hot page file or its size does not match its count
+   */
+  static auto Read(const std::string &path, std::vector<page_id_t> *page_ids) -> bool;
+
+ private:
+  /** "BTHP", read in the byte order the file was written in. */
+  static constexpr uint32_t MAGIC = 0x50485442;
+};
+
+}  // namespace bustub
@@ -12,12 +12,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <limits>
-#include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
 #include <vector>
 
+#include "buffer/frame_list.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 
@@ -33,8 +35,36 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * All per-frame state lives in arrays indexed by frame id that are allocated once by the constructor: a k-slot
+ * circular buffer of timestamps, an evictable bitset, and each frame's position in a binary heap of the evictable
+ * frames ordered by eviction priority.
+ *
+ * Frames are sorted by priority class (see PagePriority) before their backward k-distance: a frame of a lower class
+ * is always evicted first.
+ *
+ * In buffered access mode, RecordAccess() only appends the frame to a small ring picked by the calling thread. The
+ * rings are drained in a batch whenever the latch is taken anyway (Evict, SetEvictable on an unknown frame) or when
+ * a ring fills up, and accesses get their timestamps when they are drained. The LRU-k order is then only approximate
+ * within one batch, but a hit costs no latch acquisition. A buffered access carries the frame's epoch, which moves
+ * whenever the frame stops being tracked (Evict, Remove, Resize), so that an access that was still buffered then is
+ * dropped rather than start a history for whatever page the frame holds next.
+ *
+ * The evictable bits can be read without the latch: SetEvictable(frame_id, true) on a frame that is evictable
+ * already returns right away. The buffer pool does not take a pinned frame out of the replacer, Evict() may return
+ * it and the pool takes the eviction back with Reinstate(), so the unpin of a page that was hit costs no latch
+ * acquisition either.
+ *
+ * With adaptive k (SetAdaptiveK()), every frame keeps its last max_k accesses and k moves between the bounds with
+ * the workload. The pages of the last replacer_size_ evicted frames are remembered as ghosts along with their access
+ * history, as ARC remembers its evicted pages. A ghost that comes back gets its history back, as in the retained
+ * information period of the LRU-K paper, and is a miss some neighbouring k would have turned into a hit: k - 1 if
+ * it had k - 1 accesses, which k - 1 would have ranked above the frames with fewer, and k + 1 if it had more than
+ * k, which k + 1 would have ranked above the frames with exactly k. The other way round, a hit on a frame that a
+ * neighbour would have ranked below the last victim is a hit that neighbour would have lost. Every ADAPT_WINDOW
+ * evictions, k moves one step towards the neighbour whose gains exceed its losses the most, if by a clear margin.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
    *
@@ -42,8 +72,9 @@ class LRUKReplacer {
    *
    * @brief a new LRUKReplacer.
    * @param num_frames the maximum number of frames the LRUReplacer will be required to store
+   * @param buffered_access whether RecordAccess buffers accesses instead of applying them under the latch
    */
-  explicit LRUKReplacer(size_t num_frames, size_t k);
+  explicit LRUKReplacer(size_t num_frames, size_t k, bool buffered_access = false);
 
   DISALLOW_COPY_AND_MOVE(LRUKReplacer);
 
@@ -52,7 +83,7 @@ class LRUKReplacer {
    *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
    * TODO(P1): Add implementation
@@ -70,7 +101,7 @@ class LRUKReplacer {
    * @param[out] frame_id id of frame that is evicted.
    * @return true if a frame is evicted successfully, false if no frames can be evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
    * TODO(P1): Add implementation
@@ -83,7 +114,9 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame that received a new access.
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordPrefetch(frame_id_t frame_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -102,7 +135,7 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
    * TODO(P1): Add implementation
@@ -121,7 +154,10 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
+
+  /** The frame gets back the history it was evicted with, unless an access since the eviction started it over. */
+  void Reinstate(frame_id_t frame_id, page_id_t page_id) override;
 
   /**
    * TODO(P1): Add implementation
@@ -130,25 +166,185 @@ class LRUKReplacer {
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  auto PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t override;
+
+  void PinFrames(const frame_id_t *frame_ids, size_t num_frames) override;
+
+  void SetPriority(frame_id_t frame_id, PagePriority priority) override;
+
+  void Resize(size_t num_frames) override;
+
+  auto GetColdEvictionCount() -> size_t override;
+
+  /**
+   * @brief Adapt k between min_k and max_k from the ghost hits of the evicted pages, starting from the constructor's
+   * k clamped to the bounds. The access histories tracked so far are kept. Must not run concurrently with any other
+   * call on the replacer.
+   * @param min_k the smallest k, at least 1
+   * @param max_k the largest k, at least min_k
+   * @return false if the bounds are invalid, in which case k stays fixed
+   */
+  auto SetAdaptiveK(size_t min_k, size_t max_k) -> bool override;
+
+  auto GetK() -> size_t override;
+
+  /** Ghost hits are only tracked with adaptive k. */
+  void SetFramePage(frame_id_t frame_id, page_id_t page_id) override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  // [[maybe_unused]] size_t current_timestamp_{0};
-  // [[maybe_unused]] size_t curr_size_{0};
-  [[maybe_unused]] size_t replacer_size_;
+  /** Eviction priority of an evictable frame; the heap keeps the smallest key on top. */
+  struct HeapEntry {
+    uint64_t key_;
+    frame_id_t frame_id_;
+  };
+  static constexpr size_t NOT_IN_HEAP = std::numeric_limits<size_t>::max();
+  /** The priority class of a frame makes the top bits of its key, so that lower classes sort first. */
+  static constexpr uint64_t PRIORITY_SHIFT = 62;
+  /** Within a class, frames with k accesses sort after every frame with fewer, whose backward k-distance is +inf. */
+  static constexpr uint64_t FULL_HISTORY_BIT = static_cast<uint64_t>(1) << 61;
+  /** Evictions between two adjustments of an adaptive k, unless the pool has more frames. */
+  static constexpr size_t ADAPT_WINDOW = 256;
+
+  /** What a neighbouring k would have done differently in the current window. */
+  struct NeighbourEstimate {
+    uint64_t victim_key_{0};  // key of the last victim under the neighbour's k
+    size_t gains_{0};         // ghost hits the neighbour would have turned into hits
+    size_t losses_{0};        // hits on frames the neighbour would have evicted before the last victim
+  };
 
+  /** The frame Evict() returned last and what it was evicted with; the history stays in place until an access. */
+  struct Victim {
+    frame_id_t frame_id_{-1};
+    uint32_t history_head_{0};
+    uint32_t history_size_{0};
+    PagePriority priority_{PagePriority::NORMAL};
+    bool cold_{false};
+  };
+
+  /** Where the history of a ghost is kept. */
+  struct GhostEntry {
+    uint32_t slot_;  // the ghost owns ghost_history_[slot * c, (slot + 1) * c), oldest timestamp first
+    uint32_t size_;  // number of timestamps, i.e. the accesses of the page when it was evicted, at most c
+  };
+
+  /**
+   * Ring of accesses recorded by the threads hashed to it, each the frame id in the low and its epoch in the high 32
+   * bits. Writers claim a slot by advancing write_count_ and then publish the access in it. The drainer (holding
+   * latch_) consumes the published slots up to write_count_ and advances read_count_ past the leading ones; a slot
+   * claimed but not yet published is left for a later drain, the ones after it are consumed and marked as such.
+   */
+  struct AccessBuffer {
+    static constexpr size_t CAPACITY = 32;
+    static constexpr uint64_t EMPTY_SLOT = std::numeric_limits<uint64_t>::max();
+    static constexpr uint64_t CONSUMED_SLOT = EMPTY_SLOT - 1;
+
+    AccessBuffer() {
+      for (auto &slot : slots_) slot.store(EMPTY_SLOT, std::memory_order_relaxed);
+    }
+    /** @return false if the ring is full */
+    auto Offer(uint64_t access) -> bool;
+
+    alignas(64) std::atomic<uint64_t> write_count_{0};
+    std::atomic<uint64_t> read_count_{0};
+    std::atomic<uint64_t> slots_[CAPACITY];
+  };
+
+  /** Apply one access at the current timestamp. Caller must hold latch_. */
+  void RecordAccessLocked(frame_id_t frame_id);
+  /** Apply the published buffered accesses, dropping those of an earlier frame epoch. Caller must hold latch_. */
+  void DrainAccessBuffers();
+
+  /** Count a ghost hit of a page evicted with the given number of accesses. Caller must hold latch_. */
+  void RecordGhostHit(uint32_t accesses);
+  /** Count a hit the neighbours would have lost, before the access is recorded. Caller must hold latch_. */
+  void RecordNeighbourLosses(frame_id_t frame_id);
+  /** Remember the page of an evicted frame as a ghost, with its history. Caller must hold latch_. */
+  void PushGhost(frame_id_t frame_id);
+  /** Forget every ghost and size the ghost histories for the frames and capacity. Caller must hold latch_. */
+  void ResetGhosts();
+  /** Move an adaptive k towards the neighbour with the best estimate, after a window. Caller must hold latch_. */
+  void AdaptK();
+  /** Recompute the key of every evictable frame, after k changed. Caller must hold latch_. */
+  void RebuildHeap();
+
+  /**
+   * Key of a tracked frame: the timestamp of its earliest access if it has fewer than k accesses, else that of its
+   * kth previous access with FULL_HISTORY_BIT set. Without adaptive k both are the oldest slot of its history. The
+   * frame's priority class sits above them.
+   */
+  auto EvictionKey(frame_id_t frame_id) const -> uint64_t { return EvictionKey(frame_id, k_); }
+  /** The key of a frame under another k, at most the history capacity. */
+  auto EvictionKey(frame_id_t frame_id, size_t k) const -> uint64_t {
+    size_t base = frame_id * history_capacity_;
+    uint64_t priority = static_cast<uint64_t>(priorities_[frame_id]) << PRIORITY_SHIFT;
+    if (history_size_[frame_id] < k) return priority | history_[base + history_head_[frame_id]];
+    size_t kth = (history_head_[frame_id] + history_size_[frame_id] - k) % history_capacity_;
+    return priority | history_[base + kth] | FULL_HISTORY_BIT;
+  }
+  auto IsEvictable(frame_id_t frame_id) const -> bool {
+    return ((evictable_[frame_id / 64].load(std::memory_order_relaxed) >> (frame_id % 64)) & 1) != 0;
+  }
+  /** Caller must hold latch_. */
+  void SetEvictableBit(frame_id_t frame_id, bool evictable) {
+    if (evictable) {
+      evictable_[frame_id / 64].fetch_or(static_cast<uint64_t>(1) << (frame_id % 64), std::memory_order_relaxed);
+    } else {
+      evictable_[frame_id / 64].fetch_and(~(static_cast<uint64_t>(1) << (frame_id % 64)), std::memory_order_relaxed);
+    }
+  }
+  /**
+   * Forget the history and priority of a frame that is no longer in the heap, and move on to its next epoch. Caller
+   * must hold latch_.
+   */
+  void ResetFrame(frame_id_t frame_id);
+
+  /** Heap maintenance. Caller must hold latch_. */
+  void HeapPush(frame_id_t frame_id);
+  void HeapErase(size_t pos);
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+  void HeapPlace(size_t pos, const HeapEntry &entry) {
+    heap_[pos] = entry;
+    heap_pos_[entry.frame_id_] = pos;
+  }
+
+  size_t replacer_size_;
   size_t k_;
+  size_t history_capacity_;  // timestamps kept per frame: k, or max_k with adaptive k
+  bool adaptive_k_{false};
+  size_t min_k_;
+  size_t max_k_;
+  size_t curr_size_{0};
+  size_t clock_{0};
+  size_t cold_evictions_{0};
   std::mutex latch_;
-  typedef std::list<size_t> access_history_t;
-
-  std::unordered_map<frame_id_t, access_history_t>
-      preliminary_queue_;  // holds frames that have been accessed fewer than k times
-  std::unordered_map<frame_id_t, access_history_t>
-      lru_cache_queue_;  // holds frames that have been accessed at least k times
-  std::unordered_map<frame_id_t, bool> evictable_;
-  std::atomic<size_t> clock_{0};
+
+  std::vector<size_t> history_;         // frame f owns the circular buffer history_[f * c, (f + 1) * c), c the capacity
+  std::vector<uint32_t> history_head_;  // slot of the oldest timestamp in each frame's buffer
+  std::vector<uint32_t> history_size_;  // number of recorded timestamps, at most c; 0 if the frame is not tracked
+  // evictable bit of every frame, written under latch_; read without it, so Resize() must not race SetEvictable()
+  std::vector<std::atomic<uint64_t>> evictable_;
+  std::vector<PagePriority> priorities_;  // priority class of every frame
+  std::vector<size_t> heap_pos_;        // position of each frame in heap_, NOT_IN_HEAP if not evictable
+  std::vector<HeapEntry> heap_;         // evictable frames, reserved for every frame up front
+  std::vector<bool> prefetched_;        // frames tracked by RecordPrefetch() and not accessed since
+  Victim last_victim_;                  // for Reinstate()
+  std::vector<AccessBuffer> access_buffers_;  // empty unless buffered access mode is on
+  // epoch of every frame in buffered access mode; read without latch_, so Resize() must not race RecordAccess()
+  std::vector<std::atomic<uint32_t>> frame_epochs_;
+
+  // adaptive k only
+  std::vector<page_id_t> frame_page_;  // page of every frame, as told by SetFramePage()
+  GhostList ghosts_;                   // evicted pages, at most replacer_size_, oldest last
+  std::unordered_map<page_id_t, GhostEntry> ghost_entries_;
+  std::vector<size_t> ghost_history_;       // a slot of c timestamps for every ghost
+  std::vector<uint32_t> free_ghost_slots_;  // slots of ghost_history_ not used by a ghost
+  std::vector<bool> retained_;              // frames given the history of their ghost, whose next access is a miss
+  size_t window_evictions_{0};
+  NeighbourEstimate lower_k_;   // k - 1
+  NeighbourEstimate higher_k_;  // k + 1
 };
 
 }  // namespace bustub
@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_segment.h
+//
+// Identification: src/include/buffer/page_segment.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+class ParallelBufferPoolManager;
+
+/**
+ * PageSegment keeps the new pages of one table or index together on disk. NewPageInSegment() reserves the segment
+ * an extent, a run of contiguous page ids, and hands its pages out in order before reserving the next one, so pages
+ * created concurrently by other loaders or in other segments never interleave with the segment's pages within an
+ * extent, and a scan of a freshly loaded segment reads whole extents sequentially.
+ *
+ * A segment is meant to be used by one loader (one thread) at a time, and with a single buffer pool. The unused rest
+ * of its last extent stays allocated when the segment is destroyed.
+ */
+class PageSegment {
+ public:
+  /** Default number of pages of an extent. */
+  static constexpr size_t DEFAULT_EXTENT_PAGES = 64;
+
+  /**
+   * @brief Creates a new PageSegment.
+   * @param extent_pages the number of pages of an extent; a ParallelBufferPoolManager reserves that many pages in
+   * each instance, which make up a single run of consecutive page ids
+   */
+  explicit PageSegment(size_t extent_pages = DEFAULT_EXTENT_PAGES) : extent_pages_(extent_pages) {
+    BUSTUB_ASSERT(extent_pages > 0, "an extent needs at least one page");
+  }
+
+  DISALLOW_COPY_AND_MOVE(PageSegment);
+
+  /** @return the number of pages of an extent */
+  auto GetExtentPages() const -> size_t { return extent_pages_; }
+
+ private:
+  friend class BufferPoolManagerInstance;
+  friend class ParallelBufferPoolManager;
+
+  const size_t extent_pages_;
+  /** Next page id of the current extent and how many remain; ids step by stride_ within the extent. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  size_t remaining_pages_{0};
+  page_id_t stride_{1};
+};
+
+}  // namespace bustub
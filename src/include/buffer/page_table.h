@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the page ids resident in a buffer pool to their frame ids, using linear probing over a fixed array
+ * of atomic slots.
+ *
+ * Insert() and Erase() must be serialized by the caller. Find() may additionally run concurrently with them without
+ * any lock; such an optimistic Find() can miss an entry that is being inserted, or return an entry that is being
+ * erased, so its result is only a hint that the caller has to validate against the frame itself.
+ */
+class PageTable {
+ public:
+  /**
+   * @brief Creates a new PageTable.
+   * @param capacity the maximum number of entries that will be stored at the same time
+   */
+  explicit PageTable(size_t capacity);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  ~PageTable();
+
+  /** @return the number of entries the table holds without exceeding its load factor */
+  auto GetCapacity() const -> size_t { return num_slots_ / 2; }
+
+  /**
+   * @brief Look up the frame holding page_id. Safe to call without serializing against writers.
+   * @param page_id id of the page to look up
+   * @param[out] frame_id frame id mapped to page_id
+   * @return true if an entry for page_id was found
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) const -> bool;
+
+  /**
+   * @brief Map page_id to frame_id. page_id must not be in the table yet.
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the entry of page_id.
+   * @return false if page_id was not in the table, true otherwise
+   */
+  auto Erase(page_id_t page_id) -> bool;
+
+ private:
+  /** A slot packs the page id into the upper and the frame id into the lower 32 bits. */
+  static constexpr uint64_t EMPTY_SLOT = ~static_cast<uint64_t>(0);
+  /** Marks an erased entry, so that probes for later entries of the same chain keep going. */
+  static constexpr uint64_t TOMBSTONE_SLOT = EMPTY_SLOT << 32;
+
+  static auto PackSlot(page_id_t page_id, frame_id_t frame_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32) | static_cast<uint32_t>(frame_id);
+  }
+  static auto SlotPageId(uint64_t slot) -> page_id_t { return static_cast<page_id_t>(slot >> 32); }
+  static auto SlotFrameId(uint64_t slot) -> frame_id_t { return static_cast<frame_id_t>(slot & 0xFFFFFFFF); }
+
+  /** Fibonacci hashing of the page id onto the slot array. */
+  auto HomeSlot(page_id_t page_id) const -> size_t {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL) >>
+                               shift_);
+  }
+
+  /** Reinsert every live entry to get rid of accumulated tombstones. */
+  void Rebuild();
+
+  size_t num_slots_;
+  size_t mask_;
+  int shift_;
+  std::atomic<uint64_t> *slots_;
+  /** Entry and tombstone counts, only touched by the (serialized) writers. */
+  size_t num_entries_{0};
+  size_t num_tombstones_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,313 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into several BufferPoolManagerInstances. A page always lives in
+ * instance page_id % num_instances, so operations on pages of different instances never share a latch or a replacer.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy of each instance
+   * @param arena_options frame memory options of each instance; NumaPolicy::BIND without a node binds instance i to
+   * node i modulo the number of nodes
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                            const FrameArenaOptions &arena_options = FrameArenaOptions{});
+
+  /**
+   * @brief Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the size (number of frames) of all the instances combined. */
+  auto GetPoolSize() -> size_t override;
+
+  /**
+   * @brief Resize every instance to an equal share of new_pool_size frames, see
+   * BufferPoolManagerInstance::Resize(). Either every instance is resized or none is.
+   * @param new_pool_size the number of frames wanted in all the instances combined
+   * @return false if any instance cannot take the resize, in which case no instance is resized
+   */
+  auto Resize(size_t new_pool_size) -> bool;
+
+  /** @return the metrics of all the instances combined, see BufferPoolManagerInstance::GetMetrics() */
+  auto GetMetrics() -> BufferPoolMetricsSnapshot;
+
+  /**
+   * @brief Start the page cleaner of every instance, see BufferPoolManagerInstance::StartPageCleaner().
+   * @param clean_low_watermark number of frames each instance keeps clean at the head of its eviction order
+   * @param max_writes_per_second upper bound on the page writes per second of each instance's cleaner
+   */
+  void StartPageCleaner(size_t clean_low_watermark, size_t max_writes_per_second);
+
+  /** @brief Stop the page cleaner of every instance. */
+  void StopPageCleaner();
+
+  /**
+   * @brief Start loading pages that will be fetched soon, see BufferPoolManagerInstance::PrefetchPages().
+   * @param page_ids ids of the pages to load, each is prefetched by the instance that owns it
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Route the disk I/O of every instance through io_uring, see BufferPoolManagerInstance::EnableIoUring().
+   * @return true if io_uring is used
+   */
+  auto EnableIoUring(const std::string &db_file, bool direct_io) -> bool;
+
+  /**
+   * @brief Track free page ids in every instance, see BufferPoolManagerInstance::EnableFreePageMap(). Each instance
+   * keeps the map of its own page ids.
+   * @param[out] free_pages if not nullptr, receives the number of free pages found in all the maps
+   * @return false if an instance refuses, in which case none keeps a map
+   */
+  auto EnableFreePageMap(size_t *free_pages = nullptr) -> bool;
+
+  /**
+   * @brief Keep clean evicted pages compressed, see BufferPoolManagerInstance::EnableCompressedCache(). Every
+   * instance gets an equal share of the capacity.
+   * @param capacity the most bytes of compressed pages to keep in the whole pool
+   */
+  void EnableCompressedCache(size_t capacity);
+
+  /**
+   * @brief Map the database file in every instance, see BufferPoolManagerInstance::EnableMappedReads().
+   * @return true if every instance mapped the file
+   */
+  auto EnableMappedReads(const std::string &db_file) -> bool;
+
+  /**
+   * @brief Checksum the pages of every instance, see BufferPoolManagerInstance::EnableChecksums(). With several
+   * instances, the i-th one keeps its checksums in checksum_file followed by "." and i.
+   * @return true if every instance checksums its pages
+   */
+  auto EnableChecksums(const std::string &checksum_file) -> bool;
+
+  /** @return the corrupt pages of all the instances, see BufferPoolManagerInstance::GetCorruptPages() */
+  auto GetCorruptPages() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Trace the page calls of every instance, see BufferPoolManagerInstance::EnableTracing(). With several
+   * instances, the i-th one writes its trace to trace_file followed by "." and i; each trace replays one instance.
+   * @return true if every instance is traced
+   */
+  auto EnableTracing(const std::string &trace_file) -> bool;
+
+  /**
+   * @brief Adapt the lookback of the LRU-K replacer of every instance, see
+   * BufferPoolManagerInstance::EnableAdaptiveK(). Each instance adapts its k to its own pages.
+   * @return true if every instance adapts its k
+   */
+  auto EnableAdaptiveK(size_t min_k, size_t max_k) -> bool;
+
+  /**
+   * @brief Write every dirty page of every instance out, see BufferPoolManagerInstance::FlushAllDirtyPages(). The
+   * instances flush in parallel, one thread each.
+   * @return the number of bytes written
+   */
+  auto FlushAllDirtyPages() -> size_t;
+
+  /**
+   * @brief Write the ids of the resident pages of every instance to a file, see
+   * BufferPoolManagerInstance::DumpHotPages(). The instances' lists are interleaved, so that the hottest pages of
+   * each instance come first.
+   * @param path path of the file
+   * @return false if the file could not be written
+   */
+  auto DumpHotPages(const std::string &path) -> bool;
+
+  /**
+   * @brief Warm up every instance with its pages listed in a file written by DumpHotPages(), see
+   * BufferPoolManagerInstance::WarmUp().
+   * @param path path of the file
+   * @return the number of pages being loaded, 0 if the file could not be read
+   */
+  auto LoadHotPages(const std::string &path) -> size_t;
+
+  /**
+   * @brief Fetch several pages at once, all or nothing, see BufferPoolManagerInstance::FetchPages(). Each instance
+   * fetches its share of the pages in one batch; if one of them fails, the pages pinned by the others are unpinned.
+   * @param page_ids ids of the pages to fetch
+   * @return the pinned pages in the order of page_ids, empty if they cannot all be fetched
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids) -> std::vector<Page *>;
+
+  /**
+   * @brief Create several new pages at once in a single instance, all or nothing, see
+   * BufferPoolManagerInstance::NewPages(). Instances are tried round robin like NewPage().
+   * @param num_pages number of pages to create
+   * @param[out] page_ids ids of the created pages
+   * @return the pinned new pages in the order of page_ids, empty if no instance has num_pages unpinned frames
+   */
+  auto NewPages(size_t num_pages, std::vector<page_id_t> *page_ids) -> std::vector<Page *>;
+
+  /**
+   * @brief Create a new page with the next page id of the segment's current extent. An extent of the parallel pool
+   * is a run of consecutive page ids, the same PageSegment::GetExtentPages() page numbers reserved in every instance,
+   * so that its pages are contiguous on disk although they are spread over the instances.
+   * @param segment the segment the page belongs to
+   * @param[out] page_id id of created page
+   * @return nullptr if the instance owning the next page id has every frame pinned, otherwise pointer to the new page
+   */
+  auto NewPageInSegment(PageSegment *segment, page_id_t *page_id) -> Page *;
+
+  /** @brief Fetch a page from the instance that owns it, see BufferPoolManagerInstance::FetchPageBasic(). */
+  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
+
+  /** @brief Fetch and read latch a page, see BufferPoolManagerInstance::FetchPageRead(). */
+  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
+
+  /** @brief Fetch and write latch a page, see BufferPoolManagerInstance::FetchPageWrite(). */
+  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+
+  /** @brief Fetch a page through the file mapping, see BufferPoolManagerInstance::FetchPageMapped(). */
+  auto FetchPageMapped(page_id_t page_id) -> ReadPageGuard;
+
+  /** @brief Fetch a page without waiting for its read, see BufferPoolManagerInstance::FetchPageAsync(). */
+  auto FetchPageAsync(page_id_t page_id, std::function<void(Page *)> on_loaded, bool *pending) -> Page *;
+
+  /**
+   * @brief Create a new page in one of the instances like NewPage(), see
+   * BufferPoolManagerInstance::NewPageGuarded().
+   * @param[out] page_id id of created page
+   * @return the guard of the page, empty if no instance has an unpinned frame
+   */
+  auto NewPageGuarded(page_id_t *page_id) -> BasicPageGuard;
+
+  /** @brief Fetch a page in a priority class, see BufferPoolManagerInstance::FetchPageWithPriority(). */
+  auto FetchPageWithPriority(page_id_t page_id, PagePriority priority) -> Page *;
+
+  /** @brief Create a new page in a priority class, see BufferPoolManagerInstance::NewPageWithPriority(). */
+  auto NewPageWithPriority(page_id_t *page_id, PagePriority priority) -> Page *;
+
+  /** @brief FetchPageBasic() with a priority class, see BufferPoolManagerInstance::FetchPageWithPriority(). */
+  auto FetchPageBasic(page_id_t page_id, PagePriority priority) -> BasicPageGuard;
+
+  /** @brief NewPageGuarded() with a priority class, see BufferPoolManagerInstance::FetchPageWithPriority(). */
+  auto NewPageGuarded(page_id_t *page_id, PagePriority priority) -> BasicPageGuard;
+
+  /**
+   * @brief Limit the frames holding STICKY pages, see BufferPoolManagerInstance::SetStickyFrameLimit(). Every
+   * instance gets an equal share of the limit.
+   * @param max_frames the most frames of the whole pool that may hold sticky pages
+   */
+  void SetStickyFrameLimit(size_t max_frames);
+
+  /**
+   * @brief Fetch a page on behalf of a scan, see BufferPoolManagerInstance::FetchPageWithStrategy(). The strategy
+   * keeps one ring in each instance.
+   * @param page_id id of page to be fetched
+   * @param strategy the scan's access strategy, nullptr for a regular fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page *;
+
+  /** @brief Give the frames of the strategy's rings back to every instance. */
+  void ReleaseAccessStrategy(BufferAccessStrategy *strategy);
+
+ protected:
+  /**
+   * @brief Return the instance responsible for handling the given page id.
+   * @param page_id id of the page
+   * @return the instance owning page_id, or nullptr if page_id is invalid
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Unpin the target page from the instance that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Create a new page in one of the instances. Instances are tried round robin, starting one past the instance
+   * that served the previous call, until one of them has an unpinned frame.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created in any instance, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Delete a page from the instance that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the dirty pages of every instance to disk, in parallel across the instances.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Reserve the segment a new extent at the end of the file, the same page numbers in every instance.
+   * @param segment the segment whose extent is used up
+   */
+  void ReserveExtent(PageSegment *segment);
+
+  /** Number of instances. */
+  const size_t num_instances_;
+  /** Initial number of frames in each instance. */
+  const size_t pool_size_;
+  /** Instance that the next NewPgImp call tries first. */
+  std::atomic<size_t> start_index_{0};
+  /** Serializes ReserveExtent() calls. Taken before the latch of any instance. */
+  std::mutex extent_latch_;
+  /** Serializes Resize() calls, so that the instances that can take a resize still can once it is done to them. */
+  std::mutex resize_latch_;
+  /** True once EnableFreePageMap() was called: extents must then leave the map pages out. */
+  bool free_page_maps_{false};
+  /** The instances, instances_[i] owns the page ids congruent to i modulo num_instances_. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+};
+}  // namespace bustub
@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.h
+//
+// Identification: src/include/buffer/replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/** Replacement policies a BufferPoolManagerInstance can be configured with. */
+enum class ReplacerPolicy { LRU_K, CLOCK, TWO_QUEUE, ARC };
+
+/**
+ * Priority classes of the pages of a buffer pool, lowest first. Frames of a lower class are evicted before any frame
+ * of a higher class: SCAN for pages read once by a scan, NORMAL by default, STICKY for pages every lookup goes
+ * through, such as the root and inner pages of a B+ tree or catalog pages.
+ */
+enum class PagePriority : uint8_t { SCAN, NORMAL, STICKY };
+
+/**
+ * Replacer is the abstract interface of the buffer pool's replacement policies. It tracks the frames of the pool
+ * and picks the victim frame when the buffer pool needs room for a new page.
+ *
+ * A frame becomes known to the replacer on its first RecordAccess() or RecordPrefetch() and starts out
+ * non-evictable. Only evictable frames are eviction candidates, and Size() counts them.
+ */
+class Replacer {
+ public:
+  Replacer() = default;
+  virtual ~Replacer() = default;
+
+  /**
+   * @brief Pick a victim among the evictable frames and stop tracking it.
+   * @param[out] frame_id id of frame that is evicted.
+   * @return true if a frame is evicted successfully, false if no frames can be evicted.
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * @brief Record that the given frame was accessed, starting to track it if it was unknown.
+   * @param frame_id id of frame that received a new access.
+   */
+  virtual void RecordAccess(frame_id_t frame_id) = 0;
+
+  /**
+   * @brief Start tracking a frame whose page was read ahead of any access, e.g. by a prefetch. The read is no
+   * access: the frame takes part in eviction as if it had been accessed once, but its first RecordAccess() takes the
+   * place of that access rather than adding a second one. Does nothing for a tracked frame.
+   * @param frame_id id of the frame that received the page
+   */
+  virtual void RecordPrefetch(frame_id_t frame_id) = 0;
+
+  /**
+   * @brief Toggle whether a tracked frame is evictable; does nothing for an unknown frame.
+   * @param frame_id id of frame whose 'evictable' status will be modified
+   * @param set_evictable whether the given frame is evictable or not
+   */
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
+
+  /**
+   * @brief Stop tracking a frame, e.g. because its page was deleted. Does nothing for an unknown frame.
+   * @param frame_id id of frame to be removed
+   */
+  virtual void Remove(frame_id_t frame_id) = 0;
+
+  /**
+   * @brief Take back the eviction of a frame whose page turned out to be pinned again by the time the buffer pool
+   * got to it. The frame is tracked again, non-evictable, in the state it was evicted in as far as the policy still
+   * knows it, and the ghost entry the eviction left for the page is dropped without counting as the page coming
+   * back. An access recorded for the frame since the eviction counts as an access of the page.
+   * @param frame_id id of the frame Evict() returned
+   * @param page_id id of the page the frame still holds
+   */
+  virtual void Reinstate(frame_id_t frame_id, page_id_t page_id) = 0;
+
+  /**
+   * @brief Record an access to each of the frames and make it non-evictable, as RecordAccess() followed by
+   * SetEvictable(frame_id, false) on every frame in turn. The buffer pool calls this when it pins several pages at
+   * once; policies override it to do the batch under a single acquisition of their latch.
+   * @param frame_ids ids of the frames that were pinned
+   * @param num_frames number of frames in frame_ids
+   */
+  virtual void PinFrames(const frame_id_t *frame_ids, size_t num_frames) {
+    for (size_t i = 0; i < num_frames; i++) {
+      RecordAccess(frame_ids[i]);
+      SetEvictable(frame_ids[i], false);
+    }
+  }
+
+  /** @return the number of evictable frames */
+  virtual auto Size() -> size_t = 0;
+
+  /**
+   * @brief List the evictable frames in the order Evict() would pick them, without evicting them. Frames that are
+   * about to be evicted are the ones worth cleaning ahead of time.
+   * @param[out] frame_ids receives up to max_frames frame ids, the next victim first
+   * @param max_frames maximum number of frames to list
+   * @return the number of frames listed
+   */
+  virtual auto PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t = 0;
+
+  /**
+   * @brief Tell the replacer which page the frame is about to hold, before the frame's first RecordAccess().
+   * Policies that remember evicted pages (ghost entries) need the page id to recognize a page coming back.
+   * @param frame_id id of the frame
+   * @param page_id id of the page loaded into the frame
+   */
+  virtual void SetFramePage(frame_id_t frame_id, page_id_t page_id) {}
+
+  /**
+   * @return the number of evictions of frames the policy considers cold, i.e. seen once or only in a correlated
+   * burst: fewer than k accesses for LRU-K, the A1in queue for 2Q, T1 for ARC. 0 for policies without such a class.
+   * A high share of cold evictions means the pool is mostly cycling through pages that are not reused.
+   */
+  virtual auto GetColdEvictionCount() -> size_t { return 0; }
+
+  /**
+   * @brief Set the priority class of a frame until it is evicted or removed, when it returns to NORMAL. Only the
+   * policies that support priority classes override this; the others ignore it.
+   * @param frame_id id of the frame
+   * @param priority the class of the frame's page
+   */
+  virtual void SetPriority(frame_id_t frame_id, PagePriority priority) {}
+
+  /**
+   * @brief Let the policy tune its lookback online between the given bounds, see LRUKReplacer::SetAdaptiveK(). Must
+   * not run concurrently with any other call on the replacer.
+   * @param min_k the smallest lookback to use
+   * @param max_k the largest lookback to use
+   * @return false if the policy has no lookback or the bounds are invalid
+   */
+  virtual auto SetAdaptiveK(size_t min_k, size_t max_k) -> bool { return false; }
+
+  /** @return the current lookback k of the policy, 0 for policies without one */
+  virtual auto GetK() -> size_t { return 0; }
+
+  /**
+   * @brief Change the number of frames the replacer covers, when the buffer pool grows or shrinks. Frames beyond
+   * the new size are forgotten. Must not run concurrently with any other call on the replacer.
+   * @param num_frames the new number of frames
+   */
+  virtual void Resize(size_t num_frames) = 0;
+};
+
+}  // namespace bustub
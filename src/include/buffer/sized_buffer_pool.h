@@ -0,0 +1,191 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sized_buffer_pool.h
+//
+// Identification: src/include/buffer/sized_buffer_pool.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/frame_arena.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+template <size_t PageSize>
+class SizedBufferPool;
+
+/**
+ * SizedPageGuard holds the pins of the blocks of a page of a SizedBufferPool and drops them when it is destroyed or
+ * dropped. Like a BasicPageGuard it does not latch the blocks, and it is move-only. Only the blocks modified through
+ * the guard are marked dirty.
+ */
+template <size_t PageSize>
+class SizedPageGuard {
+ public:
+  static constexpr size_t BLOCKS_PER_PAGE = PageSize / BUSTUB_PAGE_SIZE;
+
+  SizedPageGuard() = default;
+
+  SizedPageGuard(const SizedPageGuard &) = delete;
+  auto operator=(const SizedPageGuard &) -> SizedPageGuard & = delete;
+
+  /** @brief Take over the pins of that; that becomes empty. */
+  SizedPageGuard(SizedPageGuard &&that) noexcept;
+
+  /** @brief Drop the pins held by this guard, then take over the pins of that; that becomes empty. */
+  auto operator=(SizedPageGuard &&that) noexcept -> SizedPageGuard &;
+
+  ~SizedPageGuard() { Drop(); }
+
+  /** @brief Drop the pins, marking the modified blocks dirty. The guard becomes empty. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return pool_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  auto PageId() const -> page_id_t { return page_id_; }
+
+  /** @return the BUSTUB_PAGE_SIZE bytes of the block-th block of the page */
+  auto GetBlock(size_t block) const -> const char * { return blocks_[block]->GetData(); }
+
+  /** @return the bytes of a block of the page, which is marked dirty when the guard is dropped */
+  auto GetBlockMut(size_t block) -> char * {
+    dirty_.set(block);
+    return blocks_[block]->GetData();
+  }
+
+  /**
+   * @brief Copy bytes out of the page, across blocks.
+   * @param offset offset in the page of the first byte
+   * @param[out] dst where to copy the bytes to
+   * @param size number of bytes, offset + size at most PageSize
+   */
+  void Read(size_t offset, char *dst, size_t size) const;
+
+  /**
+   * @brief Copy bytes into the page, across blocks, marking the blocks written to dirty.
+   * @param offset offset in the page of the first byte
+   * @param src the bytes to copy
+   * @param size number of bytes, offset + size at most PageSize
+   */
+  void Write(size_t offset, const char *src, size_t size);
+
+ private:
+  friend class SizedBufferPool<PageSize>;
+
+  SizedPageGuard(SizedBufferPool<PageSize> *pool, page_id_t page_id, const std::array<Page *, BLOCKS_PER_PAGE> &blocks)
+      : pool_(pool), page_id_(page_id), blocks_(blocks) {}
+
+  SizedBufferPool<PageSize> *pool_{nullptr};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  std::array<Page *, BLOCKS_PER_PAGE> blocks_{};
+  std::bitset<BLOCKS_PER_PAGE> dirty_;
+};
+
+/**
+ * SizedBufferPool is a buffer pool of pages of PageSize bytes, a multiple of BUSTUB_PAGE_SIZE, e.g. 32 or 64 KB
+ * pages for analytic tables next to the 4 KB pages of the indexes. Each size class is a pool of its own, over a
+ * database file of its own, with its own frames, replacer and free list, so that scans of large pages do not evict
+ * small ones.
+ *
+ * A page of the pool is stored as a run of BLOCKS_PER_PAGE consecutive BUSTUB_PAGE_SIZE blocks of the underlying
+ * BufferPoolManagerInstance: page p is blocks p * BLOCKS_PER_PAGE and up. Fetching a page pins all of its blocks at
+ * once with FetchPages(), which reads the missing ones with a single vectored I/O on the io_uring backend. Blocks
+ * are evicted independently once unpinned; a fetch reads back only those it misses.
+ *
+ * Pages must only be created through the pool, and the free page map of the underlying pool must not be enabled,
+ * since both would break the alignment of the blocks of a page.
+ */
+template <size_t PageSize>
+class SizedBufferPool {
+ public:
+  static_assert(PageSize >= BUSTUB_PAGE_SIZE && PageSize % BUSTUB_PAGE_SIZE == 0,
+                "the page size must be a multiple of BUSTUB_PAGE_SIZE");
+  static_assert(PageSize / BUSTUB_PAGE_SIZE <= DiskScheduler::MAX_PAGES_PER_REQUEST,
+                "the blocks of a page must fit in a single disk request");
+
+  static constexpr size_t BLOCKS_PER_PAGE = PageSize / BUSTUB_PAGE_SIZE;
+
+  /**
+   * @brief Creates a new SizedBufferPool.
+   * @param pool_size the number of PageSize pages the pool holds
+   * @param disk_manager the disk manager of the pool's database file
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param replacer_policy the replacement policy of the blocks
+   * @param arena_options huge page, alignment and NUMA options of the memory holding the blocks
+   */
+  SizedBufferPool(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                  ReplacerPolicy replacer_policy = ReplacerPolicy::LRU_K,
+                  const FrameArenaOptions &arena_options = FrameArenaOptions{})
+      : blocks_(pool_size * BLOCKS_PER_PAGE, disk_manager, replacer_k, nullptr, replacer_policy, arena_options) {}
+
+  DISALLOW_COPY_AND_MOVE(SizedBufferPool);
+
+  /**
+   * @brief Create a new page, zeroed.
+   * @param[out] page_id id of the created page
+   * @return the guard of the page, empty if fewer than BLOCKS_PER_PAGE frames are unpinned, or if the new blocks
+   * are not an aligned run because pages were created in the block pool directly
+   */
+  auto NewPage(page_id_t *page_id) -> SizedPageGuard<PageSize>;
+
+  /**
+   * @brief Fetch a page, all of its blocks or none.
+   * @param page_id id of the page
+   * @return the guard of the page, empty if fewer than BLOCKS_PER_PAGE frames can be pinned
+   */
+  auto FetchPage(page_id_t page_id) -> SizedPageGuard<PageSize>;
+
+  /**
+   * @brief Write out the resident blocks of a page, runs of consecutive blocks as one vectored write.
+   * @param page_id id of the page
+   * @return false if none of the blocks of the page is resident
+   */
+  auto FlushPage(page_id_t page_id) -> bool;
+
+  /**
+   * @brief Delete a page from the pool.
+   * @param page_id id of the page
+   * @return false if a block of the page is pinned, in which case none of the blocks is deleted
+   */
+  auto DeletePage(page_id_t page_id) -> bool;
+
+  /** @brief Write out every resident block. */
+  void FlushAllPages() { blocks_.FlushAllPages(); }
+
+  /** @return the pool of the blocks, e.g. to enable io_uring or to read the metrics */
+  auto GetBlockPool() -> BufferPoolManagerInstance * { return &blocks_; }
+
+ private:
+  friend class SizedPageGuard<PageSize>;
+
+  /** @return the id of a block of a page */
+  static auto BlockId(page_id_t page_id, size_t block) -> page_id_t {
+    return static_cast<page_id_t>(static_cast<size_t>(page_id) * BLOCKS_PER_PAGE + block);
+  }
+
+  /** @return the ids of the blocks of a page, in order */
+  static auto BlockIds(page_id_t page_id) -> std::vector<page_id_t>;
+
+  BufferPoolManagerInstance blocks_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,101 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/frame_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the full version of the 2Q policy (Johnson and Shasha, VLDB 1994).
+ *
+ * A page loaded for the first time enters the FIFO queue A1in, where further accesses do not promote it. Pages that
+ * leave A1in are remembered in the ghost queue A1out; a page that is loaded again while it is still remembered goes
+ * to the LRU queue Am instead. Eviction takes from A1in while it holds more than a quarter of the frames, and from
+ * Am otherwise, so a one-time scan can only ever displace A1in.
+ *
+ * The evictable frames of each queue are kept in a heap ordered by the time the frame entered A1in, or by its last
+ * access in Am, so that eviction never steps over pinned frames.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  /**
+   * @brief Creates a new TwoQueueReplacer.
+   * @param num_frames the maximum number of frames the TwoQueueReplacer will be required to store
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  DISALLOW_COPY_AND_MOVE(TwoQueueReplacer);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void RecordPrefetch(frame_id_t frame_id) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void Reinstate(frame_id_t frame_id, page_id_t page_id) override;
+
+  auto Size() -> size_t override;
+
+  auto PeekVictims(frame_id_t *frame_ids, size_t max_frames) -> size_t override;
+
+  void SetFramePage(frame_id_t frame_id, page_id_t page_id) override;
+
+  void Resize(size_t num_frames) override;
+
+  auto GetColdEvictionCount() -> size_t override;
+
+ private:
+  static constexpr size_t A1IN = 0;
+  static constexpr size_t AM = 1;
+  static constexpr size_t NO_LIST = 2;
+
+  /** @return the list Evict() takes from first */
+  auto FirstVictimList() const -> size_t;
+  /** Start tracking an untracked frame on the list, non-evictable, with the given stamp. Caller must hold latch_. */
+  void Track(frame_id_t frame_id, size_t list, uint64_t stamp);
+  /** Move a tracked frame to the list with a new stamp, evictable or not as it was. Caller must hold latch_. */
+  void Move(frame_id_t frame_id, size_t list, uint64_t stamp);
+  /** Stop tracking a tracked frame; its stamp is left behind for Reinstate(). Caller must hold latch_. */
+  void Untrack(frame_id_t frame_id);
+
+  size_t replacer_size_;
+  size_t kin_;   // A1in is preferred for eviction while it holds more frames than this
+  size_t kout_;  // number of pages A1out remembers
+  size_t curr_size_{0};
+  size_t cold_evictions_{0};
+  uint64_t clock_{0};
+  std::mutex latch_;
+
+  std::vector<size_t> list_of_;   // A1IN, AM or NO_LIST for an untracked frame
+  size_t list_sizes_[2]{0, 0};    // tracked frames of each list, evictable or not
+  std::vector<uint64_t> stamps_;  // when the frame entered A1in, or its last access in Am
+  FrameHeap victims_[2];          // evictable frames of each list by stamp
+  GhostList a1out_;
+  std::vector<page_id_t> frame_page_;
+  std::vector<bool> prefetched_;  // frames tracked by RecordPrefetch() and not accessed since
+};
+
+}  // namespace bustub
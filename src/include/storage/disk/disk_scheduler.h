@@ -0,0 +1,211 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/io_uring.h"
+#include "storage/disk/page_checksums.h"
+
+namespace bustub {
+
+/**
+ * @brief Represents a Write or Read request for the DiskManager to execute.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+
+  /**
+   * Pointer to the start of the memory location where a page is either:
+   *   1. being read into from disk (on a read).
+   *   2. being written out to disk (on a write).
+   */
+  char *data_;
+
+  /** ID of the page being read from / written to disk. */
+  page_id_t page_id_;
+
+  /** Called by the worker thread once the request has been executed. */
+  std::function<void()> callback_;
+
+  /**
+   * Buffers of the pages following page_id_ when the request covers a run of consecutive pages, which the io_uring
+   * backend transfers with a single vectored I/O. Empty for a single page request.
+   */
+  std::vector<char *> next_data_{};
+
+  /**
+   * If true, the request scheduled right after this one in the same batch starts only once this one has completed,
+   * e.g. the read of a page into a frame after the write-back of the page the frame held. The io_uring backend
+   * submits the two as linked entries; a failed write still lets the read go on.
+   */
+  bool link_next_{false};
+
+  /**
+   * If not nullptr, set to whether the request failed before the callback runs. Only the io_uring backend detects
+   * failures, the DiskManager does not report them.
+   */
+  bool *failed_{nullptr};
+
+  /** @return the number of pages the request covers */
+  auto NumPages() const -> size_t { return 1 + next_data_.size(); }
+};
+
+/**
+ * @brief The DiskScheduler queues read and write requests and executes them in the background, so that the thread
+ * issuing a request can go on with other work meanwhile.
+ *
+ * There are two backends. The default one runs worker threads that execute the requests one at a time through the
+ * DiskManager. The io_uring backend opens the database file itself and keeps up to queue_depth requests in flight
+ * in the kernel: a submitter thread passes every batch of queued requests to the kernel with a single system call,
+ * and a completion thread runs the callbacks. It falls back to the worker threads when io_uring is not available.
+ *
+ * Requests may complete out of order. A request that must follow another one is scheduled in the same batch right
+ * after it, with link_next_ set on the first, or from the callback of the first. Callbacks run on the scheduler's
+ * threads and must not block on anything that waits for I/O.
+ */
+class DiskScheduler {
+ public:
+  /** Default number of requests the io_uring backend keeps in flight. */
+  static constexpr size_t DEFAULT_QUEUE_DEPTH = 64;
+
+  /**
+   * @brief Creates a new DiskScheduler with the worker thread backend.
+   * @param disk_manager the disk manager executing the requests
+   * @param num_workers number of worker threads
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t num_workers = 1);
+
+  /**
+   * @brief Creates a new DiskScheduler with the io_uring backend, or the worker thread backend with a single worker
+   * if io_uring or the database file is not available.
+   * @param disk_manager the disk manager of the fallback backend
+   * @param db_file path of the database file the disk manager works on
+   * @param direct_io true to open the file with O_DIRECT; requests whose buffer is not aligned to
+   * DIRECT_IO_ALIGNMENT then go through an aligned bounce buffer
+   * @param queue_depth maximum number of requests in flight in the kernel
+   */
+  DiskScheduler(DiskManager *disk_manager, const std::string &db_file, bool direct_io,
+                size_t queue_depth = DEFAULT_QUEUE_DEPTH);
+
+  DISALLOW_COPY_AND_MOVE(DiskScheduler);
+
+  /**
+   * @brief Executes every request still queued, including the ones scheduled by callbacks meanwhile, then joins the
+   * scheduler's threads.
+   */
+  ~DiskScheduler();
+
+  /**
+   * @brief Schedules a request for the DiskManager to execute.
+   * @param r the request to be scheduled
+   */
+  void Schedule(DiskRequest r);
+
+  /**
+   * @brief Schedules a batch of requests at once; the io_uring backend submits them together.
+   * @param requests the requests to be scheduled
+   */
+  void Schedule(std::vector<DiskRequest> requests);
+
+  /**
+   * @brief Schedules a batch of requests and waits until all of them have completed and their callbacks have run.
+   * Must not be called from a callback.
+   * @param requests the requests to be executed
+   */
+  void ScheduleAndWait(std::vector<DiskRequest> requests);
+
+  /**
+   * @brief Have the pages written recorded in, and the pages read verified against, a checksum file. Must be called
+   * before any request is scheduled. A page is sealed when it is written, from a copy that is what goes to disk, so
+   * that a page changing under a flush cannot disagree with its checksum. A page that fails verification is still
+   * handed to the callback as read; the failure is counted and logged by the checksums.
+   * @param checksums the checksums of the pages, owned by the caller; nullptr to stop checksumming
+   */
+  void SetChecksums(PageChecksums *checksums) { checksums_ = checksums; }
+
+  /** @return true if requests go through io_uring, false if they go through the DiskManager */
+  auto UsesIoUring() const -> bool { return ring_ != nullptr; }
+
+  /** Buffer and file offset alignment required by O_DIRECT. */
+  static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+  /** Maximum number of pages a single request should cover, well below the kernel's IOV_MAX. */
+  static constexpr size_t MAX_PAGES_PER_REQUEST = 64;
+
+ private:
+  /** A request submitted to io_uring, its address is the user_data of the submission. */
+  struct InFlightRequest {
+    DiskRequest request_;
+    char *bounce_buffer_;  // aligned copy of the pages for O_DIRECT, nullptr if the request buffers are used directly
+    std::vector<iovec> iovecs_{};  // one per page of a vectored request, must live until the request completes
+  };
+
+  /** @brief Body of the worker threads: executes requests through the DiskManager until shut down. */
+  void StartWorkerThread();
+  /** @brief Execute a request through the DiskManager and run its callback. */
+  void ExecuteRequest(const DiskRequest &request);
+  /** @brief Body of the io_uring submitter thread: passes queued requests to the kernel until shut down. */
+  void StartSubmitterThread();
+  /** @brief Body of the io_uring completion thread: completes requests until the submitter's final no-op. */
+  void StartCompletionThread();
+  /** @return the number of requests at the front of the queue that are submitted together, a linked pair or one */
+  auto FrontRequests() const -> size_t;
+  /**
+   * @brief Prepare the submission of an io_uring request; the latch should be held.
+   * @param link_next true to link the entry to the one prepared next
+   */
+  void PrepareRequest(InFlightRequest *in_flight, bool link_next);
+  /** @brief Transfer a prepared io_uring request with blocking system calls. @return bytes transferred or -errno */
+  auto TransferSync(InFlightRequest *in_flight) -> int32_t;
+  /** @brief Finish an io_uring request: handle short transfers and errors, run the callback, free it. */
+  void CompleteRequest(InFlightRequest *in_flight, int32_t res);
+  /** @brief Verify the pages of a read request against their checksums, once they are read. */
+  void VerifyRequest(const DiskRequest &request);
+  /** @return the buffer the io_uring transfers the page_index-th page of a request from or to */
+  static auto PageBuffer(const InFlightRequest &in_flight, size_t page_index) -> char *;
+
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_;
+  /** Protects request_queue_, shutdown_ and in_flight_. */
+  std::mutex latch_;
+  std::condition_variable request_ready_;
+  std::deque<DiskRequest> request_queue_;
+  bool shutdown_{false};
+  std::vector<std::thread> workers_;
+
+  /** io_uring backend, nullptr with the worker thread backend. */
+  std::unique_ptr<IoUring> ring_;
+  int fd_{-1};
+  bool direct_io_{false};
+  size_t queue_depth_{0};
+  /** Number of requests submitted to io_uring and not completed yet. */
+  size_t in_flight_{0};
+  /** Checksums of the pages, nullptr if they are not checksummed. */
+  PageChecksums *checksums_{nullptr};
+};
+
+}  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.h
+//
+// Identification: src/include/storage/disk/io_uring.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * IoUring is a minimal wrapper of a Linux io_uring instance, driven through the raw system calls so that no liburing
+ * is needed. The submission side (Prepare() and Submit()) and the completion side (WaitCompletions()) may each be
+ * used by one thread, concurrently with each other.
+ */
+class IoUring {
+ public:
+  /**
+   * @brief Sets up an io_uring instance. Check IsValid() afterwards: the kernel may not support io_uring, or it may
+   * be disabled.
+   * @param entries the number of submission queue entries; rounded up to a power of two by the kernel
+   */
+  explicit IoUring(uint32_t entries);
+
+  DISALLOW_COPY_AND_MOVE(IoUring);
+
+  ~IoUring();
+
+  /** @return true if the io_uring instance was set up */
+  auto IsValid() const -> bool { return ring_fd_ >= 0; }
+
+  /** @return the number of submission queue entries */
+  auto GetEntries() const -> uint32_t { return sq_entries_; }
+
+  /**
+   * @brief Queue a submission queue entry, to be passed to the kernel by the next Submit().
+   * @param opcode one of the IORING_OP_* operations, e.g. IORING_OP_READ or IORING_OP_WRITEV
+   * @param fd file descriptor the operation works on
+   * @param addr buffer address (or iovec array for the vectored operations)
+   * @param len buffer length (or number of iovecs)
+   * @param offset file offset
+   * @param user_data value handed back with the completion of the entry
+   * @param flags IOSQE_* flags of the entry, e.g. IOSQE_IO_LINK to start the next entry only once this one is done
+   * @return false if the submission queue is full
+   */
+  auto Prepare(uint8_t opcode, int fd, const void *addr, uint32_t len, uint64_t offset, uint64_t user_data,
+               uint8_t flags = 0) -> bool;
+
+  /**
+   * @brief Pass every prepared entry to the kernel with a single io_uring_enter() call (more if it submits only part
+   * of them).
+   * @return false if the kernel rejected the submission
+   */
+  auto Submit() -> bool;
+
+  /**
+   * @brief Take back the prepared entries the kernel did not accept, after Submit() failed; they will not complete.
+   * @return the number of entries taken back, which are the last ones prepared
+   */
+  auto Retract() -> uint32_t;
+
+  /**
+   * @brief Wait until at least one completion is available, then reap all available completions.
+   * @param on_completion called with the user_data and the result (bytes transferred or -errno) of each completion
+   * @return the number of completions reaped, at least one
+   */
+  auto WaitCompletions(const std::function<void(uint64_t user_data, int32_t res)> &on_completion) -> size_t;
+
+ private:
+  int ring_fd_{-1};
+  uint32_t sq_entries_{0};
+  uint32_t to_submit_{0};
+
+  void *sq_ring_{nullptr};
+  void *cq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  /** Pointers into the rings shared with the kernel. */
+  uint32_t *sq_head_{nullptr};
+  uint32_t *sq_tail_{nullptr};
+  uint32_t *sq_mask_{nullptr};
+  uint32_t *sq_array_{nullptr};
+  uint32_t *cq_head_{nullptr};
+  uint32_t *cq_tail_{nullptr};
+  uint32_t *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+}  // namespace bustub
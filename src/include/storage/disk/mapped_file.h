@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_file.h
+//
+// Identification: src/include/storage/disk/mapped_file.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <string>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * MappedFile maps a database file read-only and shared, so that its pages can be read where the kernel keeps them,
+ * without copying them into a frame. On a DAX file system (persistent memory) the mapping is the device itself.
+ *
+ * The file is mapped in SEGMENT_SIZE segments, each the first time one of its pages is asked for, and never unmapped
+ * before the MappedFile is destroyed: a pointer handed out stays valid while the file grows. Pages past the end of
+ * the file are not handed out, since touching them would raise SIGBUS.
+ */
+class MappedFile {
+ public:
+  /** Bytes mapped at a time; the mappings only take address space until their pages are read. */
+  static constexpr size_t SEGMENT_SIZE = static_cast<size_t>(1) << 30;
+  /** Most segments of a file, i.e. the largest file that can be mapped is 1 TB. */
+  static constexpr size_t MAX_SEGMENTS = 1024;
+
+  /**
+   * @brief Open a file for mapping. Check IsValid() afterwards.
+   * @param path path of the database file
+   */
+  explicit MappedFile(const std::string &path);
+
+  DISALLOW_COPY_AND_MOVE(MappedFile);
+
+  /** @brief Unmap the segments and close the file. */
+  ~MappedFile();
+
+  /** @return true if the file could be opened */
+  auto IsValid() const -> bool { return fd_ >= 0; }
+
+  /**
+   * @brief Find a page in the mapping. Writes to the file through other descriptors show through the mapping.
+   * @param page_id id of the page, at offset page_id * BUSTUB_PAGE_SIZE of the file
+   * @return the BUSTUB_PAGE_SIZE bytes of the page, nullptr if the page is past the end of the file or its segment
+   * cannot be mapped
+   */
+  auto GetPage(page_id_t page_id) -> const char *;
+
+ private:
+  /** @brief Reread the size of the file. @return true if it holds at least end bytes */
+  auto RefreshFileSize(uint64_t end) -> bool;
+
+  int fd_{-1};
+  /** Size of the file when last looked at; it only grows. */
+  std::atomic<uint64_t> file_size_{0};
+  std::array<std::atomic<char *>, MAX_SEGMENTS> segments_{};
+  /** Serializes the mapping of segments and the size refreshes. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
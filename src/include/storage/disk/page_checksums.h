@@ -0,0 +1,131 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksums.h
+//
+// Identification: src/include/storage/disk/page_checksums.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>         // NOLINT
+#include <shared_mutex>  // NOLINT
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageChecksums keeps a CRC32C of every page written to the database file, so that a torn write or bit rot is caught
+ * when the page is read back instead of surfacing later as garbage in the layers above. The checksums are kept out
+ * of the pages, which have no room to spare, in a file of their own: a small header followed by one 4-byte slot per
+ * page of the instance, updated with every page write. A slot of 0 means unknown, and the page is not verified (a
+ * page whose checksum happens to be 0 is never verified either).
+ *
+ * Neither file is synced, so after a crash a page and its checksum may disagree; that is reported like any other
+ * corruption. Pages written before checksums were enabled are only verified once they have been written again.
+ *
+ * The CRC uses the SSE4.2 or ARMv8 CRC32C instructions when the CPU has them, which takes well under a microsecond
+ * per page, and a slicing-by-8 table otherwise. The slots are latched in stripes, so that concurrent writes of
+ * different pages do not serialize on a single latch, and a run of pages written together is sealed with a single
+ * write of the checksum file.
+ */
+class PageChecksums {
+ public:
+  /**
+   * @brief Open the checksum file, creating it if needed, and load its checksums. Check IsValid() afterwards.
+   * @param path path of the checksum file
+   * @param num_instances number of buffer pool instances the page ids are striped over; a file covers the pages of
+   * one instance, page i of the instance (page id i * num_instances + index) in slot i
+   */
+  PageChecksums(const std::string &path, uint32_t num_instances);
+
+  DISALLOW_COPY_AND_MOVE(PageChecksums);
+
+  ~PageChecksums();
+
+  /** @return true if the file could be opened and is a checksum file */
+  auto IsValid() const -> bool { return fd_ >= 0; }
+
+  /**
+   * @brief Record the checksums of a run of consecutive pages about to be written.
+   * @param page_id id of the first page
+   * @param data BUSTUB_PAGE_SIZE bytes of every page, one page after the other
+   * @param num_pages number of pages of the run
+   */
+  void Seal(page_id_t page_id, const char *data, size_t num_pages = 1);
+
+  /**
+   * @brief Check a page that was just read against its recorded checksum. A mismatch is counted, and the page is
+   * reported by GetCorruptPages() until it is written again.
+   * @param page_id id of the page
+   * @param data BUSTUB_PAGE_SIZE bytes of the page
+   * @return false if the page does not match its checksum
+   */
+  auto Verify(page_id_t page_id, const char *data) -> bool;
+
+  /** @return the number of reads that did not match their checksum */
+  auto GetFailureCount() const -> uint64_t { return failures_.load(std::memory_order_relaxed); }
+
+  /** @return the pages whose last read did not match their checksum and that were not written since */
+  auto GetCorruptPages() -> std::vector<page_id_t>;
+
+  /**
+   * @brief Compute a CRC32C (Castagnoli polynomial, as in iSCSI and ext4).
+   * @param data the bytes to checksum
+   * @param size number of bytes
+   * @return the CRC of the bytes
+   */
+  static auto Crc32c(const char *data, size_t size) -> uint32_t;
+
+  /** @return true if Crc32c() uses CRC instructions of the CPU */
+  static auto UsesHardwareCrc32c() -> bool;
+
+ private:
+  /**
+   * "BTCK", read in the byte order the file was written in, then a reserved word of 0; the slots start at
+   * HEADER_SIZE.
+   */
+  static constexpr uint32_t MAGIC = 0x4b435442;
+  static constexpr size_t HEADER_SIZE = 8;
+  /** Slots per stripe, those of a 4 KB block of the file, and the number of stripe latches they are spread over. */
+  static constexpr size_t STRIPE_SLOTS = 1024;
+  static constexpr size_t NUM_STRIPES = 64;
+
+  /** @return the slot of a page */
+  auto Slot(page_id_t page_id) const -> size_t { return static_cast<size_t>(page_id) / num_instances_; }
+
+  /** @return the latch of the stripe a slot is in */
+  auto StripeLatch(size_t slot) -> std::mutex & { return stripe_latches_[slot / STRIPE_SLOTS % NUM_STRIPES]; }
+
+  /** @brief Make room for the slots below num_slots. */
+  void GrowSlots(size_t num_slots);
+
+  int fd_{-1};
+  const uint32_t num_instances_;
+  /**
+   * Checksums by slot. slots_latch_ is held shared to read or update a slot and exclusively to grow the vector; the
+   * slot's value and its writes to the file are ordered by its stripe latch, taken after slots_latch_.
+   */
+  std::vector<uint32_t> slots_;
+  std::shared_mutex slots_latch_;
+  std::mutex stripe_latches_[NUM_STRIPES];
+  /** Pages that failed verification; their count lets a seal skip corrupt_latch_ while there are none. */
+  std::unordered_set<page_id_t> corrupt_pages_;
+  std::atomic<size_t> corrupt_page_count_{0};
+  std::mutex corrupt_latch_;
+  std::atomic<uint64_t> failures_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,185 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds a pin on a page of a buffer pool and drops it when it is destroyed or dropped, so that a pin
+ * can neither leak nor be dropped twice. The pin is dropped on the page's frame directly, without looking the page up
+ * again. A guard is move-only; a moved-from or default-constructed guard is empty and guards nothing.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * @brief Take over a pin of a page. Called by the buffer pool that pinned it.
+   * @param bpm the buffer pool holding the page
+   * @param page the pinned page
+   * @param frame_id the frame holding the page
+   * @param mapped_data the page in the pool's file mapping if the frame does not hold its data, nullptr otherwise
+   */
+  BasicPageGuard(BufferPoolManagerInstance *bpm, Page *page, frame_id_t frame_id, const char *mapped_data = nullptr)
+      : bpm_(bpm), page_(page), frame_id_(frame_id), mapped_data_(mapped_data) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** @brief Take over the pin of that; that becomes empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** @brief Drop the pin held by this guard, then take over the pin of that; that becomes empty. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  ~BasicPageGuard() { Drop(); }
+
+  /** @brief Drop the pin, marking the page dirty if it was modified through GetDataMut(). The guard becomes empty. */
+  void Drop();
+
+  /**
+   * @brief Turn this guard into a ReadPageGuard, waiting for the page's read latch. This guard becomes empty.
+   * @return the read guard, empty if this guard is empty
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+  /**
+   * @brief Turn this guard into a WritePageGuard, waiting for the page's write latch. This guard becomes empty.
+   * @return the write guard, empty if this guard is empty
+   */
+  auto UpgradeWrite() -> WritePageGuard;
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page */
+  auto GetData() const -> const char * { return mapped_data_ != nullptr ? mapped_data_ : page_->GetData(); }
+
+  /** @return the data of the guarded page, which is marked dirty when the guard is dropped */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  auto As() const -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManagerInstance *bpm_{nullptr};
+  Page *page_{nullptr};
+  frame_id_t frame_id_{-1};
+  /** Set for a page read through the file mapping, which is read-only: GetDataMut() is never used on it. */
+  const char *mapped_data_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard holds a pin and the read latch of a page, and releases both when it is destroyed or dropped.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @brief Take over the pin of guard and the read latch its page is already locked with. */
+  explicit ReadPageGuard(BasicPageGuard &&guard) : guard_(std::move(guard)) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** @brief Release the latch and pin held by this guard, then take over those of that. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  ~ReadPageGuard() { Drop(); }
+
+  /** @brief Release the read latch, then the pin. The guard becomes empty. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds a pin and the write latch of a page, and releases both when it is destroyed or dropped. The
+ * page is marked dirty when the guard is released.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @brief Take over the pin of guard and the write latch its page is already locked with. */
+  explicit WritePageGuard(BasicPageGuard &&guard) : guard_(std::move(guard)) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** @brief Release the latch and pin held by this guard, then take over those of that. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  ~WritePageGuard() { Drop(); }
+
+  /** @brief Release the write latch, then the pin, marking the page dirty. The guard becomes empty. */
+  void Drop();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+  auto GetData() const -> const char * { return guard_.GetData(); }
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,335 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+/** user_data of the no-op the submitter thread sends last, telling the completion thread to exit. */
+constexpr uint64_t SHUTDOWN_USER_DATA = 0;
+}  // namespace
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_workers > 0, "DiskScheduler needs at least one worker");
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; i++) workers_.emplace_back(&DiskScheduler::StartWorkerThread, this);
+}
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, const std::string &db_file, bool direct_io,
+                             size_t queue_depth)
+    : disk_manager_(disk_manager), direct_io_(direct_io), queue_depth_(queue_depth) {
+  // room for a linked pair at least
+  auto ring = std::make_unique<IoUring>(static_cast<uint32_t>(std::max<size_t>(queue_depth, 2)));
+  if (ring->IsValid()) {
+    fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | (direct_io ? O_DIRECT : 0), 0644);
+    if (fd_ < 0 && direct_io) {
+      // some file systems (tmpfs for one) do not support O_DIRECT
+      LOG_DEBUG("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
+      direct_io_ = false;
+      fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+  }
+  if (fd_ < 0) {
+    LOG_DEBUG("io_uring is not available, falling back to the disk manager");
+    workers_.emplace_back(&DiskScheduler::StartWorkerThread, this);
+    return;
+  }
+
+  ring_ = std::move(ring);
+  queue_depth_ = std::clamp<size_t>(queue_depth_, 2, ring_->GetEntries());
+  workers_.emplace_back(&DiskScheduler::StartSubmitterThread, this);
+  workers_.emplace_back(&DiskScheduler::StartCompletionThread, this);
+}
+
+DiskScheduler::~DiskScheduler() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    shutdown_ = true;
+  }
+  request_ready_.notify_all();
+  for (auto &worker : workers_) worker.join();
+  if (fd_ >= 0) close(fd_);
+}
+
+void DiskScheduler::Schedule(DiskRequest r) {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    request_queue_.push_back(std::move(r));
+  }
+  request_ready_.notify_one();
+}
+
+void DiskScheduler::Schedule(std::vector<DiskRequest> requests) {
+  if (requests.empty()) return;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto &request : requests) request_queue_.push_back(std::move(request));
+  }
+  request_ready_.notify_all();
+}
+
+void DiskScheduler::ScheduleAndWait(std::vector<DiskRequest> requests) {
+  std::mutex done_latch;
+  std::condition_variable done;
+  size_t pending = requests.size();
+  for (auto &request : requests) {
+    request.callback_ = [&, callback = std::move(request.callback_)] {
+      if (callback) callback();
+      std::scoped_lock<std::mutex> done_lock(done_latch);
+      if (--pending == 0) done.notify_one();
+    };
+  }
+  Schedule(std::move(requests));
+
+  std::unique_lock<std::mutex> done_lock(done_latch);
+  done.wait(done_lock, [&pending] { return pending == 0; });
+}
+
+void DiskScheduler::StartWorkerThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    request_ready_.wait(lock, [this] { return shutdown_ || !request_queue_.empty(); });
+    // a worker leaves only once the queue is empty; whoever runs a callback that schedules more comes back for it
+    if (request_queue_.empty()) return;
+    // a linked pair is taken by one worker, which executes it in order
+    std::vector<DiskRequest> requests;
+    for (size_t i = FrontRequests(); i > 0; i--) {
+      requests.push_back(std::move(request_queue_.front()));
+      request_queue_.pop_front();
+    }
+    lock.unlock();
+    for (const auto &request : requests) ExecuteRequest(request);
+    lock.lock();
+  }
+}
+
+void DiskScheduler::ExecuteRequest(const DiskRequest &request) {
+  // a flushed page may still be changing, the checksums must be the ones of the very bytes written
+  std::vector<char> sealed(request.is_write_ && checksums_ != nullptr ? request.NumPages() * BUSTUB_PAGE_SIZE : 0);
+  if (!sealed.empty()) {
+    for (size_t i = 0; i < request.NumPages(); i++) {
+      memcpy(sealed.data() + i * BUSTUB_PAGE_SIZE, i == 0 ? request.data_ : request.next_data_[i - 1],
+             BUSTUB_PAGE_SIZE);
+    }
+    checksums_->Seal(request.page_id_, sealed.data(), request.NumPages());
+  }
+  // the disk manager has no vectored I/O, a run of pages is transferred one page at a time
+  for (size_t i = 0; i < request.NumPages(); i++) {
+    char *data = i == 0 ? request.data_ : request.next_data_[i - 1];
+    auto page_id = static_cast<page_id_t>(request.page_id_ + static_cast<page_id_t>(i));
+    if (request.is_write_) {
+      if (!sealed.empty()) data = sealed.data() + i * BUSTUB_PAGE_SIZE;
+      disk_manager_->WritePage(page_id, data);
+    } else {
+      disk_manager_->ReadPage(page_id, data);
+    }
+  }
+  VerifyRequest(request);
+  if (request.failed_ != nullptr) *request.failed_ = false;
+  if (request.callback_) request.callback_();
+}
+
+auto DiskScheduler::FrontRequests() const -> size_t {
+  return request_queue_.front().link_next_ && request_queue_.size() > 1 ? 2 : 1;
+}
+
+void DiskScheduler::StartSubmitterThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    // requests still in flight may schedule more from their callbacks, so shutting down waits for them too
+    request_ready_.wait(lock, [this] {
+      return (!request_queue_.empty() && in_flight_ + FrontRequests() <= queue_depth_) ||
+             (shutdown_ && request_queue_.empty() && in_flight_ == 0);
+    });
+    if (request_queue_.empty()) break;
+
+    std::vector<InFlightRequest *> prepared;
+    while (!request_queue_.empty() && in_flight_ + FrontRequests() <= queue_depth_) {
+      size_t count = FrontRequests();
+      for (size_t i = 0; i < count; i++) {
+        auto *in_flight = new InFlightRequest{std::move(request_queue_.front()), nullptr};
+        request_queue_.pop_front();
+        PrepareRequest(in_flight, i + 1 < count);
+        in_flight_++;
+        prepared.push_back(in_flight);
+      }
+    }
+    lock.unlock();
+    // one system call for the whole batch
+    if (ring_->Submit()) {
+      lock.lock();
+      continue;
+    }
+
+    // the requests the kernel did not take are executed here, after every request in flight has completed since one
+    // of them may be linked to the first request taken back
+    size_t retracted = ring_->Retract();
+    LOG_DEBUG("io_uring submission failed, executing %zu requests synchronously", retracted);
+    lock.lock();
+    request_ready_.wait(lock, [this, retracted] { return in_flight_ == retracted; });
+    lock.unlock();
+    for (size_t i = prepared.size() - retracted; i < prepared.size(); i++) {
+      CompleteRequest(prepared[i], TransferSync(prepared[i]));
+    }
+    lock.lock();
+  }
+  lock.unlock();
+
+  ring_->Prepare(IORING_OP_NOP, -1, nullptr, 0, 0, SHUTDOWN_USER_DATA);
+  ring_->Submit();
+}
+
+void DiskScheduler::PrepareRequest(InFlightRequest *in_flight, bool link_next) {
+  DiskRequest &request = in_flight->request_;
+  size_t num_pages = request.NumPages();
+  auto offset = static_cast<uint64_t>(request.page_id_) * BUSTUB_PAGE_SIZE;
+  auto user_data = reinterpret_cast<uint64_t>(in_flight);
+  uint8_t flags = link_next ? IOSQE_IO_LINK : 0;
+
+  bool aligned = !direct_io_ || reinterpret_cast<uintptr_t>(request.data_) % DIRECT_IO_ALIGNMENT == 0;
+  for (size_t i = 0; aligned && i < request.next_data_.size(); i++) {
+    aligned = reinterpret_cast<uintptr_t>(request.next_data_[i]) % DIRECT_IO_ALIGNMENT == 0;
+  }
+  // a flushed page may still be changing, a checksummed write goes out of a copy whose checksum is the one of the
+  // very bytes written
+  bool sealed = request.is_write_ && checksums_ != nullptr;
+  if (!aligned || sealed) {
+    // one contiguous bounce buffer turns a vectored request into a plain one
+    in_flight->bounce_buffer_ =
+        static_cast<char *>(std::aligned_alloc(DIRECT_IO_ALIGNMENT, num_pages * BUSTUB_PAGE_SIZE));
+    if (request.is_write_) {
+      memcpy(in_flight->bounce_buffer_, request.data_, BUSTUB_PAGE_SIZE);
+      for (size_t i = 0; i < request.next_data_.size(); i++) {
+        memcpy(in_flight->bounce_buffer_ + (i + 1) * BUSTUB_PAGE_SIZE, request.next_data_[i], BUSTUB_PAGE_SIZE);
+      }
+    }
+    if (sealed) checksums_->Seal(request.page_id_, in_flight->bounce_buffer_, num_pages);
+  }
+
+  if (num_pages == 1 || in_flight->bounce_buffer_ != nullptr) {
+    char *buffer = in_flight->bounce_buffer_ != nullptr ? in_flight->bounce_buffer_ : request.data_;
+    ring_->Prepare(request.is_write_ ? IORING_OP_WRITE : IORING_OP_READ, fd_, buffer,
+                   static_cast<uint32_t>(num_pages * BUSTUB_PAGE_SIZE), offset, user_data, flags);
+    return;
+  }
+  in_flight->iovecs_.reserve(num_pages);
+  for (size_t i = 0; i < num_pages; i++) in_flight->iovecs_.push_back({PageBuffer(*in_flight, i), BUSTUB_PAGE_SIZE});
+  ring_->Prepare(request.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV, fd_, in_flight->iovecs_.data(),
+                 static_cast<uint32_t>(num_pages), offset, user_data, flags);
+}
+
+auto DiskScheduler::TransferSync(InFlightRequest *in_flight) -> int32_t {
+  const DiskRequest &request = in_flight->request_;
+  auto offset = static_cast<off_t>(request.page_id_) * BUSTUB_PAGE_SIZE;
+  ssize_t count;
+  if (in_flight->iovecs_.empty()) {
+    char *buffer = PageBuffer(*in_flight, 0);
+    size_t length = request.NumPages() * BUSTUB_PAGE_SIZE;
+    count = request.is_write_ ? pwrite(fd_, buffer, length, offset) : pread(fd_, buffer, length, offset);
+  } else {
+    const iovec *iovecs = in_flight->iovecs_.data();
+    auto num_iovecs = static_cast<int>(in_flight->iovecs_.size());
+    count = request.is_write_ ? pwritev(fd_, iovecs, num_iovecs, offset) : preadv(fd_, iovecs, num_iovecs, offset);
+  }
+  return count < 0 ? -errno : static_cast<int32_t>(count);
+}
+
+void DiskScheduler::StartCompletionThread() {
+  bool shutdown = false;
+  while (!shutdown) {
+    ring_->WaitCompletions([this, &shutdown](uint64_t user_data, int32_t res) {
+      if (user_data == SHUTDOWN_USER_DATA) {
+        shutdown = true;
+        return;
+      }
+      CompleteRequest(reinterpret_cast<InFlightRequest *>(user_data), res);
+    });
+  }
+}
+
+void DiskScheduler::CompleteRequest(InFlightRequest *in_flight, int32_t res) {
+  // the request was handed over through the kernel's rings, so ThreadSanitizer cannot see the submitter's writes
+  // happen before these reads and reports a race here
+  DiskRequest &request = in_flight->request_;
+  // the request was linked to a write that failed or was short; that write completed first and was finished or
+  // given up on, so the request can go on
+  if (res == -ECANCELED) res = TransferSync(in_flight);
+  size_t total = request.NumPages() * BUSTUB_PAGE_SIZE;
+  auto done = static_cast<size_t>(res < 0 ? 0 : res);
+  auto offset = static_cast<off_t>(request.page_id_) * BUSTUB_PAGE_SIZE;
+
+  // short transfers are rare enough to be finished synchronously; a read only stops short at the end of the file
+  while (done > 0 && done < total) {
+    char *buffer = PageBuffer(*in_flight, done / BUSTUB_PAGE_SIZE) + done % BUSTUB_PAGE_SIZE;
+    size_t length = BUSTUB_PAGE_SIZE - done % BUSTUB_PAGE_SIZE;
+    ssize_t count = request.is_write_ ? pwrite(fd_, buffer, length, offset + static_cast<off_t>(done))
+                                      : pread(fd_, buffer, length, offset + static_cast<off_t>(done));
+    if (count <= 0) break;
+    done += static_cast<size_t>(count);
+  }
+
+  if (request.failed_ != nullptr) *request.failed_ = done < total && (request.is_write_ || res < 0);
+  if (request.is_write_) {
+    if (done < total) LOG_DEBUG("I/O error while writing page %d", request.page_id_);
+  } else {
+    // like the DiskManager, a read past the end of the file yields zeros
+    if (res < 0) LOG_DEBUG("I/O error while reading page %d", request.page_id_);
+    for (; done < total; done += BUSTUB_PAGE_SIZE - done % BUSTUB_PAGE_SIZE) {
+      memset(PageBuffer(*in_flight, done / BUSTUB_PAGE_SIZE) + done % BUSTUB_PAGE_SIZE, 0,
+             BUSTUB_PAGE_SIZE - done % BUSTUB_PAGE_SIZE);
+    }
+    if (in_flight->bounce_buffer_ != nullptr) {
+      memcpy(request.data_, in_flight->bounce_buffer_, BUSTUB_PAGE_SIZE);
+      for (size_t i = 0; i < request.next_data_.size(); i++) {
+        memcpy(request.next_data_[i], in_flight->bounce_buffer_ + (i + 1) * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+      }
+    }
+    VerifyRequest(request);
+  }
+
+  if (request.callback_) request.callback_();
+  std::free(in_flight->bounce_buffer_);
+  delete in_flight;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    in_flight_--;
+  }
+  request_ready_.notify_all();
+}
+
+void DiskScheduler::VerifyRequest(const DiskRequest &request) {
+  if (checksums_ == nullptr || request.is_write_) return;
+  checksums_->Verify(request.page_id_, request.data_);
+  for (size_t i = 0; i < request.next_data_.size(); i++) {
+    checksums_->Verify(static_cast<page_id_t>(request.page_id_ + static_cast<page_id_t>(i + 1)), request.next_data_[i]);
+  }
+}
+
+auto DiskScheduler::PageBuffer(const InFlightRequest &in_flight, size_t page_index) -> char * {
+  if (in_flight.bounce_buffer_ != nullptr) return in_flight.bounce_buffer_ + page_index * BUSTUB_PAGE_SIZE;
+  return page_index == 0 ? in_flight.request_.data_ : in_flight.request_.next_data_[page_index - 1];
+}
+
+}  // namespace bustub
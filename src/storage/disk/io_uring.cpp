@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// io_uring.cpp
+//
+// Identification: src/storage/disk/io_uring.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/io_uring.h"
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+auto RingAt(void *ring, uint32_t offset) -> uint32_t * {
+  return reinterpret_cast<uint32_t *>(static_cast<char *>(ring) + offset);
+}
+}  // namespace
+
+IoUring::IoUring(uint32_t entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (ring_fd < 0) return;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+    if (!single_mmap && cq_ring_ != MAP_FAILED) munmap(cq_ring_, cq_ring_size_);
+    if (sqes != MAP_FAILED) munmap(sqes, sqes_size_);
+    sq_ring_ = cq_ring_ = nullptr;
+    close(ring_fd);
+    return;
+  }
+
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+  sq_head_ = RingAt(sq_ring_, params.sq_off.head);
+  sq_tail_ = RingAt(sq_ring_, params.sq_off.tail);
+  sq_mask_ = RingAt(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingAt(sq_ring_, params.sq_off.array);
+  cq_head_ = RingAt(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingAt(cq_ring_, params.cq_off.tail);
+  cq_mask_ = RingAt(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(static_cast<char *>(cq_ring_) + params.cq_off.cqes);
+  sq_entries_ = params.sq_entries;
+  ring_fd_ = ring_fd;
+}
+
+IoUring::~IoUring() {
+  if (!IsValid()) return;
+  munmap(sqes_, sqes_size_);
+  if (cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  munmap(sq_ring_, sq_ring_size_);
+  close(ring_fd_);
+}
+
+auto IoUring::Prepare(uint8_t opcode, int fd, const void *addr, uint32_t len, uint64_t offset, uint64_t user_data,
+                      uint8_t flags) -> bool {
+  // only this thread moves the tail, the kernel moves the head as it consumes entries
+  uint32_t tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) return false;
+
+  uint32_t index = tail & *sq_mask_;
+  io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->flags = flags;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  to_submit_++;
+  return true;
+}
+
+auto IoUring::Submit() -> bool {
+  while (to_submit_ > 0) {
+    int submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit_, 0, 0, nullptr, 0));
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+      return false;
+    }
+    to_submit_ -= static_cast<uint32_t>(submitted);
+  }
+  return true;
+}
+
+auto IoUring::Retract() -> uint32_t {
+  // without SQPOLL the kernel reads the submission queue in io_uring_enter() only, so the tail can move back
+  uint32_t retracted = to_submit_;
+  __atomic_store_n(sq_tail_, *sq_tail_ - retracted, __ATOMIC_RELEASE);
+  to_submit_ = 0;
+  return retracted;
+}
+
+auto IoUring::WaitCompletions(const std::function<void(uint64_t user_data, int32_t res)> &on_completion) -> size_t {
+  // only this thread moves the head, the kernel moves the tail as it posts completions
+  uint32_t head = *cq_head_;
+  uint32_t tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  while (head == tail) {
+    if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+      // io_uring_enter() would not wait (EBUSY, EAGAIN): block until the ring has a completion instead of spinning
+      pollfd ring_poll{ring_fd_, POLLIN, 0};
+      poll(&ring_poll, 1, -1);
+    }
+    tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  }
+
+  size_t reaped = 0;
+  for (; head != tail; head++, reaped++) {
+    const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+    on_completion(cqe.user_data, cqe.res);
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  return reaped;
+}
+
+}  // namespace bustub
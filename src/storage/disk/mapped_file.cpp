@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// mapped_file.cpp
+//
+// Identification: src/storage/disk/mapped_file.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bustub {
+
+MappedFile::MappedFile(const std::string &path) {
+  fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd_ >= 0) RefreshFileSize(0);
+}
+
+MappedFile::~MappedFile() {
+  for (auto &segment : segments_) {
+    char *base = segment.load();
+    if (base != nullptr) munmap(base, SEGMENT_SIZE);
+  }
+  if (fd_ >= 0) close(fd_);
+}
+
+auto MappedFile::GetPage(page_id_t page_id) -> const char * {
+  if (fd_ < 0 || page_id < 0) return nullptr;
+  auto offset = static_cast<uint64_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t segment = offset / SEGMENT_SIZE;
+  if (segment >= MAX_SEGMENTS) return nullptr;
+  uint64_t end = offset + BUSTUB_PAGE_SIZE;
+  if (end > file_size_.load(std::memory_order_acquire) && !RefreshFileSize(end)) return nullptr;
+
+  char *base = segments_[segment].load(std::memory_order_acquire);
+  if (base == nullptr) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    base = segments_[segment].load(std::memory_order_relaxed);
+    if (base == nullptr) {
+      // the segment may reach past the end of the file, its pages there are never handed out
+      auto segment_offset = static_cast<off_t>(segment * SEGMENT_SIZE);
+      void *mapping = mmap(nullptr, SEGMENT_SIZE, PROT_READ, MAP_SHARED, fd_, segment_offset);
+      if (mapping == MAP_FAILED) return nullptr;
+      base = static_cast<char *>(mapping);
+      segments_[segment].store(base, std::memory_order_release);
+    }
+  }
+  return base + offset % SEGMENT_SIZE;
+}
+
+auto MappedFile::RefreshFileSize(uint64_t end) -> bool {
+  std::scoped_lock<std::mutex> lock(latch_);
+  struct stat file_stat {};
+  if (fstat(fd_, &file_stat) != 0) return false;
+  auto size = static_cast<uint64_t>(file_stat.st_size);
+  if (size > file_size_.load(std::memory_order_relaxed)) file_size_.store(size, std::memory_order_release);
+  return size >= end;
+}
+
+}  // namespace bustub
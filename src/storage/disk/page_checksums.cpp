@@ -0,0 +1,224 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksums.cpp
+//
+// Identification: src/storage/disk/page_checksums.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_checksums.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** Reflected Castagnoli polynomial. */
+constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+/** Table k holds the CRC of each byte followed by k zero bytes, so that 8 bytes are folded at once. */
+auto MakeCrcTables() -> CrcTables {
+  CrcTables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLYNOMIAL : 0);
+    tables[0][i] = crc;
+  }
+  for (size_t k = 1; k < tables.size(); k++) {
+    for (size_t i = 0; i < 256; i++) tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+  }
+  return tables;
+}
+
+auto Crc32cSoftware(uint32_t crc, const uint8_t *data, size_t size) -> uint32_t {
+  static const CrcTables TABLES = MakeCrcTables();
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    word ^= crc;  // little-endian: the low byte of the word is the first byte of the data
+    crc = TABLES[7][word & 0xff] ^ TABLES[6][(word >> 8) & 0xff] ^ TABLES[5][(word >> 16) & 0xff] ^
+          TABLES[4][(word >> 24) & 0xff] ^ TABLES[3][(word >> 32) & 0xff] ^ TABLES[2][(word >> 40) & 0xff] ^
+          TABLES[1][(word >> 48) & 0xff] ^ TABLES[0][word >> 56];
+  }
+  for (; size > 0; data++, size--) crc = TABLES[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) auto Crc32cHardware(uint32_t crc, const uint8_t *data, size_t size) -> uint32_t {
+  uint64_t crc64 = crc;
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; data++, size--) crc = _mm_crc32_u8(crc, *data);
+  return crc;
+}
+
+auto HasHardwareCrc32c() -> bool { return __builtin_cpu_supports("sse4.2"); }
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+auto Crc32cHardware(uint32_t crc, const uint8_t *data, size_t size) -> uint32_t {
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    crc = __crc32cd(crc, word);
+  }
+  for (; size > 0; data++, size--) crc = __crc32cb(crc, *data);
+  return crc;
+}
+
+auto HasHardwareCrc32c() -> bool { return true; }
+#else
+auto Crc32cHardware(uint32_t crc, const uint8_t *data, size_t size) -> uint32_t {
+  return Crc32cSoftware(crc, data, size);
+}
+
+auto HasHardwareCrc32c() -> bool { return false; }
+#endif
+
+}  // namespace
+
+auto PageChecksums::Crc32c(const char *data, size_t size) -> uint32_t {
+  static const bool HARDWARE = HasHardwareCrc32c();
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data);
+  uint32_t crc = HARDWARE ? Crc32cHardware(~0U, bytes, size) : Crc32cSoftware(~0U, bytes, size);
+  return ~crc;
+}
+
+auto PageChecksums::UsesHardwareCrc32c() -> bool { return HasHardwareCrc32c(); }
+
+PageChecksums::PageChecksums(const std::string &path, uint32_t num_instances) : num_instances_(num_instances) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) return;
+  struct stat file_stat {};
+  if (fstat(fd, &file_stat) != 0) {
+    close(fd);
+    return;
+  }
+  auto file_size = static_cast<size_t>(file_stat.st_size);
+  uint32_t magic = MAGIC;
+  if (file_size == 0) {
+    const uint32_t header[HEADER_SIZE / sizeof(uint32_t)] = {MAGIC, 0};
+    if (pwrite(fd, header, HEADER_SIZE, 0) != static_cast<ssize_t>(HEADER_SIZE)) {
+      close(fd);
+      return;
+    }
+  } else if (file_size < HEADER_SIZE || pread(fd, &magic, sizeof(magic), 0) != sizeof(magic) || magic != MAGIC) {
+    LOG_DEBUG("%s is not a checksum file", path.c_str());
+    close(fd);
+    return;
+  }
+  if (file_size > HEADER_SIZE) {
+    slots_.resize((file_size - HEADER_SIZE) / sizeof(uint32_t));
+    size_t length = slots_.size() * sizeof(uint32_t);
+    if (pread(fd, slots_.data(), length, HEADER_SIZE) != static_cast<ssize_t>(length)) {
+      close(fd);
+      return;
+    }
+  }
+  fd_ = fd;
+}
+
+PageChecksums::~PageChecksums() {
+  if (fd_ >= 0) close(fd_);
+}
+
+void PageChecksums::Seal(page_id_t page_id, const char *data, size_t num_pages) {
+  if (num_pages == 0) return;
+  if (num_instances_ > 1 && num_pages > 1) {
+    // consecutive page ids belong to different instances, their slots are not consecutive
+    for (size_t i = 0; i < num_pages; i++) Seal(static_cast<page_id_t>(page_id + i), data + i * BUSTUB_PAGE_SIZE);
+    return;
+  }
+  std::vector<uint32_t> checksums(num_pages);
+  for (size_t i = 0; i < num_pages; i++) checksums[i] = Crc32c(data + i * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE);
+  const size_t first_slot = Slot(page_id);
+  GrowSlots(first_slot + num_pages);
+
+  if (corrupt_page_count_.load(std::memory_order_relaxed) > 0) {
+    std::scoped_lock<std::mutex> corrupt_lock(corrupt_latch_);
+    for (size_t i = 0; i < num_pages; i++) corrupt_pages_.erase(static_cast<page_id_t>(page_id + i));
+    corrupt_page_count_.store(corrupt_pages_.size(), std::memory_order_relaxed);
+  }
+
+  std::shared_lock<std::shared_mutex> slots_lock(slots_latch_);
+  // a run covers one or two stripes, whose latches are taken in address order
+  std::vector<std::mutex *> latches;
+  for (size_t slot = first_slot; slot < first_slot + num_pages; slot += STRIPE_SLOTS) {
+    latches.push_back(&StripeLatch(slot));
+  }
+  latches.push_back(&StripeLatch(first_slot + num_pages - 1));
+  std::sort(latches.begin(), latches.end());
+  latches.erase(std::unique(latches.begin(), latches.end()), latches.end());
+  std::vector<std::unique_lock<std::mutex>> stripe_locks;
+  stripe_locks.reserve(latches.size());
+  for (std::mutex *latch : latches) stripe_locks.emplace_back(*latch);
+
+  if (std::equal(checksums.begin(), checksums.end(), slots_.begin() + first_slot)) return;
+  std::copy(checksums.begin(), checksums.end(), slots_.begin() + first_slot);
+  auto offset = static_cast<off_t>(HEADER_SIZE + first_slot * sizeof(uint32_t));
+  auto length = static_cast<ssize_t>(num_pages * sizeof(uint32_t));
+  if (pwrite(fd_, checksums.data(), length, offset) != length) {
+    LOG_DEBUG("cannot write the checksums of pages %d to %d", page_id, static_cast<page_id_t>(page_id + num_pages - 1));
+  }
+}
+
+auto PageChecksums::Verify(page_id_t page_id, const char *data) -> bool {
+  uint32_t checksum = Crc32c(data, BUSTUB_PAGE_SIZE);
+  size_t slot = Slot(page_id);
+  uint32_t recorded;
+  {
+    std::shared_lock<std::shared_mutex> slots_lock(slots_latch_);
+    if (slot >= slots_.size()) return true;
+    std::scoped_lock<std::mutex> stripe_lock(StripeLatch(slot));
+    recorded = slots_[slot];
+  }
+  if (recorded == 0 || recorded == checksum) return true;
+  failures_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::scoped_lock<std::mutex> corrupt_lock(corrupt_latch_);
+    corrupt_pages_.insert(page_id);
+    corrupt_page_count_.store(corrupt_pages_.size(), std::memory_order_relaxed);
+  }
+  LOG_WARN("page %d does not match its checksum: %08x on disk, %08x recorded", page_id, checksum, recorded);
+  return false;
+}
+
+void PageChecksums::GrowSlots(size_t num_slots) {
+  {
+    std::shared_lock<std::shared_mutex> slots_lock(slots_latch_);
+    if (slots_.size() >= num_slots) return;
+  }
+  std::unique_lock<std::shared_mutex> slots_lock(slots_latch_);
+  if (slots_.size() < num_slots) slots_.resize(std::max(num_slots, 2 * slots_.size()), 0);
+}
+
+auto PageChecksums::GetCorruptPages() -> std::vector<page_id_t> {
+  std::scoped_lock<std::mutex> corrupt_lock(corrupt_latch_);
+  return {corrupt_pages_.begin(), corrupt_pages_.end()};
+}
+
+}  // namespace bustub
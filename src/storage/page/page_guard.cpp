@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/storage/page/page_guard.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include "buffer/buffer_pool_manager_instance.h"
+
+namespace bustub {
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_),
+      page_(that.page_),
+      frame_id_(that.frame_id_),
+      mapped_data_(that.mapped_data_),
+      is_dirty_(that.is_dirty_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.frame_id_ = -1;
+  that.mapped_data_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
+  if (this == &that) return *this;
+  Drop();
+  bpm_ = that.bpm_;
+  page_ = that.page_;
+  frame_id_ = that.frame_id_;
+  mapped_data_ = that.mapped_data_;
+  is_dirty_ = that.is_dirty_;
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.frame_id_ = -1;
+  that.mapped_data_ = nullptr;
+  that.is_dirty_ = false;
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ == nullptr) return;
+  bpm_->UnpinFrame(frame_id_, is_dirty_);
+  bpm_ = nullptr;
+  page_ = nullptr;
+  frame_id_ = -1;
+  mapped_data_ = nullptr;
+  is_dirty_ = false;
+}
+
+auto BasicPageGuard::UpgradeRead() -> ReadPageGuard {
+  if (page_ != nullptr) page_->RLatch();
+  return ReadPageGuard(std::move(*this));
+}
+
+auto BasicPageGuard::UpgradeWrite() -> WritePageGuard {
+  if (page_ != nullptr) page_->WLatch();
+  return WritePageGuard(std::move(*this));
+}
+
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this == &that) return *this;
+  Drop();
+  guard_ = std::move(that.guard_);
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (!guard_.IsValid()) return;
+  // the latch goes first: once unpinned, the frame may be given to another page
+  guard_.page_->RUnlatch();
+  guard_.Drop();
+}
+
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this == &that) return *this;
+  Drop();
+  guard_ = std::move(that.guard_);
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (!guard_.IsValid()) return;
+  guard_.is_dirty_ = true;
+  guard_.page_->WUnlatch();
+  guard_.Drop();
+}
+
+}  // namespace bustub
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// access_tracer_test.cpp
+//
+// Identification: test/buffer/access_tracer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/access_tracer.h"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+const char *trace_file = "access_tracer_test.trace";
+
+/** @return the index of the first record of op after from, records.size() if there is none */
+auto FindOp(const std::vector<TraceRecord> &records, TraceOp op, size_t from = 0) -> size_t {
+  for (size_t i = from; i < records.size(); i++) {
+    if (records[i].op_ == op) return i;
+  }
+  return records.size();
+}
+}  // namespace
+
+TEST(AccessTracerTest, RecordsOfEveryThread) {
+  remove(trace_file);
+  const int num_threads = 4;
+  const int num_records = 3 * static_cast<int>(AccessTracer::BUFFER_RECORDS) + 10;
+  {
+    AccessTracer tracer(trace_file);
+    ASSERT_TRUE(tracer.IsValid());
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+      threads.emplace_back([&tracer, thread, num_records] {
+        for (int i = 0; i < num_records; i++) tracer.Record(TraceOp::FETCH, thread * num_records + i);
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    ASSERT_EQ(num_threads * num_records, tracer.GetRecordCount());
+  }
+
+  std::vector<TraceRecord> records;
+  ASSERT_TRUE(AccessTracer::ReadTrace(trace_file, &records));
+  ASSERT_EQ(num_threads * num_records, records.size());
+  ASSERT_TRUE(std::is_sorted(records.begin(), records.end(), [](const TraceRecord &a, const TraceRecord &b) {
+    return a.timestamp_ns_ < b.timestamp_ns_;
+  }));
+  // each thread's records come in the order it made them
+  std::map<uint16_t, page_id_t> last_page_ids;
+  for (const TraceRecord &record : records) {
+    auto last = last_page_ids.find(record.thread_);
+    if (last != last_page_ids.end()) {
+      ASSERT_EQ(last->second + 1, record.page_id_);
+    }
+    last_page_ids[record.thread_] = record.page_id_;
+  }
+  ASSERT_EQ(num_threads, last_page_ids.size());
+  remove(trace_file);
+}
+
+TEST(AccessTracerTest, PoolTracesWhatShapesEviction) {
+  remove(trace_file);
+  DiskManagerMemory disk_manager(1000);
+  {
+    BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+    ASSERT_TRUE(bpm.EnableTracing(trace_file));
+    page_id_t page_id;
+    for (int i = 0; i < 4; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.FlushAllPages();
+
+    ASSERT_NE(nullptr, bpm.FetchPageWithPriority(0, PagePriority::STICKY));
+    bpm.UnpinPage(0, false);
+    bpm.PrefetchPages({10});
+    BufferAccessStrategy strategy(2);
+    for (page_id_t scanned = 20; scanned < 23; scanned++) {
+      ASSERT_NE(nullptr, bpm.FetchPageWithStrategy(scanned, &strategy));
+      bpm.UnpinPage(scanned, false);
+    }
+    bpm.ReleaseAccessStrategy(&strategy);
+  }
+
+  std::vector<TraceRecord> records;
+  ASSERT_TRUE(AccessTracer::ReadTrace(trace_file, &records));
+  size_t priority = FindOp(records, TraceOp::PRIORITY);
+  ASSERT_LT(priority, records.size());
+  ASSERT_EQ(0, records[priority].page_id_);
+  ASSERT_EQ(static_cast<uint8_t>(PagePriority::STICKY), records[priority].arg_);
+  size_t prefetch = FindOp(records, TraceOp::PREFETCH);
+  ASSERT_LT(prefetch, records.size());
+  ASSERT_EQ(10, records[prefetch].page_id_);
+
+  // the ring is numbered and sized before its first miss, the scan's fetches are not plain fetches
+  size_t ring = FindOp(records, TraceOp::RING);
+  ASSERT_LT(ring, records.size());
+  ASSERT_EQ(2, records[ring].page_id_);
+  size_t fetch = FindOp(records, TraceOp::FETCH_STRATEGY, ring);
+  ASSERT_LT(fetch, records.size());
+  ASSERT_EQ(20, records[fetch].page_id_);
+  ASSERT_EQ(records[ring].arg_, records[fetch].arg_);
+  for (const TraceRecord &record : records) {
+    if (record.op_ == TraceOp::FETCH) {
+      ASSERT_EQ(0, record.page_id_);
+    }
+  }
+  size_t release = FindOp(records, TraceOp::RELEASE_RING, fetch);
+  ASSERT_LT(release, records.size());
+  ASSERT_EQ(records[ring].arg_, records[release].arg_);
+  remove(trace_file);
+}
+
+}  // namespace bustub
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** Create num_pages pages, each holding its name; the last pool_size ones stay resident. */
+void FillPool(BufferPoolManagerInstance *bpm, int num_pages) {
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+}
+
+/** @return whether a fetch of page_id is a hit. A miss evicts another page, so check the hits first. */
+auto FetchIsHit(BufferPoolManagerInstance *bpm, page_id_t page_id) -> bool {
+  uint64_t misses = bpm->GetMetrics().misses_;
+  if (bpm->FetchPage(page_id) == nullptr) return false;
+  bpm->UnpinPage(page_id, false);
+  return bpm->GetMetrics().misses_ == misses;
+}
+}  // namespace
+
+TEST(BufferAccessStrategyTest, ScanStaysInItsRing) {
+  for (ReplacerPolicy policy :
+       {ReplacerPolicy::LRU_K, ReplacerPolicy::CLOCK, ReplacerPolicy::TWO_QUEUE, ReplacerPolicy::ARC}) {
+    SCOPED_TRACE(static_cast<int>(policy));
+    DiskManagerMemory disk_manager(100);
+    BufferPoolManagerInstance bpm(16, &disk_manager, 2, nullptr, policy);
+    FillPool(&bpm, 40);
+    // pages 28 to 39 are hot, the other resident pages are not
+    for (int round = 0; round < 2; round++) {
+      for (page_id_t page_id = 28; page_id < 40; page_id++) ASSERT_TRUE(FetchIsHit(&bpm, page_id));
+    }
+
+    // the ring takes four frames from the pool once, then the scan recycles them
+    BufferAccessStrategy strategy(4);
+    for (page_id_t page_id = 0; page_id < 24; page_id++) {
+      Page *page = bpm.FetchPageWithStrategy(page_id, &strategy);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+      bpm.UnpinPage(page_id, false);
+    }
+    bpm.ReleaseAccessStrategy(&strategy);
+    for (page_id_t page_id = 28; page_id < 40; page_id++) ASSERT_TRUE(FetchIsHit(&bpm, page_id)) << page_id;
+  }
+}
+
+TEST(BufferAccessStrategyTest, PlainFetchAdoptsARingPage) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  FillPool(&bpm, 20);
+  BufferAccessStrategy strategy(2);
+  for (page_id_t page_id = 0; page_id < 2; page_id++) {
+    ASSERT_NE(nullptr, bpm.FetchPageWithStrategy(page_id, &strategy));
+    bpm.UnpinPage(page_id, false);
+  }
+
+  // page 1 leaves the ring for the pool, which now tracks it like any page it fetched twice
+  ASSERT_TRUE(FetchIsHit(&bpm, 1));
+  ASSERT_TRUE(FetchIsHit(&bpm, 1));
+  for (page_id_t page_id = 2; page_id < 12; page_id++) {
+    ASSERT_NE(nullptr, bpm.FetchPageWithStrategy(page_id, &strategy));
+    bpm.UnpinPage(page_id, false);
+  }
+  bpm.ReleaseAccessStrategy(&strategy);
+  ASSERT_TRUE(FetchIsHit(&bpm, 1));
+}
+
+TEST(BufferAccessStrategyTest, PinnedRingFrameGoesToTheReplacer) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  FillPool(&bpm, 8);
+  BufferAccessStrategy strategy(2);
+  Page *pinned = bpm.FetchPageWithStrategy(0, &strategy);
+  ASSERT_NE(nullptr, pinned);
+  snprintf(pinned->GetData(), BUSTUB_PAGE_SIZE, "changed");
+  ASSERT_NE(nullptr, bpm.FetchPageWithStrategy(1, &strategy));
+  bpm.UnpinPage(1, false);
+
+  // the pinned frame leaves the ring with the release, its unpin makes it evictable like any other
+  bpm.ReleaseAccessStrategy(&strategy);
+  bpm.UnpinPage(0, true);
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  ASSERT_EQ(nullptr, bpm.NewPage(&page_id));
+  for (page_id_t new_page_id : page_ids) bpm.UnpinPage(new_page_id, false);
+
+  // it was written back when it was evicted
+  Page *page = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ("changed", std::string(page->GetData()));
+  bpm.UnpinPage(0, false);
+}
+
+}  // namespace bustub
@@ -0,0 +1,156 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_async_test.cpp
+//
+// Identification: test/buffer/buffer_pool_async_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/fetch_page_awaitable.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** Pages 0 to num_pages - 1, each holding its name, all evicted but the last pool_size ones. */
+void FillPool(BufferPoolManagerInstance *bpm, int num_pages) {
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+}
+}  // namespace
+
+TEST(BufferPoolAsyncTest, HitCompletesInPlace) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  FillPool(&bpm, 4);
+  bool pending = true;
+  bool called = false;
+  Page *page = bpm.FetchPageAsync(3, [&called](Page *) { called = true; }, &pending);
+  ASSERT_NE(nullptr, page);
+  ASSERT_FALSE(pending);
+  ASSERT_FALSE(called);
+  ASSERT_EQ("page 3", std::string(page->GetData()));
+  bpm.UnpinPage(3, false);
+}
+
+TEST(BufferPoolAsyncTest, MissCompletesThroughTheCallback) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  FillPool(&bpm, 8);
+
+  std::promise<Page *> loaded;
+  bool pending = false;
+  ASSERT_EQ(nullptr, bpm.FetchPageAsync(0, [&loaded](Page *page) { loaded.set_value(page); }, &pending));
+  ASSERT_TRUE(pending);
+  std::future<Page *> page = loaded.get_future();
+  ASSERT_EQ(std::future_status::ready, page.wait_for(std::chrono::seconds(5)));
+  Page *loaded_page = page.get();
+  ASSERT_EQ(0, loaded_page->GetPageId());
+  ASSERT_EQ("page 0", std::string(loaded_page->GetData()));
+  ASSERT_EQ(1, loaded_page->GetPinCount());
+  bpm.UnpinPage(0, false);
+
+  // a fetch of every frame pinned fails right away
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages = bpm.NewPages(4, &page_ids);
+  ASSERT_EQ(4, pages.size());
+  ASSERT_EQ(nullptr, bpm.FetchPageAsync(1, [](Page *) { FAIL(); }, &pending));
+  ASSERT_FALSE(pending);
+  for (page_id_t page_id : page_ids) bpm.UnpinPage(page_id, false);
+}
+
+#ifdef BUSTUB_HAS_COROUTINES
+
+namespace {
+/** A coroutine that starts at once and is not awaited. */
+struct DetachedTask {
+  struct promise_type {
+    auto get_return_object() -> DetachedTask { return {}; }
+    auto initial_suspend() -> std::suspend_never { return {}; }
+    auto final_suspend() noexcept -> std::suspend_never { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+/** Resumes the posted coroutines on the test thread. */
+class QueueExecutor : public CoroutineExecutor {
+ public:
+  void Post(std::coroutine_handle<> handle) override {
+    std::scoped_lock<std::mutex> lock(latch_);
+    handles_.push_back(handle);
+  }
+
+  /** @brief Resume the posted coroutines until done() holds, waiting for more to be posted. */
+  template <typename Done>
+  void RunUntil(Done done) {
+    while (!done()) {
+      std::vector<std::coroutine_handle<>> handles;
+      {
+        std::scoped_lock<std::mutex> lock(latch_);
+        handles.swap(handles_);
+      }
+      for (auto handle : handles) handle.resume();
+      if (handles.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+ private:
+  std::mutex latch_;
+  std::vector<std::coroutine_handle<>> handles_;
+};
+
+auto ReadPage(BufferPoolManagerInstance *bpm, page_id_t page_id, QueueExecutor *executor, std::string *data)
+    -> DetachedTask {
+  Page *page = co_await FetchPageAsync(bpm, page_id, executor);
+  if (page == nullptr) co_return;
+  *data = page->GetData();
+  bpm->UnpinPage(page_id, false);
+}
+}  // namespace
+
+TEST(BufferPoolAsyncTest, CoroutineResumesOnTheExecutor) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  FillPool(&bpm, 8);
+  QueueExecutor executor;
+
+  // a hit does not suspend
+  std::string hit;
+  ReadPage(&bpm, 7, &executor, &hit);
+  ASSERT_EQ("page 7", hit);
+
+  // misses suspend until their page is loaded, then run on the executor
+  std::vector<std::string> misses(3);
+  for (page_id_t page_id = 0; page_id < 3; page_id++) ReadPage(&bpm, page_id, &executor, &misses[page_id]);
+  // a read that completes before the coroutine suspends resumes it in place, without a post
+  executor.RunUntil([&misses] {
+    return std::all_of(misses.begin(), misses.end(), [](const std::string &data) { return !data.empty(); });
+  });
+  for (page_id_t page_id = 0; page_id < 3; page_id++) ASSERT_EQ("page " + std::to_string(page_id), misses[page_id]);
+  ASSERT_EQ(4, bpm.GetMetrics().unpinned_frames_);
+}
+
+#endif
+
+}  // namespace bustub
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_batch_test.cpp
+//
+// Identification: test/buffer/buffer_pool_batch_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(BufferPoolBatchTest, NewAndFetchPages) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages = bpm.NewPages(5, &page_ids);
+  ASSERT_EQ(5, pages.size());
+  for (size_t i = 0; i < pages.size(); i++) {
+    ASSERT_EQ(page_ids[i], pages[i]->GetPageId());
+    snprintf(pages[i]->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_ids[i]);
+  }
+
+  // all or nothing
+  std::vector<page_id_t> more_page_ids;
+  ASSERT_TRUE(bpm.NewPages(4, &more_page_ids).empty());
+  ASSERT_TRUE(more_page_ids.empty());
+  for (page_id_t page_id : page_ids) bpm.UnpinPage(page_id, true);
+  ASSERT_EQ(8, bpm.NewPages(8, &more_page_ids).size());
+  for (page_id_t page_id : more_page_ids) bpm.UnpinPage(page_id, false);
+
+  // the evicted pages come back, a page asked for twice is pinned twice
+  std::vector<page_id_t> wanted{page_ids[3], page_ids[0], page_ids[1], page_ids[0]};
+  pages = bpm.FetchPages(wanted);
+  ASSERT_EQ(wanted.size(), pages.size());
+  for (size_t i = 0; i < wanted.size(); i++) {
+    ASSERT_EQ("page " + std::to_string(wanted[i]), std::string(pages[i]->GetData()));
+  }
+  ASSERT_EQ(pages[1], pages[3]);
+  ASSERT_EQ(2, pages[1]->GetPinCount());
+  for (page_id_t page_id : wanted) bpm.UnpinPage(page_id, false);
+  ASSERT_EQ(8, bpm.GetMetrics().unpinned_frames_);
+}
+
+TEST(BufferPoolBatchTest, FailedFetchRecordsNoAccess) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 8; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, false);
+  }
+
+  // pages 4 to 7 are resident and were accessed once each; three frames are not enough for four misses
+  uint64_t misses = bpm.GetMetrics().misses_;
+  ASSERT_TRUE(bpm.FetchPages({4, 0, 1, 2, 3}).empty());
+  ASSERT_EQ(misses, bpm.GetMetrics().misses_);
+  ASSERT_EQ(4, bpm.GetMetrics().unpinned_frames_);
+
+  // page 4 is still the victim, its failed fetch did not count as a second access
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  bpm.UnpinPage(page_id, false);
+  for (page_id_t resident = 5; resident < 8; resident++) {
+    ASSERT_NE(nullptr, bpm.FetchPage(resident));
+    bpm.UnpinPage(resident, false);
+  }
+  ASSERT_EQ(misses, bpm.GetMetrics().misses_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_flush_test.cpp
+//
+// Identification: test/buffer/buffer_pool_flush_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/resource.h>
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/gated_disk_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(BufferPoolFlushTest, FlushAllDirtyPages) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 6; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm.UnpinPage(page_id, i % 2 == 0);
+  }
+  ASSERT_EQ(3 * BUSTUB_PAGE_SIZE, bpm.FlushAllDirtyPages());
+  // the dirty flags were cleared
+  ASSERT_EQ(0, bpm.FlushAllDirtyPages());
+
+  char data[BUSTUB_PAGE_SIZE];
+  for (page_id_t flushed : {0, 2, 4}) {
+    disk_manager.ReadPage(flushed, data);
+    ASSERT_EQ("page " + std::to_string(flushed), std::string(data));
+  }
+}
+
+TEST(BufferPoolFlushTest, FailedWriteStaysDirty) {
+  const char *db_file = "buffer_pool_flush_test.db";
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  auto *bpm = new BufferPoolManagerInstance(8, &disk_manager, 2);
+  if (!bpm->EnableIoUring(db_file, false)) {
+    delete bpm;
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, i != 1);
+  }
+
+  // the file may not grow past two pages, the write of page 0 goes through and the one of pages 2 and 3 fails
+  rlimit old_limit;
+  getrlimit(RLIMIT_FSIZE, &old_limit);
+  rlimit limit = old_limit;
+  limit.rlim_cur = 2 * BUSTUB_PAGE_SIZE;
+  auto old_handler = signal(SIGXFSZ, SIG_IGN);
+  setrlimit(RLIMIT_FSIZE, &limit);
+  size_t written = bpm->FlushAllDirtyPages();
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+  ASSERT_EQ(BUSTUB_PAGE_SIZE, written);
+
+  // the failed pages are still dirty and written by the next flush
+  ASSERT_EQ(2 * BUSTUB_PAGE_SIZE, bpm->FlushAllDirtyPages());
+  ASSERT_EQ(0, bpm->FlushAllDirtyPages());
+  delete bpm;
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+TEST(BufferPoolFlushTest, FlushDoesNotBlockThePool) {
+  GatedDiskManager disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  page_id_t flushed;
+  Page *page = bpm.NewPage(&flushed);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "flushed");
+  bpm.UnpinPage(flushed, true);
+
+  std::thread flusher([&bpm] { bpm.FlushAllDirtyPages(); });
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+  ASSERT_EQ(1, disk_manager.writes_started_);
+
+  // the write is stuck, yet the pool latch is free and the page being written can be pinned and read
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  bpm.UnpinPage(page_id, false);
+  page = bpm.FetchPage(flushed);
+  ASSERT_NE(nullptr, page);
+  ASSERT_EQ("flushed", std::string(page->GetData()));
+  // it is not evicted before it is written
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, false);
+  }
+  bpm.UnpinPage(flushed, false);
+
+  disk_manager.Open();
+  flusher.join();
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager.ReadPage(flushed, data);
+  ASSERT_EQ("flushed", std::string(data));
+  ASSERT_EQ(0, bpm.FlushAllDirtyPages());
+}
+
+}  // namespace bustub
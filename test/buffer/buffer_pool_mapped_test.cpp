@@ -0,0 +1,76 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_mapped_test.cpp
+//
+// Identification: test/buffer/buffer_pool_mapped_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+namespace {
+const char *db_file = "buffer_pool_mapped_test.db";
+}  // namespace
+
+TEST(BufferPoolMappedTest, ReadsThroughTheMapping) {
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  {
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    page_id_t page_id;
+    for (int i = 0; i < 8; i++) {
+      Page *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      bpm.UnpinPage(page_id, true);
+    }
+    bpm.FlushAllPages();
+    ASSERT_TRUE(bpm.EnableMappedReads(db_file));
+
+    // page 0 was evicted, its frame maps the file instead of holding a copy
+    ReadPageGuard guard = bpm.FetchPageMapped(0);
+    ASSERT_TRUE(guard.IsValid());
+    ASSERT_EQ("page 0", std::string(guard.GetData()));
+
+    // the guard points into the mapping, which must stay
+    ASSERT_FALSE(bpm.EnableMappedReads(db_file));
+    ASSERT_EQ("page 0", std::string(guard.GetData()));
+  }
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+TEST(BufferPoolMappedTest, MissingFileIsNotMapped) {
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  ASSERT_FALSE(bpm.EnableMappedReads("buffer_pool_mapped_test.missing"));
+
+  // without a mapping, mapped fetches are plain read fetches
+  page_id_t page_id;
+  Page *page = bpm.NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "new page");
+  bpm.UnpinPage(page_id, true);
+  {
+    ReadPageGuard guard = bpm.FetchPageMapped(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    ASSERT_EQ("new page", std::string(guard.GetData()));
+  }
+  ASSERT_TRUE(bpm.EnableMappedReads(db_file));
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+}  // namespace bustub
@@ -0,0 +1,70 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_prefetch_test.cpp
+//
+// Identification: test/buffer/buffer_pool_prefetch_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(BufferPoolPrefetchTest, PrefetchedPageIsLoaded) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 8; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm.UnpinPage(page_id, true);
+  }
+
+  // pages 0 to 3 were evicted, the fetches wait for the reads in flight at most
+  bpm.PrefetchPages({0, 1, 2, 3});
+  for (page_id_t prefetched = 0; prefetched < 4; prefetched++) {
+    Page *page = bpm.FetchPage(prefetched);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ("page " + std::to_string(prefetched), std::string(page->GetData()));
+    bpm.UnpinPage(prefetched, false);
+  }
+  ASSERT_EQ(4, bpm.GetMetrics().hits_);
+}
+
+TEST(BufferPoolPrefetchTest, PrefetchIsNoAccess) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 3; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, true);
+  }
+  // page 2 is accessed twice, page 0 was evicted
+  ASSERT_NE(nullptr, bpm.FetchPage(2));
+  bpm.UnpinPage(2, false);
+
+  // the prefetch evicts page 1; with the fetch, page 0 is accessed once and has the larger backward k-distance
+  bpm.PrefetchPages({0});
+  ASSERT_NE(nullptr, bpm.FetchPage(0));
+  bpm.UnpinPage(0, false);
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  bpm.UnpinPage(page_id, false);
+
+  uint64_t misses = bpm.GetMetrics().misses_;
+  ASSERT_NE(nullptr, bpm.FetchPage(2));
+  bpm.UnpinPage(2, false);
+  ASSERT_EQ(misses, bpm.GetMetrics().misses_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_priority_test.cpp
+//
+// Identification: test/buffer/buffer_pool_priority_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** Create num_pages pages in the given class and unpin them. */
+void NewPages(BufferPoolManagerInstance *bpm, int num_pages, PagePriority priority) {
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPageWithPriority(&page_id, priority));
+    bpm->UnpinPage(page_id, true);
+  }
+}
+
+/** Fetch the pages first_page_id to last_page_id twice, so that they are hotter than pages accessed once. */
+void Touch(BufferPoolManagerInstance *bpm, page_id_t first_page_id, page_id_t last_page_id) {
+  for (int round = 0; round < 2; round++) {
+    for (page_id_t page_id = first_page_id; page_id <= last_page_id; page_id++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+}
+
+/** @return whether a fetch of page_id is a hit. A miss evicts another page, so check the hits first. */
+auto FetchIsHit(BufferPoolManagerInstance *bpm, page_id_t page_id) -> bool {
+  uint64_t misses = bpm->GetMetrics().misses_;
+  if (bpm->FetchPage(page_id) == nullptr) return false;
+  bpm->UnpinPage(page_id, false);
+  return bpm->GetMetrics().misses_ == misses;
+}
+}  // namespace
+
+TEST(BufferPoolPriorityTest, EvictsScanThenNormalThenSticky) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  NewPages(&bpm, 1, PagePriority::STICKY);
+  NewPages(&bpm, 1, PagePriority::SCAN);
+  NewPages(&bpm, 2, PagePriority::NORMAL);
+  Touch(&bpm, 2, 3);
+
+  // page 4 takes the frame of the scan page, page 5 that of page 4; the sticky page is the coldest but stays
+  NewPages(&bpm, 2, PagePriority::NORMAL);
+  ASSERT_TRUE(FetchIsHit(&bpm, 0));
+  ASSERT_TRUE(FetchIsHit(&bpm, 2));
+  ASSERT_TRUE(FetchIsHit(&bpm, 3));
+  ASSERT_FALSE(FetchIsHit(&bpm, 1));
+}
+
+TEST(BufferPoolPriorityTest, StickyLimitDemotesToNormal) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  // a quarter of four frames: page 1 is taken as NORMAL
+  NewPages(&bpm, 2, PagePriority::STICKY);
+  NewPages(&bpm, 2, PagePriority::NORMAL);
+  Touch(&bpm, 2, 3);
+
+  NewPages(&bpm, 1, PagePriority::NORMAL);
+  ASSERT_TRUE(FetchIsHit(&bpm, 0));
+  ASSERT_TRUE(FetchIsHit(&bpm, 2));
+  ASSERT_TRUE(FetchIsHit(&bpm, 3));
+  ASSERT_FALSE(FetchIsHit(&bpm, 1));
+}
+
+TEST(BufferPoolPriorityTest, StickyLimitFollowsTheResize) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  // a quarter of eight frames
+  ASSERT_TRUE(bpm.Resize(8));
+  NewPages(&bpm, 2, PagePriority::STICKY);
+  NewPages(&bpm, 6, PagePriority::NORMAL);
+  Touch(&bpm, 2, 7);
+
+  NewPages(&bpm, 1, PagePriority::NORMAL);
+  ASSERT_TRUE(FetchIsHit(&bpm, 0));
+  ASSERT_TRUE(FetchIsHit(&bpm, 1));
+
+  // a limit that was set is kept
+  DiskManagerMemory limited_disk_manager(100);
+  BufferPoolManagerInstance limited_bpm(4, &limited_disk_manager, 2);
+  limited_bpm.SetStickyFrameLimit(0);
+  ASSERT_TRUE(limited_bpm.Resize(8));
+  NewPages(&limited_bpm, 1, PagePriority::STICKY);
+  NewPages(&limited_bpm, 7, PagePriority::NORMAL);
+  Touch(&limited_bpm, 1, 7);
+  NewPages(&limited_bpm, 1, PagePriority::NORMAL);
+  for (page_id_t page_id = 1; page_id < 8; page_id++) ASSERT_TRUE(FetchIsHit(&limited_bpm, page_id));
+  ASSERT_FALSE(FetchIsHit(&limited_bpm, 0));
+}
+
+}  // namespace bustub
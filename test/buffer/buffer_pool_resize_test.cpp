@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_resize_test.cpp
+//
+// Identification: test/buffer/buffer_pool_resize_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <future>  // NOLINT
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/gated_disk_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(BufferPoolResizeTest, GrowAndShrink) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(10, &disk_manager, 2);
+  ASSERT_FALSE(bpm.Resize(0));
+  ASSERT_FALSE(bpm.Resize(10 * (BufferPoolManagerInstance::MAX_FRAME_CHUNKS + 1)));
+
+  // whole chunks only
+  ASSERT_TRUE(bpm.Resize(25));
+  ASSERT_EQ(30, bpm.GetPoolSize());
+  page_id_t page_id;
+  for (int i = 0; i < 30; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  ASSERT_EQ(nullptr, bpm.NewPage(&page_id));
+  for (page_id_t unpinned = 0; unpinned < 30; unpinned++) bpm.UnpinPage(unpinned, true);
+
+  // the pinned page holds the shrink up, and another resize is refused meanwhile
+  ASSERT_NE(nullptr, bpm.FetchPage(25));
+  ASSERT_TRUE(bpm.Resize(10));
+  ASSERT_FALSE(bpm.CanResize(20));
+  ASSERT_FALSE(bpm.Resize(20));
+  ASSERT_EQ(30, bpm.GetPoolSize());
+  bpm.UnpinPage(25, false);
+  ASSERT_TRUE(WaitUntil([&bpm] { return bpm.GetPoolSize() == 10; }));
+  ASSERT_TRUE(bpm.CanResize(20));
+
+  // the pages of the released chunks were written out
+  for (page_id_t fetched = 0; fetched < 30; fetched++) {
+    Page *page = bpm.FetchPage(fetched);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ("page " + std::to_string(fetched), std::string(page->GetData()));
+    bpm.UnpinPage(fetched, false);
+  }
+}
+
+TEST(BufferPoolResizeTest, ShrinkWritesBackWithoutTheLatch) {
+  GatedDiskManager disk_manager(100);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  ASSERT_TRUE(bpm.Resize(8));
+  page_id_t page_id;
+  // the clean pages fill the first chunk, the dirty ones the second
+  for (int i = 0; i < 8; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, i >= 4);
+  }
+
+  ASSERT_TRUE(bpm.Resize(4));
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+
+  // a new page evicts a clean page of the first chunk while the shrink waits for its write-backs
+  auto new_page = std::async(std::launch::async, [&bpm] {
+    page_id_t new_page_id;
+    Page *page = bpm.NewPage(&new_page_id);
+    if (page != nullptr) bpm.UnpinPage(new_page_id, false);
+    return page != nullptr;
+  });
+  bool finished = new_page.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+  disk_manager.Open();
+  ASSERT_TRUE(finished);
+  ASSERT_TRUE(new_page.get());
+  ASSERT_TRUE(WaitUntil([&bpm] { return bpm.GetPoolSize() == 4; }));
+}
+
+TEST(BufferPoolResizeTest, ParallelResizeIsAllOrNothing) {
+  DiskManagerMemory disk_manager(1000);
+  ParallelBufferPoolManager bpm(2, 10, &disk_manager);
+  ASSERT_TRUE(bpm.Resize(40));
+  ASSERT_EQ(40, bpm.GetPoolSize());
+  page_id_t page_id;
+  for (int i = 0; i < 40; i++) ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+
+  // instance 1 owns the odd pages: its shrink finishes, the one of instance 0 is held up by its pinned pages
+  ASSERT_TRUE(bpm.Resize(20));
+  for (page_id_t unpinned = 1; unpinned < 40; unpinned += 2) bpm.UnpinPage(unpinned, false);
+  ASSERT_TRUE(WaitUntil([&bpm] { return bpm.GetPoolSize() == 30; }));
+
+  // instance 0 refuses, so instance 1 must not grow either
+  ASSERT_FALSE(bpm.Resize(60));
+  ASSERT_EQ(30, bpm.GetPoolSize());
+
+  for (page_id_t unpinned = 0; unpinned < 40; unpinned += 2) bpm.UnpinPage(unpinned, false);
+  ASSERT_TRUE(WaitUntil([&bpm] { return bpm.GetPoolSize() == 20; }));
+  ASSERT_TRUE(bpm.Resize(60));
+  ASSERT_EQ(60, bpm.GetPoolSize());
+}
+
+}  // namespace bustub
@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_replacer_test.cpp
+//
+// Identification: test/buffer/clock_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_replacer.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(ClockReplacerTest, SecondChance) {
+  ClockReplacer clock_replacer(7);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    clock_replacer.RecordAccess(frame_id);
+    clock_replacer.SetEvictable(frame_id, true);
+  }
+  ASSERT_EQ(4, clock_replacer.Size());
+
+  // every frame is referenced, the first turn clears the bits and the hand comes back to frame 0
+  frame_id_t frame_id;
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+
+  // frame 1 is referenced again and gets a second chance
+  clock_replacer.RecordAccess(1);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(2, frame_id);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(3, frame_id);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_FALSE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(0, clock_replacer.Size());
+}
+
+TEST(ClockReplacerTest, PinnedFramesLeaveTheCircle) {
+  const size_t num_frames = 1000;
+  ClockReplacer clock_replacer(num_frames);
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+    clock_replacer.RecordAccess(frame_id);
+  }
+  clock_replacer.SetEvictable(500, true);
+  clock_replacer.SetEvictable(7, true);
+  ASSERT_EQ(2, clock_replacer.Size());
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(500, frame_id);
+
+  // frame 7 is pinned and unpinned again: it joins right behind the hand, after frame 9 that was unpinned before
+  clock_replacer.SetEvictable(9, true);
+  clock_replacer.RecordAccess(7);
+  clock_replacer.SetEvictable(7, false);
+  clock_replacer.SetEvictable(7, true);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(9, frame_id);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(7, frame_id);
+  ASSERT_FALSE(clock_replacer.Evict(&frame_id));
+}
+
+TEST(ClockReplacerTest, PeekVictimsListsTheEvictionOrder) {
+  const size_t num_frames = 64;
+  ClockReplacer clock_replacer(num_frames);
+  std::mt19937 rng(7);
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+    clock_replacer.RecordAccess(frame_id);
+    if (rng() % 4 != 0) clock_replacer.SetEvictable(frame_id, true);
+  }
+  // clear the reference bits and set some of them again
+  frame_id_t frame_id;
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  for (int i = 0; i < 20; i++) clock_replacer.RecordAccess(static_cast<frame_id_t>(rng() % num_frames));
+
+  std::vector<frame_id_t> peeked(num_frames);
+  peeked.resize(clock_replacer.PeekVictims(peeked.data(), peeked.size()));
+  ASSERT_EQ(clock_replacer.Size(), peeked.size());
+  for (frame_id_t expected : peeked) {
+    ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+    ASSERT_EQ(expected, frame_id);
+  }
+  ASSERT_FALSE(clock_replacer.Evict(&frame_id));
+}
+
+TEST(ClockReplacerTest, Reinstate) {
+  ClockReplacer clock_replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 2; frame_id++) {
+    clock_replacer.RecordAccess(frame_id);
+    clock_replacer.SetEvictable(frame_id, true);
+  }
+  frame_id_t frame_id;
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+
+  // the frame comes back tracked and pinned, and referenced
+  clock_replacer.Reinstate(0, 100);
+  ASSERT_EQ(1, clock_replacer.Size());
+  clock_replacer.SetEvictable(0, true);
+  ASSERT_EQ(2, clock_replacer.Size());
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_TRUE(clock_replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+}
+
+TEST(ClockReplacerTest, Resize) {
+  ClockReplacer clock_replacer(8);
+  for (frame_id_t frame_id = 0; frame_id < 8; frame_id++) {
+    clock_replacer.RecordAccess(frame_id);
+    clock_replacer.SetEvictable(frame_id, true);
+  }
+  clock_replacer.Resize(4);
+  ASSERT_EQ(4, clock_replacer.Size());
+  clock_replacer.Resize(6);
+  clock_replacer.RecordAccess(5);
+  clock_replacer.SetEvictable(5, true);
+  ASSERT_EQ(5, clock_replacer.Size());
+
+  std::vector<bool> evicted(6, false);
+  frame_id_t frame_id;
+  while (clock_replacer.Evict(&frame_id)) {
+    ASSERT_LT(frame_id, 6);
+    ASSERT_FALSE(evicted[frame_id]);
+    evicted[frame_id] = true;
+  }
+  ASSERT_FALSE(evicted[4]);
+  ASSERT_TRUE(evicted[5]);
+}
+
+TEST(ClockReplacerTest, PrefetchIsNoAccess) {
+  ClockReplacer replacer(2);
+  replacer.RecordAccess(0);
+  replacer.SetEvictable(0, true);
+  // a prefetched frame has no second chance until it is accessed
+  replacer.RecordPrefetch(1);
+  replacer.SetEvictable(1, true);
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+}
+
+}  // namespace bustub
@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/compressed_page_cache.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** A page that compresses well: a short text, zeroes after it. */
+auto TextPage(int seed) -> std::vector<char> {
+  std::vector<char> page(BUSTUB_PAGE_SIZE, 0);
+  snprintf(page.data(), BUSTUB_PAGE_SIZE, "page %d", seed);
+  return page;
+}
+}  // namespace
+
+TEST(CompressedPageCacheTest, CodecRoundTrip) {
+  std::mt19937 gen(42);
+  std::vector<char> src(BUSTUB_PAGE_SIZE);
+  std::vector<char> compressed(2 * BUSTUB_PAGE_SIZE);
+  std::vector<char> restored(BUSTUB_PAGE_SIZE);
+  for (size_t size : {0, 1, 3, 4, 5, 17, 255, 300, 1000, BUSTUB_PAGE_SIZE}) {
+    // runs of repeated bytes, long enough for matches, between random literals
+    for (size_t i = 0; i < size; i++) src[i] = static_cast<char>(gen() % 4 == 0 ? gen() : 'a' + i / 64 % 3);
+    size_t compressed_size = CompressedPageCache::Compress(src.data(), size, compressed.data(), compressed.size());
+    ASSERT_LT(0, compressed_size) << "size " << size;
+    ASSERT_TRUE(CompressedPageCache::Decompress(compressed.data(), compressed_size, restored.data(), size));
+    ASSERT_EQ(0, memcmp(src.data(), restored.data(), size)) << "size " << size;
+    // the original size is part of the format
+    if (size > 0) {
+      ASSERT_FALSE(CompressedPageCache::Decompress(compressed.data(), compressed_size, restored.data(), size - 1));
+    }
+  }
+
+  // a page of one byte shrinks to a few bytes, random bytes do not fit in less than they take
+  std::vector<char> zeroes(BUSTUB_PAGE_SIZE, 0);
+  ASSERT_GT(32, CompressedPageCache::Compress(zeroes.data(), zeroes.size(), compressed.data(), compressed.size()));
+  for (char &byte : src) byte = static_cast<char>(gen());
+  ASSERT_EQ(0, CompressedPageCache::Compress(src.data(), src.size(), compressed.data(), BUSTUB_PAGE_SIZE / 2));
+
+  // a match reaching before the start of the output is malformed
+  const char bad[] = {0x10, 'x', 0x05, 0x00};
+  ASSERT_FALSE(CompressedPageCache::Decompress(bad, sizeof(bad), restored.data(), 5));
+}
+
+TEST(CompressedPageCacheTest, TakeRestoresThePage) {
+  CompressedPageCache cache(1 << 20);
+  cache.Insert(1, TextPage(1).data());
+  cache.Insert(2, TextPage(2).data());
+  cache.Insert(1, TextPage(10).data());  // replaces the first image
+  cache.CompressPending();
+  ASSERT_EQ(2, cache.GetPageCount());
+  ASSERT_GT(2 * BUSTUB_PAGE_SIZE / 4, cache.GetSize());
+
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  ASSERT_TRUE(cache.Take(1, page.data()));
+  ASSERT_EQ(TextPage(10), page);
+  ASSERT_FALSE(cache.Take(1, page.data()));
+  cache.Erase(2);
+  ASSERT_FALSE(cache.Take(2, page.data()));
+  ASSERT_EQ(0, cache.GetSize());
+
+  // a page that does not compress is not kept
+  std::mt19937 gen(7);
+  for (char &byte : page) byte = static_cast<char>(gen());
+  cache.Insert(3, page.data());
+  cache.CompressPending();
+  ASSERT_EQ(0, cache.GetPageCount());
+}
+
+TEST(CompressedPageCacheTest, CapacityCountsCompressedImages) {
+  // room for a few compressed pages, less than one raw page
+  CompressedPageCache cache(BUSTUB_PAGE_SIZE / 2);
+  for (int i = 0; i < 4; i++) cache.Insert(i, TextPage(i).data());
+  ASSERT_EQ(4, cache.GetPageCount());
+  cache.CompressPending();
+  ASSERT_EQ(4, cache.GetPageCount());
+  ASSERT_GE(BUSTUB_PAGE_SIZE / 2, cache.GetSize());
+
+  // the raw images waiting for compression are bounded, the oldest go
+  for (int i = 0; i < static_cast<int>(CompressedPageCache::MAX_PENDING_PAGES) + 8; i++) {
+    cache.Insert(100 + i, TextPage(i).data());
+  }
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  ASSERT_FALSE(cache.Take(100, page.data()));
+  ASSERT_TRUE(cache.Take(100 + static_cast<int>(CompressedPageCache::MAX_PENDING_PAGES) + 7, page.data()));
+  cache.CompressPending();
+  ASSERT_GE(BUSTUB_PAGE_SIZE / 2, cache.GetSize());
+}
+
+TEST(CompressedPageCacheTest, PrefetchCompressesTheEvictedPages) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  bpm.EnableCompressedCache(1 << 20);
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm.UnpinPage(page_id, true);
+  }
+  bpm.FlushAllPages();
+
+  // the prefetches evict the four clean pages into the cache
+  bpm.PrefetchPages({4, 5, 6, 7});
+  BufferPoolMetricsSnapshot metrics = bpm.GetMetrics();
+  ASSERT_EQ(4, metrics.compressed_pages_);
+  ASSERT_GT(BUSTUB_PAGE_SIZE, metrics.compressed_bytes_);
+  for (page_id_t prefetched = 4; prefetched < 8; prefetched++) {
+    ASSERT_NE(nullptr, bpm.FetchPage(prefetched));
+    bpm.UnpinPage(prefetched, false);
+  }
+
+  for (page_id_t cached = 0; cached < 4; cached++) {
+    Page *page = bpm.FetchPage(cached);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ("page " + std::to_string(cached), std::string(page->GetData()));
+    bpm.UnpinPage(cached, false);
+  }
+  ASSERT_EQ(4, bpm.GetMetrics().compressed_hits_);
+}
+
+}  // namespace bustub
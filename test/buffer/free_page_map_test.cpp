@@ -0,0 +1,240 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map_test.cpp
+//
+// Identification: test/buffer/free_page_map_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/free_page_map.h"
+#include "buffer/gated_disk_manager.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(FreePageMapTest, AllocateAndFree) {
+  FreePageMap free_page_map(1, 0);
+  // page 1 is the map page of the first group
+  ASSERT_EQ(0, free_page_map.Allocate());
+  ASSERT_EQ(2, free_page_map.Allocate());
+  ASSERT_EQ(3, free_page_map.Allocate());
+  ASSERT_TRUE(free_page_map.IsMapPage(1));
+  ASSERT_FALSE(free_page_map.Free(1));
+  ASSERT_FALSE(free_page_map.Free(4));
+
+  ASSERT_TRUE(free_page_map.Free(2));
+  ASSERT_FALSE(free_page_map.Free(2));
+  ASSERT_EQ(1, free_page_map.GetFreePageCount());
+  ASSERT_EQ(2, free_page_map.Allocate());
+  ASSERT_EQ(4, free_page_map.Allocate());
+
+  // the map pages of a second instance are its own
+  FreePageMap second_map(2, 1);
+  ASSERT_EQ(1, second_map.Allocate());
+  ASSERT_EQ(5, second_map.Allocate());
+  ASSERT_TRUE(second_map.IsMapPage(3));
+}
+
+TEST(FreePageMapTest, PoolReusesDeletedIds) {
+  DiskManagerMemory disk_manager(1000);
+  page_id_t page_id;
+  {
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    size_t free_pages = 1;
+    ASSERT_TRUE(bpm.EnableFreePageMap(&free_pages));
+    ASSERT_EQ(0, free_pages);
+    for (int i = 0; i < 10; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      bpm.UnpinPage(page_id, true);
+    }
+    ASSERT_EQ(10, page_id);
+
+    // the map page cannot be used as a page
+    ASSERT_EQ(nullptr, bpm.FetchPage(1));
+    ASSERT_FALSE(bpm.DeletePage(1));
+    ASSERT_EQ(nullptr, bpm.NewReservedPage(1));
+    ASSERT_TRUE(bpm.DeletePage(3));
+    ASSERT_TRUE(bpm.DeletePage(10));
+  }
+
+  // the destructor wrote the map out
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  size_t free_pages = 0;
+  ASSERT_TRUE(bpm.EnableFreePageMap(&free_pages));
+  ASSERT_EQ(2, free_pages);
+  for (page_id_t expected : {3, 10, 11}) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    ASSERT_EQ(expected, page_id);
+    bpm.UnpinPage(page_id, false);
+  }
+}
+
+TEST(FreePageMapTest, RunsSpanNoMapPage) {
+  const size_t group_span = FreePageMap::PAGES_PER_GROUP + 1;
+  // a run starts after the map page and moves to the next group rather than reach past the end of its own
+  ASSERT_EQ(2, FreePageMap::FitRun(0, 5));
+  ASSERT_EQ(2, FreePageMap::FitRun(1, 5));
+  ASSERT_EQ(7, FreePageMap::FitRun(7, 5));
+  ASSERT_EQ(group_span + 2, FreePageMap::FitRun(group_span - 3, 5));
+  ASSERT_EQ(group_span + 2, FreePageMap::FitRun(group_span, 5));
+  ASSERT_EQ(group_span - 5, FreePageMap::FitRun(group_span - 5, 5));
+
+  FreePageMap free_page_map(1, 0);
+  ASSERT_EQ(0, free_page_map.Allocate());
+  ASSERT_EQ(2, free_page_map.AllocateRun(4));
+  ASSERT_EQ(6, free_page_map.Allocate());
+  // a freed run is reused by a run that fits in it, a longer one goes to the end of the file
+  for (page_id_t page_id = 2; page_id < 6; page_id++) ASSERT_TRUE(free_page_map.Free(page_id));
+  ASSERT_EQ(7, free_page_map.AllocateRun(5));
+  ASSERT_EQ(2, free_page_map.AllocateRun(3));
+  ASSERT_EQ(5, free_page_map.Allocate());
+
+  // a run reserved past the end leaves the pages before it free
+  ASSERT_FALSE(free_page_map.ReserveRunAt(10, 2));
+  ASSERT_TRUE(free_page_map.ReserveRunAt(20, 5));
+  ASSERT_EQ(25, free_page_map.GetEndPageNo());
+  ASSERT_EQ(8, free_page_map.GetFreePageCount());
+  // and one reaching into the next group is refused
+  ASSERT_FALSE(free_page_map.ReserveRunAt(group_span - 3, 5));
+  ASSERT_TRUE(free_page_map.ReserveRunAt(group_span + 2, 3));
+  ASSERT_EQ(2, free_page_map.GetGroupCount());
+  ASSERT_TRUE(free_page_map.IsMapPage(static_cast<page_id_t>(group_span + 1)));
+  ASSERT_EQ(group_span + 5, free_page_map.GetEndPageNo());
+}
+
+TEST(FreePageMapTest, TracksPersistedPages) {
+  FreePageMap free_page_map(1, 0);
+  ASSERT_EQ(0, free_page_map.Allocate());
+  ASSERT_FALSE(free_page_map.IsPersisted(0));
+  // map pages, free pages and ids past the map need no map write
+  ASSERT_TRUE(free_page_map.IsPersisted(1));
+  ASSERT_TRUE(free_page_map.IsPersisted(1000000));
+
+  std::vector<page_id_t> map_page_ids;
+  std::vector<char> map_pages;
+  free_page_map.TakeDirtyGroups(&map_page_ids, &map_pages);
+  ASSERT_EQ(1, map_page_ids.size());
+  ASSERT_EQ(2, free_page_map.Allocate());
+  free_page_map.MarkPersisted(map_page_ids[0], map_pages.data());
+  ASSERT_TRUE(free_page_map.IsPersisted(0));
+  // allocated after the image was taken
+  ASSERT_FALSE(free_page_map.IsPersisted(2));
+  ASSERT_TRUE(free_page_map.Free(2));
+  ASSERT_TRUE(free_page_map.IsPersisted(2));
+}
+
+TEST(FreePageMapTest, MapIsWrittenBeforeThePages) {
+  GatedDiskManager disk_manager(1000);
+  // the map page is written at once
+  disk_manager.Hold(0);
+  BufferPoolManagerInstance bpm(1, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableFreePageMap());
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  bpm.UnpinPage(page_id, true);
+
+  // a new page leaves the map alone while the page only lives in the pool
+  char data[BUSTUB_PAGE_SIZE];
+  disk_manager.ReadPage(1, data);
+  FreePageMap on_disk(1, 0);
+  ASSERT_FALSE(on_disk.LoadGroup(data));
+
+  // the eviction of page 0 writes the map first
+  auto new_page = std::async(std::launch::async, [&bpm] {
+    page_id_t new_page_id;
+    if (bpm.NewPage(&new_page_id) == nullptr) return INVALID_PAGE_ID;
+    bpm.UnpinPage(new_page_id, true);
+    return new_page_id;
+  });
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+  disk_manager.ReadPage(1, data);
+  ASSERT_TRUE(on_disk.LoadGroup(data));
+  ASSERT_TRUE(on_disk.IsPersisted(0));
+  disk_manager.Open();
+  ASSERT_EQ(2, new_page.get());
+
+  // so does a flush
+  DiskManagerMemory flushed_disk_manager(1000);
+  BufferPoolManagerInstance flushed_bpm(4, &flushed_disk_manager, 2);
+  ASSERT_TRUE(flushed_bpm.EnableFreePageMap());
+  ASSERT_NE(nullptr, flushed_bpm.NewPage(&page_id));
+  flushed_bpm.UnpinPage(page_id, true);
+  ASSERT_TRUE(flushed_bpm.FlushPage(page_id));
+  flushed_disk_manager.ReadPage(1, data);
+  FreePageMap next_run(1, 0);
+  ASSERT_TRUE(next_run.LoadGroup(data));
+  ASSERT_TRUE(next_run.IsPersisted(page_id));
+  ASSERT_EQ(0, next_run.GetFreePageCount());
+}
+
+TEST(FreePageMapTest, DatabaseWithoutMapIsRefused) {
+  DiskManagerMemory disk_manager(1000);
+  page_id_t page_id;
+  {
+    BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+    for (int i = 0; i < 3; i++) {
+      Page *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      page->GetData()[0] = 'x';
+      bpm.UnpinPage(page_id, true);
+    }
+    // pages were allocated by the pool itself
+    ASSERT_FALSE(bpm.CanEnableFreePageMap());
+    ASSERT_FALSE(bpm.EnableFreePageMap());
+    bpm.FlushAllPages();
+  }
+
+  BufferPoolManagerInstance bpm(4, &disk_manager, 2);
+  ASSERT_FALSE(bpm.EnableFreePageMap());
+  ParallelBufferPoolManager parallel_bpm(2, 4, &disk_manager);
+  ASSERT_FALSE(parallel_bpm.EnableFreePageMap());
+  // no map was kept, new pages still go to the end of the file
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+}
+
+TEST(FreePageMapTest, DeleteDoesNotWaitForTheWriteBack) {
+  GatedDiskManager disk_manager(1000);
+  disk_manager.Hold(0);
+  BufferPoolManagerInstance bpm(1, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableFreePageMap());
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  bpm.UnpinPage(page_id, true);
+
+  // the next page evicts page 0, whose write-back is held
+  auto new_page = std::async(std::launch::async, [&bpm] {
+    page_id_t new_page_id;
+    if (bpm.NewPage(&new_page_id) == nullptr) return INVALID_PAGE_ID;
+    bpm.UnpinPage(new_page_id, false);
+    return new_page_id;
+  });
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+
+  auto deleted = std::async(std::launch::async, [&bpm] { return bpm.DeletePage(0); });
+  bool finished = deleted.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+  disk_manager.Open();
+  ASSERT_TRUE(finished);
+  ASSERT_TRUE(deleted.get());
+  ASSERT_EQ(2, new_page.get());
+
+  // the id is free once the write-back is done
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  bpm.UnpinPage(page_id, false);
+}
+
+}  // namespace bustub
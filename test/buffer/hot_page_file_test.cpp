@@ -0,0 +1,66 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hot_page_file_test.cpp
+//
+// Identification: test/buffer/hot_page_file_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "buffer/hot_page_file.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+const char *hot_file = "hot_page_file_test.hot";
+
+/** Write a hot page file of num_ids page ids, then overwrite the count its header gives with count. */
+void WriteRaw(uint32_t count, size_t num_ids) {
+  ASSERT_TRUE(HotPageFile::Write(hot_file, std::vector<page_id_t>(num_ids, 7)));
+  std::fstream file(hot_file, std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(sizeof(uint32_t));
+  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+}
+}  // namespace
+
+TEST(HotPageFileTest, RoundTrip) {
+  std::vector<page_id_t> written{5, 3, 8, 1};
+  ASSERT_TRUE(HotPageFile::Write(hot_file, written));
+  std::vector<page_id_t> read;
+  ASSERT_TRUE(HotPageFile::Read(hot_file, &read));
+  ASSERT_EQ(written, read);
+
+  ASSERT_TRUE(HotPageFile::Write(hot_file, {}));
+  ASSERT_TRUE(HotPageFile::Read(hot_file, &read));
+  ASSERT_TRUE(read.empty());
+  remove(hot_file);
+  ASSERT_FALSE(HotPageFile::Read(hot_file, &read));
+}
+
+TEST(HotPageFileTest, CountMustMatchTheFile) {
+  std::vector<page_id_t> read;
+  // a corrupt count is refused without allocating for it
+  WriteRaw(0xFFFFFFFF, 4);
+  ASSERT_FALSE(HotPageFile::Read(hot_file, &read));
+  ASSERT_TRUE(read.empty());
+  // truncated, or with trailing bytes
+  WriteRaw(4, 3);
+  ASSERT_FALSE(HotPageFile::Read(hot_file, &read));
+  WriteRaw(4, 5);
+  ASSERT_FALSE(HotPageFile::Read(hot_file, &read));
+  WriteRaw(4, 4);
+  ASSERT_TRUE(HotPageFile::Read(hot_file, &read));
+  ASSERT_EQ(std::vector<page_id_t>(4, 7), read);
+  remove(hot_file);
+}
+
+}  // namespace bustub
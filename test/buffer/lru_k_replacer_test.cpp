@@ -0,0 +1,453 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include <map>
+#include <random>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** The LRU-K policy as specified, a linear scan over every frame's full history. */
+class ReferenceLRUK {
+ public:
+  explicit ReferenceLRUK(size_t k) : k_(k) {}
+
+  void RecordAccess(frame_id_t frame_id) {
+    auto &history = history_[frame_id];
+    history.push_back(clock_++);
+    if (history.size() > k_) history.erase(history.begin());
+    evictable_.emplace(frame_id, false);
+  }
+
+  void SetEvictable(frame_id_t frame_id, bool evictable) {
+    if (history_.count(frame_id) > 0) evictable_[frame_id] = evictable;
+  }
+
+  void Remove(frame_id_t frame_id) {
+    history_.erase(frame_id);
+    evictable_.erase(frame_id);
+  }
+
+  auto Evict(frame_id_t *frame_id) -> bool {
+    frame_id_t victim = -1;
+    bool victim_inf = false;
+    size_t victim_timestamp = 0;
+    for (const auto &[candidate, history] : history_) {
+      if (!evictable_[candidate]) continue;
+      bool inf = history.size() < k_;
+      // with fewer than k accesses the oldest access decides, otherwise the kth most recent one, the oldest kept
+      size_t timestamp = history.front();
+      if (victim == -1 || (inf && !victim_inf) || (inf == victim_inf && timestamp < victim_timestamp)) {
+        victim = candidate;
+        victim_inf = inf;
+        victim_timestamp = timestamp;
+      }
+    }
+    if (victim == -1) return false;
+    *frame_id = victim;
+    Remove(victim);
+    return true;
+  }
+
+  auto Size() const -> size_t {
+    size_t size = 0;
+    for (const auto &[frame_id, evictable] : evictable_) size += evictable ? 1 : 0;
+    return size;
+  }
+
+  auto IsTracked(frame_id_t frame_id) const -> bool { return history_.count(frame_id) > 0; }
+
+ private:
+  size_t k_;
+  size_t clock_{0};
+  std::map<frame_id_t, std::vector<size_t>> history_;
+  std::map<frame_id_t, bool> evictable_;
+};
+
+}  // namespace
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_replacer(7, 2);
+
+  // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(6);
+  lru_replacer.SetEvictable(1, true);
+  lru_replacer.SetEvictable(2, true);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  lru_replacer.SetEvictable(5, true);
+  lru_replacer.SetEvictable(6, false);
+  ASSERT_EQ(5, lru_replacer.Size());
+
+  // Scenario: Insert access history for frame 1. Now frame 1 has two access histories.
+  // All other frames have max backward k-dist. The order of eviction is [2,3,4,5,1].
+  lru_replacer.RecordAccess(1);
+
+  // Scenario: Evict three pages from the replacer. Elements with max k-distance should be popped
+  // first based on LRU.
+  int value;
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(2, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(4, value);
+  ASSERT_EQ(2, lru_replacer.Size());
+
+  // Scenario: Now replacer has frames [5,1].
+  // Insert new frames 3, 4, and update access history for 5. We should end with [3,1,5,4]
+  lru_replacer.RecordAccess(3);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.SetEvictable(3, true);
+  lru_replacer.SetEvictable(4, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  // Scenario: continue looking for victims. We expect 3 to be evicted next.
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(3, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Set 6 to be evictable. 6 Should be evicted next since it has max backward k-dist.
+  lru_replacer.SetEvictable(6, true);
+  ASSERT_EQ(4, lru_replacer.Size());
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(6, value);
+  ASSERT_EQ(3, lru_replacer.Size());
+
+  // Now we have [1,5,4]. Continue looking for victims.
+  lru_replacer.SetEvictable(1, false);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_EQ(1, lru_replacer.Size());
+
+  // Update access history for 1. Now we have [4,1]. Next victim is 4.
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(1, true);
+  ASSERT_EQ(2, lru_replacer.Size());
+  ASSERT_EQ(true, lru_replacer.Evict(&value));
+  ASSERT_EQ(value, 4);
+
+  ASSERT_EQ(1, lru_replacer.Size());
+  lru_replacer.Evict(&value);
+  ASSERT_EQ(value, 1);
+  ASSERT_EQ(0, lru_replacer.Size());
+
+  // This operation should not modify size
+  ASSERT_EQ(false, lru_replacer.Evict(&value));
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, HeapMatchesReferenceModel) {
+  const frame_id_t num_frames = 50;
+  for (size_t k : {1, 2, 3, 5}) {
+    std::mt19937 rng(static_cast<unsigned>(k));
+    LRUKReplacer replacer(num_frames, k);
+    ReferenceLRUK reference(k);
+    for (int i = 0; i < 20000; i++) {
+      auto frame_id = static_cast<frame_id_t>(rng() % num_frames);
+      switch (rng() % 10) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+        case 4:
+          replacer.RecordAccess(frame_id);
+          reference.RecordAccess(frame_id);
+          break;
+        case 5:
+        case 6:
+        case 7: {
+          bool evictable = rng() % 2 == 0;
+          replacer.SetEvictable(frame_id, evictable);
+          reference.SetEvictable(frame_id, evictable);
+          break;
+        }
+        case 8:
+          if (reference.IsTracked(frame_id)) {
+            replacer.SetEvictable(frame_id, true);
+            reference.SetEvictable(frame_id, true);
+            replacer.Remove(frame_id);
+            reference.Remove(frame_id);
+          }
+          break;
+        default: {
+          frame_id_t victim = -1;
+          frame_id_t expected = -1;
+          bool evicted = replacer.Evict(&victim);
+          ASSERT_EQ(reference.Evict(&expected), evicted);
+          if (evicted) {
+            ASSERT_EQ(expected, victim);
+          }
+        }
+      }
+      ASSERT_EQ(reference.Size(), replacer.Size());
+    }
+  }
+}
+
+TEST(LRUKReplacerTest, PeekVictimsListsTheEvictionOrder) {
+  LRUKReplacer replacer(64, 2);
+  std::mt19937 rng(7);
+  for (int i = 0; i < 500; i++) replacer.RecordAccess(static_cast<frame_id_t>(rng() % 64));
+  for (frame_id_t frame_id = 0; frame_id < 64; frame_id++) replacer.SetEvictable(frame_id, rng() % 3 != 0);
+
+  std::vector<frame_id_t> peeked(64);
+  peeked.resize(replacer.PeekVictims(peeked.data(), peeked.size()));
+  ASSERT_EQ(replacer.Size(), peeked.size());
+  for (frame_id_t expected : peeked) {
+    frame_id_t victim = -1;
+    ASSERT_TRUE(replacer.Evict(&victim));
+    ASSERT_EQ(expected, victim);
+  }
+  frame_id_t victim = -1;
+  ASSERT_FALSE(replacer.Evict(&victim));
+}
+
+TEST(LRUKReplacerTest, ReinstateRestoresTheHistory) {
+  LRUKReplacer replacer(4, 2);
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(1);
+  replacer.SetEvictable(0, true);
+
+  frame_id_t victim = -1;
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(0, victim);
+  ASSERT_EQ(0, replacer.GetColdEvictionCount());
+
+  // with its k accesses back, frame 0 goes after frame 3 that has only one; a fresh access would put it first
+  replacer.Reinstate(0, 100);
+  ASSERT_EQ(0, replacer.Size());
+  replacer.RecordAccess(3);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(3, true);
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(3, victim);
+  ASSERT_EQ(1, replacer.GetColdEvictionCount());
+
+  // after an access in the meantime the frame starts over from that access
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(0, victim);
+  replacer.RecordAccess(0);
+  replacer.Reinstate(0, 100);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(1, true);
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(1, victim);
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(0, victim);
+}
+
+TEST(LRUKReplacerTest, ReinstateIsNoGhostHitWithAdaptiveK) {
+  const size_t num_frames = 8;
+  LRUKReplacer replacer(num_frames, 2);
+  ASSERT_TRUE(replacer.SetAdaptiveK(1, 3));
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+    replacer.SetFramePage(frame_id, 100 + frame_id);
+    for (int i = 0; i < 3; i++) replacer.RecordAccess(frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+
+  // every victim is pinned again in time; had these been ghost hits of pages with more than k accesses, k would
+  // grow at the end of the window
+  frame_id_t victim = -1;
+  for (int i = 0; i < 256; i++) {
+    ASSERT_TRUE(replacer.Evict(&victim));
+    replacer.Reinstate(victim, 100 + victim);
+    replacer.SetEvictable(victim, true);
+  }
+  // a window of evictions of pages that never come back
+  page_id_t next_page_id = 1000;
+  for (int i = 0; i < 256; i++) {
+    ASSERT_TRUE(replacer.Evict(&victim));
+    replacer.SetFramePage(victim, next_page_id++);
+    replacer.RecordAccess(victim);
+    replacer.SetEvictable(victim, true);
+  }
+  ASSERT_EQ(2, replacer.GetK());
+}
+
+TEST(LRUKReplacerTest, BufferedAccessesKeepTheOrderOfOneThread) {
+  LRUKReplacer buffered(32, 2, true);
+  LRUKReplacer direct(32, 2);
+  std::mt19937 rng(3);
+  for (int i = 0; i < 5000; i++) {
+    auto frame_id = static_cast<frame_id_t>(rng() % 32);
+    if (rng() % 4 != 0) {
+      buffered.RecordAccess(frame_id);
+      direct.RecordAccess(frame_id);
+      buffered.SetEvictable(frame_id, true);
+      direct.SetEvictable(frame_id, true);
+      continue;
+    }
+    frame_id_t buffered_victim = -1;
+    frame_id_t direct_victim = -1;
+    ASSERT_EQ(direct.Evict(&direct_victim), buffered.Evict(&buffered_victim));
+    ASSERT_EQ(direct_victim, buffered_victim);
+  }
+}
+
+TEST(LRUKReplacerTest, BufferedAccessOfARemovedFrameIsDropped) {
+  LRUKReplacer replacer(8, 2, true);
+  // the first access of a frame is still buffered when the frame is removed
+  replacer.RecordAccess(3);
+  replacer.Remove(3);
+  replacer.SetEvictable(3, true);
+  ASSERT_EQ(0, replacer.Size());
+
+  // an access buffered before an eviction does not carry over to the frame's next page
+  replacer.RecordAccess(5);
+  replacer.SetEvictable(5, true);
+  replacer.RecordAccess(5);
+  replacer.Remove(5);
+  replacer.RecordAccess(5);
+  replacer.SetEvictable(5, true);
+  replacer.RecordAccess(6);
+  replacer.SetEvictable(6, true);
+  // 5 has a single access again, so it is evicted before 6 only by the age of that access
+  frame_id_t victim = -1;
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(5, victim);
+  replacer.RecordAccess(5);
+  replacer.RecordAccess(5);
+  replacer.SetEvictable(5, true);
+  ASSERT_TRUE(replacer.Evict(&victim));
+  ASSERT_EQ(6, victim);
+}
+
+TEST(LRUKReplacerTest, BufferedAccessesFromManyThreads) {
+  const frame_id_t num_frames = 64;
+  LRUKReplacer replacer(num_frames, 2, true);
+  for (frame_id_t frame_id = 0; frame_id < num_frames; frame_id++) {
+    replacer.RecordAccess(frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&replacer, &stop, t] {
+      std::mt19937 rng(t);
+      while (!stop.load()) replacer.RecordAccess(static_cast<frame_id_t>(rng() % num_frames));
+    });
+  }
+  // frames keep being evicted and brought back while the other threads record accesses
+  std::mt19937 rng(11);
+  for (int i = 0; i < 20000; i++) {
+    frame_id_t victim = -1;
+    if (replacer.Evict(&victim)) {
+      replacer.RecordAccess(victim);
+      replacer.SetEvictable(victim, true);
+    }
+    auto frame_id = static_cast<frame_id_t>(rng() % num_frames);
+    replacer.SetEvictable(frame_id, false);
+    replacer.SetEvictable(frame_id, true);
+  }
+  stop = true;
+  for (auto &thread : threads) thread.join();
+  ASSERT_EQ(num_frames, replacer.Size());
+  for (frame_id_t i = 0; i < num_frames; i++) {
+    frame_id_t victim = -1;
+    ASSERT_TRUE(replacer.Evict(&victim));
+  }
+  ASSERT_EQ(0, replacer.Size());
+}
+
+TEST(LRUKReplacerTest, PrefetchIsNoAccess) {
+  LRUKReplacer replacer(2, 2);
+  replacer.RecordAccess(0);
+  // the prefetch and the first fetch are one access: frame 1 stays at +inf distance
+  replacer.RecordPrefetch(1);
+  replacer.RecordAccess(1);
+  replacer.RecordAccess(0);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(1, true);
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_EQ(1, replacer.GetColdEvictionCount());
+}
+
+TEST(LRUKReplacerTest, RepeatedUnpinKeepsTheFrameOnce) {
+  LRUKReplacer replacer(3, 2);
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(1);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(1, true);
+  // a hit leaves the frame evictable, its unpin sets the bit that is already set
+  replacer.RecordAccess(0);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(0, true);
+  ASSERT_EQ(2, replacer.Size());
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  // the pool takes back the eviction of a frame pinned by a hit
+  replacer.Reinstate(1, 1);
+  replacer.SetEvictable(1, true);
+  ASSERT_EQ(2, replacer.Size());
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  ASSERT_FALSE(replacer.Evict(&frame_id));
+}
+
+
+TEST(LRUKReplacerTest, EvictsTheLowerClassFirst) {
+  LRUKReplacer replacer(6, 2);
+  for (frame_id_t frame_id = 0; frame_id < 6; frame_id++) {
+    replacer.RecordAccess(frame_id);
+    replacer.SetEvictable(frame_id, true);
+  }
+  replacer.SetPriority(0, PagePriority::STICKY);
+  replacer.SetPriority(1, PagePriority::STICKY);
+  replacer.SetPriority(5, PagePriority::SCAN);
+
+  // the scan frame is the most recent, the sticky frames are the least recent
+  frame_id_t frame_id;
+  for (frame_id_t expected : {5, 2, 3, 4}) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    ASSERT_EQ(expected, frame_id);
+  }
+  replacer.SetPriority(1, PagePriority::NORMAL);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+
+  // an evicted frame comes back in the NORMAL class
+  replacer.RecordAccess(0);
+  replacer.RecordAccess(2);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(2, true);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+}
+
+}  // namespace bustub
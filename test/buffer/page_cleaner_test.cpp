@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_cleaner_test.cpp
+//
+// Identification: test/buffer/page_cleaner_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sys/resource.h>
+
+#include <chrono>  // NOLINT
+#include <csignal>
+#include <cstdio>
+#include <future>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/gated_disk_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(PageCleanerTest, CleansTheNextVictims) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 8; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm.UnpinPage(page_id, true);
+  }
+
+  bpm.StartPageCleaner(8, 100000);
+  ASSERT_TRUE(WaitUntil([&bpm] { return bpm.GetMetrics().cleaner_writes_ == 8; }));
+  bpm.StopPageCleaner();
+  ASSERT_EQ(8, bpm.GetMetrics().cleaner_writes_);
+
+  // every victim is clean, so the new pages evict without writing anything back
+  for (int i = 0; i < 8; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, false);
+  }
+  ASSERT_EQ(0, bpm.GetMetrics().dirty_evictions_);
+  for (page_id_t old_page_id = 0; old_page_id < 8; old_page_id++) {
+    Page *page = bpm.FetchPage(old_page_id);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ("page " + std::to_string(old_page_id), std::string(page->GetData()));
+    bpm.UnpinPage(old_page_id, false);
+  }
+}
+
+TEST(PageCleanerTest, FailedWriteStaysDirty) {
+  const char *db_file = "page_cleaner_test.db";
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  auto *bpm = new BufferPoolManagerInstance(4, &disk_manager, 2);
+  if (!bpm->EnableIoUring(db_file, false)) {
+    delete bpm;
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  page_id_t page_id;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // the file may not grow past two pages, the cleaner's writes of pages 2 and 3 fail
+  rlimit old_limit;
+  getrlimit(RLIMIT_FSIZE, &old_limit);
+  rlimit limit = old_limit;
+  limit.rlim_cur = 2 * BUSTUB_PAGE_SIZE;
+  auto old_handler = signal(SIGXFSZ, SIG_IGN);
+  setrlimit(RLIMIT_FSIZE, &limit);
+  bpm->StartPageCleaner(4, 100000);
+  // the limit is lifted before any assertion can return
+  bool cleaned = WaitUntil([bpm] {
+    BufferPoolMetricsSnapshot metrics = bpm->GetMetrics();
+    return metrics.cleaner_writes_ >= 2 && metrics.cleaner_write_failures_ >= 2;
+  });
+  bpm->StopPageCleaner();
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+  ASSERT_TRUE(cleaned);
+  ASSERT_EQ(2, bpm->GetMetrics().cleaner_writes_);
+  ASSERT_LE(2, bpm->GetMetrics().cleaner_write_failures_);
+
+  // the failed pages are still dirty: a flush writes them, and so would their eviction
+  ASSERT_EQ(2 * BUSTUB_PAGE_SIZE, bpm->FlushAllDirtyPages());
+  delete bpm;
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+TEST(PageCleanerTest, WaitingForTheCleanerDoesNotHoldTheLatch) {
+  GatedDiskManager disk_manager(100);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, true);
+  }
+
+  // the cleaner takes both frames and its writes are held, so no frame is evictable
+  bpm.StartPageCleaner(2, 100000);
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+  auto new_page = std::async(std::launch::async, [&bpm] {
+    page_id_t new_page_id;
+    Page *page = bpm.NewPage(&new_page_id);
+    if (page != nullptr) bpm.UnpinPage(new_page_id, false);
+    return page != nullptr;
+  });
+  auto delete_cleaning_page = std::async(std::launch::async, [&bpm] { return bpm.DeletePage(1); });
+  bool waiting = WaitUntil([&bpm] { return bpm.GetMetrics().cleaning_waits_ >= 2; });
+
+  // both wait for the cleaner, neither of them with the latch held
+  auto delete_other_page = std::async(std::launch::async, [&bpm] { return bpm.DeletePage(50); });
+  auto delete_status = delete_other_page.wait_for(std::chrono::seconds(5));
+  auto new_page_status = new_page.wait_for(std::chrono::milliseconds(0));
+  disk_manager.Open();
+  ASSERT_TRUE(waiting);
+  ASSERT_EQ(std::future_status::ready, delete_status);
+  ASSERT_EQ(std::future_status::timeout, new_page_status);
+
+  ASSERT_TRUE(delete_other_page.get());
+  ASSERT_TRUE(new_page.get());
+  ASSERT_TRUE(delete_cleaning_page.get());
+  bpm.StopPageCleaner();
+}
+
+
+TEST(PageCleanerTest, AsyncFetchWaitsForTheCleaner) {
+  GatedDiskManager disk_manager(100);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  page_id_t page_id;
+  for (int i = 0; i < 2; i++) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    bpm.UnpinPage(page_id, true);
+  }
+
+  // the cleaner holds both frames, the miss waits for them rather than failing
+  bpm.StartPageCleaner(2, 100000);
+  ASSERT_TRUE(disk_manager.WaitForWrites(1));
+  // the writes are let through later, a fetch that does not wait fails before that whenever it comes
+  auto open = std::async(std::launch::async, [&disk_manager] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    disk_manager.Open();
+  });
+  std::promise<Page *> loaded;
+  bool pending = false;
+  ASSERT_EQ(nullptr, bpm.FetchPageAsync(10, [&loaded](Page *page) { loaded.set_value(page); }, &pending));
+  ASSERT_TRUE(pending);
+  open.get();
+  std::future<Page *> page = loaded.get_future();
+  ASSERT_EQ(std::future_status::ready, page.wait_for(std::chrono::seconds(5)));
+  ASSERT_EQ(10, page.get()->GetPageId());
+  ASSERT_EQ(0, bpm.GetMetrics().fetch_failures_);
+  bpm.UnpinPage(10, false);
+  bpm.StopPageCleaner();
+}
+
+}  // namespace bustub
@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_segment_test.cpp
+//
+// Identification: test/buffer/page_segment_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_segment.h"
+
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/free_page_map.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** Create num_pages pages in the segment and return their ids. */
+template <typename BufferPool>
+auto NewSegmentPages(BufferPool *bpm, PageSegment *segment, int num_pages) -> std::vector<page_id_t> {
+  std::vector<page_id_t> page_ids;
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    if (bpm->NewPageInSegment(segment, &page_id) == nullptr) break;
+    page_ids.push_back(page_id);
+    bpm->UnpinPage(page_id, false);
+  }
+  return page_ids;
+}
+}  // namespace
+
+TEST(PageSegmentTest, ExtentsAreContiguous) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  PageSegment first_segment(4);
+  PageSegment second_segment(4);
+  std::vector<page_id_t> first_page_ids;
+  std::vector<page_id_t> second_page_ids;
+  // the loaders of both segments take turns, still each extent holds the pages of one segment
+  for (int i = 0; i < 6; i++) {
+    first_page_ids.push_back(NewSegmentPages(&bpm, &first_segment, 1).at(0));
+    second_page_ids.push_back(NewSegmentPages(&bpm, &second_segment, 1).at(0));
+  }
+  ASSERT_EQ((std::vector<page_id_t>{0, 1, 2, 3, 8, 9}), first_page_ids);
+  ASSERT_EQ((std::vector<page_id_t>{4, 5, 6, 7, 12, 13}), second_page_ids);
+
+  // a plain new page goes past the reserved extents
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(16, page_id);
+  bpm.UnpinPage(page_id, false);
+}
+
+TEST(PageSegmentTest, ExtentReusesAFreedRun) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableFreePageMap());
+  PageSegment segment(4);
+  // the extent starts after the map page, page 0 before it is left free for a plain new page
+  ASSERT_EQ((std::vector<page_id_t>{2, 3, 4, 5}), NewSegmentPages(&bpm, &segment, 4));
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  bpm.UnpinPage(page_id, false);
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(6, page_id);
+  bpm.UnpinPage(page_id, false);
+
+  for (page_id_t deleted_page_id = 3; deleted_page_id < 6; deleted_page_id++) {
+    ASSERT_TRUE(bpm.DeletePage(deleted_page_id));
+  }
+  PageSegment next_segment(2);
+  ASSERT_EQ((std::vector<page_id_t>{3, 4, 7, 8}), NewSegmentPages(&bpm, &next_segment, 4));
+}
+
+TEST(PageSegmentTest, ReservedRunIsGivenBack) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(8, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableFreePageMap());
+  // what ReserveExtent() does in every instance, and undoes in the instances that reserved when another one refused
+  ASSERT_TRUE(bpm.ReservePageRun(2, 3));
+  ASSERT_EQ(5, bpm.GetEndPageNo());
+  ASSERT_FALSE(bpm.ReservePageRun(4, 3));
+  for (page_id_t page_id = 2; page_id < 5; page_id++) ASSERT_TRUE(bpm.DeletePage(page_id));
+
+  // the pages of the run are free again, along with page 0 skipped on the way
+  page_id_t page_id;
+  for (page_id_t expected : {0, 2, 3, 4, 5}) {
+    ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+    ASSERT_EQ(expected, page_id);
+    bpm.UnpinPage(page_id, false);
+  }
+}
+
+TEST(PageSegmentTest, ParallelExtentSpansTheInstances) {
+  DiskManagerMemory disk_manager(1000);
+  ParallelBufferPoolManager bpm(3, 8, &disk_manager, 2);
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+  ASSERT_EQ(0, page_id);
+  bpm.UnpinPage(page_id, false);
+
+  // the same page numbers in every instance, past the end of the instance that is furthest
+  PageSegment segment(2);
+  ASSERT_EQ((std::vector<page_id_t>{3, 4, 5, 6, 7, 8, 9, 10}), NewSegmentPages(&bpm, &segment, 8));
+}
+
+TEST(PageSegmentTest, ParallelExtentsRaceNewPages) {
+  DiskManagerMemory disk_manager(1000);
+  constexpr size_t num_instances = 2;
+  constexpr size_t extent_pages = 3;
+  ParallelBufferPoolManager bpm(num_instances, 8, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableFreePageMap());
+
+  // plain new pages move the ends of the instances while the extents are reserved, a reservation that loses the
+  // race in one instance gives its run back in the others and tries again further on
+  std::vector<page_id_t> new_page_ids;
+  std::thread loader([&bpm, &new_page_ids] {
+    page_id_t page_id;
+    for (int i = 0; i < 100; i++) {
+      if (bpm.NewPage(&page_id) == nullptr) continue;
+      new_page_ids.push_back(page_id);
+      bpm.UnpinPage(page_id, false);
+    }
+  });
+  PageSegment segment(extent_pages);
+  std::vector<page_id_t> segment_page_ids = NewSegmentPages(&bpm, &segment, 60);
+  loader.join();
+  ASSERT_EQ(60, segment_page_ids.size());
+
+  FreePageMap first_map(num_instances, 0);
+  FreePageMap second_map(num_instances, 1);
+  for (size_t i = 0; i < segment_page_ids.size(); i++) {
+    page_id_t page_id = segment_page_ids[i];
+    if (i % (extent_pages * num_instances) != 0) ASSERT_EQ(segment_page_ids[i - 1] + 1, page_id);
+    ASSERT_FALSE(first_map.IsMapPage(page_id) || second_map.IsMapPage(page_id));
+  }
+  // no page id was handed out twice, also not one given back by a lost reservation
+  std::set<page_id_t> page_ids(segment_page_ids.begin(), segment_page_ids.end());
+  page_ids.insert(new_page_ids.begin(), new_page_ids.end());
+  ASSERT_EQ(segment_page_ids.size() + new_page_ids.size(), page_ids.size());
+}
+
+}  // namespace bustub
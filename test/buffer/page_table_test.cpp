@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table_test.cpp
+//
+// Identification: test/buffer/page_table_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+/** The frame every test maps page_id to, so that a lookup can tell a stale entry from a wrong one. */
+auto FrameOf(page_id_t page_id) -> frame_id_t { return page_id % 1000 + 1; }
+}  // namespace
+
+TEST(PageTableTest, InsertFindErase) {
+  PageTable table(8);
+  ASSERT_LE(8, table.GetCapacity());
+  frame_id_t frame_id = -1;
+  ASSERT_FALSE(table.Find(0, &frame_id));
+  for (page_id_t page_id = 0; page_id < 8; page_id++) table.Insert(page_id, FrameOf(page_id));
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    ASSERT_TRUE(table.Find(page_id, &frame_id));
+    ASSERT_EQ(FrameOf(page_id), frame_id);
+  }
+  ASSERT_FALSE(table.Find(8, &frame_id));
+
+  ASSERT_TRUE(table.Erase(3));
+  ASSERT_FALSE(table.Find(3, &frame_id));
+  // the entries probed past the erased one are still found
+  for (page_id_t page_id = 0; page_id < 8; page_id++) {
+    if (page_id != 3) ASSERT_TRUE(table.Find(page_id, &frame_id));
+  }
+}
+
+TEST(PageTableTest, EraseOfAMissingPage) {
+  PageTable table(8);
+  ASSERT_FALSE(table.Erase(0));
+  table.Insert(0, FrameOf(0));
+  ASSERT_FALSE(table.Erase(1));
+  ASSERT_TRUE(table.Erase(0));
+  // only a tombstone is left
+  ASSERT_FALSE(table.Erase(0));
+  table.Insert(0, FrameOf(0));
+  ASSERT_TRUE(table.Erase(0));
+}
+
+TEST(PageTableTest, ChurnReusesTombstonesAndRebuilds) {
+  // an insert takes the first tombstone of its probe; once entries and tombstones pass 3/4 of the slots the table
+  // is rebuilt, otherwise the churn below would fill every slot and the next insert would probe forever
+  PageTable table(16);
+  const auto num_live = static_cast<page_id_t>(table.GetCapacity());
+  frame_id_t frame_id = -1;
+  for (page_id_t page_id = 0; page_id < num_live; page_id++) table.Insert(page_id, FrameOf(page_id));
+  for (page_id_t page_id = num_live; page_id < 100 * num_live; page_id++) {
+    ASSERT_TRUE(table.Erase(page_id - num_live));
+    table.Insert(page_id, FrameOf(page_id));
+    ASSERT_TRUE(table.Find(page_id, &frame_id));
+    ASSERT_FALSE(table.Find(page_id - num_live, &frame_id));
+  }
+  for (page_id_t page_id = 99 * num_live; page_id < 100 * num_live; page_id++) {
+    ASSERT_TRUE(table.Find(page_id, &frame_id));
+    ASSERT_EQ(FrameOf(page_id), frame_id);
+  }
+}
+
+TEST(PageTableTest, OptimisticFindRacesTheWriter) {
+  PageTable table(64);
+  constexpr page_id_t num_stable = 32;
+  for (page_id_t page_id = 0; page_id < num_stable; page_id++) table.Insert(page_id, FrameOf(page_id));
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> wrong_frames{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&table, &stop, &wrong_frames] {
+      frame_id_t frame_id = -1;
+      for (page_id_t page_id = 0; !stop; page_id = (page_id + 1) % 2000) {
+        // a lookup may miss an entry or see one being erased, but never one mapped to another frame
+        if (table.Find(page_id, &frame_id) && frame_id != FrameOf(page_id)) wrong_frames++;
+      }
+    });
+  }
+
+  // the writer cycles 16 pages through the remaining slots, which rebuilds the table over and over
+  for (page_id_t page_id = 1000; page_id < 21000; page_id++) {
+    if (page_id >= 1016) ASSERT_TRUE(table.Erase(page_id - 16));
+    table.Insert(page_id, FrameOf(page_id));
+  }
+  stop = true;
+  for (auto &reader : readers) reader.join();
+  ASSERT_EQ(0, wrong_frames);
+  frame_id_t frame_id = -1;
+  for (page_id_t page_id = 0; page_id < num_stable; page_id++) {
+    ASSERT_TRUE(table.Find(page_id, &frame_id));
+    ASSERT_EQ(FrameOf(page_id), frame_id);
+  }
+}
+
+TEST(PageTableTest, ConcurrentHitsAndEvictionsInThePool) {
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(16, &disk_manager, 2);
+  constexpr int num_pages = 64;
+  page_id_t page_id;
+  for (int i = 0; i < num_pages; i++) {
+    Page *page = bpm.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    bpm.UnpinPage(page_id, true);
+  }
+
+  // hits find their frame without the latch while misses evict and reuse frames under it
+  std::atomic<int> wrong_pages{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&bpm, &wrong_pages, t] {
+      for (int i = 0; i < 2000; i++) {
+        // every thread has a hot set of its own, and all of them sweep the whole file now and then
+        page_id_t fetched_page_id = i % 4 == 0 ? (i / 4 + t) % num_pages : t * 4 + i % 4;
+        Page *page = bpm.FetchPage(fetched_page_id);
+        if (page == nullptr) continue;
+        if (page->GetPageId() != fetched_page_id ||
+            std::string(page->GetData()) != "page " + std::to_string(fetched_page_id)) {
+          wrong_pages++;
+        }
+        bpm.UnpinPage(fetched_page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  ASSERT_EQ(0, wrong_pages);
+  ASSERT_LT(0, bpm.GetMetrics().hits_);
+  ASSERT_LT(0, bpm.GetMetrics().evictions_);
+}
+
+}  // namespace bustub
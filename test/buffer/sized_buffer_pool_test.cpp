@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sized_buffer_pool_test.cpp
+//
+// Identification: test/buffer/sized_buffer_pool_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer/sized_buffer_pool.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+namespace {
+constexpr size_t PAGE_SIZE = 4 * BUSTUB_PAGE_SIZE;
+
+auto Pattern(page_id_t page_id) -> std::vector<char> {
+  std::vector<char> page(PAGE_SIZE);
+  for (size_t i = 0; i < page.size(); i++) page[i] = static_cast<char>((i * 7 + page_id) % 251);
+  return page;
+}
+}  // namespace
+
+TEST(SizedBufferPoolTest, PagesSpanBlocks) {
+  DiskManagerMemory disk_manager(1000);
+  SizedBufferPool<PAGE_SIZE> pool(2, &disk_manager, 2);
+  for (page_id_t expected = 0; expected < 6; expected++) {
+    page_id_t page_id;
+    SizedPageGuard<PAGE_SIZE> guard = pool.NewPage(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    ASSERT_EQ(expected, page_id);
+    guard.Write(0, Pattern(page_id).data(), PAGE_SIZE);
+  }
+
+  // the pages were evicted block by block, a fetch reads them back whole
+  std::vector<char> data(PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < 6; page_id++) {
+    SizedPageGuard<PAGE_SIZE> guard = pool.FetchPage(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    guard.Read(0, data.data(), PAGE_SIZE);
+    ASSERT_EQ(Pattern(page_id), data);
+  }
+
+  // two pinned pages fill the pool
+  SizedPageGuard<PAGE_SIZE> first = pool.FetchPage(0);
+  SizedPageGuard<PAGE_SIZE> second = pool.FetchPage(1);
+  ASSERT_FALSE(pool.FetchPage(2).IsValid());
+  second.Write(BUSTUB_PAGE_SIZE - 2, "abcd", 4);
+  char bytes[4];
+  second.Read(BUSTUB_PAGE_SIZE - 2, bytes, 4);
+  ASSERT_EQ(0, memcmp("abcd", bytes, 4));
+}
+
+TEST(SizedBufferPoolTest, DeleteIsAllOrNothing) {
+  DiskManagerMemory disk_manager(1000);
+  SizedBufferPool<PAGE_SIZE> pool(2, &disk_manager, 2);
+  page_id_t page_id;
+  {
+    SizedPageGuard<PAGE_SIZE> guard = pool.NewPage(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    guard.Write(0, Pattern(page_id).data(), PAGE_SIZE);
+  }
+
+  // a pin on the third block keeps the whole page
+  BufferPoolManagerInstance *blocks = pool.GetBlockPool();
+  ASSERT_NE(nullptr, blocks->FetchPage(2));
+  ASSERT_FALSE(pool.DeletePage(page_id));
+  blocks->UnpinPage(2, false);
+  {
+    SizedPageGuard<PAGE_SIZE> guard = pool.FetchPage(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    std::vector<char> data(PAGE_SIZE);
+    guard.Read(0, data.data(), PAGE_SIZE);
+    ASSERT_EQ(Pattern(page_id), data);
+  }
+  ASSERT_EQ(0, blocks->GetMetrics().misses_);
+
+  ASSERT_TRUE(pool.DeletePage(page_id));
+  ASSERT_EQ(2 * SizedBufferPool<PAGE_SIZE>::BLOCKS_PER_PAGE, blocks->GetMetrics().unpinned_frames_);
+  ASSERT_FALSE(pool.FlushPage(page_id));
+}
+
+TEST(SizedBufferPoolTest, FlushPageWritesTheBlocks) {
+  DiskManagerMemory disk_manager(1000);
+  SizedBufferPool<PAGE_SIZE> pool(2, &disk_manager, 2);
+  page_id_t page_id;
+  SizedPageGuard<PAGE_SIZE> guard = pool.NewPage(&page_id);
+  ASSERT_TRUE(guard.IsValid());
+  guard.Write(0, Pattern(page_id).data(), PAGE_SIZE);
+  guard.Drop();
+  ASSERT_TRUE(pool.FlushPage(page_id));
+
+  std::vector<char> block(BUSTUB_PAGE_SIZE);
+  std::vector<char> expected = Pattern(page_id);
+  for (size_t i = 0; i < SizedBufferPool<PAGE_SIZE>::BLOCKS_PER_PAGE; i++) {
+    disk_manager.ReadPage(static_cast<page_id_t>(i), block.data());
+    ASSERT_EQ(0, memcmp(expected.data() + i * BUSTUB_PAGE_SIZE, block.data(), BUSTUB_PAGE_SIZE)) << "block " << i;
+  }
+}
+
+TEST(SizedBufferPoolTest, MisalignedBlocksAreRefused) {
+  DiskManagerMemory disk_manager(1000);
+  SizedBufferPool<PAGE_SIZE> pool(2, &disk_manager, 2);
+  // a block created behind the pool's back shifts the blocks of the next page
+  page_id_t page_id;
+  ASSERT_NE(nullptr, pool.GetBlockPool()->NewPage(&page_id));
+  pool.GetBlockPool()->UnpinPage(page_id, false);
+
+  ASSERT_FALSE(pool.NewPage(&page_id).IsValid());
+  // the blocks created for it were given back
+  ASSERT_EQ(2 * SizedBufferPool<PAGE_SIZE>::BLOCKS_PER_PAGE, pool.GetBlockPool()->GetMetrics().unpinned_frames_);
+}
+
+}  // namespace bustub
@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer_test.cpp
+//
+// Identification: test/buffer/two_queue_replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+/** Load page_id into the frame and unpin it, as the buffer pool does. */
+void Load(TwoQueueReplacer *replacer, frame_id_t frame_id, page_id_t page_id) {
+  replacer->SetFramePage(frame_id, page_id);
+  replacer->RecordAccess(frame_id);
+  replacer->SetEvictable(frame_id, true);
+}
+}  // namespace
+
+TEST(TwoQueueReplacerTest, PageSeenAgainGoesToAm) {
+  // kin is 2: A1in is evicted first while it holds more than two frames
+  TwoQueueReplacer replacer(8);
+  for (frame_id_t frame_id = 0; frame_id < 8; frame_id++) Load(&replacer, frame_id, 100 + frame_id);
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  // page 100 is still in A1out, so it is loaded into Am; correlated accesses in A1in do not promote other pages
+  Load(&replacer, 0, 100);
+  replacer.RecordAccess(1);
+
+  for (frame_id_t expected = 1; expected <= 5; expected++) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    ASSERT_EQ(expected, frame_id);
+  }
+  // A1in is down to kin frames, Am goes first
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  ASSERT_EQ(6, replacer.GetColdEvictionCount());
+}
+
+TEST(TwoQueueReplacerTest, EvictionSkipsPinnedFrames) {
+  const size_t num_frames = 1000;
+  TwoQueueReplacer replacer(num_frames);
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+    replacer.SetFramePage(frame_id, frame_id);
+    replacer.RecordAccess(frame_id);
+  }
+  replacer.SetEvictable(600, true);
+  replacer.SetEvictable(300, true);
+  ASSERT_EQ(2, replacer.Size());
+
+  // A1in is FIFO: the order of loading counts, not the order of unpinning
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(300, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(600, frame_id);
+  ASSERT_FALSE(replacer.Evict(&frame_id));
+}
+
+TEST(TwoQueueReplacerTest, PeekVictimsListsTheEvictionOrder) {
+  const size_t num_frames = 64;
+  TwoQueueReplacer replacer(num_frames);
+  std::mt19937 rng(11);
+  for (int round = 0; round < 3; round++) {
+    for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+      if (rng() % 3 == 0) continue;
+      Load(&replacer, frame_id, static_cast<page_id_t>(rng() % 100));
+    }
+    frame_id_t frame_id;
+    for (int i = 0; i < 20; i++) replacer.Evict(&frame_id);
+  }
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(num_frames); frame_id++) {
+    if (rng() % 4 == 0) replacer.SetEvictable(frame_id, false);
+  }
+
+  std::vector<frame_id_t> peeked(num_frames);
+  peeked.resize(replacer.PeekVictims(peeked.data(), peeked.size()));
+  ASSERT_EQ(replacer.Size(), peeked.size());
+  // evicting changes which queue goes first, so only the first few are certain
+  frame_id_t frame_id;
+  for (size_t i = 0; i < 3 && i < peeked.size(); i++) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    ASSERT_EQ(peeked[i], frame_id);
+  }
+}
+
+TEST(TwoQueueReplacerTest, ReinstateDoesNotPromote) {
+  // kin is 1
+  TwoQueueReplacer replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) Load(&replacer, frame_id, 100 + frame_id);
+
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  ASSERT_EQ(1, replacer.GetColdEvictionCount());
+
+  // the page was pinned again before the pool got to it: it stays at the back of A1in, where loading it anew from
+  // A1out would have put it into Am
+  replacer.Reinstate(0, 100);
+  ASSERT_EQ(0, replacer.GetColdEvictionCount());
+  ASSERT_EQ(3, replacer.Size());
+  replacer.SetEvictable(0, true);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+
+  // the eviction's ghost did not survive the reinstatement, but this eviction left a new one
+  Load(&replacer, 0, 100);
+  for (frame_id_t expected = 1; expected <= 2; expected++) {
+    ASSERT_TRUE(replacer.Evict(&frame_id));
+    ASSERT_EQ(expected, frame_id);
+  }
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+}
+
+TEST(TwoQueueReplacerTest, ReinstateAfterAnAccessKeepsTheAccess) {
+  TwoQueueReplacer replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) Load(&replacer, frame_id, 100 + frame_id);
+  // page 100 makes it into Am
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  Load(&replacer, 0, 100);
+  replacer.SetEvictable(0, false);
+  replacer.SetEvictable(0, true);
+
+  // evict Am's only frame; a hit records an access before the pool finds the frame pinned
+  replacer.SetEvictable(1, false);
+  replacer.SetEvictable(2, false);
+  replacer.SetEvictable(3, false);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  replacer.RecordAccess(0);
+  replacer.Reinstate(0, 100);
+  replacer.SetEvictable(0, true);
+  replacer.SetEvictable(1, true);
+
+  // the frame is back in Am, behind A1in's frame
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+}
+
+TEST(TwoQueueReplacerTest, PrefetchIsNoGhostHit) {
+  TwoQueueReplacer replacer(4);
+  Load(&replacer, 0, 100);
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(1, replacer.GetColdEvictionCount());
+
+  // read back ahead of any access, the page waits in A1in and keeps its ghost
+  replacer.SetFramePage(0, 100);
+  replacer.RecordPrefetch(0);
+  replacer.SetEvictable(0, true);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  ASSERT_EQ(2, replacer.GetColdEvictionCount());
+
+  // the first access finds the ghost and promotes the page to Am
+  replacer.SetFramePage(0, 100);
+  replacer.RecordPrefetch(0);
+  replacer.RecordAccess(0);
+  replacer.SetEvictable(0, true);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  ASSERT_EQ(0, frame_id);
+  ASSERT_EQ(2, replacer.GetColdEvictionCount());
+}
+
+}  // namespace bustub
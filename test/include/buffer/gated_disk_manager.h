@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// gated_disk_manager.h
+//
+// Identification: test/include/buffer/gated_disk_manager.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+/** How long the tests wait for something to happen in another thread before they fail. */
+static constexpr std::chrono::seconds TEST_WAIT_TIMEOUT{5};
+
+/**
+ * GatedDiskManager holds page writes until Open() is called, so that a test can keep a write in flight while it
+ * checks what the buffer pool does meanwhile. Every write is held, or only those of the page passed to Hold().
+ */
+class GatedDiskManager : public DiskManagerMemory {
+ public:
+  explicit GatedDiskManager(size_t pages) : DiskManagerMemory(pages) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    page_id_t held_page_id = held_page_id_;
+    if (held_page_id == INVALID_PAGE_ID || held_page_id == page_id) {
+      std::unique_lock<std::mutex> lock(latch_);
+      writes_started_++;
+      changed_.notify_all();
+      changed_.wait(lock, [this] { return open_; });
+    }
+    DiskManagerMemory::WritePage(page_id, page_data);
+  }
+
+  /** @brief Hold the writes of page_id only, the writes of other pages go through at once. */
+  void Hold(page_id_t page_id) { held_page_id_ = page_id; }
+
+  /** @brief Let the held writes and all later ones through. */
+  void Open() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    open_ = true;
+    changed_.notify_all();
+  }
+
+  /**
+   * @brief Wait until num_writes writes have reached the gate, at most TEST_WAIT_TIMEOUT.
+   * @return false on timeout
+   */
+  auto WaitForWrites(int num_writes) -> bool {
+    std::unique_lock<std::mutex> lock(latch_);
+    return changed_.wait_for(lock, TEST_WAIT_TIMEOUT, [this, num_writes] { return writes_started_ >= num_writes; });
+  }
+
+  /** Number of writes that reached the gate, whether or not it was open. */
+  std::atomic<int> writes_started_{0};
+
+ private:
+  std::atomic<page_id_t> held_page_id_{INVALID_PAGE_ID};
+  std::mutex latch_;
+  std::condition_variable changed_;
+  bool open_{false};
+};
+
+/**
+ * @brief Wait until condition() holds, for state another thread changes without notifying anyone, such as the
+ * metrics of a buffer pool. Gives up after TEST_WAIT_TIMEOUT.
+ * @return false on timeout
+ */
+template <typename Condition>
+auto WaitUntil(Condition condition) -> bool {
+  auto deadline = std::chrono::steady_clock::now() + TEST_WAIT_TIMEOUT;
+  while (!condition()) {
+    if (std::chrono::steady_clock::now() >= deadline) return false;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+}  // namespace bustub
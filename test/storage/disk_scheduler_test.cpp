@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+namespace {
+const char *db_file = "disk_scheduler_test.db";
+
+/** Write then read back a run of pages, one request per page and one vectored request for them all. */
+void RoundTrip(DiskScheduler *scheduler) {
+  const int num_pages = 16;
+  std::vector<std::vector<char>> written(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE));
+  std::vector<DiskRequest> writes;
+  for (int i = 0; i < num_pages; i++) {
+    memset(written[i].data(), 'a' + i, BUSTUB_PAGE_SIZE);
+    writes.push_back({true, written[i].data(), i, nullptr});
+  }
+  scheduler->ScheduleAndWait(std::move(writes));
+
+  std::vector<std::vector<char>> read(num_pages, std::vector<char>(BUSTUB_PAGE_SIZE));
+  DiskRequest vectored{false, read[0].data(), 0, nullptr};
+  for (int i = 1; i < num_pages; i++) vectored.next_data_.push_back(read[i].data());
+  scheduler->ScheduleAndWait({std::move(vectored)});
+  for (int i = 0; i < num_pages; i++) ASSERT_EQ(written[i], read[i]) << "page " << i;
+}
+
+/** The read linked to a write must not overwrite the buffer before the write is done with it. */
+void LinkedWriteThenRead(DiskScheduler *scheduler) {
+  std::vector<char> old_data(BUSTUB_PAGE_SIZE, 'o');
+  scheduler->ScheduleAndWait({{true, old_data.data(), 20, nullptr}});
+
+  const int num_pairs = 32;
+  std::vector<std::vector<char>> frames(num_pairs, std::vector<char>(BUSTUB_PAGE_SIZE));
+  std::vector<DiskRequest> requests;
+  for (int i = 0; i < num_pairs; i++) {
+    memset(frames[i].data(), 'A' + i % 26, BUSTUB_PAGE_SIZE);
+    DiskRequest writeback{true, frames[i].data(), 100 + i, nullptr};
+    writeback.link_next_ = true;
+    requests.push_back(std::move(writeback));
+    requests.push_back({false, frames[i].data(), 20, nullptr});
+  }
+  scheduler->ScheduleAndWait(std::move(requests));
+
+  std::vector<char> read(BUSTUB_PAGE_SIZE);
+  for (int i = 0; i < num_pairs; i++) {
+    ASSERT_EQ(old_data, frames[i]) << "pair " << i;
+    scheduler->ScheduleAndWait({{false, read.data(), 100 + i, nullptr}});
+    ASSERT_EQ(std::vector<char>(BUSTUB_PAGE_SIZE, 'A' + i % 26), read) << "pair " << i;
+  }
+}
+}  // namespace
+
+TEST(DiskSchedulerTest, WorkerThreads) {
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  {
+    DiskScheduler scheduler(&disk_manager, 4);
+    RoundTrip(&scheduler);
+    LinkedWriteThenRead(&scheduler);
+  }
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+TEST(DiskSchedulerTest, IoUring) {
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  for (bool direct_io : {false, true}) {
+    // a queue shallower than the batches, which are then submitted in turns
+    DiskScheduler scheduler(&disk_manager, db_file, direct_io, 4);
+    if (!scheduler.UsesIoUring()) GTEST_SKIP() << "io_uring is not available";
+    RoundTrip(&scheduler);
+    LinkedWriteThenRead(&scheduler);
+  }
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+TEST(DiskSchedulerTest, CallbacksScheduleMoreAtShutdown) {
+  remove(db_file);
+  DiskManager disk_manager(db_file);
+  std::vector<char> data(BUSTUB_PAGE_SIZE);
+  std::atomic<int> completed{0};
+  {
+    DiskScheduler scheduler(&disk_manager, db_file, false, 4);
+    scheduler.ScheduleAndWait({{true, data.data(), 0, nullptr}});
+    for (int i = 0; i < 20; i++) {
+      scheduler.Schedule({false, data.data(), 0, [&] {
+                            completed++;
+                            scheduler.Schedule({false, data.data(), 0, [&] { completed++; }});
+                          }});
+    }
+  }
+  ASSERT_EQ(40, completed);
+  disk_manager.ShutDown();
+  remove(db_file);
+}
+
+}  // namespace bustub
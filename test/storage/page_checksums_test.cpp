@@ -0,0 +1,141 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksums_test.cpp
+//
+// Identification: test/storage/page_checksums_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/page_checksums.h"
+
+namespace bustub {
+
+namespace {
+const char *checksum_file = "page_checksums_test.crc";
+
+/** Changes a page buffer of the pool right when one of its writes reaches the disk. */
+class ScribblingDiskManager : public DiskManagerMemory {
+ public:
+  explicit ScribblingDiskManager(size_t pages) : DiskManagerMemory(pages) {}
+
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (scribble_ != nullptr) scribble_[0]++;
+    DiskManagerMemory::WritePage(page_id, page_data);
+  }
+
+  char *scribble_{nullptr};
+};
+
+/** Fill the pool with other pages, so that the next fetch of page_id reads it from disk. */
+void EvictAll(BufferPoolManagerInstance *bpm) {
+  page_id_t page_id;
+  for (size_t i = 0; i < bpm->GetPoolSize(); i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    bpm->UnpinPage(page_id, false);
+  }
+}
+}  // namespace
+
+TEST(PageChecksumsTest, Crc32c) {
+  // the check value of CRC-32C
+  ASSERT_EQ(0xE3069283, PageChecksums::Crc32c("123456789", 9));
+  ASSERT_EQ(0, PageChecksums::Crc32c("", 0));
+  std::vector<char> page(BUSTUB_PAGE_SIZE, 'x');
+  uint32_t crc = PageChecksums::Crc32c(page.data(), page.size());
+  page[100] = 'y';
+  ASSERT_NE(crc, PageChecksums::Crc32c(page.data(), page.size()));
+}
+
+TEST(PageChecksumsTest, ReopensTheFile) {
+  remove(checksum_file);
+  // a file created when no page was ever written
+  { ASSERT_TRUE(PageChecksums(checksum_file, 1).IsValid()); }
+  std::vector<char> pages(3 * BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < pages.size(); i++) pages[i] = static_cast<char>(i * 13 % 251);
+  {
+    PageChecksums checksums(checksum_file, 1);
+    ASSERT_TRUE(checksums.IsValid());
+    checksums.Seal(4, pages.data(), 3);
+  }
+
+  // the run sealed at once reads back page by page
+  PageChecksums checksums(checksum_file, 1);
+  ASSERT_TRUE(checksums.IsValid());
+  for (page_id_t i = 0; i < 3; i++) ASSERT_TRUE(checksums.Verify(4 + i, pages.data() + i * BUSTUB_PAGE_SIZE));
+  ASSERT_FALSE(checksums.Verify(5, pages.data()));
+  ASSERT_EQ(std::vector<page_id_t>{5}, checksums.GetCorruptPages());
+  ASSERT_TRUE(checksums.Verify(3, pages.data()));
+  checksums.Seal(5, pages.data());
+  ASSERT_TRUE(checksums.GetCorruptPages().empty());
+  remove(checksum_file);
+
+  // anything else is refused
+  FILE *file = fopen(checksum_file, "w");
+  fputs("not checksums", file);
+  fclose(file);
+  ASSERT_FALSE(PageChecksums(checksum_file, 1).IsValid());
+  remove(checksum_file);
+}
+
+TEST(PageChecksumsTest, SealsTheBytesWritten) {
+  remove(checksum_file);
+  ScribblingDiskManager disk_manager(1000);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableChecksums(checksum_file));
+  page_id_t page_id;
+  Page *page = bpm.NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page");
+
+  // the page changes while its flush is under way
+  disk_manager.scribble_ = page->GetData();
+  ASSERT_TRUE(bpm.FlushPage(page_id));
+  disk_manager.scribble_ = nullptr;
+  bpm.UnpinPage(page_id, false);
+
+  EvictAll(&bpm);
+  ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+  bpm.UnpinPage(page_id, false);
+  ASSERT_EQ(0, bpm.GetMetrics().checksum_failures_);
+  ASSERT_TRUE(bpm.GetCorruptPages().empty());
+  remove(checksum_file);
+}
+
+TEST(PageChecksumsTest, CorruptPageIsReported) {
+  remove(checksum_file);
+  DiskManagerMemory disk_manager(1000);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  ASSERT_TRUE(bpm.EnableChecksums(checksum_file));
+  page_id_t page_id;
+  Page *page = bpm.NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page");
+  bpm.UnpinPage(page_id, true);
+  EvictAll(&bpm);
+
+  // bit rot behind the pool's back
+  std::vector<char> data(BUSTUB_PAGE_SIZE);
+  disk_manager.ReadPage(page_id, data.data());
+  data[1] ^= 1;
+  disk_manager.WritePage(page_id, data.data());
+
+  ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+  bpm.UnpinPage(page_id, false);
+  ASSERT_EQ(1, bpm.GetMetrics().checksum_failures_);
+  ASSERT_EQ(std::vector<page_id_t>{page_id}, bpm.GetCorruptPages());
+  remove(checksum_file);
+}
+
+}  // namespace bustub
@@ -0,0 +1,125 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <future>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+namespace {
+/** @return the pin count of a resident page, not counting the pin taken to read it */
+auto PinCount(BufferPoolManagerInstance *bpm, page_id_t page_id) -> int {
+  Page *page = bpm->FetchPage(page_id);
+  int pin_count = page->GetPinCount() - 1;
+  bpm->UnpinPage(page_id, false);
+  return pin_count;
+}
+}  // namespace
+
+TEST(PageGuardTest, DropUnpinsOnce) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  page_id_t page_id;
+  {
+    BasicPageGuard guard = bpm.NewPageGuarded(&page_id);
+    ASSERT_TRUE(guard.IsValid());
+    ASSERT_EQ(page_id, guard.PageId());
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "guarded");
+    ASSERT_EQ(1, PinCount(&bpm, page_id));
+  }
+  ASSERT_EQ(0, PinCount(&bpm, page_id));
+
+  ReadPageGuard first = bpm.FetchPageRead(page_id);
+  ReadPageGuard second = bpm.FetchPageRead(page_id);
+  ASSERT_EQ("guarded", std::string(first.GetData()));
+  ASSERT_EQ(2, PinCount(&bpm, page_id));
+  first.Drop();
+  first.Drop();
+  ASSERT_FALSE(first.IsValid());
+  ASSERT_EQ(1, PinCount(&bpm, page_id));
+  second.Drop();
+  ASSERT_EQ(3, bpm.GetMetrics().unpinned_frames_);
+}
+
+TEST(PageGuardTest, MoveTransfersThePin) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  page_id_t page_id;
+  BasicPageGuard guard = bpm.NewPageGuarded(&page_id);
+  BasicPageGuard moved = std::move(guard);
+  ASSERT_FALSE(guard.IsValid());  // NOLINT
+  ASSERT_TRUE(moved.IsValid());
+  ASSERT_EQ(1, PinCount(&bpm, page_id));
+
+  // assigning over a guard drops the pin it held
+  page_id_t other_page_id;
+  BasicPageGuard other = bpm.NewPageGuarded(&other_page_id);
+  other = std::move(moved);
+  ASSERT_EQ(0, PinCount(&bpm, other_page_id));
+  ASSERT_EQ(1, PinCount(&bpm, page_id));
+
+  ReadPageGuard read = other.UpgradeRead();
+  ASSERT_FALSE(other.IsValid());
+  ASSERT_EQ(1, PinCount(&bpm, page_id));
+  read.Drop();
+  ASSERT_EQ(0, PinCount(&bpm, page_id));
+}
+
+TEST(PageGuardTest, WriteGuardMarksDirtyAndExcludesReaders) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(3, &disk_manager, 2);
+  page_id_t page_id;
+  { BasicPageGuard guard = bpm.NewPageGuarded(&page_id); }
+  ASSERT_TRUE(bpm.FlushPage(page_id));
+
+  WritePageGuard write = bpm.FetchPageWrite(page_id);
+  ASSERT_TRUE(write.IsValid());
+  snprintf(write.GetDataMut(), BUSTUB_PAGE_SIZE, "written");
+  auto read = std::async(std::launch::async, [&bpm, page_id] {
+    ReadPageGuard guard = bpm.FetchPageRead(page_id);
+    return std::string(guard.GetData());
+  });
+  ASSERT_EQ(std::future_status::timeout, read.wait_for(std::chrono::milliseconds(50)));
+  write.Drop();
+  ASSERT_EQ("written", read.get());
+
+  Page *page = bpm.FetchPage(page_id);
+  ASSERT_TRUE(page->IsDirty());
+  bpm.UnpinPage(page_id, false);
+}
+
+TEST(PageGuardTest, FullPoolGivesEmptyGuards) {
+  DiskManagerMemory disk_manager(100);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2);
+  std::vector<BasicPageGuard> guards;
+  page_id_t page_id;
+  for (int i = 0; i < 2; i++) {
+    guards.push_back(bpm.NewPageGuarded(&page_id));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  ASSERT_FALSE(bpm.NewPageGuarded(&page_id).IsValid());
+  ASSERT_FALSE(bpm.FetchPageRead(5).IsValid());
+  ASSERT_FALSE(bpm.FetchPageWrite(5).IsValid());
+  guards.clear();
+  ASSERT_TRUE(bpm.FetchPageWrite(5).IsValid());
+}
+
+}  // namespace bustub
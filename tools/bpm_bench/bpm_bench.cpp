@@ -0,0 +1,372 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bpm_bench.cpp
+//
+// Identification: tools/bpm_bench/bpm_bench.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Microbenchmarks of the buffer pool and its replacers. The disk is an in-memory or null DiskManager, so the numbers
+// are the CPU cost of the buffer pool alone. Run with --help for the options.
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/two_queue_replacer.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/page_checksums.h"
+
+namespace bustub {
+namespace {
+
+/** A disk that stores nothing: reads return zeros, writes are dropped. */
+class NullDiskManager : public DiskManager {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {}
+  void ReadPage(page_id_t page_id, char *page_data) override { memset(page_data, 0, BUSTUB_PAGE_SIZE); }
+};
+
+/** Zipfian generator over [0, n) of Gray et al., "Quickly Generating Billion-Record Synthetic Databases". */
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+    double zeta_2 = 0;
+    for (uint64_t i = 1; i <= n_; i++) {
+      zeta_n_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+      if (i == 2) zeta_2 = zeta_n_;
+    }
+    alpha_ = 1.0 / (1.0 - theta_);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(n_), 1.0 - theta_)) / (1.0 - zeta_2 / zeta_n_);
+  }
+
+  auto Next(std::mt19937_64 *rng) const -> uint64_t {
+    double u = std::uniform_real_distribution<double>(0, 1)(*rng);
+    double uz = u * zeta_n_;
+    if (uz < 1.0) return 0;
+    if (uz < 1.0 + std::pow(0.5, theta_)) return std::min<uint64_t>(1, n_ - 1);
+    auto rank = static_cast<uint64_t>(static_cast<double>(n_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, n_ - 1);
+  }
+
+ private:
+  uint64_t n_;
+  double theta_;
+  double zeta_n_{0};
+  double alpha_;
+  double eta_;
+};
+
+struct Options {
+  std::string workload_{"zipf"};
+  std::string policy_{"lru_k"};
+  std::string disk_{"null"};
+  size_t threads_{1};
+  size_t instances_{1};
+  size_t pool_size_{1024};
+  size_t pages_{8192};
+  size_t duration_ms_{2000};
+  size_t replacer_k_{LRUK_REPLACER_K};
+  size_t scan_length_{256};
+  size_t scan_threads_{1};
+  double theta_{0.99};
+  double write_ratio_{0.1};
+  bool replacer_only_{false};
+  bool checksum_only_{false};
+};
+
+void PrintUsage() {
+  printf(
+      "usage: bpm_bench [--option=value ...]\n"
+      "  --workload=uniform|zipf|scan|mixed  access pattern (zipf)\n"
+      "      mixed: --scan-threads threads scan, the others do Zipfian point lookups\n"
+      "  --threads=N            worker threads (1)\n"
+      "  --instances=N          ParallelBufferPoolManager instances, 1 for a single instance (1)\n"
+      "  --pool-size=N          frames in all instances together (1024)\n"
+      "  --pages=N              pages in the working set (8192)\n"
+      "  --duration-ms=N        run time of the workload (2000)\n"
+      "  --policy=lru_k|clock|2q|arc  replacement policy (lru_k)\n"
+      "  --k=N                  lookback of LRU-K (%zu)\n"
+      "  --theta=X              skew of the Zipfian distribution (0.99)\n"
+      "  --write-ratio=X        fraction of accesses that dirty the page (0.1)\n"
+      "  --scan-length=N        pages per scan (256)\n"
+      "  --scan-threads=N       scanning threads of the mixed workload (1)\n"
+      "  --disk=null|memory     null drops writes and reads zeros, memory keeps the pages in RAM (null)\n"
+      "  --replacer             benchmark RecordAccess/Evict of every replacer on its own instead\n"
+      "  --checksum             benchmark the CRC32C of a page on its own instead\n",
+      static_cast<size_t>(LRUK_REPLACER_K));
+}
+
+auto ParseOptions(int argc, char **argv, Options *options) -> bool {
+  std::map<std::string, std::string> values;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) return false;
+    size_t eq = arg.find('=');
+    values[arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2)] =
+        eq == std::string::npos ? "" : arg.substr(eq + 1);
+  }
+  auto size_value = [&values](const std::string &key, size_t *value) {
+    if (values.count(key) > 0) *value = std::strtoull(values[key].c_str(), nullptr, 10);
+  };
+  auto double_value = [&values](const std::string &key, double *value) {
+    if (values.count(key) > 0) *value = std::strtod(values[key].c_str(), nullptr);
+  };
+  if (values.count("help") > 0) return false;
+  if (values.count("workload") > 0) options->workload_ = values["workload"];
+  if (values.count("policy") > 0) options->policy_ = values["policy"];
+  if (values.count("disk") > 0) options->disk_ = values["disk"];
+  size_value("threads", &options->threads_);
+  size_value("instances", &options->instances_);
+  size_value("pool-size", &options->pool_size_);
+  size_value("pages", &options->pages_);
+  size_value("duration-ms", &options->duration_ms_);
+  size_value("k", &options->replacer_k_);
+  size_value("scan-length", &options->scan_length_);
+  size_value("scan-threads", &options->scan_threads_);
+  double_value("theta", &options->theta_);
+  double_value("write-ratio", &options->write_ratio_);
+  options->replacer_only_ = values.count("replacer") > 0;
+  options->checksum_only_ = values.count("checksum") > 0;
+  return options->threads_ > 0 && options->instances_ > 0 && options->pool_size_ >= options->instances_ &&
+         options->pages_ > 0;
+}
+
+auto ParsePolicy(const std::string &policy) -> ReplacerPolicy {
+  if (policy == "clock") return ReplacerPolicy::CLOCK;
+  if (policy == "2q") return ReplacerPolicy::TWO_QUEUE;
+  if (policy == "arc") return ReplacerPolicy::ARC;
+  return ReplacerPolicy::LRU_K;
+}
+
+void PrintLatency(const char *name, const LatencySnapshot &latency) {
+  printf("%-14s mean %8.0f ns  p50 %8lu ns  p99 %8lu ns  p99.9 %8lu ns\n", name, latency.MeanNs(),
+         static_cast<unsigned long>(latency.PercentileNs(0.5)),    // NOLINT
+         static_cast<unsigned long>(latency.PercentileNs(0.99)),   // NOLINT
+         static_cast<unsigned long>(latency.PercentileNs(0.999)));  // NOLINT
+}
+
+auto RunBufferPool(const Options &options) -> int {
+  std::unique_ptr<DiskManager> disk_manager;
+  if (options.disk_ == "memory") {
+    disk_manager = std::make_unique<DiskManagerMemory>(options.pages_);
+  } else {
+    disk_manager = std::make_unique<NullDiskManager>();
+  }
+  ReplacerPolicy policy = ParsePolicy(options.policy_);
+  std::unique_ptr<BufferPoolManager> bpm;
+  if (options.instances_ == 1) {
+    bpm = std::make_unique<BufferPoolManagerInstance>(options.pool_size_, disk_manager.get(), options.replacer_k_,
+                                                      nullptr, policy);
+  } else {
+    bpm = std::make_unique<ParallelBufferPoolManager>(options.instances_, options.pool_size_ / options.instances_,
+                                                      disk_manager.get(), options.replacer_k_, nullptr, policy);
+  }
+  auto metrics = [&bpm, &options] {
+    if (options.instances_ == 1) return static_cast<BufferPoolManagerInstance *>(bpm.get())->GetMetrics();
+    return static_cast<ParallelBufferPoolManager *>(bpm.get())->GetMetrics();
+  };
+
+  // the working set is created up front; the ids are kept since a parallel pool does not hand them out in order
+  std::vector<page_id_t> page_ids(options.pages_);
+  for (size_t i = 0; i < options.pages_; i++) {
+    if (bpm->NewPage(&page_ids[i]) == nullptr) {
+      fprintf(stderr, "cannot create page %zu\n", i);
+      return 1;
+    }
+    bpm->UnpinPage(page_ids[i], true);
+  }
+  bpm->FlushAllPages();
+
+  std::unique_ptr<ZipfianGenerator> zipf;
+  if (options.workload_ == "zipf" || options.workload_ == "mixed") {
+    zipf = std::make_unique<ZipfianGenerator>(options.pages_, options.theta_);
+  }
+  BufferPoolMetricsSnapshot before = metrics();
+  LatencyHistogram latency;
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::atomic<uint64_t> failed_ops{0};
+
+  auto worker = [&](size_t thread_index) {
+    std::mt19937_64 rng(thread_index + 1);
+    bool scanning = options.workload_ == "scan" ||
+                    (options.workload_ == "mixed" && thread_index < options.scan_threads_);
+    size_t cursor = (options.pages_ / options.threads_) * thread_index;
+    size_t scanned = options.scan_length_;
+    uint64_t ops = 0;
+    uint64_t failed = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+      size_t index;
+      if (scanning) {
+        if (scanned == options.scan_length_) {
+          cursor = std::uniform_int_distribution<size_t>(0, options.pages_ - 1)(rng);
+          scanned = 0;
+        }
+        index = (cursor + scanned++) % options.pages_;
+      } else if (zipf != nullptr) {
+        index = zipf->Next(&rng);
+      } else {
+        index = std::uniform_int_distribution<size_t>(0, options.pages_ - 1)(rng);
+      }
+      bool dirty = std::uniform_real_distribution<double>(0, 1)(rng) < options.write_ratio_;
+
+      auto start = std::chrono::steady_clock::now();
+      Page *page = bpm->FetchPage(page_ids[index]);
+      if (page != nullptr) {
+        bpm->UnpinPage(page_ids[index], dirty);
+      } else {
+        failed++;
+      }
+      latency.Record(std::chrono::steady_clock::now() - start);
+      ops++;
+    }
+    total_ops += ops;
+    failed_ops += failed;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < options.threads_; i++) threads.emplace_back(worker, i);
+  std::this_thread::sleep_for(std::chrono::milliseconds(options.duration_ms_));
+  stop = true;
+  for (auto &thread : threads) thread.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  BufferPoolMetricsSnapshot after = metrics();
+  uint64_t hits = after.hits_ - before.hits_;
+  uint64_t misses = after.misses_ - before.misses_;
+  printf("workload %s, policy %s, %zu threads, %zu instances, %zu frames, %zu pages, %s disk\n",
+         options.workload_.c_str(), options.policy_.c_str(), options.threads_, options.instances_,
+         options.pool_size_, options.pages_, options.disk_.c_str());
+  printf("%-14s %.0f ops/s (%lu ops, %lu failed)\n", "throughput", static_cast<double>(total_ops) / elapsed.count(),
+         static_cast<unsigned long>(total_ops.load()), static_cast<unsigned long>(failed_ops.load()));  // NOLINT
+  printf("%-14s %.4f (%lu hits, %lu misses)\n", "hit rate",
+         hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses),
+         static_cast<unsigned long>(hits), static_cast<unsigned long>(misses));  // NOLINT
+  printf("%-14s %lu (%lu dirty)\n", "evictions",
+         static_cast<unsigned long>(after.evictions_ - before.evictions_),               // NOLINT
+         static_cast<unsigned long>(after.dirty_evictions_ - before.dirty_evictions_));  // NOLINT
+  PrintLatency("fetch+unpin", latency.Snapshot());
+  PrintLatency("miss", after.miss_latency_);
+  PrintLatency("latch wait", after.latch_wait_);
+  return 0;
+}
+
+auto MakeReplacer(const std::string &policy, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  if (policy == "clock") return std::make_unique<ClockReplacer>(num_frames);
+  if (policy == "2q") return std::make_unique<TwoQueueReplacer>(num_frames);
+  if (policy == "arc") return std::make_unique<ArcReplacer>(num_frames);
+  return std::make_unique<LRUKReplacer>(num_frames, k, true);
+}
+
+template <class Body>
+auto MeasureOps(size_t num_threads, size_t duration_ms, Body body) -> double {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      std::mt19937_64 rng(i + 1);
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        // checking the flag every operation would dominate the cheapest ones
+        for (int j = 0; j < 64; j++) body(i, &rng);
+        ops += 64;
+      }
+      total_ops += ops;
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) thread.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(total_ops) / elapsed.count();
+}
+
+auto RunReplacers(const Options &options) -> int {
+  const size_t num_frames = options.pool_size_;
+  printf("replacers over %zu frames, %zu threads for the hits\n", num_frames, options.threads_);
+  for (const char *policy : {"lru_k", "clock", "2q", "arc"}) {
+    std::unique_ptr<Replacer> replacer = MakeReplacer(policy, num_frames, options.replacer_k_);
+    for (size_t i = 0; i < num_frames; i++) {
+      replacer->RecordAccess(static_cast<frame_id_t>(i));
+      replacer->SetEvictable(static_cast<frame_id_t>(i), true);
+    }
+    ZipfianGenerator zipf(num_frames, options.theta_);
+
+    // the hit path: the pin leaves the frame evictable, the unpin sets it evictable again
+    double hit_ops = MeasureOps(options.threads_, options.duration_ms_, [&](size_t, std::mt19937_64 *rng) {
+      auto frame_id = static_cast<frame_id_t>(zipf.Next(rng));
+      replacer->RecordAccess(frame_id);
+      replacer->SetEvictable(frame_id, true);
+    });
+
+    // the miss path: the victim is reused for a new page right away; single threaded, as the pool latch makes it
+    std::mutex evict_latch;
+    double evict_ops = MeasureOps(1, options.duration_ms_, [&](size_t, std::mt19937_64 *) {
+      std::scoped_lock<std::mutex> lock(evict_latch);
+      frame_id_t frame_id;
+      if (!replacer->Evict(&frame_id)) return;
+      replacer->RecordAccess(frame_id);
+      replacer->SetEvictable(frame_id, true);
+    });
+
+    printf("%-6s RecordAccess+unpin %12.0f ops/s   Evict+RecordAccess %12.0f ops/s\n", policy, hit_ops, evict_ops);
+  }
+  return 0;
+}
+
+auto RunChecksums(const Options &options) -> int {
+  // more pages than fit in the L1 cache, as the pages checksummed on I/O are rarely cached
+  constexpr size_t NUM_PAGES = 64;
+  std::vector<char> pages(NUM_PAGES * BUSTUB_PAGE_SIZE);
+  std::mt19937_64 fill_rng(42);
+  for (char &byte : pages) byte = static_cast<char>(fill_rng());
+  // one cache line per thread, so that keeping the results alive does not serialize the threads
+  std::vector<std::array<uint32_t, 16>> sinks(options.threads_);
+  double ops = MeasureOps(options.threads_, options.duration_ms_, [&](size_t thread, std::mt19937_64 *rng) {
+    const char *page = pages.data() + (*rng)() % NUM_PAGES * BUSTUB_PAGE_SIZE;
+    sinks[thread][0] ^= PageChecksums::Crc32c(page, BUSTUB_PAGE_SIZE);
+  });
+  uint32_t combined = 0;
+  for (const auto &sink : sinks) combined ^= sink[0];
+  printf("CRC32C (%s) of a %d byte page: %.0f ns per page per thread, %.0f MB/s over %zu threads (%08x)\n",
+         PageChecksums::UsesHardwareCrc32c() ? "hardware" : "software", BUSTUB_PAGE_SIZE,
+         1e9 * static_cast<double>(options.threads_) / ops, ops * BUSTUB_PAGE_SIZE / 1e6, options.threads_, combined);
+  return 0;
+}
+
+}  // namespace
+}  // namespace bustub
+
+auto main(int argc, char **argv) -> int {
+  bustub::Options options;
+  if (!bustub::ParseOptions(argc, argv, &options)) {
+    bustub::PrintUsage();
+    return 1;
+  }
+  if (options.checksum_only_) return bustub::RunChecksums(options);
+  return options.replacer_only_ ? bustub::RunReplacers(options) : bustub::RunBufferPool(options);
+}
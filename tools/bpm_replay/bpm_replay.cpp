@@ -0,0 +1,446 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// bpm_replay.cpp
+//
+// Identification: tools/bpm_replay/bpm_replay.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+// Replays a trace recorded by BufferPoolManagerInstance::EnableTracing() against replacement policies and pool sizes,
+// to pick the pool_size and replacer_k of a deployment from its real workload. The replay is single threaded and
+// deterministic: the calls are applied in the order they were recorded, to a simulated pool that does the
+// bookkeeping of a BufferPoolManagerInstance (page table, pins, free frames, strategy rings, priorities, prefetches)
+// around a real replacer, without pages or disk. The results are estimates, not what the traced pool measured: I/O
+// takes no time, so prefetched pages are evictable at once and waits for write-backs or the page cleaner do not
+// happen, the compressed page cache is not simulated, and the sticky limit is the one the traced pool applied.
+// Run with --help for the options.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "buffer/access_tracer.h"
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+
+namespace bustub {
+namespace {
+
+struct Options {
+  std::string trace_;
+  std::vector<std::string> policies_{"lru_k", "clock", "2q", "arc"};
+  std::vector<size_t> pool_sizes_;
+  std::vector<size_t> replacer_ks_{LRUK_REPLACER_K};
+  /** Bounds of an adaptive k, empty for a fixed k only. */
+  std::vector<size_t> adaptive_k_;
+};
+
+void PrintUsage() {
+  fprintf(stderr,
+          "usage: bpm_replay --trace=FILE [--option=value ...]\n"
+          "  --trace=FILE           trace written by BufferPoolManagerInstance::EnableTracing()\n"
+          "  --policy=P,...         replacement policies among lru_k, clock, 2q and arc (all of them)\n"
+          "  --pool-sizes=N,...     pool sizes to replay with (powers of two up to the pages of the trace)\n"
+          "  --k=N,...              lookbacks of LRU-K to replay with (%zu)\n"
+          "  --adaptive-k=MIN,MAX   also replay LRU-K with k adapting between MIN and MAX from each of the\n"
+          "                         lookbacks; the k column then shows ~ and the k the replay ended with\n",
+          static_cast<size_t>(LRUK_REPLACER_K));
+}
+
+auto SplitList(const std::string &list) -> std::vector<std::string> {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+auto SplitSizes(const std::string &list) -> std::vector<size_t> {
+  std::vector<size_t> sizes;
+  for (const std::string &item : SplitList(list)) sizes.push_back(std::strtoull(item.c_str(), nullptr, 10));
+  return sizes;
+}
+
+auto ParseOptions(int argc, char **argv, Options *options) -> bool {
+  std::map<std::string, std::string> values;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg.rfind("--", 0) != 0) return false;
+    size_t eq = arg.find('=');
+    values[arg.substr(2, eq == std::string::npos ? std::string::npos : eq - 2)] =
+        eq == std::string::npos ? "" : arg.substr(eq + 1);
+  }
+  if (values.count("help") > 0 || values.count("trace") == 0) return false;
+  options->trace_ = values["trace"];
+  if (values.count("policy") > 0) options->policies_ = SplitList(values["policy"]);
+  if (values.count("pool-sizes") > 0) options->pool_sizes_ = SplitSizes(values["pool-sizes"]);
+  if (values.count("k") > 0) options->replacer_ks_ = SplitSizes(values["k"]);
+  if (values.count("adaptive-k") > 0) {
+    options->adaptive_k_ = SplitSizes(values["adaptive-k"]);
+    if (options->adaptive_k_.size() != 2 || options->adaptive_k_[0] > options->adaptive_k_[1]) return false;
+  }
+  for (const std::string &policy : options->policies_) {
+    if (policy != "lru_k" && policy != "clock" && policy != "2q" && policy != "arc") return false;
+  }
+  auto positive = [](size_t size) { return size > 0; };
+  return !options->policies_.empty() && !options->replacer_ks_.empty() &&
+         std::all_of(options->pool_sizes_.begin(), options->pool_sizes_.end(), positive) &&
+         std::all_of(options->replacer_ks_.begin(), options->replacer_ks_.end(), positive) &&
+         std::all_of(options->adaptive_k_.begin(), options->adaptive_k_.end(), positive);
+}
+
+auto MakeReplacer(const std::string &policy, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  if (policy == "clock") return std::make_unique<ClockReplacer>(num_frames);
+  if (policy == "2q") return std::make_unique<TwoQueueReplacer>(num_frames);
+  if (policy == "arc") return std::make_unique<ArcReplacer>(num_frames);
+  return std::make_unique<LRUKReplacer>(num_frames, k);
+}
+
+struct ReplayResult {
+  uint64_t fetches_{0};
+  uint64_t hits_{0};
+  uint64_t new_pages_{0};
+  uint64_t evictions_{0};
+  uint64_t dirty_evictions_{0};
+  uint64_t cold_evictions_{0};
+  /** Fetches and new pages that found every frame pinned; they pinned a page in the traced pool. */
+  uint64_t failures_{0};
+  /** Lookback of the replacer at the end of the replay, 0 without one. */
+  size_t final_k_{0};
+
+  auto HitRatio() const -> double {
+    return fetches_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches_);
+  }
+};
+
+/** The bookkeeping of a BufferPoolManagerInstance around a replacer, without pages or disk. */
+class PoolSimulator {
+ public:
+  PoolSimulator(std::unique_ptr<Replacer> replacer, size_t pool_size)
+      : replacer_(std::move(replacer)), pin_counts_(pool_size, 0), dirty_(pool_size, false),
+        ring_owners_(pool_size, NO_RING) {
+    for (size_t i = pool_size; i > 0; i--) free_frames_.push_back(static_cast<frame_id_t>(i - 1));
+  }
+
+  void Apply(const TraceRecord &record, ReplayResult *result) {
+    page_id_t page_id = record.page_id_;
+    switch (record.op_) {
+      case TraceOp::FETCH:
+      case TraceOp::NEW: {
+        bool is_new = record.op_ == TraceOp::NEW;
+        (is_new ? result->new_pages_ : result->fetches_)++;
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) {
+          // a new page is only resident if its id was reused after a delete the simulated pool could not apply
+          if (!is_new) result->hits_++;
+          if (ring_owners_[it->second] != NO_RING) {
+            // a page a scan brought in is taken over by the pool
+            pin_counts_[it->second]++;
+            AdoptRingFrame(it->second);
+            return;
+          }
+          Pin(it->second);
+          return;
+        }
+        frame_id_t frame_id;
+        if (!AcquireFrame(&frame_id, result)) {
+          result->failures_++;
+          lost_pins_[page_id]++;  // the unpin of this pin is dropped
+          return;
+        }
+        InstallPage(frame_id, page_id, is_new);
+        Pin(frame_id);
+        return;
+      }
+      case TraceOp::FETCH_STRATEGY: {
+        result->fetches_++;
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) {
+          // neither a strategy's hits nor its misses are accesses in the replacer
+          result->hits_++;
+          if (pin_counts_[it->second]++ == 0 && ring_owners_[it->second] == NO_RING) {
+            replacer_->SetEvictable(it->second, false);
+          }
+          return;
+        }
+        auto ring = rings_.find(record.arg_);
+        frame_id_t frame_id;
+        bool acquired = ring == rings_.end() ? AcquireFrame(&frame_id, result)
+                                             : AcquireRingFrame(&ring->second, &frame_id, result);
+        if (!acquired) {
+          result->failures_++;
+          lost_pins_[page_id]++;
+          return;
+        }
+        if (ring == rings_.end()) {
+          // the ring was numbered before the trace started; without its size the page goes through the replacer
+          InstallPage(frame_id, page_id, false);
+          Pin(frame_id);
+          return;
+        }
+        page_table_[page_id] = frame_id;
+        frame_pages_[frame_id] = page_id;
+        dirty_[frame_id] = false;
+        ring_owners_[frame_id] = record.arg_;
+        pin_counts_[frame_id] = 1;
+        return;
+      }
+      case TraceOp::PREFETCH: {
+        if (page_table_.count(page_id) > 0) return;
+        frame_id_t frame_id;
+        if (!AcquireFrame(&frame_id, result)) return;
+        page_table_[page_id] = frame_id;
+        frame_pages_[frame_id] = page_id;
+        dirty_[frame_id] = false;
+        replacer_->SetFramePage(frame_id, page_id);
+        replacer_->RecordPrefetch(frame_id);
+        // the prefetch pin is dropped as soon as the read completes, which a replay without I/O does at once
+        replacer_->SetEvictable(frame_id, true);
+        return;
+      }
+      case TraceOp::UNPIN:
+      case TraceOp::UNPIN_DIRTY: {
+        auto lost = lost_pins_.find(page_id);
+        if (lost != lost_pins_.end()) {
+          if (--lost->second == 0) lost_pins_.erase(lost);
+          return;
+        }
+        auto it = page_table_.find(page_id);
+        if (it == page_table_.end() || pin_counts_[it->second] == 0) return;
+        if (record.op_ == TraceOp::UNPIN_DIRTY) dirty_[it->second] = true;
+        if (--pin_counts_[it->second] == 0 && ring_owners_[it->second] == NO_RING) {
+          replacer_->SetEvictable(it->second, true);
+        }
+        return;
+      }
+      case TraceOp::FLUSH:
+      case TraceOp::CLEAN: {
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end()) dirty_[it->second] = false;
+        return;
+      }
+      case TraceOp::PRIORITY: {
+        auto it = page_table_.find(page_id);
+        if (it != page_table_.end() && ring_owners_[it->second] == NO_RING) {
+          replacer_->SetPriority(it->second, static_cast<PagePriority>(record.arg_));
+        }
+        return;
+      }
+      case TraceOp::DELETE: {
+        auto it = page_table_.find(page_id);
+        if (it == page_table_.end() || pin_counts_[it->second] > 0) return;
+        frame_id_t frame_id = it->second;
+        ring_owners_[frame_id] = NO_RING;
+        replacer_->Remove(frame_id);
+        frame_pages_.erase(frame_id);
+        page_table_.erase(it);
+        free_frames_.push_back(frame_id);
+        return;
+      }
+      case TraceOp::RING:
+        rings_[record.arg_] = Ring{record.arg_, static_cast<size_t>(page_id), {}, 0};
+        return;
+      case TraceOp::RELEASE_RING: {
+        auto ring = rings_.find(record.arg_);
+        if (ring == rings_.end()) return;
+        for (frame_id_t frame_id : ring->second.frames_) {
+          if (ring_owners_[frame_id] != record.arg_) continue;
+          if (pin_counts_[frame_id] > 0 || dirty_[frame_id]) {
+            AdoptRingFrame(frame_id);
+            continue;
+          }
+          ring_owners_[frame_id] = NO_RING;
+          page_table_.erase(frame_pages_[frame_id]);
+          frame_pages_.erase(frame_id);
+          free_frames_.push_back(frame_id);
+        }
+        rings_.erase(ring);
+        return;
+      }
+    }
+  }
+
+  auto GetColdEvictionCount() -> size_t { return replacer_->GetColdEvictionCount(); }
+  auto GetK() -> size_t { return replacer_->GetK(); }
+
+ private:
+  /** The ring owner of a frame that belongs to no ring; rings are numbered from 1. */
+  static constexpr uint8_t NO_RING = 0;
+
+  /** The frames of a strategy, recycled in turn like BufferAccessStrategy::Ring. */
+  struct Ring {
+    uint8_t number_;
+    size_t size_;
+    std::vector<frame_id_t> frames_;
+    size_t next_;
+  };
+
+  void Pin(frame_id_t frame_id) {
+    replacer_->RecordAccess(frame_id);
+    if (pin_counts_[frame_id]++ == 0) replacer_->SetEvictable(frame_id, false);
+  }
+
+  void InstallPage(frame_id_t frame_id, page_id_t page_id, bool is_new) {
+    page_table_[page_id] = frame_id;
+    frame_pages_[frame_id] = page_id;
+    dirty_[frame_id] = is_new;
+    replacer_->SetFramePage(frame_id, page_id);
+  }
+
+  void AdoptRingFrame(frame_id_t frame_id) {
+    ring_owners_[frame_id] = NO_RING;
+    replacer_->SetFramePage(frame_id, frame_pages_[frame_id]);
+    replacer_->RecordAccess(frame_id);
+    if (pin_counts_[frame_id] == 0) replacer_->SetEvictable(frame_id, true);
+  }
+
+  auto AcquireFrame(frame_id_t *frame_id, ReplayResult *result) -> bool {
+    if (!free_frames_.empty()) {
+      *frame_id = free_frames_.back();
+      free_frames_.pop_back();
+      return true;
+    }
+    if (!replacer_->Evict(frame_id)) return false;
+    EvictPage(*frame_id, result);
+    return true;
+  }
+
+  /** Like BufferPoolManagerInstance::AcquireRingFrame(): grow the ring, else recycle its next frame. */
+  auto AcquireRingFrame(Ring *ring, frame_id_t *frame_id, ReplayResult *result) -> bool {
+    if (ring->frames_.size() < ring->size_) {
+      if (!AcquireFrame(frame_id, result)) return false;
+      ring->frames_.push_back(*frame_id);
+      return true;
+    }
+    size_t slot = ring->next_;
+    ring->next_ = (ring->next_ + 1) % ring->frames_.size();
+    frame_id_t ring_frame_id = ring->frames_[slot];
+    if (ring_owners_[ring_frame_id] == ring->number_) {
+      if (pin_counts_[ring_frame_id] == 0) {
+        *frame_id = ring_frame_id;
+        EvictPage(ring_frame_id, result);
+        return true;
+      }
+      AdoptRingFrame(ring_frame_id);
+    }
+    if (!AcquireFrame(frame_id, result)) {
+      ring->frames_.erase(ring->frames_.begin() + slot);
+      ring->next_ = slot < ring->frames_.size() ? slot : 0;
+      return false;
+    }
+    ring->frames_[slot] = *frame_id;
+    return true;
+  }
+
+  void EvictPage(frame_id_t frame_id, ReplayResult *result) {
+    result->evictions_++;
+    if (dirty_[frame_id]) result->dirty_evictions_++;
+    ring_owners_[frame_id] = NO_RING;
+    page_table_.erase(frame_pages_[frame_id]);
+    frame_pages_.erase(frame_id);
+  }
+
+  std::unique_ptr<Replacer> replacer_;
+  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  std::unordered_map<frame_id_t, page_id_t> frame_pages_;
+  std::vector<size_t> pin_counts_;
+  std::vector<bool> dirty_;
+  /** The ring each frame belongs to, NO_RING for the frames of the replacer. */
+  std::vector<uint8_t> ring_owners_;
+  std::vector<frame_id_t> free_frames_;
+  std::unordered_map<uint8_t, Ring> rings_;
+  /** Pins the traced pool took that the simulated one could not, by page. */
+  std::unordered_map<page_id_t, size_t> lost_pins_;
+};
+
+/** @param adaptive_k bounds of an adaptive k, empty for a fixed k */
+auto Replay(const std::vector<TraceRecord> &records, const std::string &policy, size_t pool_size, size_t k,
+            const std::vector<size_t> &adaptive_k) -> ReplayResult {
+  std::unique_ptr<Replacer> replacer = MakeReplacer(policy, pool_size, k);
+  if (!adaptive_k.empty()) replacer->SetAdaptiveK(adaptive_k[0], adaptive_k[1]);
+  PoolSimulator pool(std::move(replacer), pool_size);
+  ReplayResult result;
+  for (const TraceRecord &record : records) pool.Apply(record, &result);
+  result.cold_evictions_ = pool.GetColdEvictionCount();
+  result.final_k_ = pool.GetK();
+  return result;
+}
+
+auto Run(const Options &options) -> int {
+  std::vector<TraceRecord> records;
+  if (!AccessTracer::ReadTrace(options.trace_, &records)) {
+    fprintf(stderr, "cannot read the trace %s\n", options.trace_.c_str());
+    return 1;
+  }
+  std::unordered_set<page_id_t> pages;
+  std::unordered_set<uint16_t> threads;
+  for (const TraceRecord &record : records) {
+    // the page id of a ring record is the size of the ring
+    if (record.op_ != TraceOp::RING && record.op_ != TraceOp::RELEASE_RING) pages.insert(record.page_id_);
+    threads.insert(record.thread_);
+  }
+  double duration_s = records.empty() ? 0 : static_cast<double>(records.back().timestamp_ns_) / 1e9;
+  printf("%zu calls on %zu pages by %zu threads over %.3f s\n", records.size(), pages.size(), threads.size(),
+         duration_s);
+
+  std::vector<size_t> pool_sizes = options.pool_sizes_;
+  if (pool_sizes.empty()) {
+    // the hit ratio curve up to the pool that holds every page of the trace
+    for (size_t pool_size = 16; pool_size < pages.size() * 2; pool_size *= 2) pool_sizes.push_back(pool_size);
+    if (pool_sizes.empty()) pool_sizes.push_back(16);
+  }
+
+  printf("%-6s %4s %10s %10s %9s %10s %10s %10s %10s\n", "policy", "k", "pool_size", "fetches", "hit_ratio",
+         "evictions", "dirty", "cold", "failures");
+  for (const std::string &policy : options.policies_) {
+    // only LRU-K has a lookback
+    std::vector<size_t> ks = policy == "lru_k" ? options.replacer_ks_ : std::vector<size_t>{0};
+    std::vector<std::vector<size_t>> modes{{}};
+    if (policy == "lru_k" && !options.adaptive_k_.empty()) modes.push_back(options.adaptive_k_);
+    for (const std::vector<size_t> &adaptive_k : modes) {
+      for (size_t k : ks) {
+        for (size_t pool_size : pool_sizes) {
+          ReplayResult result = Replay(records, policy, pool_size, k, adaptive_k);
+          std::string k_column = k == 0 ? "-" : std::to_string(result.final_k_);
+          if (!adaptive_k.empty()) k_column = "~" + k_column;
+          printf("%-6s %4s %10zu %10lu %9.4f %10lu %10lu %10lu %10lu\n", policy.c_str(), k_column.c_str(),
+                 pool_size, static_cast<unsigned long>(result.fetches_), result.HitRatio(),  // NOLINT
+                 static_cast<unsigned long>(result.evictions_),                              // NOLINT
+                 static_cast<unsigned long>(result.dirty_evictions_),                        // NOLINT
+                 static_cast<unsigned long>(result.cold_evictions_),                         // NOLINT
+                 static_cast<unsigned long>(result.failures_));                              // NOLINT
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace bustub
+
+auto main(int argc, char **argv) -> int {
+  bustub::Options options;
+  if (!bustub::ParseOptions(argc, argv, &options)) {
+    bustub::PrintUsage();
+    return 1;
+  }
+  return bustub::Run(options);
+}